@@ -0,0 +1,117 @@
+#include <atomic>
+#include <thread>
+#include "common.h"
+
+// 绑定CPU对尾延迟的影响：多个反应堆（SO_REUSEPORT监听同一端口）回显，客户端线程一问一答
+//   floating: 反应堆线程由调度器随意迁移
+//   pinned:   反应堆i绑定到CPU i%N，并设置SO_INCOMING_CPU
+// 可以用--noise加入忙等的线程制造调度压力
+// 用法: ./bench_affinity [--reactors=CPU数] [--clients=4] [--size=64] [--noise=0] [--duration=3] [--port=9150]
+
+namespace {
+
+struct settings {
+    int reactors;
+    int clients;
+    size_t size;
+    int noise;
+    double duration;
+    int port;
+};
+
+void run(bool pinned, const settings& s) {
+    int ncpus = fnet::affinity::num_cpus();
+    std::vector<std::unique_ptr<fnet::reactor>> recs;
+    for (int i = 0; i < s.reactors; ++i) {
+        recs.emplace_back(new fnet::reactor);
+        auto& rec = *recs.back();
+        if (pinned) rec.set_cpu(i % ncpus, true);
+        fnet::acceptor<fnet::protocol::tcp> acp;
+        fnet::utility::set_reuse_address(acp.get_fd());
+        fnet::utility::set_reuse_port(acp.get_fd());
+        acp.do_bind("127.0.0.1", s.port);
+        acp.do_listen(4096);
+        rec.add_acceptor(std::move(acp), [&rec](int fd) {
+            fnet::utility::set_nonblocking(fd);
+            rec.add_socket(fd, fnet::event::readable, fnet::pattern::lt);
+        });
+        rec.set_readable_cb([](int fd) {
+            char buf[65536];
+            auto n = read(fd, buf, sizeof(buf));
+            if (n > 0 && write(fd, buf, n) != n) std::abort();
+        });
+    }
+    std::vector<std::thread> loops;
+    for (auto& r : recs) loops.emplace_back([&r] { r->activate(); });
+
+    std::atomic<bool> stop = {false};
+    std::vector<std::thread> noise;
+    for (int i = 0; i < s.noise; ++i) {
+        noise.emplace_back([&] {
+            volatile uint64_t x = 0;
+            while (!stop.load(std::memory_order_relaxed)) x = x + 1;
+        });
+    }
+
+    std::vector<std::unique_ptr<fnet::histogram>> hists;
+    std::vector<uint64_t> counts(s.clients, 0);
+    std::vector<std::thread> clients;
+    uint64_t end = bench::now_ns() + static_cast<uint64_t>(s.duration * 1e9);
+    for (int c = 0; c < s.clients; ++c) {
+        hists.emplace_back(new fnet::histogram);
+        clients.emplace_back([&, c] {
+            int fd = bench::connect_to("127.0.0.1", s.port);
+            int flags = fcntl(fd, F_GETFL);
+            fcntl(fd, F_SETFL, flags & ~O_NONBLOCK);
+            std::string msg(s.size, 'x'), buf(s.size, 0);
+            while (true) {
+                uint64_t t0 = bench::now_ns();
+                if (t0 >= end) break;
+                if (write(fd, msg.data(), s.size) != static_cast<ssize_t>(s.size)) std::abort();
+                size_t got = 0;
+                while (got < s.size) {
+                    auto n = read(fd, &buf[got], s.size - got);
+                    if (n <= 0) std::abort();
+                    got += n;
+                }
+                hists[c]->record(bench::now_ns() - t0);
+                ++counts[c];
+            }
+            close(fd);
+        });
+    }
+    for (auto& t : clients) t.join();
+    stop = true;
+    for (auto& t : noise) t.join();
+    for (auto& r : recs) {
+        auto* p = r.get();
+        p->post([p] { p->destroy(); });
+    }
+    for (auto& t : loops) t.join();
+
+    fnet::histogram::snapshot all;
+    uint64_t total = 0;
+    for (int c = 0; c < s.clients; ++c) {
+        all.merge(hists[c]->snap());
+        total += counts[c];
+    }
+    std::cout << "{\"mode\":\"" << (pinned ? "pinned" : "floating") << "\",\"reactors\":" << s.reactors
+              << ",\"clients\":" << s.clients << ",\"noise\":" << s.noise
+              << ",\"round_trips_s\":" << static_cast<uint64_t>(total / s.duration)
+              << ",\"latency_us\":" << bench::latency_json(all) << "}" << std::endl;
+}
+
+}  // namespace
+
+int main(int argn, char** args) {
+    bench::options opt(argn, args);
+    settings s;
+    s.reactors = opt.num("reactors", fnet::affinity::num_cpus());
+    s.clients = opt.num("clients", 4);
+    s.size = opt.num("size", 64);
+    s.noise = opt.num("noise", 0);
+    s.duration = opt.real("duration", 3);
+    s.port = opt.num("port", 9150);
+    run(false, s);
+    run(true, s);
+}
@@ -0,0 +1,107 @@
+#include <fastnet/cbtrie.h>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "common.h"
+
+// 200个命令的查找吞吐：双数组cbtrie vs 旧版(每节点new int[26]) vs unordered_map<string_view>
+// 用法: ./bench_cbtrie [--commands=200] [--lookups=20000000]
+
+namespace {
+
+// 旧版实现，仅支持a-z
+class legacy_trie {
+    unsigned long cnt = 0;
+    std::vector<std::unique_ptr<int[]>> nextpos;
+    std::vector<int> vals;
+public:
+    void insert(const char* str, size_t len, int v) {
+        size_t p = 0;
+        for (size_t i = 0; i < len; i++) {
+            for (auto j = nextpos.size(); j <= p; ++j) {
+                nextpos.emplace_back(new int[26]);
+                memset(nextpos.back().get(), 0, 26 * sizeof(int));
+            }
+            int c = str[i] - 'a';
+            if (!nextpos[p][c]) nextpos[p][c] = ++cnt;
+            p = nextpos[p][c];
+        }
+        if (vals.size() <= p) vals.resize(p + 1);
+        vals[p] = v;
+    }
+    int search(const char* str, size_t len) {
+        size_t p = 0;
+        for (size_t i = 0; i < len; i++) {
+            int c = str[i] - 'a';
+            if (c < 0 || c >= 26) return 0;
+            if (p >= nextpos.size() || !nextpos[p][c]) return 0;
+            p = nextpos[p][c];
+        }
+        return p < vals.size() ? vals[p] : 0;
+    }
+};
+
+template <typename F>
+double measure(const std::vector<std::string>& queries, long lookups, F&& find) {
+    uint64_t sum = 0;
+    size_t n = queries.size();
+    uint64_t begin = bench::now_ns();
+    for (long i = 0; i < lookups; ++i) {
+        auto& q = queries[i % n];
+        sum += find(q.data(), q.size());
+    }
+    uint64_t end = bench::now_ns();
+    if (sum == 42) std::cerr << "";  // 防止被优化掉
+    return lookups / ((end - begin) / 1e9);
+}
+
+}  // namespace
+
+int main(int argn, char** args) {
+    bench::options opt(argn, args);
+    int ncmds = opt.num("commands", 200);
+    long lookups = opt.num("lookups", 20000000);
+
+    // 生成小写命令名，长度3~12
+    std::vector<std::string> cmds;
+    unsigned seed = 12345;
+    auto rnd = [&] { return (seed = seed * 1103515245 + 12345) >> 16; };
+    while (static_cast<int>(cmds.size()) < ncmds) {
+        std::string s;
+        int len = 3 + rnd() % 10;
+        for (int i = 0; i < len; ++i) s += static_cast<char>('a' + rnd() % 26);
+        cmds.push_back(s);
+    }
+    // 查询：90%命中，10%未命中
+    std::vector<std::string> queries;
+    for (int i = 0; i < 4096; ++i) {
+        if (rnd() % 10) {
+            queries.push_back(cmds[rnd() % cmds.size()]);
+        } else {
+            auto s = cmds[rnd() % cmds.size()];
+            s.back() = s.back() == 'z' ? 'a' : s.back() + 1;
+            queries.push_back(s);
+        }
+    }
+
+    fnet::cbtrie trie;
+    legacy_trie legacy;
+    std::unordered_map<std::string_view, int> map;
+    for (int i = 0; i < ncmds; ++i) {
+        trie.insert(cmds[i].data(), cmds[i].size(), [](char*, size_t) {});
+        legacy.insert(cmds[i].data(), cmds[i].size(), i + 1);
+        map.emplace(cmds[i], i + 1);
+    }
+    trie.freeze();
+
+    double t_trie = measure(queries, lookups, [&](const char* s, size_t n) { return trie.search(s, n); });
+    double t_legacy = measure(queries, lookups, [&](const char* s, size_t n) { return legacy.search(s, n); });
+    double t_map = measure(queries, lookups, [&](const char* s, size_t n) {
+        auto it = map.find(std::string_view(s, n));
+        return it == map.end() ? 0 : it->second;
+    });
+    std::cout << "{\"commands\":" << ncmds << ",\"lookups\":" << lookups
+              << ",\"cbtrie_mops\":" << t_trie / 1e6 << ",\"legacy_trie_mops\":" << t_legacy / 1e6
+              << ",\"unordered_map_mops\":" << t_map / 1e6 << "}" << std::endl;
+}
@@ -0,0 +1,65 @@
+#include <fastnet/clock.h>
+#include <fastnet/timer.h>
+#include "common.h"
+
+// 超时判断的开销：每轮事件循环检查checks个连接的超时
+//   chrono: timer::is_timeout()，每次检查读取steady_clock
+//   read:   每次检查直接读取时钟源（steady/coarse/tsc）
+//   cached: 每轮loop_clock::update()一次，检查时读取缓存值
+// 用法: ./bench_clock [--iterations=200000] [--checks=64]
+
+namespace {
+
+const char* source_name(fnet::clock_source s) {
+    return s == fnet::clock_source::steady ? "steady" : s == fnet::clock_source::coarse ? "coarse" : "tsc";
+}
+
+template <typename F>
+void report(const char* mode, const char* source, long iters, int checks, F&& iteration) {
+    uint64_t expired = 0;
+    uint64_t begin = bench::now_ns();
+    for (long i = 0; i < iters; ++i) expired += iteration();
+    double ns = static_cast<double>(bench::now_ns() - begin) / (static_cast<double>(iters) * checks);
+    std::cout << "{\"mode\":\"" << mode << "\",\"source\":\"" << source << "\",\"checks\":" << checks
+              << ",\"ns_per_check\":" << ns << ",\"expired_per_iteration\":" << expired / iters << "}" << std::endl;
+}
+
+}  // namespace
+
+int main(int argn, char** args) {
+    bench::options opt(argn, args);
+    long iters = opt.num("iterations", 200000);
+    int checks = opt.num("checks", 64);
+
+    // 一半已到期，一半在很久之后
+    uint64_t now = fnet::details::now_ns();
+    std::vector<uint64_t> deadlines;
+    std::vector<fnet::timer<std::nano>> timers;
+    for (int i = 0; i < checks; ++i) {
+        uint64_t d = i % 2 ? now - 1000 : now + 3600000000000ull;
+        deadlines.push_back(d);
+        timers.emplace_back(fnet::timer<std::nano>::timestamp_t(std::chrono::nanoseconds(d)));
+    }
+
+    report("chrono", "steady", iters, checks, [&] {
+        uint64_t n = 0;
+        for (auto& t : timers) n += t.is_timeout();
+        return n;
+    });
+    for (auto s : {fnet::clock_source::steady, fnet::clock_source::coarse, fnet::clock_source::tsc}) {
+        report("read", source_name(s), iters, checks, [&] {
+            uint64_t n = 0;
+            for (uint64_t d : deadlines) n += fnet::loop_clock::read(s) > d;
+            return n;
+        });
+    }
+    for (auto s : {fnet::clock_source::steady, fnet::clock_source::coarse, fnet::clock_source::tsc}) {
+        fnet::loop_clock clk(s);
+        report("cached", source_name(clk.source()), iters, checks, [&] {
+            clk.update();
+            uint64_t n = 0;
+            for (uint64_t d : deadlines) n += clk.now() > d;
+            return n;
+        });
+    }
+}
@@ -0,0 +1,111 @@
+#include <fastnet/cbtrie.h>
+#include <fastnet/cmdtable.h>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "common.h"
+
+// 约200个Redis命令名的路由：编译期cmdtable vs cbtrie vs unordered_map<string_view>
+// *_dispatch 为查找并调用各命令各自的处理函数，*_find 与 unordered_map 只查找下标并计数
+// 用法: ./bench_cmdtable [--lookups=20000000]
+
+#define REDIS_COMMANDS_REST(X)                                                                                        \
+    X(auth) X(bgrewriteaof) X(bgsave) X(bitcount) X(bitfield) X(bitop) X(bitpos) X(blpop) X(brpop) X(brpoplpush)      \
+    X(blmove) X(bzpopmin) X(bzpopmax) X(client) X(cluster) X(command) X(config) X(dbsize) X(debug) X(decr) X(decrby) \
+    X(del) X(discard) X(dump) X(echo) X(eval) X(evalsha) X(exec) X(exists) X(expire) X(expireat) X(flushall)         \
+    X(flushdb) X(geoadd) X(geohash) X(geopos) X(geodist) X(georadius) X(georadiusbymember) X(geosearch)              \
+    X(geosearchstore) X(get) X(getbit) X(getdel) X(getex) X(getrange) X(getset) X(hdel) X(hello) X(hexists) X(hget)   \
+    X(hgetall) X(hincrby) X(hincrbyfloat) X(hkeys) X(hlen) X(hmget) X(hmset) X(hset) X(hsetnx) X(hrandfield)         \
+    X(hstrlen) X(hvals) X(hscan) X(incr) X(incrby) X(incrbyfloat) X(info) X(keys) X(lastsave) X(lindex) X(linsert)   \
+    X(llen) X(lmove) X(lpop) X(lpos) X(lpush) X(lpushx) X(lrange) X(lrem) X(lset) X(ltrim) X(memory) X(mget)          \
+    X(migrate) X(module) X(monitor) X(move) X(mset) X(msetnx) X(multi) X(object) X(persist) X(pexpire) X(pexpireat)  \
+    X(pfadd) X(pfcount) X(pfmerge) X(ping) X(psetex) X(psubscribe) X(pubsub) X(pttl) X(publish) X(punsubscribe)      \
+    X(quit) X(randomkey) X(readonly) X(readwrite) X(rename) X(renamenx) X(reset) X(restore) X(role) X(rpop)          \
+    X(rpoplpush) X(rpush) X(rpushx) X(sadd) X(save) X(scard) X(script) X(sdiff) X(sdiffstore) X(select) X(set)       \
+    X(setbit) X(setex) X(setnx) X(setrange) X(shutdown) X(sinter) X(sinterstore) X(sismember) X(smismember)          \
+    X(slaveof) X(replicaof) X(slowlog) X(smembers) X(smove) X(sort) X(spop) X(srandmember) X(srem) X(strlen)         \
+    X(subscribe) X(sunion) X(sunionstore) X(swapdb) X(sync) X(psync) X(time) X(touch) X(ttl) X(type) X(unsubscribe) \
+    X(unlink) X(unwatch) X(wait) X(watch) X(zadd) X(zcard) X(zcount) X(zdiff) X(zdiffstore) X(zincrby) X(zinter)     \
+    X(zinterstore) X(zlexcount) X(zpopmax) X(zpopmin) X(zrandmember) X(zrangestore) X(zrange) X(zrangebylex)         \
+    X(zrevrangebylex) X(zrangebyscore) X(zrank) X(zrem) X(zremrangebylex) X(zremrangebyrank) X(zremrangebyscore)    \
+    X(zrevrange) X(zrevrangebyscore) X(zrevrank) X(zscore) X(zunion) X(zmscore) X(zunionstore) X(scan) X(sscan)      \
+    X(zscan) X(xinfo) X(xadd) X(xtrim) X(xdel) X(xrange) X(xrevrange) X(xlen) X(xread) X(xgroup) X(xreadgroup)      \
+    X(xack) X(xclaim) X(xautoclaim) X(xpending) X(latency) X(lolwut) X(acl) X(stralgo) X(failover) X(copy)           \
+    X(asking) X(sintercard) X(lmpop) X(blmpop) X(zmpop) X(bzmpop) X(expiretime) X(pexpiretime) X(function) X(fcall)  \
+    X(fcall_ro)
+
+#define AS_ARG(name) , #name
+#define AS_STR(name) #name,
+
+static constexpr auto table = fnet::make_cmdtable("append" REDIS_COMMANDS_REST(AS_ARG));
+static const char* const names[] = {"append", REDIS_COMMANDS_REST(AS_STR)};
+
+namespace {
+
+template <typename F>
+double measure(const std::vector<std::string>& queries, long lookups, F&& find) {
+    uint64_t sum = 0;
+    size_t n = queries.size();
+    uint64_t begin = bench::now_ns();
+    for (long i = 0; i < lookups; ++i) {
+        auto& q = queries[i % n];
+        sum += find(q.data(), q.size());
+    }
+    uint64_t end = bench::now_ns();
+    if (sum == 42) std::cerr << "";  // 防止被优化掉
+    return lookups / ((end - begin) / 1e9);
+}
+
+// 为每个命令生成不同的回调，与cmdtable中各命令各自实例化的处理函数对等
+template <size_t... I>
+void fill_trie(fnet::cbtrie& trie, uint64_t* counts, std::index_sequence<I...>) {
+    (trie.insert(names[I], strlen(names[I]), [counts](char*, size_t) { counts[I]++; }), ...);
+}
+
+}  // namespace
+
+int main(int argn, char** args) {
+    bench::options opt(argn, args);
+    long lookups = opt.num("lookups", 20000000);
+
+    fnet::cbtrie trie;
+    std::unordered_map<std::string_view, int> map;
+    uint64_t counts[table.size()] = {};
+    fill_trie(trie, counts, std::make_index_sequence<table.size()>{});
+    for (size_t i = 0; i < table.size(); ++i) map.emplace(names[i], static_cast<int>(i));
+    trie.freeze();
+
+    // 查询：90%命中，10%未命中
+    std::vector<std::string> queries;
+    unsigned seed = 12345;
+    auto rnd = [&] { return (seed = seed * 1103515245 + 12345) >> 16; };
+    for (int i = 0; i < 4096; ++i) {
+        std::string s = names[rnd() % table.size()];
+        if (rnd() % 10 == 0) s.back() = '#';
+        queries.push_back(s);
+    }
+
+    double t_table = measure(queries, lookups, [&](const char* s, size_t n) {
+        return table.dispatch(s, n, [&](auto cmd) { counts[cmd]++; });
+    });
+    double t_find = measure(queries, lookups, [&](const char* s, size_t n) {
+        int i = table.find(s, n);
+        if (i < 0) return 0;
+        counts[i]++;
+        return 1;
+    });
+    double t_trie = measure(queries, lookups, [&](const char* s, size_t n) {
+        int p = trie.search(const_cast<char*>(s), n);
+        if (p) trie[p](nullptr, 0);
+        return p;
+    });
+    double t_map = measure(queries, lookups, [&](const char* s, size_t n) {
+        auto it = map.find(std::string_view(s, n));
+        if (it == map.end()) return 0;
+        counts[it->second]++;
+        return 1;
+    });
+    std::cout << "{\"commands\":" << table.size() << ",\"lookups\":" << lookups
+              << ",\"cmdtable_dispatch_mops\":" << t_table / 1e6 << ",\"cmdtable_find_mops\":" << t_find / 1e6 << ",\"cbtrie_dispatch_mops\":" << t_trie / 1e6
+              << ",\"unordered_map_mops\":" << t_map / 1e6 << "}" << std::endl;
+}
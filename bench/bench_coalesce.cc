@@ -0,0 +1,116 @@
+#include <sys/socket.h>
+#include <thread>
+#include "common.h"
+
+// 每个应答三次写入（头部、正文、尾部）的协议：每个请求的写系统调用数与吞吐
+//   write:     在回调中直接send()三次
+//   immediate: reactor::send()，write_mode::immediate（每次send()立即写出）
+//   coalesce:  reactor::send()，本轮结束时每个连接一次sendmsg
+// 用法: ./bench_coalesce [--connections=64] [--depth=8] [--size=64] [--duration=3] [--port=9160]
+
+namespace {
+
+const size_t req_size = 16;
+const size_t head_size = 16;
+const size_t tail_size = 8;
+
+enum class mode { write, immediate, coalesce };
+
+const char* mode_name(mode m) {
+    return m == mode::write ? "write" : m == mode::immediate ? "immediate" : "coalesce";
+}
+
+void run(mode md, int nconns, int depth, size_t size, double duration, int port) {
+    fnet::reactor server;
+    auto* m = server.enable_metrics();
+    std::string head(head_size, 'h'), body(size, 'b'), tail(tail_size, 't');
+    uint64_t requests = 0, write_calls = 0;
+    bench::conn_table in;
+    server.add_acceptor(bench::listen_on("127.0.0.1", port), [&](int fd) {
+        fnet::utility::set_nonblocking(fd);
+        fnet::utility::set_tcp_nondelay(fd);
+        server.add_socket(fd, fnet::event::readable, fnet::pattern::lt);
+        if (md == mode::immediate) server.set_write_mode(fd, fnet::write_mode::immediate);
+        in[fd].fd = fd;
+    });
+    server.set_readable_cb([&](int fd) {
+        auto& c = in[fd];
+        if (!c.fill()) {
+            server.discard_output(fd);
+            close(fd);
+            c.fd = -1;
+            return;
+        }
+        size_t off = 0;
+        for (; off + req_size <= c.in.size(); off += req_size) {
+            ++requests;
+            if (md == mode::write) {
+                write_calls += 3;
+                if (::send(fd, head.data(), head.size(), MSG_NOSIGNAL) < 0 ||
+                    ::send(fd, body.data(), body.size(), MSG_NOSIGNAL) < 0 ||
+                    ::send(fd, tail.data(), tail.size(), MSG_NOSIGNAL) < 0) {
+                    break;
+                }
+            } else {
+                server.send(fd, head.data(), head.size());
+                server.send(fd, body.data(), body.size());
+                server.send(fd, tail.data(), tail.size());
+            }
+        }
+        c.in.erase(0, off);
+    });
+    std::thread srv([&] { server.activate(); });
+
+    // 客户端：每个连接保持depth个未完成的请求
+    fnet::reactor client;
+    size_t reply_size = head_size + size + tail_size;
+    std::string req(req_size, 'r');
+    bench::conn_table out;
+    uint64_t replies = 0;
+    for (int i = 0; i < nconns; ++i) {
+        int fd = bench::connect_to("127.0.0.1", port);
+        client.add_socket(fd, fnet::event::readable, fnet::pattern::lt);
+        auto& c = out[fd];
+        c.fd = fd;
+        for (int d = 0; d < depth; ++d) c.out += req;
+        c.flush(client);
+    }
+    client.set_writable_cb([&](int fd) { out[fd].flush(client); });
+    client.set_readable_cb([&](int fd) {
+        auto& c = out[fd];
+        c.fill();
+        size_t n = c.in.size() / reply_size;
+        c.in.erase(0, n * reply_size);
+        replies += n;
+        for (size_t i = 0; i < n; ++i) c.out += req;
+        c.flush(client);
+    });
+    uint64_t begin = bench::now_ns();
+    client.run_after(static_cast<int>(duration * 1000), [&] { client.destroy(); });
+    client.activate();
+    double elapsed = (bench::now_ns() - begin) / 1e9;
+    out.for_each([](bench::conn& c) { close(c.fd); });
+    server.post([&] { server.destroy(); });
+    srv.join();
+    in.for_each([](bench::conn& c) { close(c.fd); });
+
+    uint64_t syscalls = md == mode::write ? write_calls : m->send_syscalls.load();
+    std::cout << "{\"mode\":\"" << mode_name(md) << "\",\"connections\":" << nconns << ",\"depth\":" << depth
+              << ",\"size\":" << size << ",\"requests_s\":" << static_cast<uint64_t>(replies / elapsed)
+              << ",\"write_syscalls_per_request\":" << (requests ? static_cast<double>(syscalls) / requests : 0)
+              << "}" << std::endl;
+}
+
+}  // namespace
+
+int main(int argn, char** args) {
+    bench::options opt(argn, args);
+    int nconns = opt.num("connections", 64);
+    int depth = opt.num("depth", 8);
+    size_t size = opt.num("size", 64);
+    double duration = opt.real("duration", 3);
+    int port = opt.num("port", 9160);
+    run(mode::write, nconns, depth, size, duration, port);
+    run(mode::immediate, nconns, depth, size, duration, port + 1);
+    run(mode::coalesce, nconns, depth, size, duration, port + 2);
+}
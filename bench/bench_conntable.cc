@@ -0,0 +1,74 @@
+#include <fastnet/conntable.h>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include "common.h"
+
+// 以fd为键的连接状态：unordered_map / std::set 与 conntable 的查找和遍历吞吐
+// 用法: ./bench_conntable [--conns=10000] [--lookups=20000000] [--sweeps=2000]
+
+namespace {
+
+struct state {
+    uint64_t bytes = 0;
+    uint32_t flags = 0;
+};
+
+template <typename F>
+double measure(long n, F&& f) {
+    uint64_t begin = bench::now_ns();
+    f();
+    return n / ((bench::now_ns() - begin) / 1e9);
+}
+
+}  // namespace
+
+int main(int argn, char** args) {
+    bench::options opt(argn, args);
+    int conns = opt.num("conns", 10000);
+    long lookups = opt.num("lookups", 20000000);
+    long sweeps = opt.num("sweeps", 2000);
+
+    // fd从一个较小的值开始连续分配，中间夹杂已关闭的空洞，与真实进程相近
+    std::vector<int> fds;
+    for (int fd = 16; static_cast<int>(fds.size()) < conns; ++fd) {
+        if (fd % 7 != 0) fds.push_back(fd);
+    }
+    std::unordered_map<int, state> map;
+    std::set<int> set;
+    fnet::conntable<state> table;
+    for (int fd : fds) {
+        map.emplace(fd, state());
+        set.insert(fd);
+        table.emplace(fd, state());
+    }
+    // 事件顺序：随机的fd序列
+    std::vector<int> events(4096);
+    unsigned seed = 12345;
+    for (auto& e : events) e = fds[(seed = seed * 1103515245 + 12345) % fds.size()];
+
+    uint64_t sink = 0;
+    double map_lookup = measure(lookups, [&] {
+        for (long i = 0; i < lookups; ++i) map.find(events[i & 4095])->second.bytes += i;
+    });
+    double table_lookup = measure(lookups, [&] {
+        for (long i = 0; i < lookups; ++i) table.find(events[i & 4095])->bytes += i;
+    });
+    long visits = sweeps * conns;
+    double map_iter = measure(visits, [&] {
+        for (long s = 0; s < sweeps; ++s)
+            for (auto& kv : map) sink += kv.second.bytes;
+    });
+    double set_iter = measure(visits, [&] {
+        for (long s = 0; s < sweeps; ++s)
+            for (int fd : set) sink += fd;
+    });
+    double table_iter = measure(visits, [&] {
+        for (long s = 0; s < sweeps; ++s) table.for_each([&](int, state& st) { sink += st.bytes; });
+    });
+    if (sink == 42) std::cerr << "";  // 防止被优化掉
+    std::cout << "{\"conns\":" << conns << ",\"unordered_map_lookup_mops\":" << map_lookup / 1e6
+              << ",\"conntable_lookup_mops\":" << table_lookup / 1e6
+              << ",\"unordered_map_iterate_mops\":" << map_iter / 1e6 << ",\"set_iterate_mops\":" << set_iter / 1e6
+              << ",\"conntable_iterate_mops\":" << table_iter / 1e6 << "}" << std::endl;
+}
@@ -0,0 +1,119 @@
+#include <fastnet/executor.h>
+#include <sys/socket.h>
+#include <thread>
+#include "common.h"
+
+// 混合负载：少量连接发送CPU密集请求，其余连接发送I/O请求（立即应答）
+// 比较CPU请求在反应堆线程内直接计算与卸载到线程池两种方式下，I/O请求的延迟
+// 用法: ./bench_executor [--cpu-conns=4] [--io-conns=60] [--work-us=200] [--threads=2] [--duration=3]
+
+namespace {
+
+uint64_t burn(long us) {
+    uint64_t end = bench::now_ns() + us * 1000;
+    uint64_t x = 1;
+    while (bench::now_ns() < end) {
+        for (int i = 0; i < 256; ++i) x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+    }
+    return x;
+}
+
+struct result {
+    fnet::histogram::snapshot io;
+    fnet::histogram::snapshot cpu;
+    uint64_t io_done = 0;
+    uint64_t cpu_done = 0;
+};
+
+result run(bool offload, const bench::options& opt) {
+    int cpu_conns = opt.num("cpu-conns", 4);
+    int io_conns = opt.num("io-conns", 60);
+    long work_us = opt.num("work-us", 200);
+    double duration = opt.real("duration", 3);
+
+    fnet::reactor server;
+    fnet::reactor client;
+    fnet::executor pool(opt.num("threads", 2));
+    std::vector<int> client_fds, server_fds;
+    std::vector<char> kind(65536, 0);   // 客户端fd -> 请求类型
+    std::vector<uint64_t> sent_at(65536, 0);
+
+    for (int i = 0; i < cpu_conns + io_conns; ++i) {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == -1) std::abort();
+        fnet::utility::set_nonblocking(sv[0]);
+        fnet::utility::set_nonblocking(sv[1]);
+        server.add_socket(sv[0], fnet::event::readable, fnet::pattern::lt);
+        client.add_socket(sv[1], fnet::event::readable, fnet::pattern::lt);
+        kind[sv[1]] = i < cpu_conns ? 'c' : 'i';
+        server_fds.push_back(sv[0]);
+        client_fds.push_back(sv[1]);
+    }
+
+    server.set_readable_cb([&](int fd) {
+        char req;
+        if (read(fd, &req, 1) != 1) return;
+        if (req == 'i') {
+            if (write(fd, &req, 1) != 1) std::abort();
+        } else if (offload) {
+            pool.submit(server, [work_us] { return burn(work_us); }, [fd](uint64_t) {
+                if (write(fd, "c", 1) != 1) std::abort();
+            });
+        } else {
+            burn(work_us);
+            if (write(fd, "c", 1) != 1) std::abort();
+        }
+    });
+
+    fnet::histogram io_lat, cpu_lat;
+    result res;
+    uint64_t end = bench::now_ns() + static_cast<uint64_t>(duration * 1e9);
+    client.set_readable_cb([&](int fd) {
+        char rsp;
+        if (read(fd, &rsp, 1) != 1) return;
+        uint64_t now = bench::now_ns();
+        if (kind[fd] == 'i') {
+            io_lat.record(now - sent_at[fd]);
+            ++res.io_done;
+        } else {
+            cpu_lat.record(now - sent_at[fd]);
+            ++res.cpu_done;
+        }
+        if (now >= end) {
+            client.destroy();
+            return;
+        }
+        sent_at[fd] = now;
+        if (write(fd, &kind[fd], 1) != 1) std::abort();
+    });
+
+    std::thread srv([&] { server.activate(); });
+    for (int fd : client_fds) {
+        sent_at[fd] = bench::now_ns();
+        if (write(fd, &kind[fd], 1) != 1) std::abort();
+    }
+    client.activate();
+    server.post([&] { server.destroy(); });
+    srv.join();
+
+    auto s = pool.stats();
+    res.io = io_lat.snap();
+    res.cpu = cpu_lat.snap();
+    std::cout << "{\"mode\":\"" << (offload ? "offload" : "inline") << "\",\"io_req_s\":"
+              << static_cast<uint64_t>(res.io_done / duration)
+              << ",\"cpu_req_s\":" << static_cast<uint64_t>(res.cpu_done / duration)
+              << ",\"io_latency_us\":" << bench::latency_json(res.io)
+              << ",\"cpu_latency_us\":" << bench::latency_json(res.cpu) << ",\"executor\":{\"executed\":" << s.executed
+              << ",\"steals\":" << s.steals << ",\"queued\":" << s.queued << "}}" << std::endl;
+    for (int fd : client_fds) close(fd);
+    for (int fd : server_fds) close(fd);
+    return res;
+}
+
+}  // namespace
+
+int main(int argn, char** args) {
+    bench::options opt(argn, args);
+    run(false, opt);
+    run(true, opt);
+}
@@ -0,0 +1,123 @@
+#include <fastnet/sockbuffer.h>
+#include <sys/socket.h>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include "common.h"
+
+// 一个持续灌入数据的重连接与多个乒乓的轻连接共用一个边缘触发的反应堆
+// 比较读空到EAGAIN与设置读预算+推迟处理两种方式下轻连接的延迟
+// 用法: ./bench_fairness [--light=32] [--budget=16384] [--cost=4] [--duration=3]
+//   --cost 服务端每字节的处理轮数，模拟解析开销
+
+namespace {
+
+void run(bool use_budget, const bench::options& opt) {
+    int light = opt.num("light", 32);
+    size_t budget = opt.num("budget", 16384);
+    int cost = opt.num("cost", 4);
+    double duration = opt.real("duration", 3);
+
+    fnet::reactor server;
+    fnet::reactor client;
+    std::vector<std::unique_ptr<fnet::sockbuffer>> bufs(65536);
+    std::vector<int> all_fds, light_fds;
+    int heavy_fd = -1;
+    uint64_t heavy_bytes = 0;
+    volatile uint64_t sink = 0;
+
+    auto make_pair = [&](bool is_heavy) {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == -1) std::abort();
+        fnet::utility::set_nonblocking(sv[0]);
+        bufs[sv[0]].reset(new fnet::sockbuffer(sv[0], 64 * 1024));
+        if (use_budget) bufs[sv[0]]->set_read_budget(budget);
+        server.add_socket(sv[0], fnet::event::readable, fnet::pattern::et);
+        all_fds.push_back(sv[0]);
+        all_fds.push_back(sv[1]);
+        if (is_heavy) {
+            heavy_fd = sv[1];
+        } else {
+            fnet::utility::set_nonblocking(sv[1]);
+            client.add_socket(sv[1], fnet::event::readable, fnet::pattern::lt);
+            light_fds.push_back(sv[1]);
+        }
+    };
+    make_pair(true);
+    for (int i = 0; i < light; ++i) make_pair(false);
+
+    server.set_readable_cb([&](int fd) {
+        auto& sb = *bufs[fd];
+        while (true) {
+            size_t n = sb.readsock();
+            auto view = sb.readtext(n);
+            size_t lights = 0;
+            uint64_t x = 0;
+            for (char c : view) {
+                if (c == 'l') ++lights;
+                for (int k = 0; k < cost; ++k) x = x * 31 + c;
+            }
+            sink = x;
+            if (view.size() != lights) heavy_bytes += view.size();
+            sb.reflush();
+            for (size_t i = 0; i < lights; ++i) {
+                if (write(fd, "l", 1) != 1) break;
+            }
+            if (!sb.has_more()) break;
+            if (use_budget) {
+                server.defer_readable(fd);  // 让出事件循环
+                break;
+            }
+        }
+    });
+
+    std::atomic<bool> stop = {false};
+    std::thread heavy([&] {
+        std::string chunk(64 * 1024, 'h');
+        while (!stop.load()) {
+            if (write(heavy_fd, chunk.data(), chunk.size()) <= 0) break;
+        }
+    });
+    std::thread srv([&] { server.activate(); });
+
+    fnet::histogram lat;
+    std::vector<uint64_t> sent_at(65536, 0);
+    uint64_t end = bench::now_ns() + static_cast<uint64_t>(duration * 1e9);
+    client.set_readable_cb([&](int fd) {
+        char c;
+        if (read(fd, &c, 1) != 1) return;
+        uint64_t now = bench::now_ns();
+        lat.record(now - sent_at[fd]);
+        if (now >= end) {
+            client.destroy();
+            return;
+        }
+        sent_at[fd] = now;
+        if (write(fd, "l", 1) != 1) std::abort();
+    });
+    for (int fd : light_fds) {
+        sent_at[fd] = bench::now_ns();
+        if (write(fd, "l", 1) != 1) std::abort();
+    }
+    client.activate();
+    stop.store(true);
+    server.post([&] { server.destroy(); });
+    srv.join();
+    shutdown(heavy_fd, SHUT_RDWR);
+    heavy.join();
+    for (int fd : all_fds) close(fd);
+
+    auto h = lat.snap();
+    std::cout << "{\"mode\":\"" << (use_budget ? "budget" : "drain") << "\",\"light_conns\":" << light
+              << ",\"light_req_s\":" << static_cast<uint64_t>(h.count / duration)
+              << ",\"heavy_mb_s\":" << heavy_bytes / duration / 1e6
+              << ",\"light_latency_us\":" << bench::latency_json(h) << "}" << std::endl;
+}
+
+}  // namespace
+
+int main(int argn, char** args) {
+    bench::options opt(argn, args);
+    run(false, opt);
+    run(true, opt);
+}
@@ -0,0 +1,186 @@
+#include <fastnet/http.h>
+#include <fastnet/sockbuffer.h>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include "common.h"
+
+// 类似wrk的本地HTTP压测：服务端使用http::parser + http::responder，
+// 客户端每个连接一次发出pipeline个请求，收齐响应后再发下一批
+// 用法: ./bench_http [--port=9180] [--threads=2] [--connections=64] [--pipeline=1] [--duration=3]
+
+namespace {
+
+const char body[] = "Hello, World!";
+const char request_text[] = "GET /plaintext HTTP/1.1\r\nHost: localhost\r\nAccept: text/plain\r\n\r\n";
+const char response_text[] = "HTTP/1.1 200 OK\r\nContent-Length: 13\r\nContent-Type: text/plain\r\n\r\nHello, World!";
+
+struct server_conn {
+    fnet::sockbuffer sb;
+    fnet::http::parser parser;
+    fnet::http::responder out;
+    bool want_write = false;
+    explicit server_conn(int fd) : sb(fd, 64 * 1024) {}
+};
+
+class server {
+    fnet::reactor rec;
+    std::vector<std::unique_ptr<server_conn>> conns;
+
+    void drop(int fd) {
+        conns[fd].reset();
+        close(fd);
+    }
+
+    void flush(int fd, server_conn& c) {
+        if (c.out.flush(fd) < 0) return drop(fd);
+        bool pending = !c.out.empty();
+        if (pending != c.want_write) {
+            c.want_write = pending;
+            auto ev = fnet::event::readable | (pending ? fnet::event::writable : fnet::event::null);
+            rec.reset_event(fd, ev, fnet::pattern::lt);
+        }
+    }
+
+public:
+    explicit server(int port) : conns(65536) {
+        rec.add_acceptor(bench::listen_on("127.0.0.1", port), [this](int fd) {
+            fnet::utility::set_nonblocking(fd);
+            fnet::utility::set_tcp_nondelay(fd);
+            conns[fd].reset(new server_conn(fd));
+            rec.add_socket(fd, fnet::event::readable, fnet::pattern::lt);
+        });
+        rec.set_readable_cb([this](int fd) {
+            auto& c = *conns[fd];
+            if (!c.sb.readsock() && !c.sb.has_more()) return drop(fd);  // 对端关闭
+            fnet::http::request req;
+            fnet::http::status st;
+            bool keep_alive = true;
+            while ((st = c.parser.parse(c.sb.data(), c.sb.pending(), req)) == fnet::http::status::complete) {
+                keep_alive = req.keep_alive;
+                c.out.add_static(200, body, "text/plain", keep_alive);
+                c.sb.consume(c.parser.consumed());
+            }
+            if (st == fnet::http::status::error) {
+                c.out.add(c.parser.error_code(), "", "", false);
+                keep_alive = false;
+            }
+            c.sb.drop_read();
+            flush(fd, c);
+            if (!keep_alive && conns[fd]) drop(fd);
+        });
+        rec.set_writable_cb([this](int fd) { flush(fd, *conns[fd]); });
+        rec.set_disconnect_cb([this](int fd) { drop(fd); });
+    }
+
+    void run() {
+        rec.activate();
+    }
+
+    void stop() {
+        rec.post([this] { rec.destroy(); });
+    }
+};
+
+class client {
+    fnet::reactor rec;
+    std::string batch;
+    size_t depth;
+    std::vector<size_t> received;   // 当前批次已收到的字节数
+    std::vector<uint64_t> sent_at;
+    fnet::histogram latency;
+    uint64_t end_ns = 0;
+    bool checked = false;
+
+    void send_batch(int fd) {
+        sent_at[fd] = bench::now_ns();
+        received[fd] = 0;
+        if (write(fd, batch.data(), batch.size()) != static_cast<ssize_t>(batch.size())) std::abort();
+    }
+
+public:
+    uint64_t responses = 0;
+
+    client(int port, int nconns, size_t pipeline, double duration)
+        : depth(pipeline)
+        , received(65536)
+        , sent_at(65536) {
+        for (size_t i = 0; i < depth; ++i) batch += request_text;
+        std::vector<int> fds;
+        for (int i = 0; i < nconns; ++i) {
+            int fd = bench::connect_to("127.0.0.1", port);
+            rec.add_socket(fd, fnet::event::readable, fnet::pattern::lt);
+            fds.push_back(fd);
+        }
+        size_t resp_len = sizeof(response_text) - 1;
+        rec.set_readable_cb([this, resp_len](int fd) {
+            char buf[65536];
+            auto n = read(fd, buf, sizeof(buf));
+            if (n <= 0) return;
+            if (!checked) {
+                // 确认服务端的响应与预期一致，否则按字节计数没有意义
+                if (n < static_cast<ssize_t>(resp_len) || memcmp(buf, response_text, resp_len) != 0) {
+                    std::cerr << "unexpected response\n";
+                    std::abort();
+                }
+                checked = true;
+            }
+            received[fd] += n;
+            if (received[fd] < resp_len * depth) return;
+            uint64_t now = bench::now_ns();
+            latency.record(now - sent_at[fd]);
+            responses += depth;
+            if (now >= end_ns) {
+                rec.destroy();
+                return;
+            }
+            send_batch(fd);
+        });
+        end_ns = bench::now_ns() + static_cast<uint64_t>(duration * 1e9);
+        for (int fd : fds) send_batch(fd);
+    }
+
+    void run() {
+        rec.activate();
+    }
+
+    fnet::histogram::snapshot snap() const {
+        return latency.snap();
+    }
+};
+
+}  // namespace
+
+int main(int argn, char** args) {
+    bench::options opt(argn, args);
+    int port = opt.num("port", 9180);
+    int threads = opt.num("threads", 2);
+    int connections = opt.num("connections", 64);
+    size_t pipeline = opt.num("pipeline", 1);
+    double duration = opt.real("duration", 3);
+
+    server srv(port);
+    std::thread srv_thread([&] { srv.run(); });
+
+    std::vector<std::unique_ptr<client>> clients;
+    for (int i = 0; i < threads; ++i) {
+        clients.emplace_back(new client(port, connections / threads, pipeline, duration));
+    }
+    uint64_t begin = bench::now_ns();
+    std::vector<std::thread> workers;
+    for (auto& c : clients) workers.emplace_back([&c] { c->run(); });
+    for (auto& w : workers) w.join();
+    double elapsed = (bench::now_ns() - begin) / 1e9;
+    srv.stop();
+    srv_thread.join();
+
+    uint64_t total = 0;
+    fnet::histogram::snapshot lat;
+    for (auto& c : clients) {
+        total += c->responses;
+        lat.merge(c->snap());
+    }
+    std::cout << "{\"threads\":" << threads << ",\"connections\":" << connections << ",\"pipeline\":" << pipeline
+              << ",\"requests\":" << total << ",\"req_s\":" << static_cast<uint64_t>(total / elapsed)
+              << ",\"batch_latency_us\":" << bench::latency_json(lat) << "}" << std::endl;
+}
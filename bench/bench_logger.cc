@@ -0,0 +1,105 @@
+#include <fcntl.h>
+#include <cstdio>
+#include <thread>
+#include "common.h"
+
+// 反应堆线程中每次记录日志的耗时（纳秒），每个定时器周期（1ms）连续记录burst条
+//   cerr:    std::cerr << ...（无缓冲，每次<<一次write）
+//   fprintf: 带缓冲的fprintf
+//   logger:  fnet::logger（FNET_LOG_INFO）
+//   elided:  低于编译期级别的FNET_LOG_DEBUG
+// 输出都写到/dev/null；单次耗时含一次now_ns()（见clock_overhead_ns）
+// 用法: ./bench_logger [--calls=200000] [--burst=256]
+
+namespace {
+
+enum class mode { cerr, fprintf, logger, elided };
+
+const char* mode_name(mode m) {
+    return m == mode::cerr ? "cerr" : m == mode::fprintf ? "fprintf" : m == mode::logger ? "logger" : "elided";
+}
+
+void run(mode md, int calls, int burst, uint64_t overhead) {
+    int null_fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+    int saved = dup(2);
+    dup2(null_fd, 2);
+    FILE* fp = fdopen(dup(null_fd), "w");
+    auto& log = fnet::logger::instance();
+    log.open_fd(null_fd);
+    uint64_t w0 = log.written(), d0 = log.dropped();
+
+    fnet::reactor rec;
+    fnet::histogram lat;
+    std::string peer = "127.0.0.1:50000";
+    int done = 0;
+    uint64_t total_ns = 0;
+    std::function<void()> tick = [&] {
+        for (int i = 0; i < burst && done < calls; ++i, ++done) {
+            int fd = done & 1023;
+            size_t bytes = 64 + (done & 255);
+            uint64_t t0 = bench::now_ns();
+            switch (md) {
+            case mode::cerr:
+                std::cerr << "read fd=" << fd << " bytes=" << bytes << " peer=" << peer << '\n';
+                break;
+            case mode::fprintf:
+                fprintf(fp, "read fd=%d bytes=%zu peer=%s\n", fd, bytes, peer.c_str());
+                break;
+            case mode::logger:
+                FNET_LOG_INFO("read fd={} bytes={} peer={}", fd, bytes, peer);
+                break;
+            case mode::elided:
+                FNET_LOG_DEBUG("read fd={} bytes={} peer={}", fd, bytes, peer);
+                break;
+            }
+            uint64_t d = bench::now_ns() - t0;
+            total_ns += d;
+            lat.record(d > overhead ? d - overhead : 0);
+        }
+        if (done < calls) rec.run_after(1, tick);
+        else rec.destroy();
+    };
+    rec.run_after(1, tick);
+    rec.activate();
+    log.flush();
+    fclose(fp);
+    dup2(saved, 2);
+    close(saved);
+    log.open_fd(2);
+    close(null_fd);
+
+    auto s = lat.snap();
+    std::cout << "{\"mode\":\"" << mode_name(md) << "\",\"calls\":" << calls << ",\"burst\":" << burst
+              << ",\"ns_per_call\":" << static_cast<double>(total_ns) / calls - overhead
+              << ",\"p50_ns\":" << s.percentile(0.5) << ",\"p99_ns\":" << s.percentile(0.99)
+              << ",\"max_ns\":" << s.percentile(1.0);
+    if (md == mode::logger) {
+        std::cout << ",\"written\":" << log.written() - w0 << ",\"dropped\":" << log.dropped() - d0;
+    }
+    std::cout << ",\"clock_overhead_ns\":" << overhead << "}" << std::endl;
+}
+
+// 两次相邻now_ns()之差的最小值，从单次耗时中扣除
+uint64_t clock_overhead() {
+    uint64_t best = UINT64_MAX;
+    for (int i = 0; i < 10000; ++i) {
+        uint64_t t0 = bench::now_ns();
+        best = std::min(best, bench::now_ns() - t0);
+    }
+    return best;
+}
+
+}  // namespace
+
+int main(int argn, char** args) {
+    bench::options opt(argn, args);
+    int calls = opt.num("calls", 200000);
+    int burst = opt.num("burst", 256);
+    uint64_t overhead = clock_overhead();
+    run(mode::cerr, calls, burst, overhead);
+    run(mode::fprintf, calls, burst, overhead);
+    run(mode::logger, calls, burst, overhead);
+    run(mode::elided, calls, burst, overhead);
+    // 突发超过每线程环的容量时丢弃而不阻塞
+    run(mode::logger, calls, burst * 64, overhead);
+}
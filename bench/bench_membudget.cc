@@ -0,0 +1,123 @@
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <fstream>
+#include <thread>
+#include <vector>
+#include "common.h"
+
+// 慢读者洪泛：每个客户端每10毫秒发送一个请求（共--requests个），但只读取--read_kb KB应答；服务端每个请求应答--reply_kb KB
+//   unbounded: 不设内存预算，应答堆积在reactor::send()的队列中
+//   budget:    挂载fnet::mem_budget，超过上限时暂停读取、按占用断开连接
+// 每种模式在单独的子进程中运行，报告进程的峰值RSS（VmHWM）与客户端收到的字节数
+// 用法: ./bench_membudget [--connections=32] [--requests=128] [--reply_kb=64] [--read_kb=4] [--limit_mb=16]
+//                         [--duration=3] [--port=9210]
+
+namespace {
+
+size_t peak_rss_kb() {
+    std::ifstream in("/proc/self/status");
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) return std::stoul(line.substr(6));
+    }
+    return 0;
+}
+
+void run(bool with_budget, int nconns, int requests, size_t reply, size_t read_chunk, size_t limit,
+         double duration, int port) {
+    fnet::mem_budget::options bopt;
+    bopt.global_limit = limit;
+    bopt.conn_limit = limit / 4;
+    fnet::mem_budget budget(bopt);
+    fnet::reactor server;
+    auto* m = server.enable_metrics();
+    if (with_budget) server.set_mem_budget(&budget);
+    server.add_acceptor(bench::listen_on("127.0.0.1", port), [&](int fd) {
+        fnet::utility::set_nonblocking(fd);
+        server.add_socket(fd, fnet::event::readable, fnet::pattern::lt);
+    });
+    std::string body(reply, 'r');
+    size_t peak_queued = 0;
+    std::vector<int> fds;
+    server.set_readable_cb([&](int fd) {
+        char buf[4096];
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n <= 0) return;
+        for (ssize_t i = 0; i < n; ++i) server.send(fd, body);
+        if (fd >= static_cast<int>(fds.size())) fds.resize(fd + 1, 0);
+        fds[fd] = 1;
+    });
+    server.set_disconnect_cb([&](int fd) {
+        server.discard_output(fd);
+        close(fd);
+        if (fd < static_cast<int>(fds.size())) fds[fd] = 0;
+    });
+    // 每10毫秒采样send()队列的总长度
+    std::function<void()> sample = [&] {
+        size_t queued = 0;
+        for (size_t fd = 0; fd < fds.size(); ++fd) {
+            if (fds[fd]) queued += server.pending_output(static_cast<int>(fd));
+        }
+        peak_queued = std::max(peak_queued, queued);
+        server.run_after(10, sample);
+    };
+    server.run_after(10, sample);
+    std::thread srv([&] { server.activate(); });
+
+    std::vector<int> clients;
+    for (int i = 0; i < nconns; ++i) clients.push_back(bench::connect_to("127.0.0.1", port));
+    std::vector<int> sent(nconns, 0);
+    std::vector<char> buf(read_chunk);
+    uint64_t received = 0;
+    int closed = 0;
+    uint64_t end = bench::now_ns() + static_cast<uint64_t>(duration * 1e9);
+    while (bench::now_ns() < end) {
+        for (int i = 0; i < nconns; ++i) {
+            if (clients[i] < 0) continue;
+            if (sent[i] < requests && ::send(clients[i], "x", 1, MSG_NOSIGNAL) == 1) ++sent[i];
+            ssize_t n = read(clients[i], buf.data(), buf.size());
+            if (n > 0) {
+                received += n;
+            } else if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                close(clients[i]);
+                clients[i] = -1;
+                ++closed;
+            }
+        }
+        usleep(10000);
+    }
+    server.post([&] { server.destroy(); });
+    srv.join();
+    for (int fd : clients) {
+        if (fd >= 0) close(fd);
+    }
+
+    std::cout << "{\"mode\":\"" << (with_budget ? "budget" : "unbounded") << "\",\"connections\":" << nconns
+              << ",\"limit_mb\":" << (with_budget ? limit >> 20 : 0)
+              << ",\"peak_rss_mb\":" << peak_rss_kb() / 1024 << ",\"peak_queued_mb\":" << (peak_queued >> 20)
+              << ",\"received_mb\":" << (received >> 20) << ",\"mem_pauses\":" << m->mem_pauses.load()
+              << ",\"mem_sheds\":" << m->mem_sheds.load() << ",\"clients_closed\":" << closed << "}" << std::endl;
+}
+
+}  // namespace
+
+int main(int argn, char** args) {
+    bench::options opt(argn, args);
+    int nconns = opt.num("connections", 32);
+    int requests = opt.num("requests", 128);
+    size_t reply = static_cast<size_t>(opt.num("reply_kb", 64)) << 10;
+    size_t read_chunk = static_cast<size_t>(opt.num("read_kb", 4)) << 10;
+    size_t limit = static_cast<size_t>(opt.num("limit_mb", 16)) << 20;
+    double duration = opt.real("duration", 3);
+    int port = opt.num("port", 9210);
+    // 峰值RSS按进程统计，两种模式分别在子进程中运行
+    for (bool with_budget : {false, true}) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            run(with_budget, nconns, requests, reply, read_chunk, limit, duration, port);
+            _exit(0);
+        }
+        waitpid(pid, nullptr, 0);
+        ++port;
+    }
+}
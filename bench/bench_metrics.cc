@@ -0,0 +1,74 @@
+#include <fastnet/fastnet.h>
+#include <sys/socket.h>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+// 在单个反应堆内用socketpair进行乒乓，比较开启与关闭指标统计时的吞吐
+// 用法: ./bench_metrics [pairs] [messages]
+
+static double run(int pairs, long messages, bool with_metrics) {
+    fnet::reactor rec;
+    if (with_metrics) rec.enable_metrics();
+
+    std::vector<int> peer(pairs * 2 + 1024, -1);
+    std::vector<int> fds;
+    for (int i = 0; i < pairs; ++i) {
+        int sv[2];
+        if (-1 == socketpair(AF_UNIX, SOCK_STREAM, 0, sv)) {
+            std::cerr << "socketpair: " << strerror(errno) << '\n';
+            std::abort();
+        }
+        for (int fd : sv) {
+            fnet::utility::set_nonblocking(fd);
+            if (fd >= static_cast<int>(peer.size())) peer.resize(fd + 1, -1);
+            rec.add_socket(fd, fnet::event::readable, fnet::pattern::lt);
+            fds.push_back(fd);
+        }
+        peer[sv[0]] = sv[1];
+        peer[sv[1]] = sv[0];
+    }
+
+    long handled = 0;
+    rec.set_readable_cb([&](int fd) {
+        char buf[64];
+        auto n = read(fd, buf, sizeof(buf));
+        if (n > 0) n = write(peer[fd], buf, n);
+        if (++handled == messages) rec.destroy();
+    });
+    for (int i = 0; i < pairs; ++i) {
+        if (write(fds[i * 2], "x", 1) != 1) std::abort();
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    rec.activate();
+    auto end = std::chrono::steady_clock::now();
+    for (int fd : fds) close(fd);
+
+    if (with_metrics) {
+        auto s = rec.metrics()->snap();
+        std::cout << "  loop p50/p99 (ns): " << s.loop_time_ns.percentile(0.5) << "/"
+                  << s.loop_time_ns.percentile(0.99) << "  events/wakeup p50: " << s.events_per_wakeup.percentile(0.5)
+                  << '\n';
+    }
+    return handled / std::chrono::duration<double>(end - begin).count();
+}
+
+int main(int argn, char** args) {
+    int pairs = argn > 1 ? atoi(args[1]) : 64;
+    long messages = argn > 2 ? atol(args[2]) : 2000000;
+
+    double best_off = 0, best_on = 0;
+    for (int round = 0; round < 5; ++round) {
+        double off = run(pairs, messages, false);
+        double on = run(pairs, messages, true);
+        best_off = std::max(best_off, off);
+        best_on = std::max(best_on, on);
+        std::cout << "round " << round << ": off " << static_cast<long>(off) << " msg/s, on "
+                  << static_cast<long>(on) << " msg/s\n";
+    }
+    std::cout << "pairs: " << pairs << "  messages: " << messages << '\n';
+    std::cout << "metrics off: " << static_cast<long>(best_off) << " msg/s\n";
+    std::cout << "metrics on : " << static_cast<long>(best_on) << " msg/s\n";
+    std::cout << "overhead   : " << (best_off - best_on) / best_off * 100 << " %\n";
+}
@@ -0,0 +1,137 @@
+#include <sys/socket.h>
+#include <atomic>
+#include <thread>
+#include "common.h"
+
+// 连接分布不均时的尾延迟：多个反应堆，大部分长连接落在反应堆0上，每个请求忙等work_us微秒
+//   static:   连接固定在接收时的反应堆上
+//   balanced: fnet::balancer按利用率把连接迁移到空闲的反应堆，预热之后再统计
+// 客户端为一个反应堆，每个连接一问一答；输出各反应堆处理的请求数与利用率
+// 反应堆数不超过CPU数时才有意义：共用一个CPU的反应堆利用率相近，balancer不会迁移
+// 用法: ./bench_migrate [--reactors=2] [--connections=32] [--hot=0.8] [--work_us=50] [--duration=3]
+
+namespace {
+
+struct settings {
+    int reactors;
+    int connections;
+    double hot;
+    int work_us;
+    double duration;
+};
+
+void run(bool balanced, const settings& s) {
+    std::vector<std::unique_ptr<fnet::reactor>> recs;
+    for (int i = 0; i < s.reactors; ++i) recs.emplace_back(new fnet::reactor);
+    // 每个反应堆自己的连接状态（处理的请求数），迁移时随连接转移
+    std::vector<std::vector<uint64_t>> served(s.reactors);
+    for (int i = 0; i < s.reactors; ++i) {
+        auto& rec = *recs[i];
+        auto& table = served[i];
+        rec.set_readable_cb([&rec, &table, &s](int fd) {
+            char buf[4096];
+            auto n = read(fd, buf, sizeof(buf));
+            if (n <= 0) return;
+            uint64_t until = bench::now_ns() + static_cast<uint64_t>(s.work_us) * 1000;
+            while (bench::now_ns() < until) {}
+            if (fd >= static_cast<int>(table.size())) table.resize(fd + 1, 0);
+            ++table[fd];
+            rec.send(fd, buf, n);
+        });
+        rec.set_migration_cb([&table](int fd) {
+            auto ctx = std::make_shared<uint64_t>(fd < static_cast<int>(table.size()) ? table[fd] : 0);
+            if (fd < static_cast<int>(table.size())) table[fd] = 0;
+            return ctx;
+        }, [&table](int fd, std::shared_ptr<void> ctx) {
+            if (fd >= static_cast<int>(table.size())) table.resize(fd + 1, 0);
+            table[fd] = *std::static_pointer_cast<uint64_t>(ctx);
+        });
+    }
+
+    // 前hot比例的连接放在反应堆0，其余平均分给其他反应堆
+    fnet::reactor client;
+    std::vector<int> local, peers, placement;
+    int nhot = static_cast<int>(s.connections * s.hot);
+    for (int i = 0; i < s.connections; ++i) {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv) == -1) std::abort();
+        int r = i < nhot || s.reactors == 1 ? 0 : 1 + (i - nhot) % (s.reactors - 1);
+        recs[r]->add_socket(sv[0], fnet::event::readable, fnet::pattern::lt);
+        client.add_socket(sv[1], fnet::event::readable, fnet::pattern::lt);
+        local.push_back(sv[0]);
+        peers.push_back(sv[1]);
+    }
+
+    std::vector<fnet::reactor*> ptrs;
+    for (auto& r : recs) ptrs.push_back(r.get());
+    fnet::balancer bal(ptrs);
+    std::vector<std::thread> loops;
+    for (auto& r : recs) loops.emplace_back([&r] { r->activate(); });
+    if (balanced) bal.start();
+
+    fnet::histogram hist;
+    uint64_t requests = 0;
+    bool measuring = !balanced;
+    client.set_readable_cb([&](int fd) {
+        uint64_t t0;
+        if (read(fd, &t0, sizeof(t0)) != sizeof(t0)) return;
+        uint64_t now = bench::now_ns();
+        if (measuring) {
+            hist.record(now - t0);
+            ++requests;
+        }
+        if (write(fd, &now, sizeof(now)) != sizeof(now)) std::abort();
+    });
+    for (int fd : peers) {
+        uint64_t now = bench::now_ns();
+        if (write(fd, &now, sizeof(now)) != sizeof(now)) std::abort();
+    }
+    // 平衡时先预热一秒，之后再开始统计
+    uint64_t warmup = balanced ? 1000 : 0;
+    uint64_t begin = 0;
+    std::vector<uint64_t> busy0(s.reactors), busy1(s.reactors);
+    client.run_after(static_cast<int>(warmup), [&] {
+        measuring = true;
+        begin = bench::now_ns();
+        for (int i = 0; i < s.reactors; ++i) busy0[i] = recs[i]->busy_ns();
+        client.run_after(static_cast<int>(s.duration * 1000), [&] { client.destroy(); });
+    });
+    client.activate();
+    double elapsed = (bench::now_ns() - begin) / 1e9;
+    for (int i = 0; i < s.reactors; ++i) busy1[i] = recs[i]->busy_ns();
+    bal.stop();
+    for (auto& r : recs) {
+        auto* p = r.get();
+        p->post([p] { p->destroy(); });
+    }
+    for (auto& t : loops) t.join();
+    for (int fd : local) close(fd);
+    for (int fd : peers) close(fd);
+
+    std::cout << "{\"mode\":\"" << (balanced ? "balanced" : "static") << "\",\"reactors\":" << s.reactors
+              << ",\"connections\":" << s.connections << ",\"hot\":" << s.hot
+              << ",\"requests_s\":" << static_cast<uint64_t>(requests / elapsed)
+              << ",\"migrations\":" << bal.migrations() << ",\"served\":[";
+    for (int i = 0; i < s.reactors; ++i) {
+        uint64_t sum = 0;
+        for (uint64_t v : served[i]) sum += v;
+        std::cout << (i ? "," : "") << sum;
+    }
+    std::cout << "],\"utilization\":[";
+    for (int i = 0; i < s.reactors; ++i) std::cout << (i ? "," : "") << (busy1[i] - busy0[i]) / (elapsed * 1e9);
+    std::cout << "],\"latency_us\":" << bench::latency_json(hist.snap()) << "}" << std::endl;
+}
+
+}  // namespace
+
+int main(int argn, char** args) {
+    bench::options opt(argn, args);
+    settings s;
+    s.reactors = opt.num("reactors", 2);
+    s.connections = opt.num("connections", 32);
+    s.hot = opt.real("hot", 0.8);
+    s.work_us = opt.num("work_us", 50);
+    s.duration = opt.real("duration", 3);
+    run(false, s);
+    run(true, s);
+}
@@ -0,0 +1,73 @@
+#include <sys/socket.h>
+#include <thread>
+#include "common.h"
+
+// oneshot模式回显的epoll_ctl次数
+// 服务端每个可读事件：读出请求；先打开可写事件等待输出，再尝试直接写出，写完后关闭可写事件，
+// 即每个事件调用两次reset_event()。逐次提交时每次调用都是一次epoll_ctl，合并后每个事件只需一次（重新注册oneshot）
+// 用法: ./bench_oneshot [--connections=64] [--size=64] [--duration=3]
+
+int main(int argn, char** args) {
+    bench::options opt(argn, args);
+    int nconns = opt.num("connections", 64);
+    size_t size = opt.num("size", 64);
+    double duration = opt.real("duration", 3);
+
+    fnet::reactor server, client;
+    auto* m = server.enable_metrics();
+    std::vector<int> local, peers;
+    for (int i = 0; i < nconns; ++i) {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv) == -1) std::abort();
+        local.push_back(sv[0]);
+        peers.push_back(sv[1]);
+        server.add_socket(sv[0], fnet::event::readable, fnet::pattern::lt_oneshot);
+        client.add_socket(sv[1], fnet::event::readable, fnet::pattern::lt);
+    }
+
+    uint64_t resets = 0, requests = 0;
+    auto rearm = [&](int fd, fnet::event_t ev) {
+        server.reset_event(fd, ev, fnet::pattern::lt_oneshot);
+        ++resets;
+    };
+    server.set_readable_cb([&](int fd) {
+        char buf[65536];
+        auto n = read(fd, buf, sizeof(buf));
+        if (n <= 0) {
+            rearm(fd, fnet::event::readable);
+            return;
+        }
+        ++requests;
+        rearm(fd, fnet::event::readable | fnet::event::writable);  // 输出入队，等待可写
+        if (write(fd, buf, n) == n) rearm(fd, fnet::event::readable);  // 已写完
+    });
+    server.set_writable_cb([&](int fd) { rearm(fd, fnet::event::readable); });
+
+    // 客户端：收到应答后立即发送下一个请求
+    std::string msg(size, 'x');
+    client.set_readable_cb([&](int fd) {
+        char buf[65536];
+        if (read(fd, buf, sizeof(buf)) > 0 && write(fd, msg.data(), size) != static_cast<ssize_t>(size)) std::abort();
+    });
+    for (int fd : peers) {
+        if (write(fd, msg.data(), size) != static_cast<ssize_t>(size)) std::abort();
+    }
+    std::thread cl([&] { client.activate(); });
+
+    uint64_t begin = bench::now_ns();
+    server.run_after(static_cast<int>(duration * 1000), [&] { server.destroy(); });
+    server.activate();
+    double elapsed = (bench::now_ns() - begin) / 1e9;
+    client.post([&] { client.destroy(); });
+    cl.join();
+    for (int fd : local) close(fd);
+    for (int fd : peers) close(fd);
+
+    uint64_t ctls = m->epoll_ctls.load() - nconns;  // 不计add_socket()
+    std::cout << "{\"connections\":" << nconns << ",\"requests_s\":" << static_cast<uint64_t>(requests / elapsed)
+              << ",\"reset_event_calls\":" << resets << ",\"epoll_ctl\":" << ctls
+              << ",\"epoll_ctl_saved\":" << m->epoll_ctls_saved.load()
+              << ",\"naive_ctl_per_request\":" << (requests ? static_cast<double>(resets) / requests : 0)
+              << ",\"ctl_per_request\":" << (requests ? static_cast<double>(ctls) / requests : 0) << "}"
+              << std::endl;
+}
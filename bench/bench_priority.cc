@@ -0,0 +1,124 @@
+#include <poll.h>
+#include <sys/socket.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "common.h"
+
+// 批量传输压满反应堆时控制连接的一问一答延迟
+//   fifo:     不设优先级，按epoll_wait返回的顺序处理
+//   priority: 控制连接为high，批量连接为low
+//   budget:   另外限制每轮处理low级别事件的时间
+// 服务端每次读取批量数据后忙等--work微秒模拟处理开销
+// 用法: ./bench_priority [--bulk=16] [--work=50] [--budget=200] [--duration=3] [--port=9200]
+
+namespace {
+
+enum class mode { fifo, priority, budget };
+
+const char* mode_name(mode m) {
+    return m == mode::fifo ? "fifo" : m == mode::priority ? "priority" : "budget";
+}
+
+void busy_for(int us) {
+    uint64_t end = bench::now_ns() + static_cast<uint64_t>(us) * 1000;
+    while (bench::now_ns() < end) {}
+}
+
+void run(mode md, int nbulk, int work_us, int budget_us, double duration, int port) {
+    fnet::reactor server;
+    if (md == mode::budget) server.set_priority_budget(fnet::priority::low, budget_us);
+    std::vector<char> is_ctrl;
+    uint64_t bulk_bytes = 0;
+    auto accept_as = [&](bool ctrl) {
+        return [&, ctrl](int fd) {
+            fnet::utility::set_nonblocking(fd);
+            fnet::utility::set_tcp_nondelay(fd);
+            server.add_socket(fd, fnet::event::readable, fnet::pattern::lt);
+            if (fd >= static_cast<int>(is_ctrl.size())) is_ctrl.resize(fd + 1, 0);
+            is_ctrl[fd] = ctrl;
+            if (md != mode::fifo) server.set_priority(fd, ctrl ? fnet::priority::high : fnet::priority::low);
+        };
+    };
+    server.add_acceptor(bench::listen_on("127.0.0.1", port), accept_as(false));
+    server.add_acceptor(bench::listen_on("127.0.0.1", port + 1), accept_as(true));
+    server.set_readable_cb([&](int fd) {
+        char buf[65536];
+        if (is_ctrl[fd]) {
+            ssize_t n = read(fd, buf, sizeof(buf));
+            if (n > 0) server.send(fd, buf, n);
+            return;
+        }
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n > 0) {
+            bulk_bytes += n;
+            busy_for(work_us);
+        }
+    });
+    server.set_disconnect_cb([&](int fd) { close(fd); });
+    std::thread srv([&] { server.activate(); });
+
+    std::atomic<bool> stop = {false};
+    // 批量发送：每个连接尽可能快地写入
+    std::vector<int> bulk_fds;
+    for (int i = 0; i < nbulk; ++i) bulk_fds.push_back(bench::connect_to("127.0.0.1", port));
+    std::thread bulk([&] {
+        std::string chunk(65536, 'b');
+        std::vector<struct pollfd> pfds;
+        for (int fd : bulk_fds) pfds.push_back({fd, POLLOUT, 0});
+        while (!stop.load(std::memory_order_relaxed)) {
+            if (poll(pfds.data(), pfds.size(), 10) <= 0) continue;
+            for (auto& p : pfds) {
+                if (p.revents & POLLOUT) (void)!::send(p.fd, chunk.data(), chunk.size(), MSG_NOSIGNAL);
+            }
+        }
+    });
+
+    // 控制连接：每200微秒一次8字节的请求，等待回显
+    int ctrl = bench::connect_to("127.0.0.1", port + 1);
+    fnet::histogram rtt;
+    uint64_t begin = bench::now_ns();
+    uint64_t warmup = begin + 500000000;
+    uint64_t end = begin + static_cast<uint64_t>(duration * 1e9);
+    while (bench::now_ns() < end) {
+        uint64_t t0 = bench::now_ns();
+        char msg[8];
+        memcpy(msg, &t0, sizeof(msg));
+        if (::send(ctrl, msg, sizeof(msg), MSG_NOSIGNAL) != sizeof(msg)) break;
+        size_t got = 0;
+        while (got < sizeof(msg)) {
+            struct pollfd p = {ctrl, POLLIN, 0};
+            poll(&p, 1, 100);
+            ssize_t n = read(ctrl, msg + got, sizeof(msg) - got);
+            if (n > 0) got += n;
+        }
+        uint64_t t1 = bench::now_ns();
+        if (t0 >= warmup) rtt.record(t1 - t0);
+        usleep(200);
+    }
+    double elapsed = (bench::now_ns() - begin) / 1e9;
+    stop = true;
+    bulk.join();
+    server.post([&] { server.destroy(); });
+    srv.join();
+    for (int fd : bulk_fds) close(fd);
+    close(ctrl);
+
+    std::cout << "{\"mode\":\"" << mode_name(md) << "\",\"bulk_connections\":" << nbulk << ",\"work_us\":" << work_us
+              << ",\"bulk_mb_s\":" << static_cast<uint64_t>(bulk_bytes / elapsed / 1e6)
+              << ",\"control_rtt_us\":" << bench::latency_json(rtt.snap()) << "}" << std::endl;
+}
+
+}  // namespace
+
+int main(int argn, char** args) {
+    bench::options opt(argn, args);
+    int nbulk = opt.num("bulk", 16);
+    int work = opt.num("work", 50);
+    int budget = opt.num("budget", 200);
+    double duration = opt.real("duration", 3);
+    int port = opt.num("port", 9200);
+    run(mode::fifo, nbulk, work, budget, duration, port);
+    run(mode::priority, nbulk, work, budget, duration, port + 2);
+    run(mode::budget, nbulk, work, budget, duration, port + 4);
+}
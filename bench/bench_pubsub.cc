@@ -0,0 +1,93 @@
+#include <fastnet/pubsub.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <atomic>
+#include <thread>
+#include "common.h"
+
+// 一个主题、大量订阅者的广播：每秒送达的消息数
+// naive: 像原来的聊天室一样，对每个fd逐条write()；hub: fnet::pubsub，共享消息 + 每个订阅者一次writev
+// 用法: ./bench_pubsub [--subscribers=10000] [--size=64] [--burst=8] [--duration=3]
+//   订阅者与接收端各占一个fd，受RLIMIT_NOFILE限制时自动减少订阅者数
+
+namespace {
+
+size_t max_subscribers(size_t want) {
+    struct rlimit rl;
+    getrlimit(RLIMIT_NOFILE, &rl);
+    rl.rlim_cur = rl.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &rl);
+    getrlimit(RLIMIT_NOFILE, &rl);
+    size_t cap = rl.rlim_cur > 64 ? (rl.rlim_cur - 64) / 2 : 0;
+    return want < cap ? want : cap;
+}
+
+void run(bool use_hub, size_t nsubs, size_t size, int burst, double duration) {
+    fnet::reactor server;
+    fnet::reactor reader;
+    fnet::pubsub hub(server);
+    std::vector<int> local, peers;
+    for (size_t i = 0; i < nsubs; ++i) {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv) == -1) std::abort();
+        local.push_back(sv[0]);
+        peers.push_back(sv[1]);
+        server.add_socket(sv[0], fnet::event::readable, fnet::pattern::lt);
+        reader.add_socket(sv[1], fnet::event::readable, fnet::pattern::lt);
+        hub.subscribe("all", sv[0]);
+    }
+    server.set_writable_cb([&](int fd) { hub.on_writable(fd); });
+
+    std::atomic<uint64_t> received = {0};
+    reader.set_readable_cb([&](int fd) {
+        char buf[65536];
+        auto n = read(fd, buf, sizeof(buf));
+        if (n > 0) received.fetch_add(n, std::memory_order_relaxed);
+    });
+    std::thread rd([&] { reader.activate(); });
+
+    std::string msg(size, 'm');
+    uint64_t naive_dropped = 0;
+    uint64_t begin = bench::now_ns();
+    uint64_t end = begin + static_cast<uint64_t>(duration * 1e9);
+    std::function<void()> tick = [&] {
+        for (int b = 0; b < burst; ++b) {
+            if (use_hub) {
+                hub.publish("all", msg.data(), msg.size());
+            } else {
+                for (int fd : local) {
+                    if (write(fd, msg.data(), msg.size()) != static_cast<ssize_t>(msg.size())) ++naive_dropped;
+                }
+            }
+        }
+        if (bench::now_ns() < end) server.post(tick);
+        else server.post([&] { server.destroy(); });
+    };
+    server.post(tick);
+    server.activate();
+    double elapsed = (bench::now_ns() - begin) / 1e9;
+    uint64_t delivered = received.load() / size;  // 截止时刻之前读到的完整消息
+    reader.post([&] { reader.destroy(); });
+    rd.join();
+    for (int fd : local) close(fd);
+    for (int fd : peers) close(fd);
+
+    uint64_t published = use_hub ? hub.stats().published : 0;
+    uint64_t dropped = use_hub ? hub.stats().dropped : naive_dropped;
+    std::cout << "{\"mode\":\"" << (use_hub ? "hub" : "naive") << "\",\"subscribers\":" << nsubs
+              << ",\"size\":" << size << ",\"delivered_msg_s\":" << static_cast<uint64_t>(delivered / elapsed);
+    if (use_hub) std::cout << ",\"published\":" << published;
+    std::cout << ",\"dropped\":" << dropped << "}" << std::endl;
+}
+
+}  // namespace
+
+int main(int argn, char** args) {
+    bench::options opt(argn, args);
+    size_t nsubs = max_subscribers(opt.num("subscribers", 10000));
+    size_t size = opt.num("size", 64);
+    int burst = opt.num("burst", 8);
+    double duration = opt.real("duration", 3);
+    run(false, nsubs, size, burst, duration);
+    run(true, nsubs, size, burst, duration);
+}
@@ -0,0 +1,104 @@
+#include <fastnet/throttle.h>
+#include <sys/socket.h>
+#include "common.h"
+
+// 限速的开销
+//   micro: token_bucket::try_take()、throttle::consume()与admission::admit()/release()每次调用的耗时
+//   event: 多个连接上的小请求，可读回调中逐个请求调用consume()（速率足够高，不会暂停），比较有无限速时每秒处理的事件数
+// 用法: ./bench_ratelimit [--connections=256] [--ops=10000000] [--duration=2]
+
+namespace {
+
+template <typename F>
+double ns_per_op(long ops, F&& f) {
+    uint64_t begin = bench::now_ns();
+    for (long i = 0; i < ops; ++i) f(i);
+    return static_cast<double>(bench::now_ns() - begin) / ops;
+}
+
+void micro(long ops, int nconns) {
+    fnet::token_bucket bucket(1e12, 1e12);
+    uint64_t sink = 0;
+    double bucket_ns = ns_per_op(ops, [&](long i) { sink += bucket.try_take(1, 1000 + i); });
+
+    fnet::reactor rec;
+    fnet::throttle::options topt;
+    topt.conn_rate = 1e12;
+    topt.conn_burst = 1e12;
+    topt.ip_rate = 1e12;
+    topt.ip_burst = 1e12;
+    fnet::throttle thr(rec, topt);
+    for (int fd = 0; fd < nconns; ++fd) thr.add(fd, fd % 64 + 1);
+    double consume_ns = ns_per_op(ops, [&](long i) { sink += thr.consume(static_cast<int>(i % nconns)); });
+
+    fnet::admission::options aopt;
+    aopt.max_conns_per_ip = 1000000;
+    fnet::admission adm(aopt);
+    double admit_ns = ns_per_op(ops, [&](long i) {
+        int fd = static_cast<int>(i % nconns);
+        sink += adm.admit(fd, static_cast<uint64_t>(i % 4096) + 1);
+        adm.release(fd);
+    });
+    std::cout << "{\"mode\":\"micro\",\"bucket_ns\":" << bucket_ns << ",\"consume_ns\":" << consume_ns
+              << ",\"admit_release_ns\":" << admit_ns << ",\"sink\":" << sink % 2 << "}" << std::endl;
+}
+
+void event(bool limited, int nconns, double duration) {
+    fnet::reactor rec;
+    fnet::throttle::options topt;
+    topt.conn_rate = 1e12;
+    topt.conn_burst = 1e12;
+    topt.ip_rate = 1e12;
+    topt.ip_burst = 1e12;
+    fnet::throttle thr(rec, topt);
+    std::vector<int> local, peers;
+    for (int i = 0; i < nconns; ++i) {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv) == -1) std::abort();
+        local.push_back(sv[0]);
+        peers.push_back(sv[1]);
+        rec.add_socket(sv[0], fnet::event::readable, fnet::pattern::lt);
+        if (limited) thr.add(sv[0], i % 64 + 1);
+    }
+    // 每个请求8字节，每次可读事件处理一批
+    uint64_t requests = 0, events = 0;
+    rec.set_readable_cb([&](int fd) {
+        char buf[4096];
+        auto n = read(fd, buf, sizeof(buf));
+        if (n <= 0) return;
+        ++events;
+        for (ssize_t off = 0; off + 8 <= n; off += 8) {
+            if (limited && !thr.consume(fd)) break;
+            ++requests;
+        }
+    });
+    char req[64] = {};
+    uint64_t begin = bench::now_ns();
+    uint64_t end = begin + static_cast<uint64_t>(duration * 1e9);
+    std::function<void()> tick = [&] {
+        for (int fd : peers) {
+            if (write(fd, req, sizeof(req)) <= 0) break;
+        }
+        if (bench::now_ns() < end) rec.post(tick);
+        else rec.post([&] { rec.destroy(); });
+    };
+    rec.post(tick);
+    rec.activate();
+    double elapsed = (bench::now_ns() - begin) / 1e9;
+    for (int fd : local) close(fd);
+    for (int fd : peers) close(fd);
+    std::cout << "{\"mode\":\"" << (limited ? "throttle" : "plain") << "\",\"connections\":" << nconns
+              << ",\"events_s\":" << static_cast<uint64_t>(events / elapsed)
+              << ",\"requests_s\":" << static_cast<uint64_t>(requests / elapsed) << "}" << std::endl;
+}
+
+}  // namespace
+
+int main(int argn, char** args) {
+    bench::options opt(argn, args);
+    int nconns = opt.num("connections", 256);
+    double duration = opt.real("duration", 2);
+    micro(opt.num("ops", 10000000), nconns);
+    event(false, nconns, duration);
+    event(true, nconns, duration);
+}
@@ -0,0 +1,177 @@
+#include <fastnet/resp.h>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include "common.h"
+
+// 类似redis-benchmark的RESP压测：服务端用resp::dispatcher处理PING/SET/GET，
+// 每次读事件处理完缓冲区内全部流水线命令后只写一次；客户端每个连接一次发出pipeline条命令，收齐回复后再发下一批
+// 用法: ./bench_resp [--port=9190] [--connections=50] [--duration=2] [--pipelines=1,16,128]
+
+namespace {
+
+struct server_conn {
+    fnet::sockbuffer sb;
+    fnet::resp::decoder dec;
+    fnet::resp::writer out;
+    bool want_write = false;
+    explicit server_conn(int fd) : sb(fd, 256 * 1024) {}
+};
+
+class server {
+    fnet::reactor rec;
+    fnet::resp::dispatcher cmds;
+    std::unordered_map<std::string, std::string> db;
+    std::vector<std::unique_ptr<server_conn>> conns;
+
+    void drop(int fd) {
+        conns[fd].reset();
+        close(fd);
+    }
+
+    void flush(int fd, server_conn& c) {
+        if (c.out.flush(fd) < 0) return drop(fd);
+        bool pending = !c.out.empty();
+        if (pending != c.want_write) {
+            c.want_write = pending;
+            auto ev = fnet::event::readable | (pending ? fnet::event::writable : fnet::event::null);
+            rec.reset_event(fd, ev, fnet::pattern::lt);
+        }
+    }
+
+public:
+    explicit server(int port) : conns(65536) {
+        cmds.on("ping", [](auto& args, auto& out) {
+            if (args.size() > 1) out.bulk(args[1]);
+            else out.simple("PONG");
+        });
+        cmds.on("set", [this](auto& args, auto& out) {
+            if (args.size() < 3) return (void)out.error("ERR wrong number of arguments for 'set' command");
+            db[std::string(args[1])].assign(args[2].data(), args[2].size());
+            out.simple("OK");
+        });
+        cmds.on("get", [this](auto& args, auto& out) {
+            if (args.size() < 2) return (void)out.error("ERR wrong number of arguments for 'get' command");
+            auto it = db.find(std::string(args[1]));
+            if (it == db.end()) out.null();
+            else out.bulk(it->second);
+        });
+        rec.add_acceptor(bench::listen_on("127.0.0.1", port), [this](int fd) {
+            fnet::utility::set_nonblocking(fd);
+            fnet::utility::set_tcp_nondelay(fd);
+            conns[fd].reset(new server_conn(fd));
+            rec.add_socket(fd, fnet::event::readable, fnet::pattern::lt);
+        });
+        rec.set_readable_cb([this](int fd) {
+            auto& c = *conns[fd];
+            if (!c.sb.readsock() && !c.sb.has_more()) return drop(fd);  // 对端关闭
+            bool ok = cmds.feed(c.sb, c.dec, c.out);
+            flush(fd, c);
+            if (!ok && conns[fd]) drop(fd);
+        });
+        rec.set_writable_cb([this](int fd) { flush(fd, *conns[fd]); });
+        rec.set_disconnect_cb([this](int fd) { drop(fd); });
+    }
+
+    void run() {
+        rec.activate();
+    }
+
+    void stop() {
+        rec.post([this] { rec.destroy(); });
+    }
+};
+
+// 闭环客户端，返回每秒完成的命令数
+double run_client(int port, int nconns, const std::string& cmd, size_t pipeline, double duration,
+                  fnet::histogram& latency) {
+    fnet::reactor rec;
+    std::string batch;
+    for (size_t i = 0; i < pipeline; ++i) batch += cmd;
+    std::vector<std::unique_ptr<fnet::sockbuffer>> bufs(65536);
+    std::vector<fnet::resp::decoder> decs(65536);
+    std::vector<size_t> replies(65536);
+    std::vector<uint64_t> sent_at(65536);
+    std::vector<int> fds;
+    uint64_t done = 0;
+
+    auto send_batch = [&](int fd) {
+        sent_at[fd] = bench::now_ns();
+        replies[fd] = 0;
+        if (write(fd, batch.data(), batch.size()) != static_cast<ssize_t>(batch.size())) std::abort();
+    };
+    for (int i = 0; i < nconns; ++i) {
+        int fd = bench::connect_to("127.0.0.1", port);
+        bufs[fd].reset(new fnet::sockbuffer(fd, 256 * 1024));
+        rec.add_socket(fd, fnet::event::readable, fnet::pattern::lt);
+        fds.push_back(fd);
+    }
+    uint64_t begin = bench::now_ns();
+    uint64_t end = begin + static_cast<uint64_t>(duration * 1e9);
+    rec.set_readable_cb([&](int fd) {
+        auto& sb = *bufs[fd];
+        auto& dec = decs[fd];
+        sb.readsock();
+        while (dec.parse(sb.data(), sb.pending()) == fnet::resp::status::complete) {
+            if (dec.values()[0].t == fnet::resp::type::error) {
+                std::cerr << "error reply: " << dec.values()[0].str << '\n';
+                std::abort();
+            }
+            sb.consume(dec.consumed());
+            ++replies[fd];
+        }
+        sb.drop_read();
+        if (replies[fd] < pipeline) return;
+        uint64_t now = bench::now_ns();
+        latency.record(now - sent_at[fd]);
+        done += pipeline;
+        if (now >= end) return rec.destroy();
+        send_batch(fd);
+    });
+    for (int fd : fds) send_batch(fd);
+    rec.activate();
+    double elapsed = (bench::now_ns() - begin) / 1e9;
+    for (int fd : fds) close(fd);
+    return done / elapsed;
+}
+
+std::string resp_command(std::initializer_list<std::string> args) {
+    std::string s = "*" + std::to_string(args.size()) + "\r\n";
+    for (auto& a : args) s += "$" + std::to_string(a.size()) + "\r\n" + a + "\r\n";
+    return s;
+}
+
+}  // namespace
+
+int main(int argn, char** args) {
+    bench::options opt(argn, args);
+    int port = opt.num("port", 9190);
+    int connections = opt.num("connections", 50);
+    double duration = opt.real("duration", 2);
+    std::string pipelines = opt.str("pipelines", "1,16,128");
+
+    server srv(port);
+    std::thread srv_thread([&] { srv.run(); });
+
+    std::pair<const char*, std::string> tests[] = {
+        {"PING_MBULK", resp_command({"PING"})},
+        {"SET", resp_command({"SET", "key:__rand_int__", "xxx"})},
+        {"GET", resp_command({"GET", "key:__rand_int__"})},
+    };
+    size_t from = 0;
+    while (from < pipelines.size()) {
+        size_t comma = pipelines.find(',', from);
+        if (comma == std::string::npos) comma = pipelines.size();
+        size_t pipeline = std::stoul(pipelines.substr(from, comma - from));
+        from = comma + 1;
+        for (auto& t : tests) {
+            fnet::histogram latency;
+            double ops = run_client(port, connections, t.second, pipeline, duration, latency);
+            std::cout << "{\"test\":\"" << t.first << "\",\"connections\":" << connections
+                      << ",\"pipeline\":" << pipeline << ",\"ops_s\":" << static_cast<uint64_t>(ops)
+                      << ",\"batch_latency_us\":" << bench::latency_json(latency.snap()) << "}" << std::endl;
+        }
+    }
+    srv.stop();
+    srv_thread.join();
+}
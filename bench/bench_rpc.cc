@@ -0,0 +1,90 @@
+#include <sstream>
+#include <thread>
+#include <vector>
+#include "common.h"
+
+// 回环上的fnet::rpc：客户端在若干连接上保持固定数量的未完成调用，服务端回显消息体
+// 报告每秒完成的调用数、延迟分位数，以及两端每次调用的写系统调用数（同一轮的帧合并写出）
+// 用法: ./bench_rpc [--connections=4] [--concurrency=1,16,128,1024] [--size=64] [--duration=2] [--port=9170]
+
+namespace {
+
+void run(int nconns, int concurrency, size_t size, double duration, int port) {
+    fnet::reactor server;
+    auto* sm = server.enable_metrics();
+    fnet::rpc::endpoint srv_ep(server);
+    srv_ep.on(1, [&](const fnet::rpc::call& c, std::string_view body) { srv_ep.reply(c, body); });
+    server.add_acceptor(bench::listen_on("127.0.0.1", port), [&](int fd) {
+        fnet::utility::set_nonblocking(fd);
+        fnet::utility::set_tcp_nondelay(fd);
+        server.add_socket(fd, fnet::event::readable, fnet::pattern::lt);
+        srv_ep.attach(fd);
+    });
+    auto drop = [](fnet::reactor& rec, fnet::rpc::endpoint& ep, int fd) {
+        ep.remove(fd);
+        rec.discard_output(fd);
+        close(fd);
+    };
+    server.set_readable_cb([&](int fd) {
+        if (!srv_ep.on_readable(fd)) drop(server, srv_ep, fd);
+    });
+    server.set_disconnect_cb([&](int fd) { drop(server, srv_ep, fd); });
+    std::thread srv([&] { server.activate(); });
+
+    fnet::reactor client;
+    auto* cm = client.enable_metrics();
+    fnet::rpc::endpoint cli_ep(client);
+    std::vector<int> fds;
+    for (int i = 0; i < nconns; ++i) {
+        int fd = bench::connect_to("127.0.0.1", port);
+        client.add_socket(fd, fnet::event::readable, fnet::pattern::lt);
+        cli_ep.attach(fd);
+        fds.push_back(fd);
+    }
+    client.set_readable_cb([&](int fd) { cli_ep.on_readable(fd); });
+
+    std::string body(size, 'b');
+    fnet::histogram lat;
+    uint64_t completed = 0, errors = 0;
+    bool stopping = false;
+    std::function<void(int)> issue = [&](int fd) {
+        uint64_t t0 = bench::now_ns();
+        cli_ep.invoke(fd, 1, body, [&, fd, t0](fnet::rpc::status s, std::string_view) {
+            if (s != fnet::rpc::status::ok) ++errors;
+            ++completed;
+            lat.record(bench::now_ns() - t0);
+            if (!stopping) issue(fd);
+        });
+    };
+    for (int i = 0; i < concurrency; ++i) issue(fds[i % nconns]);
+    uint64_t begin = bench::now_ns();
+    client.run_after(static_cast<int>(duration * 1000), [&] {
+        stopping = true;
+        client.destroy();
+    });
+    client.activate();
+    double elapsed = (bench::now_ns() - begin) / 1e9;
+    for (int fd : fds) close(fd);
+    server.post([&] { server.destroy(); });
+    srv.join();
+
+    double writes = static_cast<double>(cm->send_syscalls.load() + sm->send_syscalls.load());
+    std::cout << "{\"connections\":" << nconns << ",\"concurrency\":" << concurrency << ",\"size\":" << size
+              << ",\"calls_s\":" << static_cast<uint64_t>(completed / elapsed) << ",\"errors\":" << errors
+              << ",\"write_syscalls_per_call\":" << (completed ? writes / completed : 0)
+              << ",\"latency_us\":" << bench::latency_json(lat.snap()) << "}" << std::endl;
+}
+
+}  // namespace
+
+int main(int argn, char** args) {
+    bench::options opt(argn, args);
+    int nconns = opt.num("connections", 4);
+    std::string levels = opt.str("concurrency", "1,16,128,1024");
+    size_t size = opt.num("size", 64);
+    double duration = opt.real("duration", 2);
+    int port = opt.num("port", 9170);
+    std::stringstream ss(levels);
+    std::string level;
+    while (std::getline(ss, level, ',')) run(nconns, std::stoi(level), size, duration, port++);
+}
@@ -0,0 +1,124 @@
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <atomic>
+#include <thread>
+#include "common.h"
+
+// 同一主机上的单向消息流：生产者线程逐条发送定长消息，消费者为反应堆，比较每秒送达的消息数
+//   tcp:  回环TCP，每条消息一次write()
+//   uds:  UNIX域流套接字，每条消息一次write()
+//   shm:  fnet::shm_ring，消费者空闲时才敲门铃
+// 消息长度为64B与4KB
+// 用法: ./bench_shmring [--duration=2] [--port=9170]
+
+namespace {
+
+struct result {
+    uint64_t messages = 0;
+    double elapsed = 0;
+    uint64_t doorbells = 0;
+};
+
+void print(const char* transport, size_t size, const result& r) {
+    double rate = r.messages / r.elapsed;
+    std::cout << "{\"transport\":\"" << transport << "\",\"size\":" << size
+              << ",\"messages_s\":" << static_cast<uint64_t>(rate) << ",\"mb_s\":" << rate * size / 1e6;
+    if (r.doorbells) std::cout << ",\"doorbells_per_message\":" << static_cast<double>(r.doorbells) / r.messages;
+    std::cout << "}" << std::endl;
+}
+
+void set_blocking(int fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+}
+
+// 生产者写入fd_out直到时间用完后关闭，反应堆在fd_in上读到EOF为止
+result run_socket(int fd_in, int fd_out, size_t size, double duration) {
+    fnet::reactor rec;
+    fnet::utility::set_nonblocking(fd_in);
+    rec.add_socket(fd_in, fnet::event::readable, fnet::pattern::et);
+    uint64_t bytes = 0;
+    auto drain = [&](int fd) {
+        static char buf[1 << 18];
+        ssize_t n;
+        while ((n = read(fd, buf, sizeof(buf))) > 0) bytes += n;
+    };
+    rec.set_readable_cb([&](int fd) { drain(fd); });
+    rec.set_disconnect_cb([&](int fd) {
+        drain(fd);
+        rec.destroy();
+    });
+    uint64_t begin = bench::now_ns();
+    std::thread producer([&] {
+        set_blocking(fd_out);
+        std::string msg(size, 'm');
+        uint64_t until = begin + static_cast<uint64_t>(duration * 1e9);
+        while (bench::now_ns() < until) {
+            for (int i = 0; i < 64; ++i) {
+                if (write(fd_out, msg.data(), size) != static_cast<ssize_t>(size)) std::abort();
+            }
+        }
+        close(fd_out);
+    });
+    rec.activate();
+    producer.join();
+    close(fd_in);
+    result r;
+    r.messages = bytes / size;
+    r.elapsed = (bench::now_ns() - begin) / 1e9;
+    return r;
+}
+
+result run_shm(size_t size, double duration) {
+    fnet::shm_ring ring(1 << 20);
+    fnet::reactor rec;
+    uint64_t messages = 0;
+    rec.add_shm_reader(&ring, [&](const char*, size_t n) {
+        if (n == 0) rec.destroy();  // 结束标记
+        else ++messages;
+    });
+    uint64_t begin = bench::now_ns();
+    result r;
+    std::thread producer([&] {
+        auto tx = ring.share();
+        std::string msg(size, 'm');
+        uint64_t until = begin + static_cast<uint64_t>(duration * 1e9);
+        auto send = [&](const void* p, size_t n) {
+            while (!tx.try_send(p, n)) {
+                struct pollfd pfd = {tx.space_doorbell(), POLLIN, 0};
+                ::poll(&pfd, 1, 10);
+                fnet::shm_ring::clear_doorbell(tx.space_doorbell());
+            }
+        };
+        while (bench::now_ns() < until) {
+            for (int i = 0; i < 64; ++i) send(msg.data(), size);
+        }
+        send("", 0);
+        r.doorbells = tx.doorbells_rung();
+    });
+    rec.activate();
+    producer.join();
+    r.messages = messages;
+    r.elapsed = (bench::now_ns() - begin) / 1e9;
+    return r;
+}
+
+}  // namespace
+
+int main(int argn, char** args) {
+    bench::options opt(argn, args);
+    double duration = opt.real("duration", 2);
+    int port = opt.num("port", 9170);
+    for (size_t size : {static_cast<size_t>(64), static_cast<size_t>(4096)}) {
+        {
+            auto acp = bench::listen_on("127.0.0.1", port);
+            int out = bench::connect_to("127.0.0.1", port++);
+            int in = acp.do_accept();
+            print("tcp", size, run_socket(in, out, size, duration));
+        }
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == -1) std::abort();
+        print("uds", size, run_socket(sv[0], sv[1], size, duration));
+        print("shm", size, run_shm(size, duration));
+    }
+}
@@ -0,0 +1,112 @@
+#include <thread>
+#include <fastnet/tls.h>
+#include "common.h"
+
+// 回环TCP上的单向批量传输，服务端只计数收到的明文字节
+//   plain:     不加密
+//   ktls:      fnet::tls，握手后尝试切换为内核TLS（内核或OpenSSL不支持时回退，见输出中的ktls_tx/ktls_rx）
+//   userspace: fnet::tls，关闭kTLS，在用户态加解密
+// 证书为启动时生成的自签名证书，客户端不校验
+// 用法: ./bench_tls [--connections=1] [--chunk=65536] [--duration=3] [--port=9220]
+
+namespace {
+
+enum class mode { plain, ktls, userspace };
+
+const char* mode_name(mode m) {
+    return m == mode::plain ? "plain" : m == mode::ktls ? "ktls" : "userspace";
+}
+
+void run(mode md, int nconns, size_t chunk, double duration, int port) {
+    fnet::tls::endpoint::options opt;
+    opt.ktls = md == mode::ktls;
+    fnet::reactor server;
+    fnet::tls::endpoint srv_ep(server, fnet::tls::context::self_signed(), opt);
+    uint64_t received = 0;
+    server.add_acceptor(bench::listen_on("127.0.0.1", port), [&](int fd) {
+        fnet::utility::set_nonblocking(fd);
+        server.add_socket(fd, fnet::event::readable, fnet::pattern::lt);
+        if (md != mode::plain) srv_ep.accept(fd);
+    });
+    srv_ep.set_data_cb([&](int, std::string_view data) { received += data.size(); });
+    std::unique_ptr<char[]> buf(new char[256 << 10]);
+    auto drop = [&](int fd) {
+        srv_ep.remove(fd);
+        server.discard_output(fd);
+        close(fd);
+    };
+    server.set_readable_cb([&](int fd) {
+        if (md != mode::plain) {
+            if (!srv_ep.on_readable(fd)) drop(fd);
+            return;
+        }
+        ssize_t n;
+        while ((n = read(fd, buf.get(), 256 << 10)) > 0) received += n;
+        if (n == 0) drop(fd);
+    });
+    server.set_writable_cb([&](int fd) {
+        if (md != mode::plain && !srv_ep.on_writable(fd)) drop(fd);
+    });
+    server.set_disconnect_cb(drop);
+    std::thread srv([&] { server.activate(); });
+
+    fnet::reactor client;
+    fnet::tls::endpoint cli_ep(client, fnet::tls::context::client("", false), opt);
+    std::vector<int> fds;
+    for (int i = 0; i < nconns; ++i) {
+        int fd = bench::connect_to("127.0.0.1", port);
+        client.add_socket(fd, fnet::event::readable, fnet::pattern::lt);
+        if (md != mode::plain) cli_ep.connect(fd);
+        fds.push_back(fd);
+    }
+    client.set_readable_cb([&](int fd) { cli_ep.on_readable(fd); });
+    client.set_writable_cb([&](int fd) { cli_ep.on_writable(fd); });
+    // 每毫秒把每个连接的发送队列补到64个块（4MB），避免补充的频率限制吞吐
+    std::string payload(chunk, 'p');
+    std::function<void()> pump = [&] {
+        for (int fd : fds) {
+            if (md != mode::plain && !cli_ep.ready(fd)) continue;
+            while (client.pending_output(fd) < 64 * chunk) {
+                if (md == mode::plain) client.send(fd, payload);
+                else cli_ep.send(fd, payload);
+            }
+        }
+        client.run_after(1, pump);
+    };
+    client.run_after(0, pump);
+    uint64_t begin = bench::now_ns(), base = 0;
+    // 跳过握手与慢启动
+    client.run_after(200, [&] {
+        begin = bench::now_ns();
+        server.post([&] { base = received; });
+    });
+    client.run_after(200 + static_cast<int>(duration * 1000), [&] { client.destroy(); });
+    client.activate();
+    double elapsed = (bench::now_ns() - begin) / 1e9;
+    uint64_t total = 0;
+    server.post([&] {
+        total = received - base;
+        server.destroy();
+    });
+    srv.join();
+    bool tx = md != mode::plain && cli_ep.ktls_send(fds[0]);
+    bool rx = md != mode::plain && srv_ep.stats().ktls_rx > 0;
+    for (int fd : fds) close(fd);
+
+    std::cout << "{\"mode\":\"" << mode_name(md) << "\",\"connections\":" << nconns << ",\"chunk\":" << chunk
+              << ",\"mb_s\":" << static_cast<uint64_t>(total / elapsed / 1e6) << ",\"ktls_tx\":" << tx
+              << ",\"ktls_rx\":" << rx << "}" << std::endl;
+}
+
+}  // namespace
+
+int main(int argn, char** args) {
+    bench::options opt(argn, args);
+    int nconns = opt.num("connections", 1);
+    size_t chunk = opt.num("chunk", 65536);
+    double duration = opt.real("duration", 3);
+    int port = opt.num("port", 9220);
+    run(mode::plain, nconns, chunk, duration, port);
+    run(mode::ktls, nconns, chunk, duration, port + 1);
+    run(mode::userspace, nconns, chunk, duration, port + 2);
+}
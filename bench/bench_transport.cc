@@ -0,0 +1,126 @@
+#include <sys/un.h>
+#include <thread>
+#include "common.h"
+
+// 同一台机器上不同传输方式的往返延迟：服务端为fastnet反应堆上的回显，客户端阻塞地一问一答
+// 传输方式: tcp(127.0.0.1) tcp6(::1) uds(文件路径) abstract(抽象命名空间) seqpacket(抽象命名空间，SOCK_SEQPACKET)
+// 用法: ./bench_transport [--size=64] [--count=200000] [--port=9140]
+
+namespace {
+
+// 在反应堆线程中回显，直到客户端关闭
+template <typename Protocol>
+void serve(fnet::acceptor<Protocol>&& acp, const std::function<int()>& connect_fn, const char* name, size_t size,
+           long count) {
+    fnet::reactor rec;
+    rec.add_acceptor(std::move(acp), [&](int fd) {
+        fnet::utility::set_nonblocking(fd);
+        rec.add_socket(fd, fnet::event::readable, fnet::pattern::lt);
+    });
+    rec.set_readable_cb([](int fd) {
+        char buf[65536];
+        auto n = read(fd, buf, sizeof(buf));
+        if (n > 0 && write(fd, buf, n) != n) std::abort();
+    });
+    rec.set_disconnect_cb([&](int fd) {
+        close(fd);
+        rec.destroy();
+    });
+    std::thread srv([&] { rec.activate(); });
+
+    int fd = connect_fn();
+    std::string msg(size, 'x'), buf(size, 0);
+    fnet::histogram hist;
+    auto round_trip = [&] {
+        if (write(fd, msg.data(), size) != static_cast<ssize_t>(size)) std::abort();
+        size_t got = 0;
+        while (got < size) {
+            auto n = read(fd, &buf[got], size - got);
+            if (n <= 0) std::abort();
+            got += n;
+        }
+    };
+    for (long i = 0; i < count / 10; ++i) round_trip();  // 预热
+    uint64_t begin = bench::now_ns();
+    for (long i = 0; i < count; ++i) {
+        uint64_t t0 = bench::now_ns();
+        round_trip();
+        hist.record(bench::now_ns() - t0);
+    }
+    double elapsed = (bench::now_ns() - begin) / 1e9;
+    close(fd);
+    srv.join();
+    std::cout << "{\"transport\":\"" << name << "\",\"size\":" << size
+              << ",\"round_trips_s\":" << static_cast<uint64_t>(count / elapsed)
+              << ",\"latency_us\":" << bench::latency_json(hist.snap()) << "}" << std::endl;
+}
+
+// 阻塞的客户端连接
+int connect_addr(int domain, int type, const struct sockaddr* addr, socklen_t len) {
+    int fd = socket(domain, type, 0);
+    if (fd == -1 || -1 == connect(fd, addr, len)) {
+        std::cerr << "connect: " << strerror(errno) << '\n';
+        std::abort();
+    }
+    if (domain != AF_UNIX) {
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    return fd;
+}
+
+int connect_unix(const char* path, int type) {
+    struct sockaddr_un addr;
+    auto len = fnet::details::make_unix_addr(path, addr);
+    return connect_addr(AF_UNIX, type, (struct sockaddr*)&addr, len);
+}
+
+}  // namespace
+
+int main(int argn, char** args) {
+    bench::options opt(argn, args);
+    size_t size = opt.num("size", 64);
+    long count = opt.num("count", 200000);
+    int port = opt.num("port", 9140);
+
+    serve(bench::listen_on("127.0.0.1", port), [&] {
+        struct sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+        return connect_addr(AF_INET, SOCK_STREAM, (struct sockaddr*)&addr, sizeof(addr));
+    }, "tcp", size, count);
+
+    fnet::acceptor<fnet::protocol::tcp6> acp6;
+    fnet::utility::set_reuse_address(acp6.get_fd());
+    acp6.do_bind("::1", port + 1);
+    acp6.do_listen();
+    serve(std::move(acp6), [&] {
+        struct sockaddr_in6 addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin6_family = AF_INET6;
+        addr.sin6_port = htons(port + 1);
+        inet_pton(AF_INET6, "::1", &addr.sin6_addr);
+        return connect_addr(AF_INET6, SOCK_STREAM, (struct sockaddr*)&addr, sizeof(addr));
+    }, "tcp6", size, count);
+
+    const char* path = "/tmp/fastnet_bench_transport.sock";
+    fnet::acceptor<fnet::protocol::uds> uds;
+    uds.do_bind(path);
+    uds.do_listen();
+    serve(std::move(uds), [&] { return connect_unix(path, SOCK_STREAM); }, "uds", size, count);
+    unlink(path);
+
+    fnet::acceptor<fnet::protocol::uds> abs;
+    abs.do_bind("@fastnet_bench_transport");
+    abs.do_listen();
+    serve(std::move(abs), [&] { return connect_unix("@fastnet_bench_transport", SOCK_STREAM); }, "abstract", size,
+          count);
+
+    fnet::acceptor<fnet::protocol::uds_seqpacket> seq;
+    seq.do_bind("@fastnet_bench_transport_seq");
+    seq.do_listen();
+    serve(std::move(seq), [&] { return connect_unix("@fastnet_bench_transport_seq", SOCK_SEQPACKET); },
+          "seqpacket", size, count);
+}
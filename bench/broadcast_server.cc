@@ -0,0 +1,49 @@
+#include "common.h"
+
+// 广播服务器: 把每条定长消息转发给所有连接（包括发送方）
+// 用法: ./broadcast_server [--host=127.0.0.1] [--port=9101] [--size=64]
+
+int main(int argn, char** args) {
+    bench::options opt(argn, args);
+    auto host = opt.str("host", "127.0.0.1");
+    int port = opt.num("port", 9101);
+    size_t size = opt.num("size", 64);
+
+    fnet::reactor rec;
+    bench::conn_table conns;
+    std::vector<int> alive;
+    rec.add_acceptor(bench::listen_on(host, port), [&](int fd) {
+        fnet::utility::set_nonblocking(fd);
+        fnet::utility::set_tcp_nondelay(fd);
+        conns[fd].fd = fd;
+        alive.push_back(fd);
+        rec.add_socket(fd, fnet::event::readable, fnet::pattern::lt);
+    });
+    auto drop = [&](int fd) {
+        close(fd);
+        conns[fd] = bench::conn();
+        for (auto& each : alive) {
+            if (each == fd) {
+                each = alive.back();
+                alive.pop_back();
+                break;
+            }
+        }
+    };
+    rec.set_readable_cb([&](int fd) {
+        auto& c = conns[fd];
+        bool ok = c.fill();
+        size_t whole = c.in.size() / size * size;
+        if (whole) {
+            for (int each : alive) conns[each].out.append(c.in, 0, whole);
+            c.in.erase(0, whole);
+            for (int each : alive) conns[each].flush(rec);
+        }
+        if (!ok) drop(fd);
+    });
+    rec.set_writable_cb([&](int fd) { conns[fd].flush(rec); });
+    rec.set_disconnect_cb(drop);
+    bench::exit_on_sigint(rec);
+    std::cerr << "broadcast server on " << host << ":" << port << '\n';
+    rec.activate();
+}
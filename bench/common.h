@@ -0,0 +1,153 @@
+#pragma once
+#include <fastnet/fastnet.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+// 基准测试程序共用的工具：参数解析、带输出缓冲的连接、消息头与JSON报告
+
+namespace bench {
+
+inline uint64_t now_ns() {
+    return fnet::details::now_ns();
+}
+
+// 解析 --key=value 形式的参数
+class options {
+    std::map<std::string, std::string> kv;
+public:
+    options(int argn, char** args) {
+        for (int i = 1; i < argn; ++i) {
+            std::string a(args[i]);
+            if (a.compare(0, 2, "--") != 0) continue;
+            auto eq = a.find('=');
+            if (eq == a.npos) kv[a.substr(2)] = "1";
+            else kv[a.substr(2, eq - 2)] = a.substr(eq + 1);
+        }
+    }
+    std::string str(const char* key, const char* def) const {
+        auto it = kv.find(key);
+        return it == kv.end() ? def : it->second;
+    }
+    long num(const char* key, long def) const {
+        auto it = kv.find(key);
+        return it == kv.end() ? def : atol(it->second.c_str());
+    }
+    double real(const char* key, double def) const {
+        auto it = kv.find(key);
+        return it == kv.end() ? def : atof(it->second.c_str());
+    }
+};
+
+// 每条消息的头部，消息长度不小于头部长度
+struct msg_header {
+    uint64_t ts;     // 发送（或计划发送）时间，CLOCK_MONOTONIC纳秒，跨进程可比
+    uint32_t conn;   // 发送方连接编号
+    uint32_t seq;
+};
+
+// 带输出缓冲的连接，写不完的内容暂存并等待可写事件
+struct conn {
+    int fd = -1;
+    std::string in;
+    std::string out;
+    size_t out_off = 0;
+    bool want_write = false;
+
+    // 尽量写出缓冲中的内容，必要时切换可写事件的监听
+    void flush(fnet::reactor& rec) {
+        while (out_off < out.size()) {
+            auto n = write(fd, out.data() + out_off, out.size() - out_off);
+            if (n <= 0) break;
+            out_off += n;
+        }
+        if (out_off == out.size()) {
+            out.clear();
+            out_off = 0;
+        }
+        bool pending = !out.empty();
+        if (pending != want_write) {
+            want_write = pending;
+            auto ev = fnet::event::readable | (pending ? fnet::event::writable : fnet::event::null);
+            rec.reset_event(fd, ev, fnet::pattern::lt);
+        }
+    }
+
+    // 读空socket，追加到输入缓冲；返回false表示连接已关闭
+    bool fill() {
+        char buf[16384];
+        while (true) {
+            auto n = read(fd, buf, sizeof(buf));
+            if (n > 0) in.append(buf, n);
+            else if (n == 0) return false;
+            else return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+    }
+};
+
+// fd索引的连接表
+class conn_table {
+    std::vector<conn> conns;
+public:
+    conn& operator[](int fd) {
+        if (fd >= static_cast<int>(conns.size())) conns.resize(fd + 1);
+        return conns[fd];
+    }
+    template <typename F>
+    void for_each(F&& f) {
+        for (auto& c : conns) if (c.fd >= 0) f(c);
+    }
+};
+
+// 绑定并监听，失败时退出
+inline fnet::acceptor<fnet::protocol::tcp> listen_on(const std::string& host, int port) {
+    fnet::acceptor<fnet::protocol::tcp> acp;
+    fnet::utility::set_reuse_address(acp.get_fd());
+    acp.do_bind(host.c_str(), port);
+    acp.do_listen(4096);
+    return acp;
+}
+
+// 建立到host:port的TCP连接（阻塞连接后设为非阻塞并关闭Nagle），失败时退出
+inline int connect_to(const std::string& host, int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, host.c_str(), &addr.sin_addr);
+    if (fd == -1 || -1 == connect(fd, (struct sockaddr*)&addr, sizeof(addr))) {
+        std::cerr << "connect: " << strerror(errno) << '\n';
+        std::abort();
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    fnet::utility::set_nonblocking(fd);
+    return fd;
+}
+
+// 打印直方图的JSON片段（单位：微秒）
+inline std::string latency_json(const fnet::histogram::snapshot& h) {
+    auto us = [](uint64_t ns) { return std::to_string(ns / 1000.0); };
+    return std::string("{") + "\"p50\":" + us(h.percentile(0.5)) + ",\"p90\":" + us(h.percentile(0.9)) +
+           ",\"p99\":" + us(h.percentile(0.99)) + ",\"p999\":" + us(h.percentile(0.999)) +
+           ",\"max\":" + us(h.percentile(1.0)) + ",\"mean\":" + us(static_cast<uint64_t>(h.mean())) + "}";
+}
+
+// 服务端公共部分：SIGINT时退出
+inline void exit_on_sigint(fnet::reactor& rec) {
+    auto flow = fnet::sigflow::instance();
+    flow->add_signal(SIGINT, [&rec] { rec.destroy(); });
+    flow->add_signal(SIGTERM, [&rec] { rec.destroy(); });
+    rec.add_sigflow(flow);
+}
+
+}  // namespace bench
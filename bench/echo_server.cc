@@ -0,0 +1,38 @@
+#include "common.h"
+
+// 回显服务器: 原样返回收到的字节
+// 用法: ./echo_server [--host=127.0.0.1] [--port=9100]
+
+int main(int argn, char** args) {
+    bench::options opt(argn, args);
+    auto host = opt.str("host", "127.0.0.1");
+    int port = opt.num("port", 9100);
+
+    fnet::reactor rec;
+    bench::conn_table conns;
+    rec.add_acceptor(bench::listen_on(host, port), [&](int fd) {
+        fnet::utility::set_nonblocking(fd);
+        fnet::utility::set_tcp_nondelay(fd);
+        conns[fd].fd = fd;
+        rec.add_socket(fd, fnet::event::readable, fnet::pattern::lt);
+    });
+    rec.set_readable_cb([&](int fd) {
+        auto& c = conns[fd];
+        bool alive = c.fill();
+        c.out.append(c.in);
+        c.in.clear();
+        c.flush(rec);
+        if (!alive) {
+            close(fd);
+            c = bench::conn();
+        }
+    });
+    rec.set_writable_cb([&](int fd) { conns[fd].flush(rec); });
+    rec.set_disconnect_cb([&](int fd) {
+        close(fd);
+        conns[fd] = bench::conn();
+    });
+    bench::exit_on_sigint(rec);
+    std::cerr << "echo server on " << host << ":" << port << '\n';
+    rec.activate();
+}
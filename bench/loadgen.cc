@@ -0,0 +1,206 @@
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include "common.h"
+
+// 基于fastnet的多线程压测客户端，结果以JSON输出到stdout
+//
+// 用法: ./loadgen [--host=127.0.0.1] [--port=9100] [--threads=2] [--connections=64]
+//                 [--size=64] [--resp-size=<size>] [--depth=1] [--rate=0]
+//                 [--duration=5] [--warmup=1] [--server=echo]
+//   --depth     闭环模式下每个连接同时在途的请求数（流水线深度）
+//   --rate      >0 时为开环模式，所有连接合计每秒发送的消息数；延迟从计划发送时间算起，避免协同遗漏
+//   --resp-size 每个应答的长度，回显与广播时与--size相同
+//   --server    仅写入报告，用于标识被测服务
+
+namespace {
+
+struct config {
+    std::string host;
+    int port;
+    int threads;
+    int connections;
+    size_t size;
+    size_t resp_size;
+    int depth;
+    double rate;
+    double duration;
+    double warmup;
+};
+
+// 单个压测线程，持有自己的反应堆与一组连接
+class worker {
+    const config& cfg;
+    fnet::reactor rec;
+    bench::conn_table conns;
+    std::vector<int> fds;
+    std::vector<uint32_t> ids;      // fd -> 连接编号
+    std::vector<uint32_t> seqs;
+    fnet::histogram latency;
+    uint64_t begin_ns = 0;
+    uint64_t measure_ns = 0;        // 预热结束时间
+    uint64_t end_ns = 0;
+    uint64_t interval_ns = 0;       // 开环模式下每个连接的发送间隔
+    std::vector<uint64_t> next_send;
+
+public:
+    uint64_t received = 0;          // 计入统计的应答数
+    uint64_t sent = 0;
+
+    worker(const config& cfg, int first_id, int nconns)
+        : cfg(cfg) {
+        for (int i = 0; i < nconns; ++i) {
+            int fd = connect_to();
+            fds.push_back(fd);
+            if (fd >= static_cast<int>(ids.size())) ids.resize(fd + 1);
+            ids[fd] = first_id + i;
+            conns[fd].fd = fd;
+            rec.add_socket(fd, fnet::event::readable, fnet::pattern::lt);
+        }
+        seqs.resize(ids.size());
+        if (cfg.rate > 0 && nconns) {
+            interval_ns = static_cast<uint64_t>(1e9 * cfg.connections / cfg.rate);
+        }
+        rec.set_readable_cb([this](int fd) { on_readable(fd); });
+        rec.set_writable_cb([this](int fd) { conns[fd].flush(rec); });
+        rec.set_disconnect_cb([this](int) {
+            std::cerr << "connection closed by server\n";
+            std::abort();
+        });
+        rec.set_timeout(1, [this] { pump(); });
+    }
+
+    ~worker() {
+        for (int fd : fds) close(fd);
+    }
+
+    void run() {
+        begin_ns = bench::now_ns();
+        measure_ns = begin_ns + static_cast<uint64_t>(cfg.warmup * 1e9);
+        end_ns = measure_ns + static_cast<uint64_t>(cfg.duration * 1e9);
+        if (interval_ns) {
+            // 错开各连接的首次发送
+            for (size_t i = 0; i < fds.size(); ++i) next_send.push_back(begin_ns + interval_ns * i / fds.size());
+        } else {
+            for (int fd : fds) {
+                for (int d = 0; d < cfg.depth; ++d) send_one(fd, bench::now_ns());
+                conns[fd].flush(rec);
+            }
+        }
+        if (!fds.empty()) rec.activate();
+    }
+
+    fnet::histogram::snapshot snap() const {
+        return latency.snap();
+    }
+
+private:
+    int connect_to() {
+        return bench::connect_to(cfg.host, cfg.port);
+    }
+
+    void send_one(int fd, uint64_t ts) {
+        auto& c = conns[fd];
+        bench::msg_header h{ts, ids[fd], seqs[fd]++};
+        size_t off = c.out.size();
+        c.out.resize(off + cfg.size, 'q');
+        std::memcpy(&c.out[off], &h, sizeof(h));
+        ++sent;
+    }
+
+    void on_readable(int fd) {
+        auto& c = conns[fd];
+        if (!c.fill()) {
+            std::cerr << "connection closed by server\n";
+            std::abort();
+        }
+        uint64_t now = bench::now_ns();
+        size_t off = 0;
+        int own = 0;
+        for (; off + cfg.resp_size <= c.in.size(); off += cfg.resp_size) {
+            bench::msg_header h;
+            std::memcpy(&h, &c.in[off], sizeof(h));
+            if (now >= measure_ns) {
+                latency.record(now - h.ts);
+                ++received;
+            }
+            if (h.conn == ids[fd]) ++own;
+        }
+        c.in.erase(0, off);
+        if (!interval_ns) {
+            for (int i = 0; i < own; ++i) send_one(fd, now);
+            c.flush(rec);
+        }
+        pump();
+    }
+
+    // 开环模式下发送到期的消息，并检查是否结束
+    void pump() {
+        uint64_t now = bench::now_ns();
+        if (now >= end_ns) {
+            rec.destroy();
+            return;
+        }
+        if (!interval_ns) return;
+        for (size_t i = 0; i < fds.size(); ++i) {
+            bool due = false;
+            while (next_send[i] <= now) {
+                send_one(fds[i], next_send[i]);
+                next_send[i] += interval_ns;
+                due = true;
+            }
+            if (due) conns[fds[i]].flush(rec);
+        }
+    }
+};
+
+}  // namespace
+
+int main(int argn, char** args) {
+    bench::options opt(argn, args);
+    config cfg;
+    cfg.host = opt.str("host", "127.0.0.1");
+    cfg.port = opt.num("port", 9100);
+    cfg.threads = opt.num("threads", 2);
+    cfg.connections = opt.num("connections", 64);
+    cfg.size = opt.num("size", 64);
+    cfg.resp_size = opt.num("resp-size", cfg.size);
+    cfg.depth = opt.num("depth", 1);
+    cfg.rate = opt.real("rate", 0);
+    cfg.duration = opt.real("duration", 5);
+    cfg.warmup = opt.real("warmup", 1);
+    if (cfg.size < sizeof(bench::msg_header) || cfg.resp_size < sizeof(bench::msg_header)) {
+        std::cerr << "message size must be at least " << sizeof(bench::msg_header) << '\n';
+        return 1;
+    }
+    if (cfg.threads < 1) cfg.threads = 1;
+
+    std::vector<std::unique_ptr<worker>> workers;
+    for (int t = 0, first = 0; t < cfg.threads; ++t) {
+        int n = cfg.connections / cfg.threads + (t < cfg.connections % cfg.threads);
+        workers.emplace_back(new worker(cfg, first, n));
+        first += n;
+    }
+    std::vector<std::thread> thrds;
+    for (auto& w : workers) thrds.emplace_back(&worker::run, w.get());
+    for (auto& t : thrds) t.join();
+
+    fnet::histogram::snapshot all;
+    uint64_t received = 0, sent = 0;
+    for (auto& w : workers) {
+        all.merge(w->snap());
+        received += w->received;
+        sent += w->sent;
+    }
+    double tput = received / cfg.duration;
+    std::cout << "{\"server\":\"" << opt.str("server", "echo") << "\""
+              << ",\"mode\":\"" << (cfg.rate > 0 ? "open" : "closed") << "\""
+              << ",\"threads\":" << cfg.threads << ",\"connections\":" << cfg.connections
+              << ",\"size\":" << cfg.size << ",\"resp_size\":" << cfg.resp_size << ",\"depth\":" << cfg.depth
+              << ",\"rate\":" << cfg.rate << ",\"duration_s\":" << cfg.duration << ",\"sent\":" << sent
+              << ",\"received\":" << received << ",\"throughput_msg_s\":" << static_cast<uint64_t>(tput)
+              << ",\"throughput_mb_s\":" << tput * cfg.resp_size / 1e6
+              << ",\"latency_us\":" << bench::latency_json(all) << "}" << std::endl;
+}
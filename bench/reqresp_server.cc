@@ -0,0 +1,54 @@
+#include "common.h"
+
+// 请求/应答服务器: 每个定长请求返回一个定长应答，应答头部沿用请求的头部
+// --work 为每个请求额外计算的轮数，用于模拟处理耗时
+// 用法: ./reqresp_server [--host=127.0.0.1] [--port=9102] [--size=64] [--resp-size=256] [--work=0]
+
+int main(int argn, char** args) {
+    bench::options opt(argn, args);
+    auto host = opt.str("host", "127.0.0.1");
+    int port = opt.num("port", 9102);
+    size_t size = opt.num("size", 64);
+    size_t resp_size = opt.num("resp-size", 256);
+    long work = opt.num("work", 0);
+    if (size < sizeof(bench::msg_header) || resp_size < sizeof(bench::msg_header)) {
+        std::cerr << "message size must be at least " << sizeof(bench::msg_header) << '\n';
+        return 1;
+    }
+
+    fnet::reactor rec;
+    bench::conn_table conns;
+    std::string resp(resp_size, 'r');
+    rec.add_acceptor(bench::listen_on(host, port), [&](int fd) {
+        fnet::utility::set_nonblocking(fd);
+        fnet::utility::set_tcp_nondelay(fd);
+        conns[fd].fd = fd;
+        rec.add_socket(fd, fnet::event::readable, fnet::pattern::lt);
+    });
+    rec.set_readable_cb([&](int fd) {
+        auto& c = conns[fd];
+        bool alive = c.fill();
+        size_t off = 0;
+        for (; off + size <= c.in.size(); off += size) {
+            uint64_t sum = 0;
+            for (long i = 0; i < work; ++i) sum = sum * 31 + c.in[off + i % size];
+            resp.replace(0, sizeof(bench::msg_header), c.in, off, sizeof(bench::msg_header));
+            resp.back() = static_cast<char>(sum);
+            c.out.append(resp);
+        }
+        c.in.erase(0, off);
+        c.flush(rec);
+        if (!alive) {
+            close(fd);
+            c = bench::conn();
+        }
+    });
+    rec.set_writable_cb([&](int fd) { conns[fd].flush(rec); });
+    rec.set_disconnect_cb([&](int fd) {
+        close(fd);
+        conns[fd] = bench::conn();
+    });
+    bench::exit_on_sigint(rec);
+    std::cerr << "reqresp server on " << host << ":" << port << '\n';
+    rec.activate();
+}
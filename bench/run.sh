@@ -0,0 +1,23 @@
+#!/bin/sh
+# 在本机回环地址上依次运行各个服务端与压测客户端，每行输出一个JSON结果
+# 用法: ./run.sh [build目录]   (默认 ./build)
+set -e
+BIN=${1:-./build}
+DURATION=${DURATION:-5}
+
+run() {
+    server=$1; port=$2; shift 2
+    "$BIN/$server" --port="$port" "$@" 2>/dev/null &
+    pid=$!
+    sleep 0.5
+    "$BIN/loadgen" --port="$port" --server="$server" --duration="$DURATION" $LOADGEN_ARGS
+    kill -INT $pid
+    wait $pid 2>/dev/null || true
+}
+
+LOADGEN_ARGS="--connections=64 --depth=1"                 run echo_server 9100
+LOADGEN_ARGS="--connections=64 --depth=16"                run echo_server 9100
+LOADGEN_ARGS="--connections=64 --rate=50000"              run echo_server 9100
+LOADGEN_ARGS="--connections=64 --size=4096"               run echo_server 9100
+LOADGEN_ARGS="--connections=16 --depth=1"                 run broadcast_server 9101
+LOADGEN_ARGS="--connections=64 --resp-size=256 --depth=4" run reqresp_server 9102 --resp-size=256
@@ -1,12 +1,12 @@
 #include <fastnet/fastnet.h>
-#include <set>
+#include <fastnet/pubsub.h>
+#include <fastnet/conntable.h>
 #include <cstdlib>
 #include <iostream>
 #include <vector>
 #include <string>
 #define TICK_TVAL 10
 
-std::set<int> alive_fds; 
 const char* prefix[5] = { "AG_", "QG_", "ES_", "TG_", "DR_"};
 
 int main(int argn, char** args) {
@@ -28,22 +28,31 @@ int main(int argn, char** args) {
 
     // 创建反应堆并添加套接字
     fnet::reactor rec;
-    rec.add_acceptor(std::move(acp), [&rec, &mesg, widx](int fd){
+    // 所有连接订阅同一个主题，由pubsub负责转发，慢的客户端只丢弃消息而不阻塞其他人
+    fnet::pubsub hub(rec);
+    // 每个连接的名称，以fd为下标
+    fnet::conntable<std::string> names;
+    rec.add_acceptor(std::move(acp), [&rec, &hub, &names, &mesg, widx](int fd){
         // 非阻塞IO + epoll的LT触发模式
         fnet::utility::set_nonblocking(fd);
         rec.add_socket(fd, fnet::event::readable, fnet::pattern::lt); 
-        alive_fds.emplace(fd); // 用集合保存fd
-        std::cout<<"connect: "<<fd<<std::endl;
-        // send: You name is: what  
+        hub.subscribe("chat", fd); // 订阅聊天室主题
         constexpr int num = sizeof(prefix) / sizeof(char*);
+        names.emplace(fd, std::string("-> ") + prefix[fd % num] + std::to_string(fd) + ": ");
+        FNET_LOG_INFO("connect: {}", fd);
+        // send: You name is: what  
         int wlen = snprintf(mesg+widx, 64-widx, "%s%d]\n",  prefix[fd % num], fd);
         mesg[widx + wlen] = '\0';
         write(fd, mesg, widx + wlen + 1);
 
     });
-    rec.set_disconnect_cb([](int fd){
+    rec.set_disconnect_cb([&hub, &names](int fd){
+        hub.remove(fd);
+        names.erase(fd);
         close(fd);
-        alive_fds.erase(fd);
+    });
+    rec.set_writable_cb([&hub](int fd){
+        hub.on_writable(fd);
     });
 
     // =============
@@ -51,16 +60,15 @@ int main(int argn, char** args) {
     // =============
     // 通过中断信号主动关闭服务器
     fnet::sigflow* pflow = fnet::sigflow::instance();
-    pflow->add_signal(SIGINT, [&rec]{
-        for (auto fd: alive_fds) {
-            write(fd, "The Server was closed...\n", 26);
-        } 
+    pflow->add_signal(SIGINT, [&rec, &hub]{
+        hub.publish("chat", "The Server was closed...\n", 26);
+        hub.flush();
         rec.destroy();
-        std::cout<<"\n";
+        fnet::logger::instance().flush();
     });
     // 通过定时中断实现单线程定时器
-    pflow->add_signal(SIGALRM, []{
-        std::cout<<"Online: "<<alive_fds.size()<<std::endl;
+    pflow->add_signal(SIGALRM, [&hub]{
+        FNET_LOG_INFO("Online: {}", hub.subscribers("chat"));
         alarm(TICK_TVAL); // 每TIME_SHOT秒发送一次
     });
     // 将信号流交由反应堆统一处理
@@ -69,31 +77,24 @@ int main(int argn, char** args) {
     // =================
     //     业务逻辑
     // =================    
-    rec.set_readable_cb([](int fd)
+    rec.set_readable_cb([&hub, &names](int fd)
     {
-        // prepare the name
-        constexpr int num = sizeof(prefix) / sizeof(char*);
-        std::string name = "-> ";
-        name += prefix[fd % num];
-        name += std::to_string(fd);
-        name += ": ";
+        // the name
+        const std::string& name = names[fd];
 
         // read content
         static const int name_sz = 12;
         static char buf[name_sz + 1024 + 1];
         int rbs = read(fd, buf + name_sz, 1024);
+        if (rbs <= 0) return; // 连接关闭由断开回调处理
         buf[name_sz + rbs] = '\0'; // end
         
         // cat <name> && <content>
         int spaces = name_sz - name.length();
         std::strncpy(buf + spaces, name.c_str(), name.length());
         
-        // distribute
-        for (auto each: alive_fds) {
-            if (each != fd) {
-                write(each, buf + spaces, name.length() + rbs + 1);
-            } 
-        }
+        // distribute: 一次拷贝，所有订阅者共享，除了发送者自己
+        hub.publish("chat", buf + spaces, name.length() + rbs + 1, fd);
     });
     alarm(TICK_TVAL);
     // 启动
@@ -2,9 +2,13 @@
 #include <arpa/inet.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/un.h>
 #include <unistd.h>
 #include <cstring>
 #include <iostream>
+#include <optional>
+#include "address.h"
+#include "sockopts.h"
 #include "utility.h"
 
 namespace fnet {
@@ -12,7 +16,10 @@ namespace fnet {
 // 用于模板特化的类型
 struct protocol
 {
-    struct tcp {}; 
+    struct tcp {};             // IPv4
+    struct tcp6 {};            // IPv6
+    struct uds {};             // UNIX域，SOCK_STREAM
+    struct uds_seqpacket {};   // UNIX域，SOCK_SEQPACKET（保留消息边界）
     struct udp {};
 };
 
@@ -20,65 +27,54 @@ struct protocol
 template <typename Protocol>
 class acceptor {};
 
-// tcp acceptor
-template <>
-class acceptor<protocol::tcp> {
+namespace details {
+
+// 各类接收器的公共部分：持有监听socket
+class acceptor_base {
+protected:
     int  sock = 0;
-    struct sockaddr_in remote_info_buf;
-    socklen_t remote_addr_sz = sizeof(struct sockaddr_in);
+    peer_address remote_buf;
+    std::optional<sockopts> opts;
 
-public:
-    /**
-     * @brief 构造接收器并绑定IP+端口
-     * @param ip ip地址
-     * @param port 端口号
-     * @param reuse_addr 是否快速复用端口 
-     */
-    explicit acceptor() {
-        sock = socket(PF_INET, SOCK_STREAM, 0);
+    acceptor_base(int domain, int type) {
+        sock = socket(domain, type, 0);
         if (sock == -1) {
             std::cerr<<"[FastNet-Error]: "<<strerror(errno)<<std::endl;
             std::abort();
-        } 
+        }
     }
-    acceptor(const acceptor&) = delete;
-    acceptor(acceptor&& other) noexcept {
+    acceptor_base(const acceptor_base&) = delete;
+    acceptor_base(acceptor_base&& other) noexcept
+        : opts(std::move(other.opts)) {
         sock = other.release();
     }
-    acceptor& operator=(const acceptor&) = delete;
-    acceptor& operator=(acceptor&& other) {
-        sock = other.release();
+    acceptor_base& operator=(const acceptor_base&) = delete;
+    acceptor_base& operator=(acceptor_base&& other) noexcept {
+        if (this != &other) {
+            do_close();
+            sock = other.release();
+            opts = std::move(other.opts);
+        }
         return *this;
     }
-    ~acceptor() {
+    ~acceptor_base() {
         do_close();
     }
 
-public:
-    /**
-     * @brief 开始监听
-     * @param backlog 最多积压的连接数，达到该数后新连接会被丢弃
-     */
-    void do_listen(int backlog = 511) {
-        if (-1 == listen(sock, backlog)) {
+    void bind_or_abort(const struct sockaddr* addr, socklen_t len) {
+        if (-1 == bind(sock, addr, len)) {
             std::cerr<<"[FastNet-Error]: "<<strerror(errno)<<std::endl;
             std::abort();
         }
     }
 
+public:
     /**
-     * @brief 绑定IP与端口，并设置是否快速复用端口
-     * @param ip ip地址
-     * @param port 端口
-     * @param reuse_addr 是否快速复用端口 
+     * @brief 开始监听
+     * @param backlog 最多积压的连接数，达到该数后新连接会被丢弃
      */
-    void do_bind(const char* ip, int port) {
-        struct sockaddr_in sock_addr;
-        std::memset(&sock_addr, 0, sizeof(sock_addr));
-        inet_pton(AF_INET, ip, &sock_addr.sin_addr);
-        sock_addr.sin_family = AF_INET;
-        sock_addr.sin_port = htons(port);
-        if (-1 == bind(sock, (struct sockaddr*)&sock_addr, sizeof(sock_addr))) {
+    void do_listen(int backlog = 511) {
+        if (-1 == listen(sock, backlog)) {
             std::cerr<<"[FastNet-Error]: "<<strerror(errno)<<std::endl;
             std::abort();
         }
@@ -89,24 +85,50 @@ public:
      * @note 该函数时可重入的，但不建议随意调用
      */
     void do_close() {
-        close(sock);
+        if (sock > 0) close(sock);
         sock = 0;
     }
 
     /**
      * @brief 阻塞等待接收一个连接
      * @return 成功: fd ; 失败: -1
+     * @note 挂载的socket选项设置失败时关闭该连接并返回-1，errno为setsockopt的错误码
      */
     int do_accept() {
-        return accept(sock, (struct sockaddr*)&remote_info_buf, &remote_addr_sz);
+        remote_buf.reset();
+        int fd = accept(sock, remote_buf.data(), remote_buf.size_ptr());
+        if (fd != -1 && opts && !opts->try_apply(fd)) {
+            int err = errno;
+            close(fd);
+            errno = err;
+            return -1;
+        }
+        return fd;
     }
 
     /**
-     * @brief 获取最新客户端连接的地址信息
-     * @return sockaddr_in 
+     * @brief 挂载socket选项配置：立即设置监听socket上的选项，之后接收的每个连接（do_accept()或
+     *        reactor::add_acceptor()）都会被设置连接上的选项
+     * @param o 选项配置
+     * @note 需在do_bind()之前调用（SO_REUSEPORT），失败时抛出异常
      */
-    const struct sockaddr_in& remote_info() {
-        return remote_info_buf;
+    void set_options(const sockopts& o) {
+        o.apply_listener(sock);
+        opts = o;
+    }
+
+    /**
+     * @brief 挂载的socket选项配置
+     */
+    const std::optional<sockopts>& options() const noexcept {
+        return opts;
+    }
+
+    /**
+     * @brief 获取最新客户端连接的地址
+     */
+    const peer_address& remote() const noexcept {
+        return remote_buf;
     }
 
     /**
@@ -128,5 +150,117 @@ public:
     }
 };
 
+// 填写UNIX域地址，以'@'开头的路径表示抽象命名空间（不在文件系统中创建文件）
+inline socklen_t make_unix_addr(const char* path, struct sockaddr_un& addr) {
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    size_t n = strnlen(path, sizeof(addr.sun_path) - 1);
+    std::memcpy(addr.sun_path, path, n);
+    if (path[0] == '@') addr.sun_path[0] = '\0';
+    else n += 1;  // 文件路径带上结尾的'\0'
+    return static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + n);
+}
+
+}  // namespace details
+
+// tcp acceptor
+template <>
+class acceptor<protocol::tcp> : public details::acceptor_base {
+public:
+    /**
+     * @brief 构造IPv4接收器，之后通过do_bind()绑定IP+端口
+     */
+    explicit acceptor()
+        : acceptor_base(PF_INET, SOCK_STREAM) {}
+
+    /**
+     * @brief 绑定IP与端口
+     * @param ip ip地址
+     * @param port 端口
+     */
+    void do_bind(const char* ip, int port) {
+        struct sockaddr_in sock_addr;
+        std::memset(&sock_addr, 0, sizeof(sock_addr));
+        inet_pton(AF_INET, ip, &sock_addr.sin_addr);
+        sock_addr.sin_family = AF_INET;
+        sock_addr.sin_port = htons(port);
+        bind_or_abort((struct sockaddr*)&sock_addr, sizeof(sock_addr));
+    }
+
+    /**
+     * @brief 获取最新客户端连接的地址信息
+     * @return sockaddr_in
+     */
+    const struct sockaddr_in& remote_info() {
+        return remote_buf.v4();
+    }
+};
+
+// IPv6 tcp acceptor
+template <>
+class acceptor<protocol::tcp6> : public details::acceptor_base {
+public:
+    /**
+     * @brief 构造IPv6接收器
+     * @param v6_only 是否只接收IPv6连接，为false时同时接收IPv4映射地址（::ffff:a.b.c.d）
+     */
+    explicit acceptor(bool v6_only = true)
+        : acceptor_base(PF_INET6, SOCK_STREAM) {
+        int option = v6_only ? 1 : 0;
+        setsockopt(sock, IPPROTO_IPV6, IPV6_V6ONLY, &option, sizeof(option));
+    }
+
+    /**
+     * @brief 绑定IP与端口
+     * @param ip ipv6地址，如 ::1、::
+     * @param port 端口
+     */
+    void do_bind(const char* ip, int port) {
+        struct sockaddr_in6 sock_addr;
+        std::memset(&sock_addr, 0, sizeof(sock_addr));
+        inet_pton(AF_INET6, ip, &sock_addr.sin6_addr);
+        sock_addr.sin6_family = AF_INET6;
+        sock_addr.sin6_port = htons(port);
+        bind_or_abort((struct sockaddr*)&sock_addr, sizeof(sock_addr));
+    }
+};
+
+// UNIX域 acceptor（SOCK_STREAM）
+template <>
+class acceptor<protocol::uds> : public details::acceptor_base {
+public:
+    explicit acceptor()
+        : acceptor_base(PF_UNIX, SOCK_STREAM) {}
+
+    /**
+     * @brief 绑定路径
+     * @param path 文件路径（已存在时先删除）；以'@'开头表示抽象命名空间，如 "@fastnet"
+     */
+    void do_bind(const char* path) {
+        struct sockaddr_un addr;
+        auto len = details::make_unix_addr(path, addr);
+        if (path[0] != '@') unlink(path);
+        bind_or_abort((struct sockaddr*)&addr, len);
+    }
+};
+
+// UNIX域 acceptor（SOCK_SEQPACKET），每次read()返回一条完整的消息
+template <>
+class acceptor<protocol::uds_seqpacket> : public details::acceptor_base {
+public:
+    explicit acceptor()
+        : acceptor_base(PF_UNIX, SOCK_SEQPACKET) {}
+
+    /**
+     * @brief 绑定路径，见acceptor<protocol::uds>::do_bind()
+     */
+    void do_bind(const char* path) {
+        struct sockaddr_un addr;
+        auto len = details::make_unix_addr(path, addr);
+        if (path[0] != '@') unlink(path);
+        bind_or_abort((struct sockaddr*)&addr, len);
+    }
+};
+
 
-} // namespace fnet
\ No newline at end of file
+} // namespace fnet
@@ -0,0 +1,108 @@
+#pragma once
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+namespace fnet {
+
+/**
+ * @brief 与协议无关的对端地址（IPv4/IPv6/UNIX域）
+ */
+class peer_address {
+    struct sockaddr_storage ss;
+    socklen_t len = sizeof(ss);
+
+public:
+    peer_address() {
+        std::memset(&ss, 0, sizeof(ss));
+    }
+
+    /**
+     * @brief 供accept()/getpeername()写入
+     * @note 传入前需调用reset()恢复长度
+     */
+    struct sockaddr* data() noexcept {
+        return reinterpret_cast<struct sockaddr*>(&ss);
+    }
+    const struct sockaddr* data() const noexcept {
+        return reinterpret_cast<const struct sockaddr*>(&ss);
+    }
+    socklen_t* size_ptr() noexcept {
+        return &len;
+    }
+    socklen_t size() const noexcept {
+        return len;
+    }
+    void reset() noexcept {
+        len = sizeof(ss);
+    }
+
+    /**
+     * @return AF_INET、AF_INET6或AF_UNIX
+     */
+    int family() const noexcept {
+        return ss.ss_family;
+    }
+    bool is_v4() const noexcept {
+        return family() == AF_INET;
+    }
+    bool is_v6() const noexcept {
+        return family() == AF_INET6;
+    }
+    bool is_unix() const noexcept {
+        return family() == AF_UNIX;
+    }
+
+    /**
+     * @brief 按IPv4地址访问，调用前需确认is_v4()
+     */
+    const struct sockaddr_in& v4() const noexcept {
+        return *reinterpret_cast<const struct sockaddr_in*>(&ss);
+    }
+
+    /**
+     * @brief 按IPv6地址访问，调用前需确认is_v6()
+     */
+    const struct sockaddr_in6& v6() const noexcept {
+        return *reinterpret_cast<const struct sockaddr_in6*>(&ss);
+    }
+
+    /**
+     * @brief 端口号（主机字节序），UNIX域地址返回0
+     */
+    int port() const noexcept {
+        if (is_v4()) return ntohs(v4().sin_port);
+        if (is_v6()) return ntohs(v6().sin6_port);
+        return 0;
+    }
+
+    /**
+     * @brief 地址的文本形式，如 127.0.0.1:9090、[::1]:9090、/tmp/x.sock、@abstract；
+     *        未命名的UNIX域对端（客户端通常如此）返回 unix:
+     */
+    std::string to_string() const {
+        char buf[INET6_ADDRSTRLEN];
+        if (is_v4()) {
+            inet_ntop(AF_INET, &v4().sin_addr, buf, sizeof(buf));
+            return std::string(buf) + ':' + std::to_string(port());
+        }
+        if (is_v6()) {
+            inet_ntop(AF_INET6, &v6().sin6_addr, buf, sizeof(buf));
+            return '[' + std::string(buf) + "]:" + std::to_string(port());
+        }
+        if (is_unix()) {
+            auto& un = *reinterpret_cast<const struct sockaddr_un*>(&ss);
+            size_t n = len > offsetof(sockaddr_un, sun_path) ? len - offsetof(sockaddr_un, sun_path) : 0;
+            if (n == 0) return "unix:";
+            if (un.sun_path[0] == '\0') return '@' + std::string(un.sun_path + 1, n - 1);
+            return std::string(un.sun_path, strnlen(un.sun_path, n));
+        }
+        return "";
+    }
+};
+
+}  // namespace fnet
@@ -0,0 +1,124 @@
+#pragma once
+#include <dirent.h>
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace fnet {
+
+// CPU亲和性与NUMA节点工具
+struct affinity {
+
+    // 在线的CPU数
+    static int num_cpus() {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        return n > 0 ? static_cast<int>(n) : 1;
+    }
+
+    /**
+     * @brief 将调用线程绑定到一个CPU
+     * @note 失败时抛出异常
+     */
+    static void pin_thread(int cpu) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (err) throw std::runtime_error(strerror(err));
+    }
+
+    // 调用线程当前所在的CPU
+    static int current_cpu() {
+        return sched_getcpu();
+    }
+
+    /**
+     * @brief CPU所属的NUMA节点
+     * @return 节点编号，没有NUMA信息时返回0
+     */
+    static int node_of(int cpu) {
+        std::string dir = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+        DIR* d = opendir(dir.c_str());
+        if (!d) return 0;
+        int node = 0;
+        while (auto* ent = readdir(d)) {
+            if (strncmp(ent->d_name, "node", 4) == 0 && ent->d_name[4] >= '0' && ent->d_name[4] <= '9') {
+                node = atoi(ent->d_name + 4);
+                break;
+            }
+        }
+        closedir(d);
+        return node;
+    }
+
+    /**
+     * @brief 分配优先位于指定NUMA节点的内存（按页对齐），并预先写入使其立即分配物理页
+     * @param bytes 字节数
+     * @param node 节点编号，小于0时不指定（由首次写入的线程所在节点决定）
+     * @note 失败时抛出std::bad_alloc；需用free_local()释放
+     */
+    static void* alloc_local(size_t bytes, int node) {
+        void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) throw std::bad_alloc();
+        if (node >= 0 && node < 64) {
+            // 单节点的机器或内核不支持时失败，忽略即可
+            unsigned long mask = 1UL << node;
+            syscall(SYS_mbind, p, bytes, MPOL_PREFERRED, &mask, sizeof(mask) * 8, 0);
+        }
+        std::memset(p, 0, bytes);
+        return p;
+    }
+
+    static void free_local(void* p, size_t bytes) noexcept {
+        if (p) munmap(p, bytes);
+    }
+};
+
+/**
+ * @brief 位于指定NUMA节点上的定长数组
+ * @tparam T 可平凡构造与析构的类型
+ */
+template <typename T>
+class node_array {
+    T* p = nullptr;
+    size_t n = 0;
+
+public:
+    node_array() = default;
+    node_array(size_t n, int node)
+        : p(static_cast<T*>(affinity::alloc_local(n * sizeof(T), node)))
+        , n(n) {}
+    node_array(const node_array&) = delete;
+    node_array(node_array&& other) noexcept
+        : p(std::exchange(other.p, nullptr))
+        , n(std::exchange(other.n, 0)) {}
+    node_array& operator=(node_array&& other) noexcept {
+        std::swap(p, other.p);
+        std::swap(n, other.n);
+        return *this;
+    }
+    ~node_array() {
+        affinity::free_local(p, n * sizeof(T));
+    }
+
+    T* get() const noexcept {
+        return p;
+    }
+    T& operator[](size_t i) const noexcept {
+        return p[i];
+    }
+    size_t size() const noexcept {
+        return n;
+    }
+};
+
+}  // namespace fnet
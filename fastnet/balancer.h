@@ -0,0 +1,153 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "reactor.h"
+
+namespace fnet {
+
+/**
+ * @brief 在多个反应堆之间平衡连接：定期采样各反应堆的利用率（处理事件的时间占比），
+ *        最忙的反应堆超过阈值且明显忙于最空闲的反应堆时，把其中最活跃的一部分连接迁移过去
+ * @note 连接的用户状态通过各反应堆的set_migration_cb()转移；迁移在源反应堆线程中进行，
+ *       发起迁移后的下一个采样周期只采样不迁移，等待新的分布生效
+ */
+class balancer {
+public:
+    struct options {
+        int interval_ms = 100;   // 采样周期
+        double high = 0.75;      // 利用率超过该值才迁出
+        double min_gap = 0.2;    // 与最空闲的反应堆的利用率之差超过该值才迁出
+        size_t max_moves = 16;   // 每次最多迁移的连接数
+    };
+
+private:
+    std::vector<reactor*> recs;
+    options opt;
+    std::vector<uint64_t> last_busy;
+    std::vector<double> utils;
+    uint64_t last_ns = 0;
+    bool cooling = false;
+    std::shared_ptr<std::atomic<uint64_t>> moved;  // 投递的迁移任务可能在balancer析构后执行
+    bool closed = false;
+    std::mutex lok;
+    std::mutex util_lok;
+    std::condition_variable cv;
+    std::thread thrd;
+
+public:
+    /**
+     * @param reactors 参与平衡的反应堆，需在balancer析构之前保持有效
+     * @note 在反应堆activate()之前构造，会开启各反应堆的负载统计
+     */
+    balancer(std::vector<reactor*> reactors, options o)
+        : recs(std::move(reactors))
+        , opt(o)
+        , last_busy(recs.size(), 0)
+        , utils(recs.size(), 0)
+        , moved(std::make_shared<std::atomic<uint64_t>>(0)) {
+        for (auto* r : recs) r->enable_load_tracking();
+        last_ns = details::now_ns();
+    }
+    explicit balancer(std::vector<reactor*> reactors)
+        : balancer(std::move(reactors), options()) {}
+    balancer(const balancer&) = delete;
+    balancer(balancer&&) = delete;
+    ~balancer() {
+        stop();
+    }
+
+    /**
+     * @brief 启动后台线程，每个采样周期调用一次balance()
+     */
+    void start() {
+        std::lock_guard<std::mutex> lock(lok);
+        if (thrd.joinable()) {
+            std::cerr<<"[FastNet Error]: Called balancer::start() again"<<std::endl;
+            std::abort();
+        }
+        thrd = std::thread([this] {
+            std::unique_lock<std::mutex> locker(lok);
+            while (!closed) {
+                cv.wait_for(locker, std::chrono::milliseconds(opt.interval_ms));
+                if (closed) break;
+                locker.unlock();
+                balance();
+                locker.lock();
+            }
+        });
+    }
+
+    /**
+     * @brief 停止后台线程
+     * @note 已投递给反应堆的迁移仍会执行
+     */
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(lok);
+            closed = true;
+        }
+        cv.notify_one();
+        if (thrd.joinable()) thrd.join();
+    }
+
+    /**
+     * @brief 采样一次利用率，必要时发起迁移（不启动后台线程时可手动调用，不能与后台线程同时调用）
+     * @return 是否发起了迁移
+     */
+    bool balance() {
+        uint64_t now = details::now_ns();
+        double elapsed = static_cast<double>(now - last_ns);
+        last_ns = now;
+        if (recs.size() < 2 || elapsed <= 0) return false;
+        size_t hot = 0, cold = 0;
+        {
+            std::lock_guard<std::mutex> lock(util_lok);
+            for (size_t i = 0; i < recs.size(); ++i) {
+                uint64_t busy = recs[i]->busy_ns();
+                utils[i] = (busy - last_busy[i]) / elapsed;
+                last_busy[i] = busy;
+                if (utils[i] > utils[hot]) hot = i;
+                if (utils[i] < utils[cold]) cold = i;
+            }
+        }
+        if (cooling) {
+            cooling = false;
+            return false;
+        }
+        double uh = utils[hot], uc = utils[cold];
+        if (uh < opt.high || uh - uc < opt.min_gap) return false;
+        // 迁出两者之差的一半，按回调次数估计每个连接的负载
+        double share = (uh - uc) / 2 / uh;
+        reactor* src = recs[hot];
+        reactor* dst = recs[cold];
+        size_t max_moves = opt.max_moves;
+        auto counter = moved;
+        src->post([counter, src, dst, share, max_moves] {
+            counter->fetch_add(src->shed(*dst, share, max_moves), std::memory_order_relaxed);
+        });
+        cooling = true;
+        return true;
+    }
+
+    /**
+     * @brief 最近一次采样的各反应堆利用率（0~1）
+     */
+    std::vector<double> utilization() {
+        std::lock_guard<std::mutex> lock(util_lok);
+        return utils;
+    }
+
+    /**
+     * @brief 已迁移的连接数
+     */
+    uint64_t migrations() const noexcept {
+        return moved->load(std::memory_order_relaxed);
+    }
+};
+
+}  // namespace fnet
@@ -1,19 +1,58 @@
 #pragma once
-#include <vector>
-#include <memory>
-#include <iostream>
-#include <functional>
+#include <cstdint>
 #include <cstring>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
 
 namespace fnet {
 
+/**
+ * @brief Callback trie for command dispatching.
+ * Keys are inserted into a pointer-based build tree and compiled ("frozen") into a flat
+ * double-array over the full byte range, so a lookup is one contiguous array access per byte.
+ * Lookups never abort: unknown bytes or commands simply yield 0 (not found).
+ */
 class cbtrie
 {
-    unsigned long cnt = 0;
-    std::vector<std::unique_ptr<int[]>> nextpos;
-    std::vector<std::function<void(char *, size_t)>> cbs;
 public:
-    cbtrie() = default;
+    using callback_t = std::function<void(char *, size_t)>;
+
+private:
+    // node of the build tree, children are kept sorted by byte
+    struct build_node {
+        std::vector<std::pair<unsigned char, int>> next;
+        int value = 0;
+    };
+    // unit of the double-array: child of state s by byte c lives at base[s] + c iff check == s
+    struct unit {
+        int32_t base = 0;
+        int32_t check = -1;
+        int32_t value = 0;
+    };
+
+    bool icase = false;
+    bool dirty = false;
+    unsigned char fold[256];
+    std::vector<build_node> nodes;
+    std::vector<unit> units;
+    std::vector<callback_t> cbs;
+
+public:
+    /**
+     * @param case_insensitive match ASCII letters regardless of case
+     */
+    explicit cbtrie(bool case_insensitive = false)
+        : icase(case_insensitive)
+        , nodes(1)
+        , units(1)
+        , cbs(1) {
+        for (int c = 0; c < 256; ++c) {
+            fold[c] = static_cast<unsigned char>((icase && c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c);
+        }
+        units[0].check = 0;  // root
+    }
     cbtrie(const cbtrie&) = delete;
     cbtrie(cbtrie&&) = default;
     ~cbtrie() = default;
@@ -24,56 +63,86 @@ public:
      * @param cb callback function
      */
     template <size_t N>
-    void insert(const char (&str)[N], std::function<void(char *, size_t)> cb) { 
-        size_t p = 0;
-        for (size_t i = 0; i < (N-1); i++) {
-            for (auto i = nextpos.size(); i <= p; ++i) {
-                nextpos.emplace_back(new int[26]);
-                memset(nextpos.back().get(), 0, 26*sizeof(int)); // clean
-            }
-            int c = str[i] - 'a';
-            if (c >= 0 && c < 26) {
-                if (!nextpos[p][c])
-                    nextpos[p][c] = ++cnt; // append the trie
-                p = nextpos[p][c];
-            } else {
-                std::cerr<<"invalid charactor"<<std::endl;
-                std::abort();
-            }
-        }
-        if (cbs.size() <= p) {
-            cbs.resize(p + 1);
-        }
-        cbs[p] = cb;
+    void insert(const char (&str)[N], callback_t cb) {
+        insert(str, N - 1, std::move(cb));
     }
 
     /**
      * @brief insert a string into the trie and assign it's callback function
-     * @param str the target str
+     * @param str the target str, any byte is allowed
      * @param len real length of the str (exclude the '\0')
      * @param cb  callback function
+     * @note inserting an existing key replaces its callback; the trie stays unfrozen until the next freeze()
      */
-    void insert(const char* str, size_t len, std::function<void(char *, size_t)> cb) { 
-        size_t p = 0;
+    void insert(const char* str, size_t len, callback_t cb) {
+        int p = 0;
         for (size_t i = 0; i < len; i++) {
-            for (auto i = nextpos.size(); i <= p; ++i) {
-                nextpos.emplace_back(new int[26]);
-                memset(nextpos.back().get(), 0, 26*sizeof(int)); // clean
-            }
-            int c = str[i] - 'a';
-            if (c >= 0 && c < 26) {
-                if (!nextpos[p][c])
-                    nextpos[p][c] = ++cnt; // append the trie
-                p = nextpos[p][c];
+            unsigned char c = fold[static_cast<unsigned char>(str[i])];
+            auto& next = nodes[p].next;
+            auto it = next.begin();
+            while (it != next.end() && it->first < c) ++it;
+            if (it != next.end() && it->first == c) {
+                p = it->second;
             } else {
-                std::cerr<<"invalid charactor"<<std::endl;
-                std::abort();
+                int child = static_cast<int>(nodes.size());
+                next.insert(it, {c, child});
+                nodes.emplace_back();
+                p = child;
             }
         }
-        if (cbs.size() <= p) {
-            cbs.resize(p + 1);
+        if (!nodes[p].value) {
+            nodes[p].value = static_cast<int>(cbs.size());
+            cbs.emplace_back();
+        }
+        cbs[nodes[p].value] = std::move(cb);
+        dirty = true;
+    }
+
+    /**
+     * @brief compile the inserted keys into the flat lookup table
+     * @note call it once after the last insert(), before the trie is shared between threads
+     */
+    void freeze() {
+        std::vector<unit> da(256 + 1);
+        da[0].check = 0;
+        std::vector<int32_t> state_of(nodes.size(), 0);  // build node -> double-array state
+        std::queue<int> todo;
+        todo.push(0);
+        size_t scan_from = 1;
+        while (!todo.empty()) {
+            int n = todo.front();
+            todo.pop();
+            int32_t s = state_of[n];
+            da[s].value = nodes[n].value;
+            auto& next = nodes[n].next;
+            if (next.empty()) continue;
+            // skip the leading fully-occupied region, then find the first base that fits all children
+            while (scan_from < da.size() && da[scan_from].check != -1) ++scan_from;
+            int32_t b = static_cast<int32_t>(scan_from) - next.front().first;
+            if (b < 1) b = 1;
+            while (true) {
+                if (da.size() < static_cast<size_t>(b) + 256) da.resize(b + 256);
+                bool fits = true;
+                for (auto& e : next) {
+                    if (da[b + e.first].check != -1) {
+                        fits = false;
+                        break;
+                    }
+                }
+                if (fits) break;
+                ++b;
+            }
+            da[s].base = b;
+            for (auto& e : next) {
+                da[b + e.first].check = s;
+                state_of[e.second] = b + e.first;
+                todo.push(e.second);
+            }
         }
-        cbs[p] = cb;
+        while (da.size() > 1 && da.back().check == -1) da.pop_back();
+        da.shrink_to_fit();
+        units.swap(da);
+        dirty = false;
     }
 
     /**
@@ -81,39 +150,66 @@ public:
      * @param str the target str
      * @param len real length of the str (exclude the '\0')
      * @return The position of the str's callback function. If not found, return 0.
+     * @note never modifies the trie; until freeze() is called it walks the (slower) build tree instead
      */
-    int search(const char *str, size_t len) { 
-        size_t p = 0;
+    int search(const char *str, size_t len) const {
+        if (dirty) return search_build(str, len);
+        const unit* u = units.data();
+        const int32_t n = static_cast<int32_t>(units.size());
+        int32_t s = 0;
         for (size_t i = 0; i < len; i++) {
-            int c = str[i] - 'a';
-            if (c >= 0 && c < 26) {
-                if (!nextpos[p][c]) return 0;
-                p = nextpos[p][c];
-            } else {
-                std::cerr<<"invalid charactor"<<std::endl;
-                std::abort();
-            }
+            int32_t t = u[s].base + fold[static_cast<unsigned char>(str[i])];
+            if (!u[s].base || t >= n || u[t].check != s) return 0;
+            s = t;
         }
-        return p;
+        return u[s].value;
+    }
+
+    /**
+     * @brief whether every inserted key has been compiled by freeze()
+     */
+    bool frozen() const noexcept {
+        return !dirty;
+    }
+
+    /**
+     * @brief number of distinct keys
+     */
+    size_t size() const noexcept {
+        return cbs.size() - 1;
     }
 
     /**
      * @brief get the reference of the callback function
-     * @param p position of the callback function 
-     * @return std::function<void(char*, size_t)> 
+     * @param p position of the callback function
+     * @return std::function<void(char*, size_t)>
      */
-    auto get(int p) -> std::function<void(char*, size_t)>& {
+    auto get(int p) -> callback_t& {
         return cbs[p];
     }
 
     /**
      * @brief get the reference of the callback function
-     * @param p position of the callback function 
-     * @return std::function<void(char*, size_t)> 
+     * @param p position of the callback function
+     * @return std::function<void(char*, size_t)>
      */
-    auto operator [](int p) -> std::function<void(char*, size_t)>& {
+    auto operator [](int p) -> callback_t& {
         return cbs[p];
     }
+
+private:
+    int search_build(const char *str, size_t len) const {
+        int p = 0;
+        for (size_t i = 0; i < len; i++) {
+            unsigned char c = fold[static_cast<unsigned char>(str[i])];
+            auto& next = nodes[p].next;
+            auto it = next.begin();
+            while (it != next.end() && it->first < c) ++it;
+            if (it == next.end() || it->first != c) return 0;
+            p = it->second;
+        }
+        return nodes[p].value;
+    }
 };
 
 } // namespace fnet
@@ -0,0 +1,184 @@
+#pragma once
+#include <time.h>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include "metrics.h"
+
+namespace fnet {
+
+// 时钟源，均与details::now_ns()（CLOCK_MONOTONIC）使用同一时间基准
+enum class clock_source {
+    steady,   // CLOCK_MONOTONIC，vDSO读取，约20ns
+    coarse,   // CLOCK_MONOTONIC_COARSE，只读内核上次节拍的时间，精度为一个节拍（通常1~4ms）
+    tsc       // 校准后的rdtsc，仅x86且TSC恒定时可用，否则退回steady
+};
+
+namespace details {
+
+inline uint64_t coarse_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+inline uint64_t rdtsc() {
+    uint32_t lo, hi;
+    __asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+    return (static_cast<uint64_t>(hi) << 32) | lo;
+}
+#else
+inline uint64_t rdtsc() {
+    return 0;
+}
+#endif
+
+// TSC频率的校准结果，进程内只校准一次（约10ms）
+struct tsc_calibration {
+    uint64_t mult = 0;       // 每个tick的纳秒数，32位定点小数
+    uint64_t base_tsc = 0;
+    uint64_t base_ns = 0;
+
+    static const tsc_calibration& get() {
+        static const tsc_calibration c = calibrate();
+        return c;
+    }
+
+    bool usable() const noexcept {
+        return mult != 0;
+    }
+
+    uint64_t to_ns(uint64_t tsc, uint64_t anchor_tsc, uint64_t anchor_ns) const noexcept {
+        unsigned __int128 d = static_cast<unsigned __int128>(tsc - anchor_tsc) * mult;
+        return anchor_ns + static_cast<uint64_t>(d >> 32);
+    }
+
+private:
+    // 不随频率变化、不在深度睡眠中停止的TSC才能当作时钟
+    static bool invariant() {
+#if defined(__x86_64__) || defined(__i386__)
+        std::ifstream in("/proc/cpuinfo");
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.compare(0, 5, "flags") != 0) continue;
+            return line.find(" constant_tsc") != std::string::npos && line.find(" nonstop_tsc") != std::string::npos;
+        }
+#endif
+        return false;
+    }
+
+    static tsc_calibration calibrate() {
+        tsc_calibration c;
+        if (!invariant()) return c;
+        uint64_t ns0 = now_ns(), tsc0 = rdtsc();
+        uint64_t ns1 = ns0, tsc1 = tsc0;
+        while (ns1 - ns0 < 10000000) {
+            ns1 = now_ns();
+            tsc1 = rdtsc();
+        }
+        if (tsc1 <= tsc0) return c;
+        c.mult = static_cast<uint64_t>((static_cast<unsigned __int128>(ns1 - ns0) << 32) / (tsc1 - tsc0));
+        c.base_tsc = tsc1;
+        c.base_ns = ns1;
+        return c;
+    }
+};
+
+}  // namespace details
+
+/**
+ * @brief 事件循环的缓存时钟：每轮采样一次，本轮内的超时判断都读取缓存值
+ * @note 单线程使用；缓存值单调不减
+ */
+class loop_clock {
+    clock_source src = clock_source::steady;
+    uint64_t cached = 0;
+    uint64_t anchor_tsc = 0;   // tsc源：与CLOCK_MONOTONIC对齐的锚点，每秒重新对齐以消除漂移
+    uint64_t anchor_ns = 0;
+    uint64_t resync_tsc = 0;
+
+public:
+    explicit loop_clock(clock_source s = clock_source::steady) {
+        set_source(s);
+    }
+
+    /**
+     * @brief 切换时钟源，TSC不可用时使用steady
+     */
+    void set_source(clock_source s) {
+        if (s == clock_source::tsc && !tsc_available()) s = clock_source::steady;
+        src = s;
+        if (src == clock_source::tsc) resync_tsc = 0;
+        update();
+    }
+
+    clock_source source() const noexcept {
+        return src;
+    }
+
+    /**
+     * @brief 最近一次采样的时间（纳秒）
+     */
+    uint64_t now() const noexcept {
+        return cached;
+    }
+
+    /**
+     * @brief 以std::chrono表示的缓存时间，可传给timer::is_timeout()与timer_master::clean_timeout_timers()
+     */
+    std::chrono::steady_clock::time_point time_point() const noexcept {
+        return std::chrono::steady_clock::time_point(
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(cached)));
+    }
+
+    /**
+     * @brief 重新采样
+     * @return 新的缓存时间
+     */
+    uint64_t update() noexcept {
+        uint64_t t;
+        if (src == clock_source::tsc) {
+            uint64_t tsc = details::rdtsc();
+            if (tsc >= resync_tsc || tsc < anchor_tsc) {
+                anchor_ns = details::now_ns();
+                anchor_tsc = details::rdtsc();
+                resync_tsc = anchor_tsc + (1000000000ull << 32) / details::tsc_calibration::get().mult;
+                t = anchor_ns;
+            } else {
+                t = details::tsc_calibration::get().to_ns(tsc, anchor_tsc, anchor_ns);
+            }
+        } else {
+            t = read(src);
+        }
+        if (t > cached) cached = t;
+        return cached;
+    }
+
+    /**
+     * @brief 不经缓存直接读取一个时钟源
+     */
+    static uint64_t read(clock_source s) noexcept {
+        switch (s) {
+        case clock_source::coarse:
+            return details::coarse_ns();
+        case clock_source::tsc: {
+            auto& c = details::tsc_calibration::get();
+            if (c.usable()) return c.to_ns(details::rdtsc(), c.base_tsc, c.base_ns);
+            return details::now_ns();
+        }
+        default:
+            return details::now_ns();
+        }
+    }
+
+    /**
+     * @brief 本机的TSC是否可以当作时钟（首次调用时校准）
+     */
+    static bool tsc_available() {
+        return details::tsc_calibration::get().usable();
+    }
+};
+
+}  // namespace fnet
@@ -0,0 +1,250 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace fnet {
+namespace details {
+
+constexpr uint64_t cmd_mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// FNV-1a，编译期与运行期共用
+constexpr uint64_t cmd_hash(const char* s, size_t n) {
+    uint64_t h = 0xcbf29ce484222325ULL ^ n;
+    for (size_t i = 0; i < n; ++i) {
+        h ^= static_cast<unsigned char>(s[i]);
+        h *= 0x100000001b3ULL;
+    }
+    return cmd_mix(h);
+}
+
+constexpr size_t pow2_at_least(size_t n) {
+    size_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+constexpr size_t max_of(std::initializer_list<size_t> l) {
+    size_t m = 0;
+    for (auto v : l) m = v > m ? v : m;
+    return m;
+}
+
+// 把字节按本机字节序打包成8字节字，与运行期memcpy加载的结果一致
+constexpr uint64_t pack_word(const char* s, size_t n, size_t w) {
+    uint64_t v = 0;
+    for (size_t i = 0; i < 8 && w * 8 + i < n; ++i) {
+        uint64_t c = static_cast<unsigned char>(s[w * 8 + i]);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        v |= c << (8 * (7 - i));
+#else
+        v |= c << (8 * i);
+#endif
+    }
+    return v;
+}
+
+}  // namespace details
+
+/**
+ * @brief 编译期生成的命令表：对固定的命令名集合构造完美哈希（哈希-位移法），
+ *        查找时计算一次哈希，再按长度与8字节字比较确认，分发时直接调用处理函数
+ * @tparam N 命令数
+ * @tparam MaxLen 最长命令名的长度
+ * @note 通过make_cmdtable()构造，整个表是constexpr的，不在堆上分配，也不经过std::function
+ */
+template <size_t N, size_t MaxLen>
+class cmdtable {
+public:
+    static constexpr size_t slots = details::pow2_at_least(N * 2);
+    static constexpr size_t buckets = details::pow2_at_least(N / 2 + 1);
+    static constexpr size_t words = MaxLen ? (MaxLen + 7) / 8 : 1;
+
+private:
+    const char* names[N] = {};
+    size_t lens[N] = {};
+    uint64_t packed[N][words] = {};
+    uint64_t disp[buckets] = {};   // 每个桶的位移
+    int32_t index[slots] = {};     // 槽 -> 命令下标，-1表示空
+
+    static constexpr size_t bucket_of(uint64_t h) {
+        return (h >> 40) & (buckets - 1);
+    }
+    static constexpr size_t slot_of(uint64_t h, uint64_t d) {
+        return details::cmd_mix(h + d * 0x9e3779b97f4a7c15ULL) & (slots - 1);
+    }
+
+    constexpr bool same_name(size_t a, size_t b) const {
+        if (lens[a] != lens[b]) return false;
+        for (size_t i = 0; i < lens[a]; ++i) {
+            if (names[a][i] != names[b][i]) return false;
+        }
+        return true;
+    }
+
+public:
+    constexpr cmdtable(const char* const (&ns)[N], const size_t (&ls)[N]) {
+        uint64_t hashes[N] = {};
+        size_t bucket_size[buckets] = {};
+        for (size_t i = 0; i < N; ++i) {
+            names[i] = ns[i];
+            lens[i] = ls[i];
+            for (size_t w = 0; w < words; ++w) packed[i][w] = details::pack_word(ns[i], ls[i], w);
+            hashes[i] = details::cmd_hash(ns[i], ls[i]);
+            bucket_size[bucket_of(hashes[i])]++;
+        }
+        for (size_t i = 0; i < N; ++i) {
+            for (size_t j = i + 1; j < N; ++j) {
+                if (same_name(i, j)) throw std::logic_error("duplicate command name");
+            }
+        }
+        for (size_t s = 0; s < slots; ++s) index[s] = -1;
+        // 按桶归类：members[first[b], first[b] + bucket_size[b]) 为桶b中的命令
+        size_t first[buckets] = {};
+        size_t fill[buckets] = {};
+        size_t members[N] = {};
+        for (size_t b = 1; b < buckets; ++b) first[b] = first[b - 1] + bucket_size[b - 1];
+        for (size_t i = 0; i < N; ++i) {
+            size_t b = bucket_of(hashes[i]);
+            members[first[b] + fill[b]++] = i;
+        }
+        // 从大桶到小桶，依次为每个桶寻找使其所有命令落入空槽的位移
+        bool done[buckets] = {};
+        for (size_t round = 0; round < buckets; ++round) {
+            size_t b = 0;
+            bool found = false;
+            for (size_t k = 0; k < buckets; ++k) {
+                if (!done[k] && (!found || bucket_size[k] > bucket_size[b])) {
+                    b = k;
+                    found = true;
+                }
+            }
+            done[b] = true;
+            if (!bucket_size[b]) break;
+            const size_t* mem = members + first[b];
+            for (uint64_t d = 0;; ++d) {
+                if (d > (1u << 20)) throw std::logic_error("failed to build perfect hash");
+                bool ok = true;
+                for (size_t k = 0; k < bucket_size[b] && ok; ++k) {
+                    size_t s = slot_of(hashes[mem[k]], d);
+                    if (index[s] != -1) ok = false;
+                    // 同一桶内的命令也不能互相冲突
+                    for (size_t j = 0; j < k && ok; ++j) {
+                        if (slot_of(hashes[mem[j]], d) == s) ok = false;
+                    }
+                }
+                if (!ok) continue;
+                disp[b] = d;
+                for (size_t k = 0; k < bucket_size[b]; ++k) {
+                    index[slot_of(hashes[mem[k]], d)] = static_cast<int32_t>(mem[k]);
+                }
+                break;
+            }
+        }
+    }
+
+    /**
+     * @brief 查找命令（编译期可用）
+     * @param s 命令名
+     * @return 命令下标，未找到时返回-1
+     */
+    constexpr int index_of(std::string_view s) const {
+        uint64_t h = details::cmd_hash(s.data(), s.size());
+        int32_t i = index[slot_of(h, disp[bucket_of(h)])];
+        if (i < 0 || lens[i] != s.size()) return -1;
+        for (size_t k = 0; k < s.size(); ++k) {
+            if (names[i][k] != s[k]) return -1;
+        }
+        return i;
+    }
+
+    /**
+     * @brief 查找命令（运行期），按8字节字比较
+     * @param s 命令名，不要求以'\0'结尾
+     * @param n 长度
+     * @return 命令下标，未找到时返回-1
+     */
+    int find(const char* s, size_t n) const noexcept {
+        if (n > MaxLen) return -1;
+        uint64_t h = details::cmd_hash(s, n);
+        int32_t i = index[slot_of(h, disp[bucket_of(h)])];
+        if (i < 0 || lens[i] != n) return -1;
+        size_t w = 0;
+        for (; (w + 1) * 8 <= n; ++w) {
+            uint64_t v;
+            std::memcpy(&v, s + w * 8, 8);
+            if (v != packed[i][w]) return -1;
+        }
+        if (n % 8) {
+            uint64_t v = 0;
+            std::memcpy(&v, s + w * 8, n % 8);
+            if (v != packed[i][w]) return -1;
+        }
+        return i;
+    }
+
+    /**
+     * @brief 查找命令并调用处理函数
+     * @param s 命令名
+     * @param n 长度
+     * @param h 处理函数，以 h(std::integral_constant<size_t, I>{}, args...) 的形式被调用，
+     *          I为命令下标，可用 if constexpr 或重载区分命令
+     * @return 未找到命令时返回false
+     */
+    template <typename Handler, typename... Args>
+    bool dispatch(const char* s, size_t n, Handler&& h, Args&&... args) const {
+        int i = find(s, n);
+        if (i < 0) return false;
+        call(static_cast<size_t>(i), h, std::make_index_sequence<N>{}, args...);
+        return true;
+    }
+
+    constexpr std::string_view name(size_t i) const {
+        return std::string_view(names[i], lens[i]);
+    }
+
+    static constexpr size_t size() {
+        return N;
+    }
+
+private:
+    template <size_t I, typename Handler, typename... Args>
+    static void thunk(Handler& h, Args&... args) {
+        h(std::integral_constant<size_t, I>{}, args...);
+    }
+
+    // 与switch生成的跳转表相同：按下标取出对应实例化的入口，处理函数在各入口内被直接调用（可内联）
+    template <typename Handler, size_t... I, typename... Args>
+    static void call(size_t i, Handler& h, std::index_sequence<I...>, Args&... args) {
+        using entry_t = void (*)(Handler&, Args&...);
+        static constexpr entry_t jump[] = {&thunk<I, Handler, Args...>...};
+        jump[i](h, args...);
+    }
+};
+
+/**
+ * @brief 由字符串字面量构造编译期命令表，用法与cbtrie::insert()的字面量版本一致
+ * @return cmdtable，命令下标与参数顺序一致
+ * @note 命令名重复时编译失败
+ */
+template <size_t... L>
+constexpr auto make_cmdtable(const char (&... names)[L]) {
+    constexpr size_t n = sizeof...(L);
+    const char* ns[n] = {names...};
+    size_t ls[n] = {(L - 1)...};
+    return cmdtable<n, details::max_of({(L - 1)...})>(ns, ls);
+}
+
+}  // namespace fnet
@@ -0,0 +1,168 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace fnet {
+
+/**
+ * @brief 以fd为下标的连接表
+ * 槽位按块（每块2^ChunkBits个）平铺存放，查找只需一次移位与一次下标，不做哈希；
+ * 每个槽位带有代数，fd关闭后被系统复用时可通过handle识别出过期的引用；
+ * 存活的fd另外保存在一个稠密数组中，遍历所有连接时不必扫描空槽位
+ * @tparam T 每个连接的状态
+ * @note 块一旦分配不再移动，插入新fd不会使已有元素的引用失效；erase()会使被删除元素的引用失效
+ */
+template <typename T, size_t ChunkBits = 10>
+class conntable {
+    static constexpr size_t chunk_size = size_t(1) << ChunkBits;
+
+    struct slot {
+        std::optional<T> value;
+        uint32_t gen = 0;   // 每次删除后加一
+        int32_t pos = -1;   // 在live中的下标，-1表示空
+    };
+
+    std::vector<std::unique_ptr<slot[]>> chunks;
+    std::vector<int> live;
+
+public:
+    /**
+     * @brief 对某个连接的弱引用，fd被关闭后再被复用时失效
+     */
+    struct handle {
+        int fd = -1;
+        uint32_t gen = 0;
+    };
+
+    conntable() = default;
+    conntable(const conntable&) = delete;
+    conntable(conntable&&) = default;
+    conntable& operator=(conntable&&) = default;
+
+    /**
+     * @brief 插入或替换fd对应的状态
+     * @return 新状态的引用
+     */
+    template <typename... Args>
+    T& emplace(int fd, Args&&... args) {
+        slot& s = at(fd);
+        if (s.pos < 0) {
+            s.pos = static_cast<int32_t>(live.size());
+            live.push_back(fd);
+        }
+        return s.value.emplace(std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief 查找fd对应的状态
+     * @return 不存在时返回nullptr
+     */
+    T* find(int fd) noexcept {
+        slot* s = peek(fd);
+        return (s && s->pos >= 0) ? &*s->value : nullptr;
+    }
+
+    const T* find(int fd) const noexcept {
+        return const_cast<conntable*>(this)->find(fd);
+    }
+
+    /**
+     * @brief 通过弱引用查找，fd已被删除（即使又被复用）时返回nullptr
+     */
+    T* find(handle h) noexcept {
+        slot* s = peek(h.fd);
+        return (s && s->pos >= 0 && s->gen == h.gen) ? &*s->value : nullptr;
+    }
+
+    /**
+     * @brief 获取fd当前的弱引用，可在投递到其他线程的回调中携带
+     */
+    handle handle_of(int fd) const noexcept {
+        const slot* s = const_cast<conntable*>(this)->peek(fd);
+        return {fd, s ? s->gen : 0};
+    }
+
+    bool contains(int fd) const noexcept {
+        return find(fd) != nullptr;
+    }
+
+    /**
+     * @brief 获取fd对应的状态，不存在时默认构造
+     */
+    T& operator[](int fd) {
+        T* v = find(fd);
+        return v ? *v : emplace(fd);
+    }
+
+    /**
+     * @brief 删除fd对应的状态，并使其弱引用失效
+     * @return fd是否存在
+     */
+    bool erase(int fd) {
+        slot* s = peek(fd);
+        if (!s || s->pos < 0) return false;
+        int moved = live.back();
+        live[s->pos] = moved;
+        at(moved).pos = s->pos;
+        live.pop_back();
+        s->pos = -1;
+        s->gen++;
+        s->value.reset();
+        return true;
+    }
+
+    /**
+     * @brief 存活的fd，顺序不固定
+     */
+    const std::vector<int>& fds() const noexcept {
+        return live;
+    }
+
+    size_t size() const noexcept {
+        return live.size();
+    }
+
+    bool empty() const noexcept {
+        return live.empty();
+    }
+
+    /**
+     * @brief 遍历所有存活的连接，f(int fd, T& value)
+     * @note 遍历过程中不能插入或删除
+     */
+    template <typename F>
+    void for_each(F&& f) {
+        for (int fd : live) f(fd, *at(fd).value);
+    }
+
+    void clear() {
+        for (int fd : live) {
+            slot& s = at(fd);
+            s.pos = -1;
+            s.gen++;
+            s.value.reset();
+        }
+        live.clear();
+    }
+
+private:
+    slot* peek(int fd) noexcept {
+        if (fd < 0) return nullptr;
+        size_t c = static_cast<size_t>(fd) >> ChunkBits;
+        if (c >= chunks.size() || !chunks[c]) return nullptr;
+        return &chunks[c][fd & (chunk_size - 1)];
+    }
+
+    slot& at(int fd) {
+        size_t c = static_cast<size_t>(fd) >> ChunkBits;
+        if (c >= chunks.size()) chunks.resize(c + 1);
+        if (!chunks[c]) chunks[c].reset(new slot[chunk_size]);
+        return chunks[c][fd & (chunk_size - 1)];
+    }
+};
+
+}  // namespace fnet
@@ -0,0 +1,311 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "metrics.h"
+#include "reactor.h"
+
+namespace fnet {
+
+/**
+ * @brief Chase-Lev无锁工作窃取双端队列
+ * @tparam T 元素类型（指针）
+ * @note 只有所属线程可以push()/pop()，其他线程只能steal()
+ */
+template <typename T>
+class ws_deque {
+    static_assert(std::is_pointer<T>::value, "ws_deque stores pointers");
+
+    struct ring {
+        int64_t cap;
+        std::unique_ptr<std::atomic<T>[]> slots;
+        explicit ring(int64_t cap)
+            : cap(cap)
+            , slots(new std::atomic<T>[cap]) {}
+        T get(int64_t i) const noexcept {
+            return slots[i & (cap - 1)].load(std::memory_order_relaxed);
+        }
+        void put(int64_t i, T x) noexcept {
+            slots[i & (cap - 1)].store(x, std::memory_order_relaxed);
+        }
+    };
+
+    std::atomic<int64_t> top = {0};
+    std::atomic<int64_t> bottom = {0};
+    std::atomic<ring*> buf;
+    std::vector<std::unique_ptr<ring>> rings;  // 扩容后旧数组可能仍在被窃取者读取，统一在析构时释放
+
+public:
+    explicit ws_deque(int64_t cap = 256) {
+        rings.emplace_back(new ring(cap));
+        buf.store(rings.back().get(), std::memory_order_relaxed);
+    }
+    ws_deque(const ws_deque&) = delete;
+
+    void push(T x) {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_acquire);
+        ring* a = buf.load(std::memory_order_relaxed);
+        if (b - t > a->cap - 1) {
+            rings.emplace_back(new ring(a->cap * 2));
+            ring* bigger = rings.back().get();
+            for (int64_t i = t; i < b; ++i) bigger->put(i, a->get(i));
+            buf.store(bigger, std::memory_order_release);
+            a = bigger;
+        }
+        a->put(b, x);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    // 从底部取出，空时返回nullptr
+    T pop() noexcept {
+        int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        ring* a = buf.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+        T x = nullptr;
+        if (t <= b) {
+            x = a->get(b);
+            if (t == b) {
+                // 最后一个元素，与窃取者竞争
+                if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                    x = nullptr;
+                }
+                bottom.store(b + 1, std::memory_order_relaxed);
+            }
+        } else {
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return x;
+    }
+
+    // 从顶部窃取，空或竞争失败时返回nullptr
+    T steal() noexcept {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom.load(std::memory_order_acquire);
+        if (t < b) {
+            ring* a = buf.load(std::memory_order_acquire);
+            T x = a->get(t);
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                return nullptr;
+            }
+            return x;
+        }
+        return nullptr;
+    }
+
+    // 近似长度
+    int64_t size() const noexcept {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_relaxed);
+        return b > t ? b - t : 0;
+    }
+};
+
+/**
+ * @brief 工作窃取线程池，用于把耗时的计算从反应堆线程中卸载出去
+ * @note 工作线程内提交的任务进入本线程的双端队列，其他线程提交的任务进入共享的注入队列；
+ *       空闲线程依次检查本地队列、注入队列，再随机窃取其他线程的任务
+ */
+class executor {
+public:
+    using task_t = std::function<void()>;
+
+    struct stats_t {
+        uint64_t submitted;
+        uint64_t executed;
+        uint64_t steals;
+        uint64_t queued;    // 当前排队的任务数
+    };
+
+private:
+    struct task_node {
+        task_t fn;
+    };
+    struct worker {
+        executor* pool;
+        ws_deque<task_node*> local;
+        counter executed;
+        counter steals;
+        counter submitted;
+        std::thread thrd;
+    };
+
+    std::vector<std::unique_ptr<worker>> workers;
+    std::mutex lok;
+    std::condition_variable cv;
+    std::deque<task_node*> injected;
+    counter injected_total;  // 由lok保护
+    std::atomic<int64_t> pending = {0};
+    std::atomic<int> sleepers = {0};
+    bool closed = false;
+
+    static worker*& current() {
+        thread_local worker* w = nullptr;
+        return w;
+    }
+
+public:
+    /**
+     * @brief 创建线程池
+     * @param nthreads 工作线程数，0表示使用硬件线程数
+     */
+    explicit executor(unsigned nthreads = 0) {
+        if (!nthreads) nthreads = std::thread::hardware_concurrency();
+        if (!nthreads) nthreads = 1;
+        for (unsigned i = 0; i < nthreads; ++i) {
+            workers.emplace_back(new worker);
+            workers.back()->pool = this;
+        }
+        for (unsigned i = 0; i < nthreads; ++i) {
+            workers[i]->thrd = std::thread(&executor::loop, this, i);
+        }
+    }
+    executor(const executor&) = delete;
+    executor(executor&&) = delete;
+    ~executor() {
+        {
+            std::lock_guard<std::mutex> lock(lok);
+            closed = true;
+        }
+        cv.notify_all();
+        for (auto& w : workers) w->thrd.join();
+        // 关闭后仍未执行的任务直接丢弃
+        for (auto* t : injected) delete t;
+        for (auto& w : workers) {
+            while (auto* t = w->local.pop()) delete t;
+        }
+    }
+
+public:
+    /**
+     * @brief 提交任务，可在任意线程调用
+     * @param fn 任务，类型: void()
+     */
+    void submit(task_t fn) {
+        auto* node = new task_node{std::move(fn)};
+        pending.fetch_add(1);
+        worker* self = current();
+        if (self && self->pool == this) {
+            self->local.push(node);
+            self->submitted.add();
+        } else {
+            std::lock_guard<std::mutex> lock(lok);
+            injected.push_back(node);
+            injected_total.add();
+        }
+        if (sleepers.load() > 0) {
+            std::lock_guard<std::mutex> lock(lok);
+            cv.notify_one();
+        }
+    }
+
+    /**
+     * @brief 在线程池中执行计算，并把结果投递回指定反应堆的线程
+     * @param owner 结果所属的反应堆（通常是连接所在的反应堆）
+     * @param work 计算任务，类型: R()
+     * @param done 完成回调，在owner线程中执行，类型: void(R) 或 void()（当R为void时）
+     */
+    template <typename Work, typename Done>
+    void submit(reactor& owner, Work work, Done done) {
+        using result_t = decltype(work());
+        submit([&owner, work = std::move(work), done = std::move(done)]() mutable {
+            if constexpr (std::is_void<result_t>::value) {
+                work();
+                owner.post(std::move(done));
+            } else {
+                auto res = std::make_shared<result_t>(work());
+                owner.post([res, done = std::move(done)]() mutable { done(std::move(*res)); });
+            }
+        });
+    }
+
+    /**
+     * @brief 获取统计信息
+     */
+    stats_t stats() {
+        stats_t s{0, 0, 0, 0};
+        {
+            std::lock_guard<std::mutex> lock(lok);
+            s.submitted = injected_total.load();
+        }
+        for (auto& w : workers) {
+            s.submitted += w->submitted.load();
+            s.executed += w->executed.load();
+            s.steals += w->steals.load();
+        }
+        s.queued = queue_depth();
+        return s;
+    }
+
+    /**
+     * @brief 当前排队（尚未开始执行）的任务数
+     */
+    uint64_t queue_depth() const noexcept {
+        auto n = pending.load(std::memory_order_relaxed);
+        return n > 0 ? n : 0;
+    }
+
+    size_t num_threads() const noexcept {
+        return workers.size();
+    }
+
+private:
+    task_node* take_injected() {
+        std::lock_guard<std::mutex> lock(lok);
+        if (injected.empty()) return nullptr;
+        auto* t = injected.front();
+        injected.pop_front();
+        return t;
+    }
+
+    task_node* find_task(unsigned idx, std::minstd_rand& rng) {
+        worker& self = *workers[idx];
+        if (auto* t = self.local.pop()) return t;
+        if (auto* t = take_injected()) return t;
+        size_t n = workers.size();
+        size_t start = rng() % n;
+        for (size_t i = 0; i < n; ++i) {
+            size_t victim = (start + i) % n;
+            if (victim == idx) continue;
+            if (auto* t = workers[victim]->local.steal()) {
+                self.steals.add();
+                return t;
+            }
+        }
+        return nullptr;
+    }
+
+    void loop(unsigned idx) {
+        worker& self = *workers[idx];
+        current() = &self;
+        std::minstd_rand rng(idx + 1);
+        while (true) {
+            if (auto* t = find_task(idx, rng)) {
+                pending.fetch_sub(1);
+                t->fn();
+                delete t;
+                self.executed.add();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(lok);
+            sleepers.fetch_add(1);
+            cv.wait(lock, [this] { return closed || pending.load() > 0; });
+            sleepers.fetch_sub(1);
+            if (closed) return;
+        }
+    }
+};
+
+}  // namespace fnet
@@ -1,5 +1,12 @@
 #pragma once
 #include "reactor.h"
 #include "acceptor.h"
+#include "metrics.h"
+#include "membudget.h"
+#include "clock.h"
+#include "shmring.h"
 #include "timer.h"
 #include "sigflow.h"
+#include "balancer.h"
+#include "logger.h"
+#include "rpc.h"
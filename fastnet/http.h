@@ -0,0 +1,522 @@
+#pragma once
+#include <sys/uio.h>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fnet {
+namespace http {
+
+struct header {
+    std::string_view name;
+    std::string_view value;
+};
+
+static constexpr size_t max_headers = 32;
+
+/**
+ * @brief 解析得到的请求，所有视图都指向调用者的缓冲区（如sockbuffer::data()），不做拷贝
+ * @note 视图在调用者消耗掉该请求或移动缓冲区内容之前有效
+ */
+struct request {
+    std::string_view method;
+    std::string_view target;
+    int minor_version = 1;
+    header headers[max_headers];
+    size_t num_headers = 0;
+    std::string_view body;  // 分块编码的消息体已在缓冲区内原地拼接为连续的内容
+    bool keep_alive = true;
+    bool chunked = false;
+
+    /**
+     * @brief 按名称查找头部（不区分大小写）
+     * @return 头部的值，不存在时返回空视图
+     */
+    std::string_view get(std::string_view name) const;
+};
+
+enum class status {
+    complete,    // 解析出一个完整的请求
+    incomplete,  // 需要更多数据
+    error        // 请求非法，error_code()给出建议的响应状态码
+};
+
+namespace details {
+
+inline char lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+}
+
+inline bool iequals(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (lower(a[i]) != lower(b[i])) return false;
+    }
+    return true;
+}
+
+// 逗号分隔的列表中是否含有某个token，如 "Connection: keep-alive, Upgrade"
+inline bool has_token(std::string_view list, std::string_view token) {
+    while (!list.empty()) {
+        auto comma = list.find(',');
+        auto item = list.substr(0, comma);
+        while (!item.empty() && (item.front() == ' ' || item.front() == '\t')) item.remove_prefix(1);
+        while (!item.empty() && (item.back() == ' ' || item.back() == '\t')) item.remove_suffix(1);
+        if (iequals(item, token)) return true;
+        if (comma == list.npos) break;
+        list.remove_prefix(comma + 1);
+    }
+    return false;
+}
+
+inline bool is_tchar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+           (c && strchr("!#$%&'*+-.^_`|~", c));
+}
+
+}  // namespace details
+
+inline std::string_view request::get(std::string_view name) const {
+    for (size_t i = 0; i < num_headers; ++i) {
+        if (details::iequals(headers[i].name, name)) return headers[i].value;
+    }
+    return std::string_view();
+}
+
+/**
+ * @brief 可恢复的HTTP/1.1请求解析器
+ * 每次以同一请求起始处的连续字节调用parse()，数据不完整时返回incomplete并记住进度，
+ * 新数据到达后再次调用时不会重复扫描已扫描过的内容
+ * @note 一个连接一个解析器。两次调用之间调用者可以移动缓冲区（如sockbuffer::drop_read()），
+ *       只要请求起始处之后的内容保持不变
+ */
+class parser {
+    enum class stage { head, body, chunk_size, chunk_data, chunk_crlf, trailer, done };
+
+    stage st = stage::head;
+    size_t max_head;
+    size_t max_body;
+    size_t scanned = 0;   // 已搜索过头部结束符的字节数
+    size_t head_len = 0;
+    size_t raw = 0;       // 分块编码：原始数据已处理到的位置
+    size_t body_len = 0;  // 已得到的消息体长度
+    size_t remain = 0;    // 当前分块剩余的字节数
+    size_t total = 0;
+    int err = 0;
+    const char* base = nullptr;  // 解析头部时缓冲区的地址，用于缓冲区移动后修正视图
+    request head;                // 已解析的请求行与头部，消息体跨越多次调用到达时保存在这里
+
+public:
+    /**
+     * @param max_head 请求行与头部的最大长度，超过时返回error(431)
+     * @param max_body 消息体的最大长度，超过时返回error(413)
+     */
+    explicit parser(size_t max_head = 8192, size_t max_body = 1 << 20)
+        : max_head(max_head)
+        , max_body(max_body) {}
+
+    /**
+     * @brief 解析一个请求
+     * @param data 请求起始处，分块编码的消息体会在此缓冲区内被原地改写
+     * @param len  可用的字节数
+     * @param req  返回complete时被完整填充，各次调用可以传入不同的对象
+     * @return status
+     * @note 返回complete后，调用者应消耗consumed()个字节，下一次调用自动开始解析新的请求
+     */
+    status parse(char* data, size_t len, request& req) {
+        if (err) return status::error;
+        if (st == stage::done) reset();
+        if (st == stage::head) {
+            // 请求行之前允许出现空行；从上次搜索的位置向前回退3字节，防止结束符跨越两次到达的数据
+            size_t lead = 0;
+            while (lead + 1 < len && data[lead] == '\r' && data[lead + 1] == '\n') lead += 2;
+            size_t from = scanned > lead + 3 ? scanned - 3 : lead;
+            auto pos = std::string_view(data, len).find("\r\n\r\n", from);
+            if (pos == std::string_view::npos) {
+                scanned = len;
+                return len > max_head ? fail(431) : status::incomplete;
+            }
+            head_len = pos + 4;
+            if (head_len > max_head) return fail(431);
+            if (!parse_head(data, head)) return err ? status::error : fail(400);
+            base = data;
+            if (head.chunked) {
+                raw = head_len;
+                st = stage::chunk_size;
+            } else {
+                st = stage::body;
+            }
+        }
+        if (st == stage::body) {
+            if (len < head_len + remain) return status::incomplete;
+            body_len = remain;
+            total = head_len + remain;
+        } else if (!parse_chunked(data, len)) {
+            return err ? status::error : status::incomplete;
+        }
+        fill(data, req);
+        req.body = std::string_view(data + head_len, body_len);
+        st = stage::done;
+        return status::complete;
+    }
+
+    /**
+     * @brief 上一个完整请求占用的字节数（含头部与原始的消息体）
+     */
+    size_t consumed() const noexcept {
+        return total;
+    }
+
+    /**
+     * @brief 出错时建议返回给客户端的状态码：400、413、431或501
+     */
+    int error_code() const noexcept {
+        return err;
+    }
+
+    /**
+     * @brief 放弃当前进度，从头开始解析
+     */
+    void reset() {
+        st = stage::head;
+        scanned = head_len = raw = body_len = remain = total = 0;
+        err = 0;
+        base = nullptr;
+    }
+
+private:
+    status fail(int code) {
+        err = code;
+        return status::error;
+    }
+
+    bool parse_head(char* data, request& req) {
+        std::string_view head(data, head_len - 2);  // 保留最后一个头部行的"\r\n"
+        req.num_headers = 0;
+        req.chunked = false;
+        while (head.substr(0, 2) == "\r\n") head.remove_prefix(2);
+        auto eol = head.find("\r\n");
+        if (eol == head.npos) return false;
+        auto line = head.substr(0, eol);
+        head.remove_prefix(eol + 2);
+
+        auto sp1 = line.find(' ');
+        if (sp1 == line.npos || sp1 == 0) return false;
+        req.method = line.substr(0, sp1);
+        for (char c : req.method) {
+            if (!details::is_tchar(c)) return false;
+        }
+        line.remove_prefix(sp1 + 1);
+        auto sp2 = line.find(' ');
+        if (sp2 == line.npos || sp2 == 0) return false;
+        req.target = line.substr(0, sp2);
+        auto ver = line.substr(sp2 + 1);
+        if (ver.size() != 8 || ver.substr(0, 7) != "HTTP/1." || ver[7] < '0' || ver[7] > '9') return false;
+        req.minor_version = ver[7] - '0';
+
+        bool has_length = false;
+        size_t length = 0;
+        std::string_view conn, te;
+        while (!head.empty()) {
+            eol = head.find("\r\n");
+            line = head.substr(0, eol);
+            head.remove_prefix(eol + 2);
+            auto colon = line.find(':');
+            if (colon == line.npos || colon == 0) return false;
+            auto name = line.substr(0, colon);
+            for (char c : name) {
+                if (!details::is_tchar(c)) return false;  // 也拒绝了折叠行与名称后的空白
+            }
+            auto value = line.substr(colon + 1);
+            while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) value.remove_prefix(1);
+            while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) value.remove_suffix(1);
+            if (req.num_headers == max_headers) return fail(431), false;
+            req.headers[req.num_headers++] = {name, value};
+
+            if (details::iequals(name, "content-length")) {
+                if (value.empty()) return false;
+                size_t v = 0;
+                for (char c : value) {
+                    if (c < '0' || c > '9' || v > (SIZE_MAX - 9) / 10) return false;
+                    v = v * 10 + (c - '0');
+                }
+                if (has_length && v != length) return false;
+                has_length = true;
+                length = v;
+            } else if (details::iequals(name, "transfer-encoding")) {
+                te = value;
+            } else if (details::iequals(name, "connection")) {
+                conn = value;
+            }
+        }
+        if (!te.empty()) {
+            // 同时出现两者时无法确定消息边界，按RFC 9112拒绝以免请求走私
+            if (has_length) return false;
+            auto last = te.substr(te.rfind(',') == te.npos ? 0 : te.rfind(',') + 1);
+            if (!details::has_token(last, "chunked")) return fail(501), false;
+            req.chunked = true;
+        }
+        if (length > max_body) return fail(413), false;
+        remain = length;
+        if (req.minor_version == 0) {
+            req.keep_alive = details::has_token(conn, "keep-alive");
+        } else {
+            req.keep_alive = !details::has_token(conn, "close");
+        }
+        return true;
+    }
+
+    // 把分块的内容依次前移，拼接到头部之后；返回true表示消息体（含尾部头）已完整
+    bool parse_chunked(char* data, size_t len) {
+        while (true) {
+            switch (st) {
+            case stage::chunk_size: {
+                auto view = std::string_view(data + raw, len - raw);
+                auto eol = view.find("\r\n");
+                if (eol == view.npos) {
+                    if (view.size() > 1024) fail(400);
+                    return false;
+                }
+                size_t size = 0;
+                size_t i = 0;
+                for (; i < eol; ++i) {
+                    char c = details::lower(view[i]);
+                    int d = (c >= '0' && c <= '9') ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : -1;
+                    if (d < 0) break;
+                    if (size > (SIZE_MAX >> 4)) return fail(400), false;
+                    size = size * 16 + d;
+                }
+                // 分块扩展（";name=value"）被忽略
+                if (i == 0 || (i < eol && view[i] != ';' && view[i] != ' ' && view[i] != '\t')) {
+                    return fail(400), false;
+                }
+                raw += eol + 2;
+                if (size == 0) {
+                    st = stage::trailer;
+                } else {
+                    if (size > max_body - body_len) return fail(413), false;
+                    remain = size;
+                    st = stage::chunk_data;
+                }
+                break;
+            }
+            case stage::chunk_data: {
+                size_t n = len - raw < remain ? len - raw : remain;
+                memmove(data + head_len + body_len, data + raw, n);
+                body_len += n;
+                raw += n;
+                remain -= n;
+                if (remain) return false;
+                st = stage::chunk_crlf;
+                break;
+            }
+            case stage::chunk_crlf:
+                if (len - raw < 2) return false;
+                if (data[raw] != '\r' || data[raw + 1] != '\n') return fail(400), false;
+                raw += 2;
+                st = stage::chunk_size;
+                break;
+            case stage::trailer: {
+                auto view = std::string_view(data + raw, len - raw);
+                auto eol = view.find("\r\n");
+                if (eol == view.npos) {
+                    if (view.size() > max_head) fail(431);
+                    return false;
+                }
+                raw += eol + 2;
+                if (eol == 0) {
+                    total = raw;
+                    return true;
+                }
+                break;  // 尾部头被忽略
+            }
+            default:
+                return false;
+            }
+        }
+    }
+
+    // 把保存的头部复制给调用者；头部解析后缓冲区被移动过时，修正指向旧地址的视图
+    void fill(const char* data, request& req) const {
+        auto fix = [&](std::string_view v) { return std::string_view(data + (v.data() - base), v.size()); };
+        req.method = fix(head.method);
+        req.target = fix(head.target);
+        req.minor_version = head.minor_version;
+        req.num_headers = head.num_headers;
+        for (size_t i = 0; i < head.num_headers; ++i) {
+            req.headers[i] = {fix(head.headers[i].name), fix(head.headers[i].value)};
+        }
+        req.keep_alive = head.keep_alive;
+        req.chunked = head.chunked;
+    }
+};
+
+/**
+ * @brief 状态码对应的原因短语
+ */
+inline const char* reason(int code) {
+    switch (code) {
+    case 100: return "Continue";
+    case 200: return "OK";
+    case 201: return "Created";
+    case 202: return "Accepted";
+    case 204: return "No Content";
+    case 206: return "Partial Content";
+    case 301: return "Moved Permanently";
+    case 302: return "Found";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 403: return "Forbidden";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 408: return "Request Timeout";
+    case 413: return "Content Too Large";
+    case 429: return "Too Many Requests";
+    case 431: return "Request Header Fields Too Large";
+    case 500: return "Internal Server Error";
+    case 501: return "Not Implemented";
+    case 503: return "Service Unavailable";
+    default:  return "Unknown";
+    }
+}
+
+/**
+ * @brief 响应队列：按顺序暂存一个连接上流水线请求的响应，由flush()以writev一次写出
+ * @note 在处理完一批请求（一次读事件）后调用flush()，写不完的部分保留到下次flush()
+ */
+class responder {
+    // data为nullptr时内容位于buf[off, off + len)，否则引用外部内存
+    struct segment {
+        const char* data;
+        size_t off;
+        size_t len;
+    };
+
+    std::string buf;  // 状态行、头部及被拷贝的消息体
+    std::vector<segment> segs;
+    size_t first = 0;  // 第一个未写完的段
+    size_t bytes = 0;
+
+public:
+    /**
+     * @brief 追加一个响应，消息体被拷贝
+     * @param code 状态码
+     * @param body 消息体
+     * @param content_type 为空时不输出Content-Type
+     * @param keep_alive 为false时输出"Connection: close"，调用者应在flush()完成后关闭连接
+     * @param extra 额外的头部
+     */
+    void add(int code, std::string_view body, std::string_view content_type = "text/plain",
+             bool keep_alive = true, std::initializer_list<header> extra = {}) {
+        size_t off = buf.size();
+        append_head(code, body.size(), content_type, keep_alive, extra);
+        buf.append(body);
+        push(nullptr, off, buf.size() - off);
+    }
+
+    /**
+     * @brief 追加一个响应，消息体以引用的方式写出，不做拷贝
+     * @note body指向的内存在flush()将其全部写出之前必须有效，适合静态内容或缓存的页面
+     */
+    void add_static(int code, std::string_view body, std::string_view content_type = "text/plain",
+                    bool keep_alive = true, std::initializer_list<header> extra = {}) {
+        size_t off = buf.size();
+        append_head(code, body.size(), content_type, keep_alive, extra);
+        push(nullptr, off, buf.size() - off);
+        if (!body.empty()) push(body.data(), 0, body.size());
+    }
+
+    /**
+     * @brief 以尽量少的writev写出暂存的响应
+     * @param fd 非阻塞socket
+     * @return 写出的字节数；出现EAGAIN以外的错误时返回-1，未写出的内容保留
+     */
+    ssize_t flush(int fd) {
+        ssize_t written = 0;
+        while (first < segs.size()) {
+            struct iovec iov[64];
+            int cnt = 0;
+            for (size_t i = first; i < segs.size() && cnt < 64; ++i, ++cnt) {
+                auto& s = segs[i];
+                iov[cnt].iov_base = const_cast<char*>(s.data ? s.data : buf.data() + s.off);
+                iov[cnt].iov_len = s.len;
+            }
+            ssize_t n = writev(fd, iov, cnt);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return (errno == EAGAIN || errno == EWOULDBLOCK) ? written : -1;
+            }
+            written += n;
+            bytes -= n;
+            size_t left = n;
+            while (left && left >= segs[first].len) left -= segs[first++].len;
+            if (left) {
+                auto& s = segs[first];
+                if (s.data) s.data += left;
+                else s.off += left;
+                s.len -= left;
+                break;  // 内核发送缓冲已满
+            }
+        }
+        if (first == segs.size()) {
+            buf.clear();
+            segs.clear();
+            first = 0;
+        }
+        return written;
+    }
+
+    /**
+     * @brief 尚未写出的字节数
+     */
+    size_t pending() const noexcept {
+        return bytes;
+    }
+
+    bool empty() const noexcept {
+        return bytes == 0;
+    }
+
+private:
+    void push(const char* data, size_t off, size_t len) {
+        bytes += len;
+        // 与上一段在buf中相邻时合并，减少iovec数量
+        if (!data && first < segs.size() && !segs.back().data && segs.back().off + segs.back().len == off) {
+            segs.back().len += len;
+            return;
+        }
+        segs.push_back({data, off, len});
+    }
+
+    void append_head(int code, size_t length, std::string_view content_type, bool keep_alive,
+                     std::initializer_list<header> extra) {
+        char num[24];
+        buf.append("HTTP/1.1 ");
+        buf.append(num, snprintf(num, sizeof(num), "%d ", code));
+        buf.append(reason(code));
+        buf.append("\r\nContent-Length: ");
+        buf.append(num, snprintf(num, sizeof(num), "%zu", length));
+        if (!content_type.empty()) {
+            buf.append("\r\nContent-Type: ");
+            buf.append(content_type);
+        }
+        if (!keep_alive) buf.append("\r\nConnection: close");
+        for (auto& h : extra) {
+            buf.append("\r\n");
+            buf.append(h.name);
+            buf.append(": ");
+            buf.append(h.value);
+        }
+        buf.append("\r\n\r\n");
+    }
+};
+
+}  // namespace http
+}  // namespace fnet
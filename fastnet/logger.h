@@ -0,0 +1,559 @@
+#pragma once
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "clock.h"
+
+// 编译期的最低日志级别，低于该级别的FNET_LOG_*不生成代码，参数也不求值
+// 0: trace, 1: debug, 2: info, 3: warn, 4: error
+#ifndef FNET_LOG_LEVEL
+#define FNET_LOG_LEVEL 2
+#endif
+
+namespace fnet {
+
+enum class log_level : int {
+    trace = 0,
+    debug,
+    info,
+    warn,
+    error,
+    off
+};
+
+namespace details {
+
+inline const char* log_level_name(log_level l) {
+    static const char* names[] = {"TRACE", "DEBUG", "INFO ", "WARN ", "ERROR"};
+    return names[static_cast<int>(l)];
+}
+
+// 参数按类型编码：数值原样保存，字符串拷贝内容，其他指针保存地址
+template <typename T>
+constexpr bool is_log_string = std::is_convertible_v<const T&, std::string_view>;
+
+template <typename T>
+constexpr bool is_log_cstr = std::is_same_v<std::decay_t<T>, const char*> || std::is_same_v<std::decay_t<T>, char*>;
+
+template <typename T, typename = void>
+struct log_stored {
+    using type = T;
+};
+template <typename T>
+struct log_stored<T, std::enable_if_t<std::is_enum_v<T>>> {
+    using type = std::underlying_type_t<T>;
+};
+template <typename T>
+struct log_stored<T, std::enable_if_t<std::is_pointer_v<T> && !is_log_cstr<T>>> {
+    using type = uintptr_t;
+};
+
+template <typename T>
+std::string_view log_view(const T& v) {
+    if constexpr (std::is_array_v<T>) {
+        return std::string_view(v);  // 字面量与字符数组不会为空，也避免-Waddress告警
+    } else if constexpr (is_log_cstr<T>) {
+        return v ? std::string_view(v) : std::string_view("(null)");
+    } else {
+        return std::string_view(v);
+    }
+}
+
+template <typename T>
+size_t log_arg_size(const T& v) {
+    if constexpr (is_log_string<T>) {
+        return sizeof(uint32_t) + log_view(v).size();
+    } else {
+        return sizeof(typename log_stored<std::decay_t<T>>::type);
+    }
+}
+
+template <typename T>
+char* log_encode(char* p, const T& v) {
+    if constexpr (is_log_string<T>) {
+        auto s = log_view(v);
+        uint32_t n = static_cast<uint32_t>(s.size());
+        memcpy(p, &n, sizeof(n));
+        memcpy(p + sizeof(n), s.data(), n);
+        return p + sizeof(n) + n;
+    } else {
+        using S = typename log_stored<std::decay_t<T>>::type;
+        S s;
+        if constexpr (std::is_pointer_v<std::decay_t<T>>) s = reinterpret_cast<uintptr_t>(v);
+        else s = static_cast<S>(v);
+        memcpy(p, &s, sizeof(s));
+        return p + sizeof(s);
+    }
+}
+
+template <typename T>
+const char* log_decode(const char* p, std::string& out) {
+    if constexpr (is_log_string<T>) {
+        uint32_t n;
+        memcpy(&n, p, sizeof(n));
+        out.append(p + sizeof(n), n);
+        return p + sizeof(n) + n;
+    } else {
+        using D = std::decay_t<T>;
+        using S = typename log_stored<D>::type;
+        S s;
+        memcpy(&s, p, sizeof(s));
+        char buf[32];
+        if constexpr (std::is_same_v<D, bool>) {
+            out += s ? "true" : "false";
+        } else if constexpr (std::is_same_v<D, char>) {
+            out += s;
+        } else if constexpr (std::is_pointer_v<D>) {
+            snprintf(buf, sizeof(buf), "0x%llx", static_cast<unsigned long long>(s));
+            out += buf;
+        } else if constexpr (std::is_floating_point_v<S>) {
+            snprintf(buf, sizeof(buf), "%g", static_cast<double>(s));
+            out += buf;
+        } else if constexpr (std::is_signed_v<S>) {
+            out += std::to_string(static_cast<long long>(s));
+        } else {
+            out += std::to_string(static_cast<unsigned long long>(s));
+        }
+        return p + sizeof(s);
+    }
+}
+
+// 把格式串中下一个"{}"之前的内容追加到out，没有占位符时追加全部并以空格分隔参数
+inline void log_copy_until(const char*& f, std::string& out) {
+    const char* ph = strstr(f, "{}");
+    if (!ph) {
+        out += f;
+        out += ' ';
+        f += strlen(f);
+        return;
+    }
+    out.append(f, ph - f);
+    f = ph + 2;
+}
+
+template <typename... Args>
+void log_format(const char* fmt, const char* args, std::string& out) {
+    const char* f = fmt;
+    ((log_copy_until(f, out), args = log_decode<Args>(args, out)), ...);
+    out += f;
+}
+
+// 记录头部，之后是编码的参数；level为-1的记录是环末尾的填充
+struct log_record {
+    uint32_t size;
+    int32_t level;
+    uint64_t ts;
+    const char* fmt;
+    const char* file;
+    uint64_t line;
+    void (*format)(const char*, const char*, std::string&);
+};
+
+// 每个线程一个的单生产者单消费者环，写不下时丢弃
+struct log_ring {
+    std::unique_ptr<char[]> buf;
+    uint64_t mask;
+    alignas(64) std::atomic<uint64_t> head = {0};
+    uint64_t tail_cache = 0;
+    std::atomic<uint64_t> dropped = {0};
+    alignas(64) std::atomic<uint64_t> tail = {0};
+    std::atomic<bool> retired = {false};  // 所属线程已退出
+
+    explicit log_ring(size_t cap) : buf(new char[cap]), mask(cap - 1) {}
+
+    char* reserve(size_t n) {
+        uint64_t cap = mask + 1;
+        uint64_t h = head.load(std::memory_order_relaxed);
+        uint64_t off = h & mask;
+        uint64_t pad = off + n > cap ? cap - off : 0;
+        if (h + pad + n - tail_cache > cap) {
+            tail_cache = tail.load(std::memory_order_acquire);
+            if (h + pad + n - tail_cache > cap) {
+                dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return nullptr;
+            }
+        }
+        if (pad) {
+            auto* r = reinterpret_cast<log_record*>(buf.get() + off);
+            r->size = static_cast<uint32_t>(pad);
+            r->level = -1;
+            head.store(h + pad, std::memory_order_release);
+            h += pad;
+        }
+        return buf.get() + (h & mask);
+    }
+
+    void commit(size_t n) {
+        head.store(head.load(std::memory_order_relaxed) + n, std::memory_order_release);
+    }
+};
+
+}  // namespace details
+
+/**
+ * @brief 异步日志：调用线程只把参数的二进制形式写入本线程的环，格式化与写出由后台线程批量完成
+ * @note 每个线程的环大小固定，写满时丢弃新的记录并计数（dropped()），日志调用永不阻塞；
+ *       格式串中的"{}"依次替换为参数，格式串必须是字符串常量；
+ *       程序退出或调用flush()时写出所有已记录的日志
+ */
+class logger {
+    std::atomic<int> min_level = {static_cast<int>(log_level::info)};
+    size_t ring_size = 1 << 18;
+    int interval_ms = 2;
+    std::mutex lok;
+    std::condition_variable cv;
+    std::condition_variable done_cv;
+    std::vector<std::shared_ptr<details::log_ring>> rings;
+    std::thread thrd;
+    bool stopping = false;
+    uint64_t flush_req = 0;
+    uint64_t flush_done = 0;
+    std::atomic<uint64_t> written_cnt = {0};
+    uint64_t dropped_reported = 0;  // 已移除的环的丢弃数
+    uint64_t dropped_seen = 0;      // 后台线程已报告过的丢弃数
+
+    // 输出目标，由后台线程使用
+    std::mutex sink_lok;
+    int out_fd = 2;
+    bool own_fd = false;
+    char* journal = nullptr;    // mmap的日志文件
+    size_t journal_len = 0;
+    size_t journal_cap = 0;
+    size_t journal_chunk = 0;
+    int64_t wall_offset = 0;    // CLOCK_REALTIME与单调时钟之差
+
+    struct ring_holder {
+        std::shared_ptr<details::log_ring> ring;
+        ~ring_holder() {
+            if (ring) ring->retired.store(true, std::memory_order_release);
+        }
+    };
+
+    logger() {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        wall_offset = static_cast<int64_t>(ts.tv_sec * 1000000000ll + ts.tv_nsec) -
+                      static_cast<int64_t>(loop_clock::read(clock_source::tsc));
+    }
+
+public:
+    logger(const logger&) = delete;
+    logger& operator=(const logger&) = delete;
+    ~logger() {
+        {
+            std::lock_guard<std::mutex> lock(lok);
+            stopping = true;
+        }
+        cv.notify_one();
+        if (thrd.joinable()) thrd.join();
+        close_sink();
+    }
+
+    static logger& instance() {
+        static logger log;
+        return log;
+    }
+
+    /**
+     * @brief 设置运行时的最低级别（编译期级别见FNET_LOG_LEVEL）
+     */
+    void set_level(log_level l) noexcept {
+        min_level.store(static_cast<int>(l), std::memory_order_relaxed);
+    }
+
+    bool enabled(log_level l) const noexcept {
+        return static_cast<int>(l) >= min_level.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 每个线程的环大小（字节，向上取整为2的幂），只影响之后首次记录日志的线程
+     */
+    void set_ring_size(size_t bytes) {
+        size_t cap = 4096;
+        while (cap < bytes) cap <<= 1;
+        std::lock_guard<std::mutex> lock(lok);
+        ring_size = cap;
+    }
+
+    /**
+     * @brief 后台线程检查各线程的环的间隔（毫秒）
+     */
+    void set_flush_interval(int ms) {
+        std::lock_guard<std::mutex> lock(lok);
+        interval_ms = ms;
+    }
+
+    /**
+     * @brief 写到已打开的fd（默认为标准错误），不接管fd
+     */
+    void open_fd(int fd) {
+        flush();
+        std::lock_guard<std::mutex> lock(sink_lok);
+        close_sink();
+        out_fd = fd;
+    }
+
+    /**
+     * @brief 追加写到文件
+     * @note 失败时抛出异常
+     */
+    void open_file(const char* path) {
+        int fd = ::open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd == -1) throw std::runtime_error(strerror(errno));
+        flush();
+        std::lock_guard<std::mutex> lock(sink_lok);
+        close_sink();
+        out_fd = fd;
+        own_fd = true;
+    }
+
+    /**
+     * @brief 写到mmap的日志文件：后台线程以内存拷贝代替write()，文件按chunk字节扩展，关闭时截断到实际长度
+     * @note 覆盖已有文件；失败时抛出异常
+     */
+    void open_journal(const char* path, size_t chunk = 64 << 20) {
+        int fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd == -1) throw std::runtime_error(strerror(errno));
+        flush();
+        std::lock_guard<std::mutex> lock(sink_lok);
+        close_sink();
+        out_fd = fd;
+        own_fd = true;
+        journal_chunk = chunk;
+        journal_len = 0;
+        journal_cap = 0;
+        if (!grow_journal(chunk)) throw std::runtime_error(strerror(errno));
+    }
+
+    /**
+     * @brief 记录一条日志，一般通过FNET_LOG_*宏调用
+     */
+    template <typename... Args>
+    void log(log_level l, const char* file, int line, const char* fmt, const Args&... args) {
+        auto* ring = local_ring();
+        size_t n = sizeof(details::log_record);
+        ((n += details::log_arg_size(args)), ...);
+        n = (n + 7) & ~size_t(7);
+        if (n > (ring->mask + 1) / 2) {
+            ring->dropped.store(ring->dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return;
+        }
+        char* p = ring->reserve(n);
+        if (!p) return;
+        auto* r = reinterpret_cast<details::log_record*>(p);
+        r->size = static_cast<uint32_t>(n);
+        r->level = static_cast<int32_t>(l);
+        r->ts = loop_clock::read(clock_source::tsc);
+        r->fmt = fmt;
+        r->file = file;
+        r->line = static_cast<uint64_t>(line);
+        r->format = &details::log_format<Args...>;
+        char* a = p + sizeof(details::log_record);
+        ((a = details::log_encode(a, args)), ...);
+        ring->commit(n);
+    }
+
+    /**
+     * @brief 等待此前记录的日志全部写出
+     */
+    void flush() {
+        std::unique_lock<std::mutex> lock(lok);
+        if (!thrd.joinable()) return;
+        uint64_t target = ++flush_req;
+        cv.notify_one();
+        done_cv.wait(lock, [&] { return flush_done >= target; });
+    }
+
+    /**
+     * @brief 因环写满而丢弃的记录数
+     */
+    uint64_t dropped() {
+        std::lock_guard<std::mutex> lock(lok);
+        uint64_t n = dropped_reported;
+        for (auto& r : rings) n += r->dropped.load(std::memory_order_relaxed);
+        return n;
+    }
+
+    /**
+     * @brief 已写出的记录数
+     */
+    uint64_t written() const noexcept {
+        return written_cnt.load(std::memory_order_relaxed);
+    }
+
+private:
+    details::log_ring* local_ring() {
+        static thread_local ring_holder holder;
+        if (!holder.ring) {
+            std::lock_guard<std::mutex> lock(lok);
+            holder.ring = std::make_shared<details::log_ring>(ring_size);
+            rings.push_back(holder.ring);
+            if (!thrd.joinable()) thrd = std::thread(&logger::loop, this);
+        }
+        return holder.ring.get();
+    }
+
+    void loop() {
+        std::string batch;
+        std::vector<std::shared_ptr<details::log_ring>> snapshot;
+        std::unique_lock<std::mutex> lock(lok);
+        while (true) {
+            cv.wait_for(lock, std::chrono::milliseconds(interval_ms),
+                        [&] { return stopping || flush_req > flush_done; });
+            uint64_t req = flush_req;
+            bool stop = stopping;
+            snapshot = rings;
+            lock.unlock();
+            drain(snapshot, batch);
+            lock.lock();
+            // 线程已退出且环已读空的移除，保留其丢弃计数
+            for (auto it = rings.begin(); it != rings.end();) {
+                auto& r = *it;
+                if (r->retired.load(std::memory_order_acquire) &&
+                    r->tail.load(std::memory_order_relaxed) == r->head.load(std::memory_order_acquire)) {
+                    dropped_reported += r->dropped.load(std::memory_order_relaxed);
+                    it = rings.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            flush_done = req;
+            done_cv.notify_all();
+            if (stop) break;
+        }
+    }
+
+    // 取出所有环中已发布的记录，按时间排序后格式化，一次写出
+    void drain(std::vector<std::shared_ptr<details::log_ring>>& snapshot, std::string& batch) {
+        struct item {
+            uint64_t ts;
+            const details::log_record* rec;
+        };
+        std::vector<item> items;
+        std::vector<uint64_t> ends(snapshot.size());
+        for (size_t i = 0; i < snapshot.size(); ++i) {
+            auto& r = *snapshot[i];
+            uint64_t t = r.tail.load(std::memory_order_relaxed);
+            uint64_t h = r.head.load(std::memory_order_acquire);
+            while (t < h) {
+                auto* rec = reinterpret_cast<const details::log_record*>(r.buf.get() + (t & r.mask));
+                if (rec->level >= 0) items.push_back({rec->ts, rec});
+                t += rec->size;
+            }
+            ends[i] = h;
+        }
+        if (items.empty()) return;
+        std::stable_sort(items.begin(), items.end(), [](const item& a, const item& b) { return a.ts < b.ts; });
+        batch.clear();
+        time_t cached_sec = 0;
+        char stamp[32] = {0};
+        for (auto& it : items) {
+            auto* rec = it.rec;
+            int64_t wall = static_cast<int64_t>(rec->ts) + wall_offset;
+            time_t sec = static_cast<time_t>(wall / 1000000000);
+            if (sec != cached_sec) {
+                struct tm tm;
+                localtime_r(&sec, &tm);
+                strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &tm);
+                cached_sec = sec;
+            }
+            char head[96];
+            const char* base = strrchr(rec->file, '/');
+            snprintf(head, sizeof(head), "%s.%06lld %s %s:%llu ", stamp,
+                     static_cast<long long>(wall % 1000000000 / 1000),
+                     details::log_level_name(static_cast<log_level>(rec->level)), base ? base + 1 : rec->file,
+                     static_cast<unsigned long long>(rec->line));
+            batch += head;
+            rec->format(rec->fmt, reinterpret_cast<const char*>(rec) + sizeof(details::log_record), batch);
+            batch += '\n';
+        }
+        for (size_t i = 0; i < snapshot.size(); ++i) snapshot[i]->tail.store(ends[i], std::memory_order_release);
+        // 有新的丢弃时追加一行说明
+        uint64_t lost = dropped_reported;
+        for (auto& r : snapshot) lost += r->dropped.load(std::memory_order_relaxed);
+        if (lost > dropped_seen) {
+            batch += stamp;
+            batch += " WARN  logger: dropped " + std::to_string(lost - dropped_seen) + " records\n";
+            dropped_seen = lost;
+        }
+        write_out(batch);
+        written_cnt.fetch_add(items.size(), std::memory_order_relaxed);
+    }
+
+    void write_out(const std::string& data) {
+        std::lock_guard<std::mutex> lock(sink_lok);
+        if (journal) {
+            if (journal_len + data.size() > journal_cap &&
+                !grow_journal(std::max(journal_chunk, journal_len + data.size() - journal_cap))) {
+                return;
+            }
+            memcpy(journal + journal_len, data.data(), data.size());
+            journal_len += data.size();
+            return;
+        }
+        size_t off = 0;
+        while (off < data.size()) {
+            ssize_t n = ::write(out_fd, data.data() + off, data.size() - off);
+            if (n <= 0) {
+                if (n == -1 && errno == EINTR) continue;
+                return;
+            }
+            off += static_cast<size_t>(n);
+        }
+    }
+
+    // 扩展日志文件并重新映射，调用者需持有sink_lok
+    bool grow_journal(size_t extra) {
+        size_t cap = journal_cap + extra;
+        if (ftruncate(out_fd, static_cast<off_t>(cap)) == -1) return false;
+        void* p = journal ? mremap(journal, journal_cap, cap, MREMAP_MAYMOVE)
+                          : mmap(nullptr, cap, PROT_READ | PROT_WRITE, MAP_SHARED, out_fd, 0);
+        if (p == MAP_FAILED) return false;
+        journal = static_cast<char*>(p);
+        journal_cap = cap;
+        return true;
+    }
+
+    void close_sink() {
+        if (journal) {
+            munmap(journal, journal_cap);
+            (void)!ftruncate(out_fd, static_cast<off_t>(journal_len));
+            journal = nullptr;
+            journal_cap = journal_len = 0;
+        }
+        if (own_fd) close(out_fd);
+        own_fd = false;
+        out_fd = 2;
+    }
+};
+
+}  // namespace fnet
+
+#define FNET_LOG(level, ...)                                                                \
+    do {                                                                                    \
+        if constexpr (static_cast<int>(level) >= FNET_LOG_LEVEL) {                          \
+            auto& fnet_logger_ = ::fnet::logger::instance();                                \
+            if (fnet_logger_.enabled(level)) fnet_logger_.log(level, __FILE__, __LINE__, __VA_ARGS__); \
+        }                                                                                   \
+    } while (0)
+
+#define FNET_LOG_TRACE(...) FNET_LOG(::fnet::log_level::trace, __VA_ARGS__)
+#define FNET_LOG_DEBUG(...) FNET_LOG(::fnet::log_level::debug, __VA_ARGS__)
+#define FNET_LOG_INFO(...)  FNET_LOG(::fnet::log_level::info, __VA_ARGS__)
+#define FNET_LOG_WARN(...)  FNET_LOG(::fnet::log_level::warn, __VA_ARGS__)
+#define FNET_LOG_ERROR(...) FNET_LOG(::fnet::log_level::error, __VA_ARGS__)
@@ -0,0 +1,296 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "conntable.h"
+
+namespace fnet {
+
+class budget_lease;
+
+/**
+ * @brief 连接缓冲的内存预算：统计每个连接的sockbuffer与reactor::send()队列占用的字节数
+ * 单个连接超过conn_limit，或总量超过global_limit * pause_ratio时，暂停读取占用增长的连接；
+ * 总量超过global_limit时，按占用从多到少断开连接，直到回落到global_limit * resume_ratio；
+ * 连接的占用回落到conn_limit * resume_ratio且总量回落到global_limit * resume_ratio以下时恢复读取
+ * @note 由reactor::set_mem_budget()挂载，暂停、恢复与断开在反应堆每轮事件处理之后统一执行（enforce()）；
+ *       只能在所属反应堆线程中使用，多个反应堆共享总量上限时各使用一个sibling()
+ */
+class mem_budget {
+public:
+    struct options {
+        size_t global_limit = 256 << 20;   // 所有连接缓冲的总字节数上限
+        size_t conn_limit = 4 << 20;       // 单个连接的字节数上限
+        double pause_ratio = 0.8;
+        double resume_ratio = 0.5;
+    };
+
+    struct statistics {
+        uint64_t pauses = 0;
+        uint64_t resumes = 0;
+        uint64_t sheds = 0;    // 因总量超限被断开的连接数
+        size_t peak = 0;       // 观察到的总量峰值
+    };
+
+private:
+    friend class budget_lease;
+
+    struct entry {
+        size_t bytes = 0;
+        bool paused = false;
+        bool touched = false;           // 本轮占用有变化，在touched中等待检查
+        budget_lease* lease = nullptr;  // 绑定在该连接上的记账凭证，forget()时使其失效
+    };
+
+    options opt;
+    std::shared_ptr<std::atomic<size_t>> total;
+    conntable<entry> conns;
+    std::vector<int> touched;
+    std::vector<int> paused_fds;
+    size_t local = 0;           // 本实例记账的字节数
+    bool released = false;      // 上次enforce()以来有释放，需要检查能否恢复
+    statistics st;
+
+public:
+    mem_budget() : mem_budget(options()) {}
+    explicit mem_budget(options o)
+        : opt(o)
+        , total(std::make_shared<std::atomic<size_t>>(0)) {}
+    mem_budget(const mem_budget&) = delete;
+    mem_budget(mem_budget&&) = default;
+    ~mem_budget() {
+        if (total) total->fetch_sub(local, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 与本实例共享总量上限的新实例，供另一个反应堆使用
+     */
+    mem_budget sibling() const {
+        mem_budget b(opt);
+        b.total = total;
+        return b;
+    }
+
+    /**
+     * @brief 记入连接新占用的字节
+     */
+    void charge(int fd, size_t n) {
+        if (!n) return;
+        auto& e = conns[fd];
+        e.bytes += n;
+        local += n;
+        size_t t = total->fetch_add(n, std::memory_order_relaxed) + n;
+        if (t > st.peak) st.peak = t;
+        mark(fd, e);
+    }
+
+    /**
+     * @brief 释放连接占用的字节（超出已记账的部分被忽略）
+     */
+    void release(int fd, size_t n) {
+        auto* e = conns.find(fd);
+        if (!e || !n) return;
+        n = std::min(n, e->bytes);
+        e->bytes -= n;
+        local -= n;
+        total->fetch_sub(n, std::memory_order_relaxed);
+        released = true;
+        if (idle(*e)) conns.erase(fd);
+    }
+
+    /**
+     * @brief 连接关闭或迁出：释放其全部占用、取消暂停，绑定在该连接上的记账凭证失效（之后不再访问本实例）
+     */
+    void forget(int fd);
+
+    size_t usage(int fd) const noexcept {
+        auto* e = conns.find(fd);
+        return e ? e->bytes : 0;
+    }
+
+    bool paused(int fd) const noexcept {
+        auto* e = conns.find(fd);
+        return e && e->paused;
+    }
+
+    /**
+     * @brief 总占用（包括共享上限的其他实例），可在任意线程读取
+     */
+    size_t used() const noexcept {
+        return total->load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 本实例记账的字节数
+     */
+    size_t local_used() const noexcept {
+        return local;
+    }
+
+    const options& opts() const noexcept {
+        return opt;
+    }
+
+    const statistics& stats() const noexcept {
+        return st;
+    }
+
+    /**
+     * @brief 执行暂停、断开与恢复，由反应堆在每轮事件处理之后调用
+     * @param pause 类型: void(int fd)，停止监听可读事件
+     * @param resume 类型: void(int fd)，恢复监听可读事件
+     * @param shed 类型: void(int fd)，断开连接（之后本实例会forget(fd)）
+     */
+    template <typename Pause, typename Resume, typename Shed>
+    void enforce(Pause&& pause, Resume&& resume, Shed&& shed) {
+        size_t t = used();
+        auto resume_at = static_cast<size_t>(opt.global_limit * opt.resume_ratio);
+        if (t > opt.global_limit) {
+            // 先按占用从多到少断开，剩下的连接不必再因总量而暂停
+            std::vector<std::pair<size_t, int>> order;
+            order.reserve(conns.size());
+            conns.for_each([&](int fd, entry& e) { order.emplace_back(e.bytes, fd); });
+            std::sort(order.begin(), order.end(), std::greater<std::pair<size_t, int>>());
+            for (auto& o : order) {
+                if (t <= resume_at || !o.first) break;
+                t -= std::min(t, o.first);
+                ++st.sheds;
+                shed(o.second);
+                forget(o.second);
+            }
+            t = used();
+        }
+        auto pause_at = static_cast<size_t>(opt.global_limit * opt.pause_ratio);
+        for (int fd : touched) {
+            auto* e = conns.find(fd);
+            if (!e || !e->touched) continue;
+            e->touched = false;
+            if (!e->paused && e->bytes && (e->bytes > opt.conn_limit || t > pause_at)) {
+                e->paused = true;
+                paused_fds.push_back(fd);
+                ++st.pauses;
+                pause(fd);
+            } else if (idle(*e)) {
+                conns.erase(fd);
+            }
+        }
+        touched.clear();
+        if (released && !paused_fds.empty() && t <= resume_at) {
+            auto conn_resume = static_cast<size_t>(opt.conn_limit * opt.resume_ratio);
+            size_t kept = 0;
+            for (int fd : paused_fds) {
+                auto* e = conns.find(fd);
+                if (!e || !e->paused) continue;
+                if (e->bytes > conn_resume) {
+                    paused_fds[kept++] = fd;
+                    continue;
+                }
+                e->paused = false;
+                ++st.resumes;
+                resume(fd);
+                if (idle(*e)) conns.erase(fd);
+            }
+            paused_fds.resize(kept);
+        }
+        released = false;
+    }
+
+private:
+    static bool idle(const entry& e) noexcept {
+        return !e.bytes && !e.paused && !e.touched && !e.lease;
+    }
+
+    void mark(int fd, entry& e) {
+        if (e.touched) return;
+        e.touched = true;
+        touched.push_back(fd);
+    }
+};
+
+/**
+ * @brief 在内存预算中占用固定字节数的记账凭证，析构或移动赋值时归还
+ * @note 每个连接至多绑定一个；只能在预算所属的反应堆线程中使用与析构。连接被断开或迁出（mem_budget::forget()）
+ *       后凭证失效，不再访问原预算，可在其他线程中析构或重新绑定
+ */
+class budget_lease {
+    friend class mem_budget;
+
+    mem_budget* budget = nullptr;
+    int fd = -1;
+    size_t bytes = 0;
+
+public:
+    budget_lease() = default;
+    budget_lease(mem_budget* b, int fd, size_t n)
+        : budget(b)
+        , fd(fd) {
+        if (!budget) return;
+        budget->charge(fd, n);
+        bytes = n;
+        budget->conns[fd].lease = this;
+    }
+    budget_lease(const budget_lease&) = delete;
+    budget_lease(budget_lease&& o) noexcept {
+        take(o);
+    }
+    budget_lease& operator=(budget_lease&& o) noexcept {
+        if (this != &o) {
+            reset();
+            take(o);
+        }
+        return *this;
+    }
+    ~budget_lease() {
+        reset();
+    }
+
+    /**
+     * @brief 改为占用n字节
+     */
+    void resize(size_t n) {
+        if (!budget) return;
+        if (n > bytes) budget->charge(fd, n - bytes);
+        else budget->release(fd, bytes - n);
+        bytes = n;
+    }
+
+    void reset() {
+        if (auto* e = budget ? budget->conns.find(fd) : nullptr) {
+            e->lease = nullptr;
+            if (bytes) budget->release(fd, bytes);
+            else if (mem_budget::idle(*e)) budget->conns.erase(fd);
+        }
+        budget = nullptr;
+        bytes = 0;
+    }
+
+private:
+    void take(budget_lease& o) noexcept {
+        budget = o.budget;
+        fd = o.fd;
+        bytes = o.bytes;
+        o.budget = nullptr;
+        o.bytes = 0;
+        if (budget) budget->conns[fd].lease = this;
+    }
+};
+
+inline void mem_budget::forget(int fd) {
+    auto* e = conns.find(fd);
+    if (!e) return;
+    if (e->lease) {
+        e->lease->budget = nullptr;
+        e->lease->bytes = 0;
+    }
+    if (e->paused) paused_fds.erase(std::remove(paused_fds.begin(), paused_fds.end(), fd), paused_fds.end());
+    local -= e->bytes;
+    total->fetch_sub(e->bytes, std::memory_order_relaxed);
+    conns.erase(fd);
+    released = true;
+}
+
+}  // namespace fnet
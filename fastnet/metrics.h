@@ -0,0 +1,332 @@
+#pragma once
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace fnet {
+
+// 回调类型，用于分类统计
+enum class cb_kind : int {
+    readable = 0,
+    writable,
+    disconnect,
+    specific,   // 接收器、信号流等内部fd
+    timeout,
+    timer,      // reactor::run_after()/run_at()
+    count
+};
+
+namespace details {
+
+inline const char* cb_kind_name(cb_kind k) {
+    static const char* names[] = {"readable", "writable", "disconnect", "specific", "timeout", "timer"};
+    return names[static_cast<int>(k)];
+}
+
+// 单调时钟的纳秒时间戳
+inline uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}  // namespace details
+
+/**
+ * @brief 计数器，仅允许所属线程写入，任意线程读取
+ * @note 单写者下用relaxed的load+store代替fetch_add，避免lock前缀的开销
+ */
+class counter {
+    std::atomic<uint64_t> val = {0};
+public:
+    void add(uint64_t n = 1) noexcept {
+        val.store(val.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+    uint64_t load() const noexcept {
+        return val.load(std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @brief 仪表，记录当前值（可增可减），仅允许所属线程写入，任意线程读取
+ */
+class gauge {
+    std::atomic<uint64_t> val = {0};
+public:
+    void set(uint64_t v) noexcept {
+        val.store(v, std::memory_order_relaxed);
+    }
+    uint64_t load() const noexcept {
+        return val.load(std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @brief 对数-线性直方图（单写者，无锁）
+ * @note 每个2的幂区间再线性细分为sub_buckets个桶，相对误差不超过1/sub_buckets
+ */
+class histogram {
+public:
+    static const int sub_bits = 3;
+    static const int sub_buckets = 1 << sub_bits;
+    static const int num_buckets = (64 - sub_bits + 1) * sub_buckets;
+
+    // 直方图在某一时刻的拷贝，可在任意线程上计算分位数
+    struct snapshot {
+        std::array<uint64_t, num_buckets> counts = {};
+        uint64_t count = 0;
+        uint64_t sum = 0;
+
+        /**
+         * @brief 计算分位数
+         * @param q 分位，取值[0, 1]
+         * @return 所在桶的上界
+         */
+        uint64_t percentile(double q) const {
+            if (!count) return 0;
+            uint64_t rank = static_cast<uint64_t>(q * count);
+            if (rank >= count) rank = count - 1;
+            uint64_t seen = 0;
+            for (int i = 0; i < num_buckets; ++i) {
+                seen += counts[i];
+                if (seen > rank) return upper_bound(i);
+            }
+            return upper_bound(num_buckets - 1);
+        }
+
+        double mean() const {
+            return count ? static_cast<double>(sum) / count : 0.0;
+        }
+
+        // 合并另一份快照（如多个线程的直方图）
+        void merge(const snapshot& other) {
+            for (int i = 0; i < num_buckets; ++i) counts[i] += other.counts[i];
+            count += other.count;
+            sum += other.sum;
+        }
+    };
+
+private:
+    std::array<std::atomic<uint64_t>, num_buckets> buckets = {};
+    counter total;
+    counter sum;
+
+public:
+    histogram() = default;
+    histogram(const histogram&) = delete;
+
+    static int index_of(uint64_t v) noexcept {
+        if (v < static_cast<uint64_t>(sub_buckets)) return static_cast<int>(v);
+        int msb = 63 - __builtin_clzll(v);
+        int shift = msb - sub_bits;
+        return (shift + 1) * sub_buckets + static_cast<int>((v >> shift) & (sub_buckets - 1));
+    }
+
+    static uint64_t lower_bound(int idx) noexcept {
+        if (idx < sub_buckets) return idx;
+        int shift = idx / sub_buckets - 1;
+        return static_cast<uint64_t>(sub_buckets + idx % sub_buckets) << shift;
+    }
+
+    static uint64_t upper_bound(int idx) noexcept {
+        if (idx < sub_buckets) return idx;
+        int shift = idx / sub_buckets - 1;
+        return lower_bound(idx) + ((uint64_t(1) << shift) - 1);
+    }
+
+    /**
+     * @brief 记录一个样本
+     * @param v 样本值
+     */
+    void record(uint64_t v) noexcept {
+        auto& b = buckets[index_of(v)];
+        b.store(b.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        total.add();
+        sum.add(v);
+    }
+
+    snapshot snap() const {
+        snapshot s;
+        for (int i = 0; i < num_buckets; ++i) s.counts[i] = buckets[i].load(std::memory_order_relaxed);
+        s.count = total.load();
+        s.sum = sum.load();
+        return s;
+    }
+};
+
+/**
+ * @brief 单个反应堆的运行指标
+ * @note 所有字段只由反应堆线程写入，可在任意线程读取快照；timer_lag_ns记录反应堆自己的定时器，
+ *       timer_master只应在反应堆线程中清理时与之共用（见timer_master::set_lag_histogram()）
+ */
+struct reactor_metrics {
+    counter loop_iterations;    // epoll_wait返回次数
+    counter timeouts;           // 超时唤醒次数
+    counter events;             // 处理的事件总数
+    counter accepts;            // 接收的连接数（不含指标接收器）
+    counter scrapes;            // 指标接收器接收的抓取连接数
+    counter bytes_read;         // sockbuffer读入的字节数
+    counter bytes_written;      // 写出的字节数
+    counter deferred_reads;     // 因读预算被推迟处理的次数
+    counter rejected_accepts;   // 被准入控制拒绝（接收后立即关闭）的连接数
+    counter sockopt_failures;   // 设置socket选项失败而关闭的连接数
+    counter paused_reads;       // 因限速暂停读取的次数
+    counter epoll_ctls;         // 反应堆发出的epoll_ctl调用数
+    counter epoll_ctls_saved;   // 因掩码未变或同一轮中合并而省去的epoll_ctl调用数
+    counter sends;              // reactor::send()的调用数
+    counter send_syscalls;      // 写出reactor::send()的数据所用的系统调用数
+    counter migrations;         // 迁出到其他反应堆的连接数
+    counter budget_deferred;    // 超出优先级时间预算、推迟到下一轮的事件数
+    counter mem_pauses;         // 因内存预算暂停读取的次数
+    counter mem_sheds;          // 因内存总量超限被断开的连接数
+    gauge mem_used;             // 挂载内存预算时连接缓冲占用的字节数（每轮更新，含共享上限的其他反应堆）
+
+    histogram loop_time_ns;         // 每轮事件处理耗时（不含等待）
+    histogram events_per_wakeup;    // 每次唤醒的事件数
+    histogram cb_latency_ns[static_cast<int>(cb_kind::count)];  // 各类回调耗时
+    histogram timer_lag_ns;         // 定时器实际执行时间与超时时间点之差（run_after()/run_at()）
+    histogram sockbuffer_fill;      // 读后sockbuffer的填充率（百分比）
+
+    struct snapshot {
+        uint64_t loop_iterations;
+        uint64_t timeouts;
+        uint64_t events;
+        uint64_t accepts;
+        uint64_t scrapes;
+        uint64_t bytes_read;
+        uint64_t bytes_written;
+        uint64_t deferred_reads;
+        uint64_t rejected_accepts;
+        uint64_t sockopt_failures;
+        uint64_t paused_reads;
+        uint64_t epoll_ctls;
+        uint64_t epoll_ctls_saved;
+        uint64_t sends;
+        uint64_t send_syscalls;
+        uint64_t migrations;
+        uint64_t budget_deferred;
+        uint64_t mem_pauses;
+        uint64_t mem_sheds;
+        uint64_t mem_used;
+        histogram::snapshot loop_time_ns;
+        histogram::snapshot events_per_wakeup;
+        histogram::snapshot cb_latency_ns[static_cast<int>(cb_kind::count)];
+        histogram::snapshot timer_lag_ns;
+        histogram::snapshot sockbuffer_fill;
+    };
+
+    /**
+     * @brief 获取当前指标的快照
+     * @note 各字段分别读取，彼此之间不保证是同一时刻的值
+     */
+    snapshot snap() const {
+        snapshot s;
+        s.loop_iterations = loop_iterations.load();
+        s.timeouts = timeouts.load();
+        s.events = events.load();
+        s.accepts = accepts.load();
+        s.scrapes = scrapes.load();
+        s.bytes_read = bytes_read.load();
+        s.bytes_written = bytes_written.load();
+        s.deferred_reads = deferred_reads.load();
+        s.rejected_accepts = rejected_accepts.load();
+        s.sockopt_failures = sockopt_failures.load();
+        s.paused_reads = paused_reads.load();
+        s.epoll_ctls = epoll_ctls.load();
+        s.epoll_ctls_saved = epoll_ctls_saved.load();
+        s.sends = sends.load();
+        s.send_syscalls = send_syscalls.load();
+        s.migrations = migrations.load();
+        s.budget_deferred = budget_deferred.load();
+        s.mem_pauses = mem_pauses.load();
+        s.mem_sheds = mem_sheds.load();
+        s.mem_used = mem_used.load();
+        s.loop_time_ns = loop_time_ns.snap();
+        s.events_per_wakeup = events_per_wakeup.snap();
+        for (int i = 0; i < static_cast<int>(cb_kind::count); ++i) s.cb_latency_ns[i] = cb_latency_ns[i].snap();
+        s.timer_lag_ns = timer_lag_ns.snap();
+        s.sockbuffer_fill = sockbuffer_fill.snap();
+        return s;
+    }
+};
+
+namespace details {
+
+inline void prom_counter(std::string& out, const std::string& name, const char* labels, uint64_t v) {
+    out += "# TYPE " + name + " counter\n";
+    out += name + "{" + labels + "} " + std::to_string(v) + "\n";
+}
+
+inline void prom_gauge(std::string& out, const std::string& name, const char* labels, uint64_t v) {
+    out += "# TYPE " + name + " gauge\n";
+    out += name + "{" + labels + "} " + std::to_string(v) + "\n";
+}
+
+// 输出的最大边界为2^40-1，纳秒计约18分钟，更大的样本只计入+Inf
+static const int prom_max_pow2 = 40;
+
+inline void prom_histogram(std::string& out, const std::string& name, const std::string& labels,
+                           const histogram::snapshot& h, bool with_type = true) {
+    if (with_type) out += "# TYPE " + name + " histogram\n";
+    std::string sep = labels.empty() ? "" : ",";
+    // 每次输出同一组边界le=2^k-1（恰好是内部桶的上界），把内部桶按2的幂合并，便于跨时间与跨实例聚合
+    uint64_t cum = 0;
+    int i = 0;
+    for (int k = 0; k <= prom_max_pow2; ++k) {
+        uint64_t le = (uint64_t(1) << k) - 1;
+        for (int end = histogram::index_of(le); i <= end; ++i) cum += h.counts[i];
+        out += name + "_bucket{" + labels + sep + "le=\"" + std::to_string(le) + "\"} " + std::to_string(cum) + "\n";
+    }
+    out += name + "_bucket{" + labels + sep + "le=\"+Inf\"} " + std::to_string(h.count) + "\n";
+    out += name + "_sum{" + labels + "} " + std::to_string(h.sum) + "\n";
+    out += name + "_count{" + labels + "} " + std::to_string(h.count) + "\n";
+}
+
+}  // namespace details
+
+/**
+ * @brief 将指标快照输出为Prometheus文本格式
+ * @param s 指标快照
+ * @param labels 附加的标签，如 reactor="0"，可为空
+ * @param prefix 指标名前缀
+ * @return Prometheus文本
+ */
+inline std::string to_prometheus(const reactor_metrics::snapshot& s, const char* labels = "",
+                                 const std::string& prefix = "fastnet") {
+    std::string out;
+    out.reserve(4096);
+    details::prom_counter(out, prefix + "_loop_iterations_total", labels, s.loop_iterations);
+    details::prom_counter(out, prefix + "_timeouts_total", labels, s.timeouts);
+    details::prom_counter(out, prefix + "_events_total", labels, s.events);
+    details::prom_counter(out, prefix + "_accepts_total", labels, s.accepts);
+    details::prom_counter(out, prefix + "_scrapes_total", labels, s.scrapes);
+    details::prom_counter(out, prefix + "_read_bytes_total", labels, s.bytes_read);
+    details::prom_counter(out, prefix + "_written_bytes_total", labels, s.bytes_written);
+    details::prom_counter(out, prefix + "_deferred_reads_total", labels, s.deferred_reads);
+    details::prom_counter(out, prefix + "_rejected_accepts_total", labels, s.rejected_accepts);
+    details::prom_counter(out, prefix + "_sockopt_failures_total", labels, s.sockopt_failures);
+    details::prom_counter(out, prefix + "_paused_reads_total", labels, s.paused_reads);
+    details::prom_counter(out, prefix + "_epoll_ctl_total", labels, s.epoll_ctls);
+    details::prom_counter(out, prefix + "_epoll_ctl_saved_total", labels, s.epoll_ctls_saved);
+    details::prom_counter(out, prefix + "_sends_total", labels, s.sends);
+    details::prom_counter(out, prefix + "_send_syscalls_total", labels, s.send_syscalls);
+    details::prom_counter(out, prefix + "_migrations_total", labels, s.migrations);
+    details::prom_counter(out, prefix + "_budget_deferred_events_total", labels, s.budget_deferred);
+    details::prom_counter(out, prefix + "_mem_pauses_total", labels, s.mem_pauses);
+    details::prom_counter(out, prefix + "_mem_sheds_total", labels, s.mem_sheds);
+    details::prom_gauge(out, prefix + "_mem_used_bytes", labels, s.mem_used);
+    details::prom_histogram(out, prefix + "_loop_time_ns", labels, s.loop_time_ns);
+    details::prom_histogram(out, prefix + "_events_per_wakeup", labels, s.events_per_wakeup);
+    std::string base(labels);
+    std::string sep = base.empty() ? "" : ",";
+    for (int i = 0; i < static_cast<int>(cb_kind::count); ++i) {
+        std::string l = base + sep + "kind=\"" + details::cb_kind_name(static_cast<cb_kind>(i)) + "\"";
+        details::prom_histogram(out, prefix + "_callback_latency_ns", l, s.cb_latency_ns[i], i == 0);
+    }
+    details::prom_histogram(out, prefix + "_timer_lag_ns", labels, s.timer_lag_ns);
+    details::prom_histogram(out, prefix + "_sockbuffer_fill_percent", labels, s.sockbuffer_fill);
+    return out;
+}
+
+}  // namespace fnet
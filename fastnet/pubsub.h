@@ -0,0 +1,422 @@
+#pragma once
+#include <sys/uio.h>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "reactor.h"
+
+namespace fnet {
+
+/**
+ * @brief 引用计数的只读消息，一次发布只分配、拷贝一次，所有订阅者的队列共享同一份内容
+ * @note 计数是原子的，可以跨反应堆传递
+ */
+class payload {
+    struct block {
+        std::atomic<uint32_t> refs;
+        size_t len;
+        char data[1];
+    };
+    block* blk = nullptr;
+
+    explicit payload(block* b) : blk(b) {}
+
+public:
+    payload() = default;
+    payload(const payload& other) noexcept : blk(other.blk) {
+        if (blk) blk->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+    payload(payload&& other) noexcept : blk(other.blk) {
+        other.blk = nullptr;
+    }
+    payload& operator=(payload other) noexcept {
+        std::swap(blk, other.blk);
+        return *this;
+    }
+    ~payload() {
+        if (blk && blk->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            blk->~block();
+            free(blk);
+        }
+    }
+
+    /**
+     * @brief 拷贝内容并创建消息
+     */
+    static payload make(const void* data, size_t len) {
+        void* mem = malloc(offsetof(block, data) + len + 1);
+        if (!mem) throw std::bad_alloc();
+        block* b = new (mem) block;
+        b->refs.store(1, std::memory_order_relaxed);
+        b->len = len;
+        memcpy(b->data, data, len);
+        return payload(b);
+    }
+
+    static payload make(std::string_view s) {
+        return make(s.data(), s.size());
+    }
+
+    const char* data() const noexcept {
+        return blk ? blk->data : nullptr;
+    }
+
+    size_t size() const noexcept {
+        return blk ? blk->len : 0;
+    }
+
+    uint32_t use_count() const noexcept {
+        return blk ? blk->refs.load(std::memory_order_relaxed) : 0;
+    }
+};
+
+/**
+ * @brief 订阅者的发送队列写满时的处理方式
+ */
+enum class overflow {
+    drop_newest,  // 丢弃新消息
+    drop_oldest,  // 丢弃最旧的（尚未开始写出的）消息
+    disconnect    // 断开该订阅者
+};
+
+/**
+ * @brief 单个反应堆上基于主题的发布/订阅
+ * 每个主题的订阅者fd连续存放；发布时消息只被加入各订阅者的有界队列，
+ * 同一轮事件循环中的多次发布在本轮末尾统一以writev写出，每个订阅者一次系统调用
+ * @note 只能在所属反应堆的线程中使用。订阅者的fd需已通过add_socket()加入反应堆，
+ *       并在可写回调中调用on_writable()，在断开回调中调用remove()
+ */
+class pubsub {
+public:
+    struct options {
+        size_t max_messages = 1024;           // 每个订阅者最多排队的消息数
+        size_t max_bytes = 4 * 1024 * 1024;   // 每个订阅者最多排队的字节数
+        overflow policy = overflow::drop_newest;
+        event_t events = event::readable;     // 订阅者fd平时监听的事件，发送缓冲满时额外监听可写
+        pattern_t pattern = pattern::lt;
+    };
+
+    struct statistics {
+        uint64_t published = 0;
+        uint64_t delivered = 0;     // 已进入发送队列的消息数（按订阅者计）
+        uint64_t dropped = 0;
+        uint64_t disconnected = 0;
+    };
+
+private:
+    struct topic {
+        std::string name;
+        std::vector<int> fds;
+    };
+
+    struct subscriber {
+        bool active = false;
+        bool dirty = false;        // 已在待写出列表中
+        bool want_write = false;
+        size_t head_off = 0;       // 队首消息已写出的字节数
+        size_t bytes = 0;
+        std::deque<payload> queue;
+        std::vector<std::pair<uint32_t, uint32_t>> topics;  // (主题, 在主题fds中的下标)
+    };
+
+    reactor& rec;
+    options opt;
+    std::deque<topic> topics;  // 只增不删，元素地址不变
+    std::unordered_map<std::string_view, uint32_t> topic_ids;  // 键指向topics中的名称，查找时不构造std::string
+    std::vector<subscriber> subs;  // fd索引
+    std::vector<int> dirty;
+    bool flush_scheduled = false;
+    statistics st;
+    std::function<void(int)> overflow_cb;
+
+public:
+    explicit pubsub(reactor& rec) : pubsub(rec, options()) {}
+    pubsub(reactor& rec, options opt)
+        : rec(rec)
+        , opt(opt) {}
+    pubsub(const pubsub&) = delete;
+
+    /**
+     * @brief 订阅
+     * @param name 主题名，不存在时创建
+     * @param fd   订阅者
+     */
+    void subscribe(std::string_view name, int fd) {
+        uint32_t t = topic_id(name);
+        auto& s = sub(fd);
+        for (auto& m : s.topics) {
+            if (m.first == t) return;
+        }
+        s.active = true;
+        s.topics.emplace_back(t, static_cast<uint32_t>(topics[t].fds.size()));
+        topics[t].fds.push_back(fd);
+    }
+
+    /**
+     * @brief 退订
+     */
+    void unsubscribe(std::string_view name, int fd) {
+        auto it = topic_ids.find(name);
+        if (it == topic_ids.end() || fd >= static_cast<int>(subs.size())) return;
+        auto& ms = subs[fd].topics;
+        for (size_t i = 0; i < ms.size(); ++i) {
+            if (ms[i].first == it->second) {
+                detach(it->second, ms[i].second);
+                ms[i] = ms.back();
+                ms.pop_back();
+                return;
+            }
+        }
+    }
+
+    /**
+     * @brief 移除订阅者：退订所有主题并丢弃其发送队列，连接断开时调用
+     * @note 不关闭fd，须在关闭fd之前调用
+     */
+    void remove(int fd) {
+        if (fd >= static_cast<int>(subs.size()) || !subs[fd].active) return;
+        auto& s = subs[fd];
+        for (auto& m : s.topics) detach(m.first, m.second);
+        if (s.want_write) rec.reset_event(fd, opt.events, opt.pattern);
+        s = subscriber();
+    }
+
+    /**
+     * @brief 发布消息
+     * @param name 主题名
+     * @param msg  消息，所有订阅者共享同一份
+     * @param except 不接收该消息的fd，如发布者自己
+     * @return 进入发送队列的订阅者数
+     */
+    size_t publish(std::string_view name, const payload& msg, int except = -1) {
+        auto it = topic_ids.find(name);
+        return it == topic_ids.end() ? 0 : publish(it->second, msg, except);
+    }
+
+    size_t publish(std::string_view name, const void* data, size_t len, int except = -1) {
+        auto it = topic_ids.find(name);
+        if (it == topic_ids.end() || topics[it->second].fds.empty()) return 0;
+        return publish(it->second, payload::make(data, len), except);
+    }
+
+    /**
+     * @brief 立即写出所有订阅者排队的消息
+     * @note 发布后会自动在本轮事件循环末尾写出（见reactor::at_iteration_end()），一般无需手动调用
+     */
+    void flush() {
+        std::vector<int> todo;
+        todo.swap(dirty);
+        for (int fd : todo) {
+            subs[fd].dirty = false;
+            if (subs[fd].active) write_queue(fd);
+        }
+    }
+
+    /**
+     * @brief 订阅者fd可写时调用，继续写出排队的消息
+     */
+    void on_writable(int fd) {
+        if (fd < static_cast<int>(subs.size()) && subs[fd].active) write_queue(fd);
+    }
+
+    /**
+     * @brief 设置overflow::disconnect策略断开订阅者时的回调，默认调用reactor::disconnect()交给反应堆的断开回调
+     * @note 回调执行时订阅者已被remove()
+     */
+    void set_overflow_cb(std::function<void(int)> cb) {
+        overflow_cb = std::move(cb);
+    }
+
+    /**
+     * @brief 主题的订阅者数
+     */
+    size_t subscribers(std::string_view name) const {
+        auto it = topic_ids.find(name);
+        return it == topic_ids.end() ? 0 : topics[it->second].fds.size();
+    }
+
+    /**
+     * @brief 订阅者排队未写出的字节数
+     */
+    size_t queued_bytes(int fd) const {
+        return fd < static_cast<int>(subs.size()) ? subs[fd].bytes : 0;
+    }
+
+    const statistics& stats() const noexcept {
+        return st;
+    }
+
+private:
+    subscriber& sub(int fd) {
+        if (fd >= static_cast<int>(subs.size())) subs.resize(fd + 1);
+        return subs[fd];
+    }
+
+    uint32_t topic_id(std::string_view name) {
+        auto it = topic_ids.find(name);
+        if (it != topic_ids.end()) return it->second;
+        uint32_t id = static_cast<uint32_t>(topics.size());
+        topics.push_back({std::string(name), {}});
+        topic_ids.emplace(topics.back().name, id);
+        return id;
+    }
+
+    // 从主题的订阅者数组中移除下标pos，用最后一个订阅者填补空位
+    void detach(uint32_t t, uint32_t pos) {
+        auto& fds = topics[t].fds;
+        int moved = fds.back();
+        fds[pos] = moved;
+        fds.pop_back();
+        if (pos == fds.size()) return;
+        for (auto& m : subs[moved].topics) {
+            if (m.first == t) {
+                m.second = pos;
+                break;
+            }
+        }
+    }
+
+    size_t publish(uint32_t t, const payload& msg, int except) {
+        st.published++;
+        size_t n = 0;
+        auto& fds = topics[t].fds;
+        std::vector<int> evicted;
+        for (size_t i = 0; i < fds.size(); ++i) {
+            int fd = fds[i];
+            if (fd == except) continue;
+            auto& s = subs[fd];
+            if (s.queue.size() >= opt.max_messages || s.bytes + msg.size() > opt.max_bytes) {
+                if (!make_room(s, msg.size())) {
+                    st.dropped++;
+                    if (opt.policy == overflow::disconnect) evicted.push_back(fd);
+                    continue;
+                }
+            }
+            s.queue.push_back(msg);
+            s.bytes += msg.size();
+            st.delivered++;
+            ++n;
+            if (!s.dirty && !s.want_write) {
+                s.dirty = true;
+                dirty.push_back(fd);
+            }
+        }
+        for (int fd : evicted) {
+            remove(fd);
+            st.disconnected++;
+            if (overflow_cb) overflow_cb(fd);
+            else rec.disconnect(fd);
+        }
+        if (!dirty.empty() && !flush_scheduled) {
+            flush_scheduled = true;
+            rec.at_iteration_end([this] {
+                flush_scheduled = false;
+                flush();
+            });
+        }
+        return n;
+    }
+
+    // 按策略为新消息腾出空间，返回false表示该消息不能入队
+    bool make_room(subscriber& s, size_t len) {
+        if (opt.policy != overflow::drop_oldest) return false;
+        // 队首消息可能已经写出一部分，不能丢弃
+        size_t keep = s.head_off ? 1 : 0;
+        while (s.queue.size() > keep && (s.queue.size() >= opt.max_messages || s.bytes + len > opt.max_bytes)) {
+            auto it = s.queue.begin() + keep;
+            s.bytes -= it->size();
+            s.queue.erase(it);
+            st.dropped++;
+        }
+        return s.queue.size() < opt.max_messages && s.bytes + len <= opt.max_bytes;
+    }
+
+    void write_queue(int fd) {
+        auto& s = subs[fd];
+        while (!s.queue.empty()) {
+            struct iovec iov[64];
+            int cnt = 0;
+            for (auto it = s.queue.begin(); it != s.queue.end() && cnt < 64; ++it, ++cnt) {
+                size_t off = cnt ? 0 : s.head_off;
+                iov[cnt].iov_base = const_cast<char*>(it->data() + off);
+                iov[cnt].iov_len = it->size() - off;
+            }
+            ssize_t n = writev(fd, iov, cnt);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    // 连接已出错，丢弃队列，等待反应堆的断开回调
+                    s.queue.clear();
+                    s.bytes = s.head_off = 0;
+                }
+                break;
+            }
+            s.bytes -= n;
+            size_t left = n + s.head_off;
+            while (!s.queue.empty() && left >= s.queue.front().size()) {
+                left -= s.queue.front().size();
+                s.queue.pop_front();
+            }
+            s.head_off = left;
+            if (left) break;  // 发送缓冲已满
+        }
+        bool pending = !s.queue.empty();
+        if (pending != s.want_write) {
+            s.want_write = pending;
+            rec.reset_event(fd, opt.events | (pending ? event::writable : event::null), opt.pattern);
+        }
+    }
+};
+
+/**
+ * @brief 分布在多个反应堆上的发布/订阅：每个反应堆（分片）管理自己线程中的连接，
+ *        发布时消息只创建一次，通过reactor::post()交给各分片，由分片写给本地的订阅者
+ * @note 订阅、退订、移除须在fd所属分片的线程中调用（shard(i)）；publish()可在任意线程调用
+ */
+class pubsub_group {
+    std::vector<std::unique_ptr<pubsub>> shards;
+    std::vector<reactor*> reactors;
+
+public:
+    pubsub_group(const std::vector<reactor*>& recs, pubsub::options opt = pubsub::options()) : reactors(recs) {
+        for (auto* r : recs) shards.emplace_back(new pubsub(*r, opt));
+    }
+
+    pubsub& shard(size_t i) {
+        return *shards[i];
+    }
+
+    size_t size() const noexcept {
+        return shards.size();
+    }
+
+    /**
+     * @brief 向所有分片发布
+     * @param except 不接收消息的fd（仅在except_shard分片中生效）
+     */
+    void publish(std::string_view name, const payload& msg, int except = -1, size_t except_shard = SIZE_MAX) {
+        auto topic = std::make_shared<const std::string>(name);
+        for (size_t i = 0; i < shards.size(); ++i) {
+            pubsub* s = shards[i].get();
+            int ex = i == except_shard ? except : -1;
+            reactors[i]->post([s, topic, msg, ex] { s->publish(*topic, msg, ex); });
+        }
+    }
+
+    void publish(std::string_view name, const void* data, size_t len, int except = -1, size_t except_shard = SIZE_MAX) {
+        publish(name, payload::make(data, len), except, except_shard);
+    }
+};
+
+}  // namespace fnet
@@ -0,0 +1,261 @@
+#pragma once
+#include <netinet/in.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "address.h"
+#include "conntable.h"
+
+namespace fnet {
+
+/**
+ * @brief 令牌桶：按时间惰性补充令牌，不需要为每个桶设置定时器
+ * @note 时间由调用者传入（纳秒，单调时钟），同一个桶只能在一个线程中使用
+ */
+class token_bucket {
+    double rate = 0;    // 每纳秒补充的令牌数
+    double burst = 0;   // 桶容量
+    double tokens = 0;
+    uint64_t last = 0;
+
+    void refill(uint64_t now) {
+        if (now > last) {
+            tokens = std::min(burst, tokens + (now - last) * rate);
+            last = now;
+        }
+    }
+
+public:
+    token_bucket() = default;
+    /**
+     * @param per_sec 每秒补充的令牌数
+     * @param burst   桶容量，初始时桶是满的
+     */
+    token_bucket(double per_sec, double burst)
+        : rate(per_sec / 1e9)
+        , burst(burst)
+        , tokens(burst) {}
+
+    /**
+     * @brief 尝试取出n个令牌
+     * @return 令牌不足时返回false，且不取出
+     */
+    bool try_take(double n, uint64_t now) {
+        refill(now);
+        if (tokens < n) return false;
+        tokens -= n;
+        return true;
+    }
+
+    /**
+     * @brief 桶中积累到n个令牌的时间点
+     * @return 纳秒时间戳，已足够时返回now
+     */
+    uint64_t ready_at(double n, uint64_t now) {
+        refill(now);
+        if (tokens >= n) return now;
+        if (rate <= 0 || n > burst) return UINT64_MAX;
+        return now + static_cast<uint64_t>(std::ceil((n - tokens) / rate));
+    }
+
+    double available(uint64_t now) {
+        refill(now);
+        return tokens;
+    }
+};
+
+/**
+ * @brief 对端地址的紧凑键，IPv4地址直接作为键
+ */
+inline uint64_t ip_key(const sockaddr_in& addr) {
+    return static_cast<uint64_t>(addr.sin_addr.s_addr) | (uint64_t(1) << 32);
+}
+
+/**
+ * @brief 任意对端地址的紧凑键
+ * @note IPv6取前64位（通常一个主机或用户分得一个/64前缀），IPv4映射地址按IPv4处理；UNIX域连接共用一个键
+ */
+inline uint64_t ip_key(const peer_address& addr) {
+    if (addr.is_v4()) return ip_key(addr.v4());
+    if (addr.is_v6()) {
+        const uint8_t* b = addr.v6().sin6_addr.s6_addr;
+        if (IN6_IS_ADDR_V4MAPPED(&addr.v6().sin6_addr)) {
+            uint32_t v4;
+            std::memcpy(&v4, b + 12, 4);
+            return static_cast<uint64_t>(v4) | (uint64_t(1) << 32);
+        }
+        uint64_t prefix;
+        std::memcpy(&prefix, b, 8);
+        // 避开IPv4键的空间（高32位为1）与空键0
+        return (prefix ^ 0x9e3779b97f4a7c15ULL) | (uint64_t(1) << 63);
+    }
+    return uint64_t(2) << 32;
+}
+
+/**
+ * @brief 以对端地址为键的开放寻址哈希表（线性探测，删除时后移），记录每个地址的连接数与请求令牌桶
+ * @note 容量为2的幂，装载率超过一半时扩容；没有连接的地址会被删除
+ */
+class ip_table {
+public:
+    struct entry {
+        uint64_t key = 0;   // 0表示空
+        uint32_t conns = 0;
+        token_bucket bucket;
+    };
+
+private:
+    std::vector<entry> slots;
+    size_t used = 0;
+
+    static uint64_t mix(uint64_t k) {
+        k ^= k >> 33;
+        k *= 0xff51afd7ed558ccdULL;
+        k ^= k >> 33;
+        return k;
+    }
+
+    size_t mask() const {
+        return slots.size() - 1;
+    }
+
+    void grow() {
+        std::vector<entry> old(slots.empty() ? 64 : slots.size() * 2);
+        old.swap(slots);
+        used = 0;
+        for (auto& e : old) {
+            if (e.key) insert(e.key) = e;
+        }
+    }
+
+public:
+    /**
+     * @return 不存在时返回nullptr
+     */
+    entry* find(uint64_t key) {
+        if (slots.empty()) return nullptr;
+        for (size_t i = mix(key) & mask();; i = (i + 1) & mask()) {
+            if (slots[i].key == key) return &slots[i];
+            if (!slots[i].key) return nullptr;
+        }
+    }
+
+    /**
+     * @brief 查找，不存在时插入默认值
+     */
+    entry& insert(uint64_t key) {
+        if ((used + 1) * 2 > slots.size()) grow();
+        size_t i = mix(key) & mask();
+        for (; slots[i].key; i = (i + 1) & mask()) {
+            if (slots[i].key == key) return slots[i];
+        }
+        slots[i] = entry();
+        slots[i].key = key;
+        ++used;
+        return slots[i];
+    }
+
+    void erase(uint64_t key) {
+        if (slots.empty()) return;
+        size_t i = mix(key) & mask();
+        for (; slots[i].key != key; i = (i + 1) & mask()) {
+            if (!slots[i].key) return;
+        }
+        // 把后续同一探测链上的元素前移，保持查找不中断
+        for (size_t j = (i + 1) & mask(); slots[j].key; j = (j + 1) & mask()) {
+            size_t home = mix(slots[j].key) & mask();
+            if (((j - home) & mask()) >= ((j - i) & mask())) {
+                slots[i] = slots[j];
+                i = j;
+            }
+        }
+        slots[i] = entry();
+        --used;
+    }
+
+    size_t size() const noexcept {
+        return used;
+    }
+};
+
+/**
+ * @brief 接收连接时的准入控制：全局接收速率与每个来源地址的连接数上限
+ * @note 与reactor::add_acceptor()配合使用，连接关闭时须调用release()
+ */
+class admission {
+public:
+    struct options {
+        double accept_rate = 0;       // 每秒最多接收的连接数，0表示不限制
+        double accept_burst = 64;
+        uint32_t max_conns_per_ip = 0;  // 0表示不限制
+    };
+
+private:
+    options opt;
+    token_bucket accepts;
+    ip_table ips;
+    conntable<uint64_t> peers;  // fd -> 地址键
+    uint64_t num_rejected = 0;
+
+public:
+    explicit admission(options opt)
+        : opt(opt)
+        , accepts(opt.accept_rate, opt.accept_burst) {}
+
+    /**
+     * @brief 全局速率是否允许再接收一个连接
+     * @return 允许时返回now，否则返回允许的时间点
+     */
+    uint64_t next_accept(uint64_t now) {
+        return opt.accept_rate > 0 ? accepts.ready_at(1, now) : now;
+    }
+
+    /**
+     * @brief 记录一次接收，消耗一个令牌
+     */
+    void on_accept(uint64_t now) {
+        if (opt.accept_rate > 0) accepts.try_take(1, now);
+    }
+
+    /**
+     * @brief 检查来源地址的连接数，通过时记录该连接
+     * @return false -> 调用者应关闭fd
+     */
+    bool admit(int fd, uint64_t key) {
+        auto& e = ips.insert(key);
+        if (opt.max_conns_per_ip && e.conns >= opt.max_conns_per_ip) {
+            ++num_rejected;
+            return false;
+        }
+        e.conns++;
+        peers.emplace(fd, key);
+        return true;
+    }
+
+    /**
+     * @brief 连接关闭时调用
+     */
+    void release(int fd) {
+        auto* key = peers.find(fd);
+        if (!key) return;
+        auto* e = ips.find(*key);
+        if (e && --e->conns == 0) ips.erase(*key);
+        peers.erase(fd);
+    }
+
+    /**
+     * @brief 来源地址当前的连接数
+     */
+    uint32_t connections(uint64_t key) {
+        auto* e = ips.find(key);
+        return e ? e->conns : 0;
+    }
+
+    uint64_t rejected() const noexcept {
+        return num_rejected;
+    }
+};
+
+}  // namespace fnet
@@ -2,17 +2,36 @@
 #include <arpa/inet.h>
 #include <fcntl.h>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #include <cerrno>
 #include <cstring>
 #include <cassert>
+#include <algorithm>
+#include <atomic>
+#include <deque>
 #include <memory>
 #include <functional>
+#include <mutex>
+#include <string>
+#include <type_traits>
 #include <unordered_map>
+#include <vector>
 #include "acceptor.h"
+#include "affinity.h"
+#include "clock.h"
+#include "conntable.h"
+#include "membudget.h"
+#include "metrics.h"
+#include "ratelimit.h"
 #include "utility.h"
+#include "shmring.h"
 #include "sigflow.h"
+#ifdef FNET_ENABLE_WATCHDOG
+#include "watchdog.h"
+#endif
 
 namespace fnet {  
 
@@ -34,6 +53,20 @@ namespace pattern {
     static const pattern_t et_oneshot = EPOLLET | EPOLLONESHOT;
 };
 
+// reactor::send()的写出方式
+enum class write_mode {
+    coalesce,   // 本轮事件处理完毕后与其他写入合并，一次写出
+    immediate,  // 立即写出，用于对延迟敏感的连接
+};
+
+// fd的优先级，每轮事件按级别从高到低处理
+enum class priority : uint8_t {
+    high,     // 控制连接等；内部fd（接收器、信号流、投递任务等）总是该级别
+    normal,
+    low       // 批量传输等
+};
+static constexpr int num_priorities = 3;
+
 /**
  * @brief 可定制不同触发模式和设置事件回调的反应堆
  * @note  配置文件在 事实上所做的配置并不需要多做更改
@@ -51,16 +84,104 @@ class reactor {
     socket_cb_t readable_cb = {};
     socket_cb_t writable_cb = {};
     socket_cb_t dconnect_cb = {};
-    std::unordered_map<int, event_cb_t> specific_fds;
-    std::unique_ptr<epoll_event[]> ev_buf;
+    conntable<event_cb_t> specific_fds;  // 内部fd（接收器、信号流等）及其回调
+    std::vector<int> retired_fds;
+    std::vector<int> ready_fds;        // 被推迟的仍可读的fd
+    std::vector<int> running_fds;
+    std::vector<char> deferred_marks;  // fd -> 是否在ready_fds中等待
+
+    struct interest {
+        event_t ev = 0;
+        pattern_t pat = 0;
+        event_t registered = 0;  // 内核中当前的事件掩码
+        bool paused = false;     // 暂停读取时不向epoll注册可读事件
+        bool fired = false;      // oneshot事件已触发，内核已停止监听，需要重新注册
+        bool dirty = false;      // 在pending_fds中等待写入内核
+        bool out = false;        // 有未写完的send()数据，监听可写事件
+        bool mem_paused = false; // 因内存预算暂停读取，与pause_reading()互不影响
+        bool held = false;       // oneshot事件已交给回调，reset_event()之前只为send()的数据监听可写事件
+        uint32_t hits = 0;       // 开启负载统计时，上次shed()以来的回调次数
+        priority prio = priority::normal;
+    };
+    std::vector<interest> interests;   // fd -> 注册的事件
+    std::vector<int> pending_fds;      // 本轮回调中修改过事件的fd
+    bool looping = false;              // 在activate()中，事件修改推迟到下一次epoll_wait之前统一提交
+
+    struct output {
+        std::deque<std::string> segs;  // 小的写入追加到最后一段
+        size_t head_off = 0;           // 第一段中已写出的字节数
+        bool tail_copied = false;      // 最后一段由拷贝生成，而不是send(std::string&&)移入的
+        socket_cb_t drained;           // 全部写出后执行一次，见when_drained()
+        bool queued = false;           // 在flush_fds中
+        bool immediate = false;
+    };
+    conntable<output> outputs;         // fd -> send()的待写数据
+    std::vector<int> flush_fds;        // 本轮有send()的fd
+    std::vector<event_cb_t> flush_cbs; // 在写出flush_fds之前执行一次的任务
+    static const size_t small_write = 4096;  // 不超过该长度的写入拷贝到上一段末尾
+
+    bool prioritized = false;                      // 设置过优先级或时间预算，按级别分批处理事件
+    uint64_t prio_budget[num_priorities] = {};     // 每轮处理各级别事件的时间上限（纳秒），0表示不限
+    std::vector<epoll_event> prio_events[num_priorities];
+    std::vector<uint32_t> prio_marks;              // fd -> 在所属级别中的下标+1，合并同一fd的事件
+    std::vector<epoll_event> carried;              // 超出时间预算、留到下一轮的边缘触发与oneshot事件
+    mem_budget* budget = nullptr;                  // send()队列与sockbuffer的内存记账
+
+    struct timer_entry {
+        uint64_t deadline;
+        uint64_t id;
+        bool operator>(const timer_entry& o) const noexcept {
+            return deadline > o.deadline;
+        }
+    };
+    struct timer_task {
+        event_cb_t cb;
+        uint64_t deadline;
+        int fd;                        // 连接定时器所属的fd，随连接迁移；-1表示普通定时器
+    };
+    std::vector<timer_entry> timer_heap;  // 最小堆
+    std::unordered_map<uint64_t, timer_task> timer_cbs;  // 已取消的定时器不在其中
+    uint64_t next_timer_id = 0;
+    uint64_t timer_id_base;            // 编号的高位区分反应堆，迁移后定时器编号不变
+    bool timer_wakeup = false;  // 本轮等待时长由定时器决定
+    loop_clock clk;                // 每轮等待返回后采样，定时器与限流读取缓存值
+    int post_fd = 0;
+    std::mutex post_lok;
+    std::vector<event_cb_t> posted;
+    node_array<epoll_event> ev_buf;
+    int cpu_id = -1;                   // 绑定的CPU，-1表示不绑定
+    bool steer_incoming = false;
+    std::unique_ptr<reactor_metrics> stats;
+
+    // 迁移中的连接，由源反应堆打包，在目标反应堆线程中恢复
+    struct handoff {
+        int fd;
+        event_t ev;
+        pattern_t pat;
+        bool paused;
+        bool deferred;
+        bool held;
+        priority prio;
+        output out;
+        std::vector<std::pair<uint64_t, timer_task>> timers;
+        std::shared_ptr<void> context;
+    };
+    std::function<std::shared_ptr<void>(int)> detach_cb;
+    std::function<void(int, std::shared_ptr<void>)> attach_cb;
+    bool track_load = false;
+    uint64_t wake_ns = 0;
+    std::atomic<uint64_t> busy_total = {0};  // 开启负载统计后处理事件的累计耗时（不含等待）
+#ifdef FNET_ENABLE_WATCHDOG
+    watchdog* dog = nullptr;
+#endif
 
-    struct sockaddr_in remote_addr;
-    socklen_t remote_addr_sz = sizeof(sockaddr_in);
+    peer_address remote_addr;
     static const int ev_buf_sz = 1024;
 
 public:
     explicit reactor()
-        : ev_buf(new epoll_event[ev_buf_sz]) {
+        : timer_id_base(next_serial() << 40)
+        , ev_buf(ev_buf_sz, -1) {
         epoll_fd = epoll_create(30);
         if (epoll_fd == -1) {
             std::cerr<<"[FastNet-Error]: "<<strerror(errno)<<'\n';
@@ -70,29 +191,100 @@ public:
         readable_cb = [](int){};
         writable_cb = [](int){};
         dconnect_cb = [](int fd){ close(fd); };
+        post_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (post_fd == -1) {
+            std::cerr<<"[FastNet-Error]: "<<strerror(errno)<<'\n';
+            std::abort();
+        }
+        epoll_add(post_fd, event::readable, pattern::et);
+        specific_fds.emplace(post_fd, [this]{ run_posted(); });
     }
     reactor(const reactor&) = delete;
     reactor(reactor&&) = delete;
-    ~reactor() noexcept { destroy(); }
+    ~reactor() noexcept {
+        destroy();
+        close(post_fd);
+    }
 
 private:
     
-    void epoll_add(int sock, event_t ev, pattern_t pattern) {
+    interest& interest_of(int fd) {
+        if (fd >= static_cast<int>(interests.size())) interests.resize(fd + 1);
+        return interests[fd];
+    }
+
+    static event_t mask_of(const interest& in) noexcept {
+        if (in.held) return (in.out ? event::writable : event::null) | in.pat;
+        event_t ev = (in.paused || in.mem_paused ? in.ev & ~event::readable : in.ev) |
+                     (in.out ? event::writable : event::null);
+        return ev | in.pat | event::disconnect;
+    }
+
+    void epoll_add(int sock, event_t ev, pattern_t pattern, bool held = false) {
+        auto& in = interest_of(sock);
+        in = {ev, pattern, 0, false, false, false, false};  // 复用的fd丢弃之前未提交的修改与未写出的数据
+        in.held = held;
+        outputs.erase(sock);
+        if (!carried.empty()) drop_carried(sock);
+        if (sock < static_cast<int>(deferred_marks.size())) deferred_marks[sock] = 0;
+        if (budget) budget->forget(sock);
+        in.registered = mask_of(in);
         struct epoll_event event;
         event.data.fd = sock;
-        event.events = ev | pattern | event::disconnect;
+        event.events = in.registered;
+        if (stats) stats->epoll_ctls.add();
         if (-1 == epoll_ctl(epoll_fd, EPOLL_CTL_ADD, sock, &event)) {
             throw std::runtime_error(strerror(errno));
         }
     }
     
     void epoll_mod(int sock, event_t ev, pattern_t pattern) {
+        auto& in = interest_of(sock);
+        in.ev = ev;
+        in.pat = pattern;
+        in.held = false;
+        update_interest(sock, in);
+    }
+
+    // 事件循环中只记录，在下一次epoll_wait之前统一提交；循环之外立即提交
+    void update_interest(int sock, interest& in) {
+        if (!looping) {
+            commit_interest(sock, in, false);
+        } else if (!in.dirty) {
+            in.dirty = true;
+            pending_fds.push_back(sock);
+        } else if (stats) {
+            stats->epoll_ctls_saved.add();  // 与之前的修改合并
+        }
+    }
+
+    // 掩码未变且未因oneshot失效时跳过系统调用；oneshot失效后没有需要监听的事件时保持失效
+    void commit_interest(int sock, interest& in, bool deferred) {
+        in.dirty = false;
+        event_t mask = mask_of(in);
+        if (in.fired ? mask == in.pat : mask == in.registered) {
+            if (stats) stats->epoll_ctls_saved.add();
+            return;
+        }
         struct epoll_event event;
         event.data.fd = sock;
-        event.events = ev | pattern | event::disconnect;
+        event.events = mask;
+        if (stats) stats->epoll_ctls.add();
         if (-1 == epoll_ctl(epoll_fd, EPOLL_CTL_MOD, sock, &event)) {
+            // 提交之前fd已被关闭
+            if (deferred && (errno == EBADF || errno == ENOENT)) return;
             throw std::runtime_error(strerror(errno));
         }
+        in.registered = mask;
+        in.fired = false;
+    }
+
+    void flush_interests() {
+        for (int fd : pending_fds) {
+            auto& in = interests[fd];
+            if (in.dirty) commit_interest(fd, in, true);
+        }
+        pending_fds.clear();
     }
 
 public:
@@ -109,18 +301,126 @@ public:
 
     /**
      * @brief 添加接收器，可重复添加。reactor不会自动打开接收器进行监听。
-     * @param acp 接收器（tcp协议与udp协议皆可）
-     * @param connected_cb 回调函数，类型：void(int fd)，传入已接收的fd
+     * @param acp 接收器（tcp/tcp6/uds/uds_seqpacket）
+     * @param connected_cb 回调函数，类型：void(int fd)，传入已接收的fd，对端地址见remote()
+     * @note 接收器挂载了sockopts时，设置选项失败的连接直接关闭，不调用回调（计入sockopt_failures）
      */
-    void add_acceptor(acceptor<protocol::tcp>&& acp, socket_cb_t connected_cb) {
+    template <typename Protocol>
+    void add_acceptor(acceptor<Protocol>&& acp, socket_cb_t connected_cb) {
+        auto opts = acp.options();
         auto acp_fd = acp.release();
         utility::set_nonblocking(acp_fd); 
+        if (steer_incoming) utility::set_incoming_cpu(acp_fd, cpu_id);
         epoll_add(acp_fd, event::readable, pattern::et);
         specific_fds.emplace(acp_fd, [=](){
             while (true) {
-                int fd = accept(acp_fd, (struct sockaddr*)&remote_addr, &remote_addr_sz);
+                remote_addr.reset();
+                int fd = accept(acp_fd, remote_addr.data(), remote_addr.size_ptr());
+                if (fd == -1) break;
+                if (stats) stats->accepts.add();
+                if (opts && !opts->try_apply(fd)) {
+                    close(fd);
+                    if (stats) stats->sockopt_failures.add();
+                    continue;
+                }
+                connected_cb(fd);
+            }
+        });
+    }
+
+    /**
+     * @brief 添加带准入控制的接收器
+     * @param acp 接收器
+     * @param connected_cb 回调函数，类型：void(int fd)，只传入通过准入检查的fd
+     * @param adm 准入控制，需在反应堆运行期间保持有效，连接关闭时须调用adm.release(fd)
+     * @note 接收速率的令牌耗尽时暂停监听接收器，令牌补充后恢复；来源地址的连接数超出上限时直接关闭
+     */
+    template <typename Protocol>
+    void add_acceptor(acceptor<Protocol>&& acp, socket_cb_t connected_cb, admission& adm) {
+        auto opts = acp.options();
+        auto acp_fd = acp.release();
+        utility::set_nonblocking(acp_fd);
+        if (steer_incoming) utility::set_incoming_cpu(acp_fd, cpu_id);
+        epoll_add(acp_fd, event::readable, pattern::et);
+        specific_fds.emplace(acp_fd, [=, &adm]() {
+            while (true) {
+                uint64_t now = loop_now();
+                uint64_t at = adm.next_accept(now);
+                if (at > now) {
+                    // 未接收的连接留在监听队列中，恢复监听时会再次触发
+                    pause_reading(acp_fd);
+                    run_at(at, [=] { resume_reading(acp_fd); });
+                    break;
+                }
+                remote_addr.reset();
+                int fd = accept(acp_fd, remote_addr.data(), remote_addr.size_ptr());
+                if (fd == -1) break;
+                adm.on_accept(now);
+                if (stats) stats->accepts.add();
+                if (!adm.admit(fd, ip_key(remote_addr))) {
+                    close(fd);
+                    if (stats) stats->rejected_accepts.add();
+                    continue;
+                }
+                if (opts && !opts->try_apply(fd)) {
+                    adm.release(fd);
+                    close(fd);
+                    if (stats) stats->sockopt_failures.add();
+                    continue;
+                }
+                connected_cb(fd);
+            }
+        });
+    }
+
+    /**
+     * @brief 添加指标接收器，以HTTP返回Prometheus文本格式的指标
+     * @param acp 已绑定并监听的接收器（tcp/tcp6/uds）
+     * @param labels 附加的标签，如 reactor="0"
+     * @note 会自动开启指标统计
+     */
+    template <typename Protocol>
+    void add_metrics_endpoint(acceptor<Protocol>&& acp, std::string labels = "") {
+        enable_metrics();
+        auto acp_fd = acp.release();
+        utility::set_nonblocking(acp_fd);
+        epoll_add(acp_fd, event::readable, pattern::et);
+        specific_fds.emplace(acp_fd, [=]() {
+            while (true) {
+                int fd = accept(acp_fd, nullptr, nullptr);
                 if (fd == -1) break;
-                else connected_cb(fd);
+                stats->scrapes.add();
+                utility::set_nonblocking(fd);
+                epoll_add(fd, event::readable, pattern::lt);
+                auto resp = std::make_shared<std::string>();
+                auto off = std::make_shared<size_t>(0);
+                specific_fds.emplace(fd, [this, fd, labels, resp, off]() {
+                    if (resp->empty()) {
+                        // 请求内容不做解析，读空后直接应答并关闭
+                        char buf[1024];
+                        while (read(fd, buf, sizeof(buf)) > 0) {}
+                        auto body = to_prometheus(stats->snap(), labels.c_str());
+                        *resp = "HTTP/1.0 200 OK\r\n"
+                                "Content-Type: text/plain; version=0.0.4\r\n"
+                                "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                                "Connection: close\r\n\r\n";
+                        *resp += body;
+                    }
+                    while (*off < resp->size()) {
+                        ssize_t n = ::send(fd, resp->data() + *off, resp->size() - *off, MSG_NOSIGNAL);
+                        if (n > 0) {
+                            stats->bytes_written.add(n);
+                            *off += n;
+                        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                            // 写不完时改为监听可写事件，写完再关闭
+                            epoll_mod(fd, event::writable, pattern::lt);
+                            return;
+                        } else {
+                            break;
+                        }
+                    }
+                    retire(fd);
+                });
             }
         });
     }
@@ -137,16 +437,302 @@ public:
         });
     }
 
+    /**
+     * @brief 作为消费者监听共享内存环：生产者发布消息后在反应堆线程中依次调用回调
+     * @param ring 环，需在反应堆运行期间保持有效
+     * @param cb 回调，类型: void(const char* data, size_t len)，data只在回调期间有效
+     * @param budget 每轮最多处理的消息数，其余留到下一轮
+     * @note 回调执行期间生产者不再敲门铃，消息很密集时每批只有一次eventfd读写
+     */
+    void add_shm_reader(shm_ring* ring, std::function<void(const char*, size_t)> cb, size_t budget = 1024) {
+        assert(ring != nullptr);
+        int fd = ring->data_doorbell();
+        epoll_add(fd, event::readable, pattern::et);
+        specific_fds.emplace(fd, [=] {
+            shm_ring::clear_doorbell(fd);
+            ring->poll(cb, budget);
+            if (!ring->idle()) shm_ring::ring_doorbell(fd);  // 达到budget，下一轮继续
+        });
+    }
+
+    /**
+     * @brief 作为生产者监听共享内存环的空间门铃：try_send()返回false之后，消费者腾出空间时调用回调
+     * @param ring 环，需在反应堆运行期间保持有效
+     * @param cb 回调，类型: void()
+     */
+    void add_shm_writer(shm_ring* ring, event_cb_t cb) {
+        assert(ring != nullptr);
+        int fd = ring->space_doorbell();
+        epoll_add(fd, event::readable, pattern::et);
+        specific_fds.emplace(fd, [=] {
+            shm_ring::clear_doorbell(fd);
+            cb();
+        });
+    }
+
     /**
      * @brief 更新套接字状态（在oneshot模式下使用）
      * @param fd 套接字
      * @param event 事件类型
      * @param pattern 触发模式
+     * @note 在回调中调用时，修改在本轮事件处理完毕、下一次epoll_wait之前统一提交，同一fd的多次修改只提交最后一次；
+     *       与内核中的掩码相同且未因oneshot失效时不做系统调用。oneshot事件交给回调后、调用本函数之前，
+     *       send()写不完的数据只注册可写事件，不会重新打开可读事件（连接可以安全地交给其他线程处理）
      */
     void reset_event(int fd, event_t event, pattern_t pattern) {
         epoll_mod(fd, event, pattern);
     }
+
+    /**
+     * @brief 向连接写入数据：在回调中调用时先暂存，本轮事件处理完毕后与同一连接的其他写入合并，
+     *        以一次sendmsg写出（超过64段时分多次，除最后一次外带MSG_MORE）；写不完的部分由反应堆监听可写事件继续写出
+     * @param fd 已添加到反应堆的socket
+     * @param data 数据，会被拷贝
+     * @param len 长度
+     * @note 在反应堆线程中调用；主动关闭连接前应调用discard_output()（对端断开时自动丢弃）
+     */
+    void send(int fd, const void* data, size_t len) {
+        if (!len) return;
+        auto& o = outputs[fd];
+        if (stats) stats->sends.add();
+        size_t off = 0;
+        if (o.immediate && o.segs.empty()) {
+            off = write_now(fd, data, len);
+            if (off == len) return;
+        }
+        const char* p = static_cast<const char*>(data) + off;
+        len -= off;
+        if (appendable(o, len)) {
+            o.segs.back().append(p, len);
+        } else {
+            o.segs.emplace_back(p, len);
+            o.tail_copied = true;
+        }
+        if (budget) budget->charge(fd, len);
+        schedule_flush(fd, o);
+    }
+
+    void send(int fd, const std::string& data) {
+        send(fd, data.data(), data.size());
+    }
+
+    /**
+     * @brief 写入数据，较长的字符串直接移入队列而不拷贝，见send()
+     */
+    void send(int fd, std::string&& data) {
+        if (data.size() <= small_write) return send(fd, data.data(), data.size());
+        auto& o = outputs[fd];
+        if (stats) stats->sends.add();
+        if (o.immediate && o.segs.empty()) {
+            size_t n = write_now(fd, data.data(), data.size());
+            if (n == data.size()) return;
+            data.erase(0, n);
+        }
+        if (budget) budget->charge(fd, data.size());
+        o.segs.push_back(std::move(data));
+        o.tail_copied = false;
+        schedule_flush(fd, o);
+    }
+
+    /**
+     * @brief 设置send()的写出方式，默认合并写出
+     * @param fd 已添加到反应堆的socket（add_socket()会重置为默认值）
+     */
+    void set_write_mode(int fd, write_mode mode) {
+        outputs[fd].immediate = mode == write_mode::immediate;
+    }
+
+    /**
+     * @brief send()尚未写出的字节数
+     */
+    size_t pending_output(int fd) const noexcept {
+        auto* o = outputs.find(fd);
+        if (!o) return 0;
+        size_t n = 0;
+        for (auto& s : o->segs) n += s.size();
+        return n - o->head_off;
+    }
+
+    /**
+     * @brief send()的数据全部写出后执行一次任务，如在应答写完后发送TLS的close_notify或关闭连接
+     * @param fd 已添加到反应堆的socket
+     * @param cb 任务，类型: void(int fd)；没有未写出的数据时立即执行
+     * @note 同一fd只保留最后一次设置的任务；写出出错清空队列时同样执行。discard_output()、对端断开、
+     *       fd被重新添加或迁移时任务被丢弃
+     */
+    void when_drained(int fd, socket_cb_t cb) {
+        auto* o = outputs.find(fd);
+        if (!o || o->segs.empty()) return cb(fd);
+        o->drained = std::move(cb);
+    }
+
+    /**
+     * @brief 丢弃send()尚未写出的数据
+     */
+    void discard_output(int fd) {
+        if (budget) budget->release(fd, pending_output(fd));
+        if (!outputs.erase(fd)) return;
+        if (fd < static_cast<int>(interests.size())) interests[fd].out = false;
+    }
+
+    /**
+     * @brief 主动断开连接：按对端断开处理，取消推迟的读取、丢弃未写出的数据并调用断开回调
+     * @param fd 套接字
+     * @note 供组件（如pubsub的overflow::disconnect策略）踢出连接，由断开回调统一清理并关闭fd
+     */
+    void disconnect(int fd) {
+        cancel_deferred(fd);
+        discard_output(fd);
+        dconnect_cb(fd);
+    }
+
+    /**
+     * @brief 暂停读取：不再监听fd的可读事件，其余事件不变
+     * @param fd 已添加的套接字
+     * @note 暂停期间reset_event()同样不会注册可读事件；重复调用只生效一次
+     */
+    void pause_reading(int fd) {
+        auto& in = interest_of(fd);
+        if (in.paused) return;
+        in.paused = true;
+        update_interest(fd, in);
+        cancel_deferred(fd);
+        if (stats) stats->paused_reads.add();
+    }
+
+    /**
+     * @brief 恢复读取，已到达的数据会再次触发可读事件（包括边缘触发模式）
+     * @param fd 套接字
+     */
+    void resume_reading(int fd) {
+        auto& in = interest_of(fd);
+        if (!in.paused) return;
+        in.paused = false;
+        update_interest(fd, in);
+    }
+
+    /**
+     * @brief 挂载内存预算：send()未写出的数据与绑定了预算的sockbuffer（见sockbuffer::bind_budget()）计入其中，
+     *        每轮事件处理之后检查，超过单连接或总量的暂停线时暂停读取占用增长的连接，占用回落后恢复；
+     *        总量超过上限时按占用从多到少以断开事件回调断开连接（未写出的数据被丢弃）
+     * @param b 预算，传入nullptr则卸载；多个反应堆共享总量上限时各挂载一个mem_budget::sibling()
+     * @note 在activate()之前调用，预算的生命周期须长于反应堆；因预算暂停的读取与pause_reading()互不影响
+     */
+    void set_mem_budget(mem_budget* b) {
+        budget = b;
+    }
+
+    mem_budget* mem_budget_of() const noexcept {
+        return budget;
+    }
+
+    /**
+     * @brief fd是否被暂停读取
+     */
+    bool reading_paused(int fd) const noexcept {
+        return fd < static_cast<int>(interests.size()) && interests[fd].paused;
+    }
+
+    /**
+     * @brief 设置fd的优先级：每轮的事件按high、normal、low分批处理，同一级别内保持epoll_wait返回的顺序
+     * @param fd 已添加的套接字，add_socket()会重置为normal；内部fd总是high
+     * @note 从未设置过优先级与时间预算时不分批，处理顺序与epoll_wait返回的顺序相同
+     */
+    void set_priority(int fd, priority p) {
+        interest_of(fd).prio = p;
+        if (p != priority::normal) prioritized = true;
+    }
+
+    priority priority_of(int fd) const noexcept {
+        if (specific_fds.contains(fd)) return priority::high;
+        return fd < static_cast<int>(interests.size()) ? interests[fd].prio : priority::normal;
+    }
+
+    /**
+     * @brief 限制每轮处理某一级别事件的时间，用完后该级别剩余的事件留到下一轮，下一轮不阻塞等待
+     * @param p normal或low，high不受限制
+     * @param us 微秒，0表示不限
+     * @note 至少处理一个事件后才检查预算；水平触发的fd下次等待时会再次被报告，
+     *       边缘触发与oneshot的fd的事件由反应堆保存，在下一轮同级别的新事件之前处理
+     */
+    void set_priority_budget(priority p, int us) {
+        if (p == priority::high) return;
+        prio_budget[static_cast<int>(p)] = static_cast<uint64_t>(us) * 1000;
+        if (us > 0) prioritized = true;
+    }
+
+    /**
+     * @brief 在反应堆线程中设置一次性定时器
+     * @param deadline 到期时间，details::now_ns()的时间基准，一般由loop_now()加上时长得到
+     * @param cb 回调，类型: void()
+     * @return 定时器编号，用于cancel_timer()
+     * @note 只能在反应堆线程中调用（其他线程请通过post()）；到期的定时器在本轮事件处理之后执行
+     */
+    uint64_t run_at(uint64_t deadline, event_cb_t cb) {
+        uint64_t id = timer_id_base | ++next_timer_id;
+        add_timer(id, {std::move(cb), deadline, -1});
+        return id;
+    }
+
+    /**
+     * @brief 在ms毫秒后执行回调，见run_at()
+     */
+    uint64_t run_after(int ms, event_cb_t cb) {
+        return run_at(loop_now() + static_cast<uint64_t>(ms) * 1000000, std::move(cb));
+    }
+
+    /**
+     * @brief 为连接设置定时器（如空闲超时），连接被migrate()时随之迁移，编号不变
+     * @param fd 连接
+     * @param ms 毫秒
+     * @param cb 回调，类型: void(int fd)，不应捕获源反应堆
+     * @return 定时器编号，迁移后须在新的反应堆上cancel_timer()
+     */
+    uint64_t run_after(int fd, int ms, socket_cb_t cb) {
+        uint64_t id = timer_id_base | ++next_timer_id;
+        add_timer(id, {[fd, cb = std::move(cb)] { cb(fd); }, loop_now() + static_cast<uint64_t>(ms) * 1000000, fd});
+        return id;
+    }
+
+    /**
+     * @brief 取消尚未执行的定时器
+     * @return 定时器是否存在
+     */
+    bool cancel_timer(uint64_t id) {
+        return timer_cbs.erase(id) > 0;
+    }
     
+    /**
+     * @brief 将任务投递到反应堆线程执行，可在任意线程调用
+     * @param cb 任务，类型: void()
+     * @note 任务在反应堆下一次处理事件时按投递顺序执行
+     */
+    void post(event_cb_t cb) {
+        bool was_empty;
+        {
+            std::lock_guard<std::mutex> lock(post_lok);
+            was_empty = posted.empty();
+            posted.push_back(std::move(cb));
+        }
+        // 队列非空时反应堆必然已被唤醒且尚未取走任务，无需重复通知
+        if (was_empty) {
+            uint64_t one = 1;
+            if (write(post_fd, &one, sizeof(one)) == -1 && errno != EAGAIN) {
+                throw std::runtime_error(strerror(errno));
+            }
+        }
+    }
+
+    /**
+     * @brief 在本轮事件与定时器处理完毕、send()的数据写出之前执行一次任务，只能在反应堆线程中调用
+     * @param cb 任务，类型: void()
+     * @note 供组件把一轮中的多次写入合并到本轮末尾（如pubsub），不经过post()的eventfd；
+     *       在事件循环之外调用时，任务在下一轮末尾执行
+     */
+    void at_iteration_end(event_cb_t cb) {
+        flush_cbs.push_back(std::move(cb));
+    }
+
     /**
      * @brief 设置epoll等待事件的超时机制
      * @param timeout 超时时长，单位: ms
@@ -182,10 +768,81 @@ public:
     }
 
     /**
-     * @brief 获取最新客户端连接的地址信息等
-     * @return sockaddr_in 
+     * @brief 开启指标统计，可重复调用
+     * @return 指标结构，其生命周期与反应堆相同
+     */
+    reactor_metrics* enable_metrics() {
+        if (!stats) stats.reset(new reactor_metrics);
+        return stats.get();
+    }
+
+    /**
+     * @brief 获取指标结构
+     * @return 未开启统计时返回nullptr
+     */
+    reactor_metrics* metrics() const noexcept {
+        return stats.get();
+    }
+
+    /**
+     * @brief 将反应堆线程绑定到一个CPU
+     * @param cpu CPU编号
+     * @param steer 是否为之后添加的接收器设置SO_INCOMING_CPU。配合SO_REUSEPORT（每个反应堆一个监听同一端口的接收器），
+     *              新连接交给与处理其数据包的CPU（网卡队列）相同的反应堆
+     * @note 在activate()开始时绑定，并在本地NUMA节点上重新分配事件缓冲、定时器堆等内部结构；
+     *       之后在回调中分配的内存（如sockbuffer）由本线程首次写入，同样位于本地节点
+     */
+    void set_cpu(int cpu, bool steer = false) {
+        cpu_id = cpu;
+        steer_incoming = steer;
+    }
+
+    /**
+     * @brief 绑定的CPU，未绑定时返回-1
      */
-    const struct sockaddr_in& remote() {
+    int cpu() const noexcept {
+        return cpu_id;
+    }
+
+    /**
+     * @brief 设置事件循环的时钟源，见clock_source
+     * @note 在activate()之前或反应堆线程中调用；coarse源使定时器的精度降为一个时钟节拍
+     */
+    void set_clock_source(clock_source s) {
+        clk.set_source(s);
+    }
+
+    /**
+     * @brief 事件循环的缓存时间（纳秒，details::now_ns()的时间基准），在本轮等待返回时采样
+     * @note 回调中用于超时判断，代替每次读取时钟；循环之外调用时重新采样
+     */
+    uint64_t loop_now() noexcept {
+        return looping ? clk.now() : clk.update();
+    }
+
+    /**
+     * @brief 缓存时间的std::chrono表示，可传给timer::is_timeout()与timer_master::clean_timeout_timers()
+     */
+    std::chrono::steady_clock::time_point loop_time_point() noexcept {
+        loop_now();
+        return clk.time_point();
+    }
+
+#ifdef FNET_ENABLE_WATCHDOG
+    /**
+     * @brief 挂载看门狗，记录慢回调与事件循环时间线（需定义FNET_ENABLE_WATCHDOG）
+     * @param w 看门狗，传入nullptr则卸载，需在反应堆运行期间保持有效
+     */
+    void set_watchdog(watchdog* w) {
+        dog = w;
+    }
+#endif
+
+    /**
+     * @brief 获取最新客户端连接的地址，在接收回调中有效
+     * @return peer_address，IPv4/IPv6/UNIX域
+     */
+    const peer_address& remote() {
         return remote_addr;
     }
 
@@ -194,36 +851,578 @@ public:
      * @note 想要关闭阻塞的reactor，最好的实践是在事件回调中关闭
      */
     void activate() {
-        int fd = 0;
+        if (cpu_id >= 0) bind_local();
         int ev_nums = 0;
+        looping = true;
         while (!closed) {
-            ev_nums = epoll_wait(epoll_fd, ev_buf.get(), ev_buf_sz, timeout);
-            if (!ev_nums) {
-                timeout_cb();
+            if (!pending_fds.empty()) flush_interests();
+            // 有被推迟的fd或留到本轮的事件时不阻塞等待，尽快回到这些连接
+            int wait_ms = ready_fds.empty() && carried.empty() ? wait_timeout() : 0;
+            if (track_load) account_busy();
+            if (timed()) {
+                uint64_t wait_begin = details::now_ns();
+                ev_nums = epoll_wait(epoll_fd, ev_buf.get(), ev_buf_sz, wait_ms);
+                clk.update();
+                if (track_load) wake_ns = details::now_ns();
+                process_timed(ev_nums, wait_begin);
             } else {
-                for (int i = 0; i < ev_nums; i++) {
-                    fd = ev_buf[i].data.fd;
-                    auto it = specific_fds.find(fd);
-                    if (it != specific_fds.end()) {
-                        it->second(); 
-                    } else if (ev_buf[i].events & event::disconnect) {
-                        dconnect_cb(fd);
-                    } else if (ev_buf[i].events & event::readable) {
-                        readable_cb(fd);
-                    } else if (ev_buf[i].events & event::writable) {
-                        writable_cb(fd);
-                    }
+                ev_nums = epoll_wait(epoll_fd, ev_buf.get(), ev_buf_sz, wait_ms);
+                clk.update();
+                if (track_load) wake_ns = details::now_ns();
+                process(ev_nums);
+            }
+            if (!timer_heap.empty()) run_timers();
+            if (!flush_cbs.empty()) run_flush_cbs();
+            if (!flush_fds.empty()) flush_outputs();
+            if (budget) enforce_budget();
+            release_retired();
+        }
+        looping = false;
+        pending_fds.clear();
+    }
+
+    /**
+     * @brief 设置迁移连接时的用户上下文回调
+     * @param detach 在源反应堆线程中调用，类型: std::shared_ptr<void>(int fd)，取出连接的用户状态
+     *        （如sockbuffer、协议解析器），从源反应堆的表中移除
+     * @param attach 在目标反应堆线程中调用，类型: void(int fd, std::shared_ptr<void> ctx)，装入目标反应堆的表
+     * @note 每个参与迁移的反应堆都要设置；sockbuffer绑定了指标或预算时应在attach中改为绑定新反应堆的指标与预算
+     */
+    void set_migration_cb(std::function<std::shared_ptr<void>(int)> detach,
+                          std::function<void(int, std::shared_ptr<void>)> attach) {
+        detach_cb = std::move(detach);
+        attach_cb = std::move(attach);
+    }
+
+    /**
+     * @brief 把连接迁移到另一个反应堆：注册的事件与暂停状态、send()未写出的数据、连接定时器与用户上下文
+     *        （见set_migration_cb()）一并转移
+     * @param fd 通过add_socket()添加的连接
+     * @param target 目标反应堆
+     * @return false -> fd不在本反应堆中（如已关闭）或是内部fd
+     * @note 只能在本反应堆线程中调用，可在事件回调中调用：本批中该fd剩余的事件会被跳过。目标反应堆在下一次
+     *       处理投递的任务时接管，期间到达的数据留在内核中，接管时重新注册即会触发。内存预算中的记账（包括因预算
+     *       暂停的读取）在本线程中归还，目标反应堆接管时按其预算重新记账；限速、准入等组件中的连接状态不随之迁移
+     */
+    bool migrate(int fd, reactor& target) {
+        if (&target == this || specific_fds.contains(fd)) return false;
+        if (-1 == epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr)) return false;
+        if (stats) stats->epoll_ctls.add();
+        auto h = std::make_shared<handoff>();
+        auto& in = interest_of(fd);
+        h->fd = fd;
+        h->ev = in.ev;
+        h->pat = in.pat;
+        h->paused = in.paused;
+        h->held = in.held;
+        h->prio = in.prio;
+        in = interest();  // 未提交的修改随之作废
+        h->deferred = is_deferred(fd);
+        cancel_deferred(fd);
+        if (budget) budget->forget(fd);
+        if (auto* o = outputs.find(fd)) {
+            h->out = std::move(*o);
+            h->out.queued = false;
+            h->out.drained = nullptr;  // 任务属于源反应堆上的组件
+            outputs.erase(fd);
+        }
+        for (auto it = timer_cbs.begin(); it != timer_cbs.end();) {
+            if (it->second.fd == fd) {
+                h->timers.emplace_back(it->first, std::move(it->second));
+                it = timer_cbs.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        if (detach_cb) h->context = detach_cb(fd);
+        if (stats) stats->migrations.add();
+        target.post([&target, h] { target.adopt(*h); });
+        return true;
+    }
+
+    /**
+     * @brief 开启负载统计：累计处理事件的耗时（busy_ns()）与每个连接的回调次数（供shed()挑选连接）
+     * @note 在activate()之前调用；每轮多读取一次时钟
+     */
+    void enable_load_tracking() {
+        track_load = true;
+    }
+
+    /**
+     * @brief 开启负载统计以来处理事件的累计耗时（纳秒），可在任意线程读取
+     */
+    uint64_t busy_ns() const noexcept {
+        return busy_total.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 把最活跃的连接迁移到另一个反应堆，直到迁出的连接约占上次调用以来回调次数的share
+     * @param target 目标反应堆
+     * @param share 0~1
+     * @param max_conns 最多迁移的连接数
+     * @return 迁移的连接数
+     * @note 只能在本反应堆线程中调用，需先enable_load_tracking()；调用后重新开始统计
+     */
+    size_t shed(reactor& target, double share, size_t max_conns) {
+        std::vector<std::pair<uint32_t, int>> active;
+        uint64_t total = 0;
+        for (size_t fd = 0; fd < interests.size(); ++fd) {
+            auto& in = interests[fd];
+            if (!in.hits) continue;
+            total += in.hits;
+            if (in.registered && !specific_fds.contains(static_cast<int>(fd))) {
+                active.emplace_back(in.hits, static_cast<int>(fd));
+            }
+            in.hits = 0;
+        }
+        std::sort(active.begin(), active.end(), std::greater<std::pair<uint32_t, int>>());
+        uint64_t goal = static_cast<uint64_t>(total * share), moved = 0;
+        size_t n = 0;
+        for (auto& a : active) {
+            if (moved >= goal || n >= max_conns) break;
+            if (migrate(a.second, target)) {
+                moved += a.first;
+                ++n;
+            }
+        }
+        return n;
+    }
+
+    /**
+     * @brief 推迟处理一个仍可读的连接：反应堆在处理完本轮其他fd后再次调用其可读回调
+     * @param fd 套接字
+     * @note 用于在可读回调中达到读预算（如sockbuffer::set_read_budget()）时让出事件循环，
+     *       在边缘触发模式下必须如此，否则剩余数据不会再次触发事件；重复调用只生效一次
+     */
+    void defer_readable(int fd) {
+        if (fd >= static_cast<int>(deferred_marks.size())) deferred_marks.resize(fd + 1, 0);
+        if (deferred_marks[fd]) return;
+        deferred_marks[fd] = 1;
+        ready_fds.push_back(fd);
+        if (stats) stats->deferred_reads.add();
+    }
+
+    /**
+     * @brief 取消推迟处理（如在回调中关闭了连接），包括因优先级时间预算留到下一轮的事件
+     * @param fd 套接字
+     */
+    void cancel_deferred(int fd) {
+        if (fd < static_cast<int>(deferred_marks.size())) deferred_marks[fd] = 0;
+        if (!carried.empty()) drop_carried(fd);
+    }
+
+private:
+    // 绑定CPU后把内部结构搬到本地节点：事件缓冲显式分配在该节点，其余容器在本线程重新分配，由首次写入决定位置
+    void bind_local() {
+        affinity::pin_thread(cpu_id);
+        ev_buf = node_array<epoll_event>(ev_buf_sz, affinity::node_of(cpu_id));
+        auto relocate = [](auto& v, size_t min_cap) {
+            typename std::decay<decltype(v)>::type fresh;
+            fresh.reserve(std::max(v.capacity(), min_cap));
+            fresh.assign(v.begin(), v.end());
+            v.swap(fresh);
+        };
+        relocate(timer_heap, 64);
+        relocate(interests, 1024);
+        relocate(deferred_marks, 1024);
+        relocate(ready_fds, 64);
+        relocate(running_fds, 64);
+    }
+
+    // 等待时长取epoll超时与最近的定时器中较小者；有定时器时重新采样，本轮回调的耗时不会推迟定时器
+    int wait_timeout() {
+        timer_wakeup = false;
+        while (!timer_heap.empty() && !timer_cbs.count(timer_heap.front().id)) {
+            std::pop_heap(timer_heap.begin(), timer_heap.end(), std::greater<timer_entry>());
+            timer_heap.pop_back();
+        }
+        if (timer_heap.empty()) return timeout;
+        uint64_t now = clk.update();
+        uint64_t deadline = timer_heap.front().deadline;
+        uint64_t ms = deadline > now ? (deadline - now + 999999) / 1000000 : 0;
+        if (timeout >= 0 && static_cast<uint64_t>(timeout) < ms) return timeout;
+        timer_wakeup = true;
+        return static_cast<int>(std::min<uint64_t>(ms, INT32_MAX));
+    }
+
+    static uint64_t next_serial() {
+        static std::atomic<uint64_t> serial = {0};
+        return ++serial;
+    }
+
+    void add_timer(uint64_t id, timer_task task) {
+        timer_heap.push_back({task.deadline, id});
+        std::push_heap(timer_heap.begin(), timer_heap.end(), std::greater<timer_entry>());
+        timer_cbs.emplace(id, std::move(task));
+    }
+
+    // 在目标反应堆线程中接管迁移来的连接
+    void adopt(handoff& h) {
+        int fd = h.fd;
+        epoll_add(fd, h.ev, h.pat, h.held);  // 仍由回调持有的oneshot连接不重新打开可读事件
+        if (h.paused) pause_reading(fd);
+        if (h.prio != priority::normal) set_priority(fd, h.prio);
+        if (!h.out.segs.empty() || h.out.immediate) {
+            auto& o = outputs[fd];
+            o = std::move(h.out);
+            if (budget) budget->charge(fd, pending_output(fd));
+            if (!o.segs.empty()) schedule_flush(fd, o);
+        }
+        for (auto& t : h.timers) add_timer(t.first, std::move(t.second));
+        if (h.deferred) defer_readable(fd);
+        if (attach_cb) attach_cb(fd, std::move(h.context));
+    }
+
+    // 执行所有已到期的定时器
+    void run_timers() {
+        uint64_t now = clk.now();
+        bool with_timing = timed();
+        while (!timer_heap.empty() && timer_heap.front().deadline <= now) {
+            uint64_t id = timer_heap.front().id;
+            std::pop_heap(timer_heap.begin(), timer_heap.end(), std::greater<timer_entry>());
+            timer_heap.pop_back();
+            auto it = timer_cbs.find(id);
+            if (it == timer_cbs.end()) continue;
+            if (stats) stats->timer_lag_ns.record(now - it->second.deadline);
+            auto cb = std::move(it->second.cb);
+            timer_cbs.erase(it);
+            uint64_t t0 = with_timing ? details::now_ns() : 0;
+            cb();
+            if (with_timing) on_callback(-1, cb_kind::timer, t0, details::now_ns());
+        }
+    }
+
+    // 上次等待返回到本次等待之前的耗时
+    void account_busy() {
+        uint64_t now = details::now_ns();
+        if (wake_ns) busy_total.store(busy_total.load(std::memory_order_relaxed) + (now - wake_ns),
+                                      std::memory_order_relaxed);
+        wake_ns = 0;
+    }
+
+    bool is_deferred(int fd) const noexcept {
+        return fd < static_cast<int>(deferred_marks.size()) && deferred_marks[fd];
+    }
+
+    cb_kind dispatch(const epoll_event& ev) {
+        int fd = ev.data.fd;
+        if (auto* cb = specific_fds.find(fd)) {
+            (*cb)();
+            return cb_kind::specific;
+        }
+        // 本批中已被migrate()迁出的fd不再属于本反应堆，剩余的事件由目标反应堆接管后重新报告
+        if (fd >= static_cast<int>(interests.size()) || !interests[fd].registered) return cb_kind::readable;
+        // oneshot事件触发后内核停止监听该fd，之后的reset_event()即使掩码不变也必须提交
+        auto& in = interests[fd];
+        if (in.pat & EPOLLONESHOT) in.fired = true;
+        if (track_load) ++in.hits;
+        if (in.out && (ev.events & event::writable) && !(ev.events & event::disconnect)) {
+            flush_output(fd);
+            // 可写事件只因send()的数据而监听
+            if (!(in.ev & event::writable) && !(ev.events & event::readable)) return cb_kind::writable;
+        }
+        if (in.pat & EPOLLONESHOT) in.held = true;
+        if (ev.events & event::disconnect) {
+            disconnect(fd);
+            return cb_kind::disconnect;
+        } else if (ev.events & event::readable) {
+            // 已在推迟队列中的fd会在本轮末尾处理，避免一轮中处理两次
+            if (!is_deferred(fd)) readable_cb(fd);
+            return cb_kind::readable;
+        } else {
+            if (ev.events & event::writable) writable_cb(fd);
+            return cb_kind::writable;
+        }
+    }
+
+    void process(int ev_nums) {
+        if (!ev_nums && carried.empty()) {
+            if (ready_fds.empty() && !timer_wakeup) timeout_cb();
+        } else if (prioritized) {
+            process_prioritized(ev_nums, false);
+        } else {
+            for (int i = 0; i < ev_nums; i++) {
+                dispatch(ev_buf[i]);
+            }
+        }
+        if (!ready_fds.empty()) run_deferred(false);
+    }
+
+    // 按级别分批处理本轮事件与上一轮留下的事件（同一fd的事件合并）；
+    // 某一级别用完时间预算后，剩余的边缘触发与oneshot事件留到下一轮，水平触发的由内核再次报告
+    void process_prioritized(int ev_nums, bool with_timing) {
+        auto add = [this](const epoll_event& e) {
+            int fd = e.data.fd;
+            if (fd >= static_cast<int>(prio_marks.size())) prio_marks.resize(fd + 1, 0);
+            auto& batch = prio_events[static_cast<int>(priority_of(fd))];
+            if (prio_marks[fd]) {
+                batch[prio_marks[fd] - 1].events |= e.events;
+                return;
+            }
+            batch.push_back(e);
+            prio_marks[fd] = static_cast<uint32_t>(batch.size());
+        };
+        for (auto& e : carried) add(e);
+        carried.clear();
+        for (int i = 0; i < ev_nums; i++) add(ev_buf[i]);
+        for (auto& batch : prio_events) {
+            for (auto& e : batch) prio_marks[e.data.fd] = 0;
+        }
+        uint64_t t0 = with_timing ? details::now_ns() : 0;
+        for (int c = 0; c < num_priorities; ++c) {
+            auto& batch = prio_events[c];
+            uint64_t budget = prio_budget[c];
+            uint64_t begin = budget ? (with_timing ? t0 : details::now_ns()) : 0;
+            size_t i = 0;
+            while (i < batch.size()) {
+                auto kind = dispatch(batch[i++]);
+                if (!with_timing && !budget) continue;
+                uint64_t t1 = details::now_ns();
+                if (with_timing) {
+                    on_callback(batch[i - 1].data.fd, kind, t0, t1);
+                    t0 = t1;
                 }
+                if (budget && t1 - begin >= budget) break;
             }
+            for (; i < batch.size(); ++i) {
+                int fd = batch[i].data.fd;
+                if (stats) stats->budget_deferred.add();
+                if (fd < static_cast<int>(interests.size()) && (interests[fd].pat & (EPOLLET | EPOLLONESHOT))) {
+                    carried.push_back(batch[i]);
+                }
+            }
+            batch.clear();
         }
     }
 
+    void drop_carried(int fd) {
+        carried.erase(std::remove_if(carried.begin(), carried.end(),
+                                     [fd](const epoll_event& e) { return e.data.fd == fd; }),
+                      carried.end());
+    }
+
+    // 依次处理被推迟的fd，期间再次推迟的fd留到下一轮
+    void run_deferred(bool with_timing) {
+        running_fds.swap(ready_fds);
+        uint64_t t0 = with_timing ? details::now_ns() : 0;
+        for (int fd : running_fds) {
+            if (!deferred_marks[fd]) continue;
+            deferred_marks[fd] = 0;
+            if (track_load && fd < static_cast<int>(interests.size())) ++interests[fd].hits;
+            readable_cb(fd);
+            if (with_timing) {
+                uint64_t t1 = details::now_ns();
+                on_callback(fd, cb_kind::readable, t0, t1);
+                t0 = t1;
+            }
+        }
+        running_fds.clear();
+    }
+
+    // 是否需要为每次回调计时（开启了指标统计或挂载了看门狗）
+    bool timed() const noexcept {
+#ifdef FNET_ENABLE_WATCHDOG
+        if (dog) return true;
+#endif
+        return stats != nullptr;
+    }
+
+    // 每次回调之后的记录
+    void on_callback(int fd, cb_kind kind, uint64_t begin, uint64_t end) {
+        if (stats) stats->cb_latency_ns[static_cast<int>(kind)].record(end - begin);
+#ifdef FNET_ENABLE_WATCHDOG
+        if (dog) dog->on_callback(fd, kind, begin, end);
+#else
+        (void)fd;
+#endif
+    }
+
+    // 与process()逻辑相同，附带计时与计数
+    void process_timed(int ev_nums, uint64_t wait_begin) {
+        uint64_t begin = details::now_ns();
+        if (stats) stats->loop_iterations.add();
+        if (!ev_nums && carried.empty()) {
+            if (ready_fds.empty() && !timer_wakeup) {
+                if (stats) stats->timeouts.add();
+                timeout_cb();
+                on_callback(-1, cb_kind::timeout, begin, details::now_ns());
+            }
+        } else if (prioritized) {
+            if (stats && ev_nums > 0) {
+                stats->events.add(ev_nums);
+                stats->events_per_wakeup.record(ev_nums);
+            }
+            process_prioritized(ev_nums, true);
+        } else if (ev_nums > 0) {
+            if (stats) {
+                stats->events.add(ev_nums);
+                stats->events_per_wakeup.record(ev_nums);
+            }
+            uint64_t t0 = begin;
+            for (int i = 0; i < ev_nums; i++) {
+                auto kind = dispatch(ev_buf[i]);
+                uint64_t t1 = details::now_ns();
+                on_callback(ev_buf[i].data.fd, kind, t0, t1);
+                t0 = t1;
+            }
+        }
+        if (!ready_fds.empty()) run_deferred(true);
+        uint64_t end = details::now_ns();
+        if (stats) stats->loop_time_ns.record(end - begin);
+#ifdef FNET_ENABLE_WATCHDOG
+        if (dog) dog->on_iteration(wait_begin, begin, end, ev_nums > 0 ? ev_nums : 0);
+#else
+        (void)wait_begin;
+#endif
+    }
+
+    // 立即写出，返回写出的字节数
+    size_t write_now(int fd, const void* data, size_t len) {
+        ssize_t n = ::send(fd, data, len, MSG_NOSIGNAL);
+        if (stats) stats->send_syscalls.add();
+        if (n <= 0) return 0;
+        if (stats) stats->bytes_written.add(n);
+        return static_cast<size_t>(n);
+    }
+
+    // 小的写入只追加到拷贝生成的最后一段，且不为此重新分配一段较长的内容
+    static bool appendable(const output& o, size_t len) noexcept {
+        if (o.segs.empty() || len > small_write || !o.tail_copied) return false;
+        auto& tail = o.segs.back();
+        return tail.size() <= small_write || tail.size() + len <= tail.capacity();
+    }
+
+    void schedule_flush(int fd, output& o) {
+        if (o.queued) return;
+        o.queued = true;
+        if (looping) flush_fds.push_back(fd);
+        else flush_output(fd);
+    }
+
+    void run_flush_cbs() {
+        std::vector<event_cb_t> cbs;
+        cbs.swap(flush_cbs);
+        for (auto& cb : cbs) cb();  // 执行中新加入的任务留到下一轮
+    }
+
+    void flush_outputs() {
+        for (size_t i = 0; i < flush_fds.size(); ++i) flush_output(flush_fds[i]);
+        flush_fds.clear();
+    }
+
+    void enforce_budget() {
+        budget->enforce(
+            [this](int fd) {
+                auto& in = interest_of(fd);
+                in.mem_paused = true;
+                update_interest(fd, in);
+                cancel_deferred(fd);
+                if (stats) stats->mem_pauses.add();
+            },
+            [this](int fd) {
+                auto& in = interest_of(fd);
+                in.mem_paused = false;
+                update_interest(fd, in);
+            },
+            [this](int fd) {
+                if (stats) stats->mem_sheds.add();
+                disconnect(fd);
+            });
+        if (stats) stats->mem_used.set(budget->used());
+    }
+
+    // 尽量写出一个连接的全部数据，写不完时监听可写事件
+    void flush_output(int fd) {
+        auto* o = outputs.find(fd);
+        if (!o) return;
+        o->queued = false;
+        while (!o->segs.empty()) {
+            struct iovec iov[64];
+            size_t cnt = 0, total = 0;
+            for (auto it = o->segs.begin(); it != o->segs.end() && cnt < 64; ++it, ++cnt) {
+                size_t skip = cnt == 0 ? o->head_off : 0;
+                iov[cnt].iov_base = const_cast<char*>(it->data()) + skip;
+                iov[cnt].iov_len = it->size() - skip;
+                total += iov[cnt].iov_len;
+            }
+            struct msghdr msg;
+            std::memset(&msg, 0, sizeof(msg));
+            msg.msg_iov = iov;
+            msg.msg_iovlen = cnt;
+            // 后面还有数据时带MSG_MORE，内核把它们合并成满的报文段
+            int flags = MSG_NOSIGNAL | (cnt < o->segs.size() ? MSG_MORE : 0);
+            ssize_t n = sendmsg(fd, &msg, flags);
+            if (stats) stats->send_syscalls.add();
+            if (n < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                // 连接已出错或已被关闭，断开事件（如果有）由epoll报告
+                if (budget) budget->release(fd, pending_output(fd));
+                o->segs.clear();
+                o->head_off = 0;
+                break;
+            }
+            if (stats) stats->bytes_written.add(n);
+            if (budget) budget->release(fd, n);
+            size_t left = static_cast<size_t>(n);
+            while (left) {
+                size_t avail = o->segs.front().size() - o->head_off;
+                if (left < avail) {
+                    o->head_off += left;
+                    break;
+                }
+                left -= avail;
+                o->segs.pop_front();
+                o->head_off = 0;
+            }
+            if (static_cast<size_t>(n) < total) break;
+        }
+        bool pending = !o->segs.empty();
+        // oneshot的可写事件触发后即使仍未写完也要重新注册
+        if (fd < static_cast<int>(interests.size()) && (interests[fd].out != pending || (interests[fd].fired && pending))) {
+            interests[fd].out = pending;
+            update_interest(fd, interests[fd]);
+        }
+        if (!pending && o->drained) {
+            auto cb = std::move(o->drained);
+            o->drained = nullptr;
+            cb(fd);  // 之后不再访问o：任务中的send()可能移动outputs中的元素
+        }
+    }
+
+    void run_posted() {
+        uint64_t val;
+        while (read(post_fd, &val, sizeof(val)) > 0) {}
+        std::vector<event_cb_t> tasks;
+        {
+            std::lock_guard<std::mutex> lock(post_lok);
+            tasks.swap(posted);
+        }
+        for (auto& task : tasks) task();
+    }
+
+    // 移除内部fd，延迟到本轮事件处理完毕后再关闭，避免回调执行中被析构以及fd被复用
+    void retire(int fd) {
+        if (stats) stats->epoll_ctls.add();
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+        retired_fds.push_back(fd);
+    }
+
+    void release_retired() {
+        if (retired_fds.empty()) return;
+        for (int fd : retired_fds) {
+            specific_fds.erase(fd);
+            close(fd);
+        }
+        retired_fds.clear();
+    }
+
+public:
     /**
      * @brief 关闭反应堆
      * @note 如果是同步关闭，则立刻执行，否则可能会延迟执行
      */
     void destroy() noexcept {
-        close(epoll_fd);
+        if (epoll_fd > 0) close(epoll_fd);
         epoll_fd = 0;
         closed = true;
     }
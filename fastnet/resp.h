@@ -0,0 +1,538 @@
+#pragma once
+#include <sys/socket.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "cbtrie.h"
+#include "sockbuffer.h"
+
+namespace fnet {
+namespace resp {
+
+// 类型即RESP2/RESP3中的首字节，inline_command为不以类型字节开头的内联命令（如telnet输入的"PING\r\n"）
+enum class type : char {
+    simple_string = '+',
+    error = '-',
+    integer = ':',
+    bulk_string = '$',
+    array = '*',
+    null = '_',
+    boolean = '#',
+    real = ',',
+    big_number = '(',
+    bulk_error = '!',
+    verbatim = '=',
+    map = '%',
+    set = '~',
+    push = '>',
+    attribute = '|',
+    inline_command = 'i'
+};
+
+/**
+ * @brief 解码得到的值，按先序排列，聚合类型之后紧跟它的元素
+ */
+struct node {
+    type t = type::null;
+    std::string_view str;  // 字符串类型的内容，直接指向调用者的缓冲区
+    int64_t num = 0;       // integer的值；boolean为0/1；聚合类型为元素个数（map/attribute为键值对数）
+    bool is_null = false;  // RESP2中的"$-1"与"*-1"
+};
+
+enum class status {
+    complete,
+    incomplete,
+    error
+};
+
+/**
+ * @brief 可恢复的RESP2/RESP3流式解码器
+ * 每次以同一个值起始处的连续字节调用parse()，数据不完整时返回incomplete，
+ * 再次调用时从上次停下的位置继续，已解码的元素不会被重复解析
+ * @note 两次调用之间调用者可以移动缓冲区（如sockbuffer::drop_read()），只要值起始处之后的内容不变
+ */
+class decoder {
+    struct frame {
+        int64_t remain;
+        bool attr;
+    };
+
+    std::vector<node> nodes;
+    std::vector<frame> stack;
+    std::vector<std::string_view> argv;
+    const char* base = nullptr;
+    size_t pos = 0;
+    size_t total = 0;
+    bool done = false;
+    bool failed = false;
+
+    size_t max_bulk;
+    size_t max_elements;
+    static constexpr size_t max_inline = 64 * 1024;
+    static constexpr size_t max_depth = 128;
+
+public:
+    /**
+     * @param max_bulk 单个字符串的最大长度，默认与Redis的proto-max-bulk-len相同
+     * @param max_elements 单个聚合类型的最大元素个数
+     */
+    explicit decoder(size_t max_bulk = 512 * 1024 * 1024, size_t max_elements = 1024 * 1024)
+        : max_bulk(max_bulk)
+        , max_elements(max_elements) {}
+
+    /**
+     * @brief 单个字符串的最大长度
+     */
+    size_t max_bulk_len() const noexcept {
+        return max_bulk;
+    }
+
+    /**
+     * @brief 修改单个字符串的最大长度，对之后读到的长度前缀生效
+     */
+    void set_max_bulk_len(size_t n) noexcept {
+        max_bulk = n;
+    }
+
+    /**
+     * @brief 解码一个顶层的值
+     * @param data 值的起始处
+     * @param len  可用的字节数
+     * @return status
+     * @note 返回complete后，调用者应消耗consumed()个字节，下一次调用自动开始解码新的值
+     */
+    status parse(const char* data, size_t len) {
+        if (failed) return status::error;
+        if (done) reset();
+        if (base != data) rebase(data);
+        if (nodes.empty() && pos < len && !is_type(data[0])) return parse_inline(data, len);
+        while (pos < len) {
+            if (stack.size() > max_depth) return fail();
+            char t = data[pos];
+            if (!is_type(t)) return fail();
+            auto eol = find_crlf(data, len, pos + 1);
+            if (eol == std::string_view::npos) return len - pos > max_inline ? fail() : status::incomplete;
+            std::string_view line(data + pos + 1, eol - pos - 1);
+            node n;
+            n.t = static_cast<type>(t);
+            switch (n.t) {
+            case type::bulk_string:
+            case type::bulk_error:
+            case type::verbatim: {
+                int64_t size;
+                if (!to_int(line, size) || size < -1 || (size > 0 && static_cast<uint64_t>(size) > max_bulk)) return fail();
+                size_t next = eol + 2;
+                if (size == -1) {
+                    n.is_null = true;
+                } else {
+                    if (len < next + size + 2) return status::incomplete;
+                    if (data[next + size] != '\r' || data[next + size + 1] != '\n') return fail();
+                    n.str = std::string_view(data + next, size);
+                    next += size + 2;
+                }
+                nodes.push_back(n);
+                pos = next;
+                if (element_done()) return finish();
+                continue;
+            }
+            case type::array:
+            case type::map:
+            case type::set:
+            case type::push:
+            case type::attribute: {
+                if (!to_int(line, n.num) || n.num < -1 || (n.num > 0 && static_cast<uint64_t>(n.num) > max_elements)) return fail();
+                if (n.num == -1) {
+                    n.is_null = true;
+                    n.num = 0;
+                }
+                nodes.push_back(n);
+                pos = eol + 2;
+                int64_t children = (n.t == type::map || n.t == type::attribute) ? n.num * 2 : n.num;
+                if (children) {
+                    stack.push_back({children, n.t == type::attribute});
+                } else if (n.t != type::attribute && element_done()) {
+                    return finish();
+                }
+                continue;
+            }
+            case type::integer:
+                if (!to_int(line, n.num)) return fail();
+                break;
+            case type::boolean:
+                if (line != "t" && line != "f") return fail();
+                n.num = line == "t";
+                break;
+            case type::null:
+                if (!line.empty()) return fail();
+                break;
+            default:
+                break;
+            }
+            // 单行的类型：内容即该行
+            n.str = line;
+            nodes.push_back(n);
+            pos = eol + 2;
+            if (element_done()) return finish();
+        }
+        return status::incomplete;
+    }
+
+    /**
+     * @brief 上一个完整的值占用的字节数
+     */
+    size_t consumed() const noexcept {
+        return total;
+    }
+
+    /**
+     * @brief 上一个完整的值的全部节点（先序）
+     */
+    const std::vector<node>& values() const noexcept {
+        return nodes;
+    }
+
+    /**
+     * @brief 上一个值是否为命令：由批量字符串组成的数组，或内联命令
+     */
+    bool is_command() const noexcept {
+        return !argv.empty();
+    }
+
+    /**
+     * @brief 命令的参数，args()[0]为命令名；不是命令时为空
+     */
+    const std::vector<std::string_view>& args() const noexcept {
+        return argv;
+    }
+
+    /**
+     * @brief 放弃当前进度，从头开始解码
+     */
+    void reset() {
+        nodes.clear();
+        stack.clear();
+        argv.clear();
+        base = nullptr;
+        pos = total = 0;
+        done = failed = false;
+    }
+
+private:
+    static bool is_type(char c) {
+        return c && strchr("+-:$*_#,(!=%~>|", c);
+    }
+
+    static size_t find_crlf(const char* data, size_t len, size_t from) {
+        auto view = std::string_view(data, len);
+        auto p = view.find('\r', from);
+        while (p != view.npos && p + 1 < len && data[p + 1] != '\n') p = view.find('\r', p + 1);
+        return (p == view.npos || p + 1 >= len) ? std::string_view::npos : p;
+    }
+
+    static bool to_int(std::string_view s, int64_t& v) {
+        bool neg = !s.empty() && s[0] == '-';
+        if (neg || (!s.empty() && s[0] == '+')) s.remove_prefix(1);
+        if (s.empty() || s.size() > 19) return false;
+        uint64_t u = 0;
+        for (char c : s) {
+            if (c < '0' || c > '9') return false;
+            u = u * 10 + (c - '0');
+        }
+        if (u > static_cast<uint64_t>(INT64_MAX)) return false;
+        v = neg ? -static_cast<int64_t>(u) : static_cast<int64_t>(u);
+        return true;
+    }
+
+    status fail() {
+        failed = true;
+        return status::error;
+    }
+
+    // 一个元素完成，向上结束已经收齐元素的聚合类型；返回true表示顶层的值已完整
+    bool element_done() {
+        while (!stack.empty()) {
+            if (--stack.back().remain > 0) return false;
+            bool attr = stack.back().attr;
+            stack.pop_back();
+            if (attr) return false;  // 属性附加在下一个值上，本身不算作父聚合的元素
+        }
+        return true;
+    }
+
+    status finish() {
+        total = pos;
+        done = true;
+        argv.clear();
+        if (nodes[0].t == type::array && !nodes[0].is_null && nodes.size() == static_cast<size_t>(nodes[0].num) + 1) {
+            for (size_t i = 1; i < nodes.size(); ++i) {
+                if (nodes[i].t != type::bulk_string || nodes[i].is_null) {
+                    argv.clear();
+                    break;
+                }
+                argv.push_back(nodes[i].str);
+            }
+        }
+        return status::complete;
+    }
+
+    status parse_inline(const char* data, size_t len) {
+        auto view = std::string_view(data, len);
+        auto eol = view.find('\n');
+        if (eol == view.npos) return len > max_inline ? fail() : status::incomplete;
+        auto line = view.substr(0, eol);
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        argv.clear();
+        while (!line.empty()) {
+            auto sp = line.find_first_not_of(" \t");
+            if (sp == line.npos) break;
+            line.remove_prefix(sp);
+            auto e = line.find_first_of(" \t");
+            argv.push_back(line.substr(0, e));
+            if (e == line.npos) break;
+            line.remove_prefix(e);
+        }
+        node n;
+        n.t = type::inline_command;
+        n.str = view.substr(0, eol);
+        n.num = static_cast<int64_t>(argv.size());
+        nodes.push_back(n);
+        total = pos = eol + 1;
+        done = true;
+        return status::complete;
+    }
+
+    // 缓冲区被移动后，修正已解码节点中指向旧地址的视图
+    void rebase(const char* data) {
+        for (auto& n : nodes) {
+            if (n.str.data()) n.str = std::string_view(data + (n.str.data() - base), n.str.size());
+        }
+        base = data;
+    }
+};
+
+/**
+ * @brief 回复编码器：回复被追加到内部缓冲中，由flush()一次写出
+ * @note 在处理完缓冲区内所有流水线命令之后再调用flush()，多个回复合并为一次write
+ */
+class writer {
+    std::string buf;
+    size_t off = 0;
+    int proto = 2;
+
+public:
+    /**
+     * @brief 设置协议版本（2或3，由HELLO命令协商），决定null、boolean、map等的编码方式
+     */
+    void set_protocol(int version) {
+        proto = version;
+    }
+
+    int protocol() const noexcept {
+        return proto;
+    }
+
+    writer& simple(std::string_view s) {
+        return line('+', s);
+    }
+
+    writer& error(std::string_view s) {
+        return line('-', s);
+    }
+
+    writer& integer(int64_t v) {
+        char num[24];
+        return line(':', std::string_view(num, snprintf(num, sizeof(num), "%lld", static_cast<long long>(v))));
+    }
+
+    writer& bulk(std::string_view s) {
+        header('$', s.size());
+        buf.append(s);
+        buf.append("\r\n");
+        return *this;
+    }
+
+    // RESP3中为"_"，RESP2中为空的批量字符串
+    writer& null() {
+        buf.append(proto >= 3 ? "_\r\n" : "$-1\r\n");
+        return *this;
+    }
+
+    writer& boolean(bool v) {
+        if (proto >= 3) return line('#', v ? "t" : "f");
+        return integer(v);
+    }
+
+    writer& real(double v) {
+        char num[32];
+        std::string_view s(num, snprintf(num, sizeof(num), "%.17g", v));
+        return proto >= 3 ? line(',', s) : bulk(s);
+    }
+
+    writer& array(size_t n) {
+        return header('*', n);
+    }
+
+    writer& set(size_t n) {
+        return header(proto >= 3 ? '~' : '*', n);
+    }
+
+    // RESP2中编码为2n个元素的数组
+    writer& map(size_t n) {
+        return proto >= 3 ? header('%', n) : header('*', n * 2);
+    }
+
+    writer& push(size_t n) {
+        return header(proto >= 3 ? '>' : '*', n);
+    }
+
+    /**
+     * @brief 追加已编码好的内容
+     */
+    writer& raw(std::string_view s) {
+        buf.append(s);
+        return *this;
+    }
+
+    /**
+     * @brief 写出缓冲中的回复
+     * @param fd 非阻塞socket
+     * @return 写出的字节数；出现EAGAIN以外的错误时返回-1，未写出的内容保留
+     */
+    ssize_t flush(int fd) {
+        ssize_t written = 0;
+        while (off < buf.size()) {
+            ssize_t n = send(fd, buf.data() + off, buf.size() - off, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                return -1;
+            }
+            off += n;
+            written += n;
+        }
+        if (off == buf.size()) {
+            buf.clear();
+            off = 0;
+        }
+        return written;
+    }
+
+    size_t pending() const noexcept {
+        return buf.size() - off;
+    }
+
+    bool empty() const noexcept {
+        return off == buf.size();
+    }
+
+private:
+    writer& line(char t, std::string_view s) {
+        buf.push_back(t);
+        buf.append(s);
+        buf.append("\r\n");
+        return *this;
+    }
+
+    writer& header(char t, size_t n) {
+        char num[24];
+        return line(t, std::string_view(num, snprintf(num, sizeof(num), "%zu", n)));
+    }
+};
+
+/**
+ * @brief 命令分发：命令名经由cbtrie（不区分大小写）找到处理函数
+ */
+class dispatcher {
+public:
+    using handler_t = std::function<void(const std::vector<std::string_view>& args, writer& out)>;
+
+private:
+    cbtrie trie{true};
+    handler_t unknown;
+    const std::vector<std::string_view>* cur_args = nullptr;
+    writer* cur_out = nullptr;
+
+public:
+    dispatcher() {
+        unknown = [](const std::vector<std::string_view>& args, writer& out) {
+            std::string msg = "ERR unknown command '";
+            msg.append(args[0].substr(0, 128));
+            msg.push_back('\'');
+            out.error(msg);
+        };
+    }
+    dispatcher(const dispatcher&) = delete;
+
+    /**
+     * @brief 注册命令
+     * @param name 命令名，不区分大小写
+     * @param h    处理函数，回复写入out
+     */
+    void on(std::string_view name, handler_t h) {
+        trie.insert(name.data(), name.size(), [this, h = std::move(h)](char*, size_t) { h(*cur_args, *cur_out); });
+    }
+
+    /**
+     * @brief 设置未知命令的处理函数，默认回复"-ERR unknown command"
+     */
+    void on_unknown(handler_t h) {
+        unknown = std::move(h);
+    }
+
+    /**
+     * @brief 分发一条命令
+     * @return 命令名是否已注册
+     */
+    bool dispatch(const std::vector<std::string_view>& args, writer& out) {
+        if (args.empty()) return true;
+        if (!trie.frozen()) trie.freeze();  // 注册完成后的第一条命令
+        int p = trie.search(args[0].data(), args[0].size());
+        if (!p) {
+            unknown(args, out);
+            return false;
+        }
+        cur_args = &args;
+        cur_out = &out;
+        trie[p](nullptr, 0);
+        return true;
+    }
+
+    /**
+     * @brief 处理缓冲区内所有完整的流水线命令，回复追加到out中，不完整的命令留待下次
+     * @return 出现协议错误、或缓冲区已满仍无法容纳一条命令时返回false，此时已向out写入错误回复，
+     *         调用者应在flush()后关闭连接
+     * @note 调用者随后调用一次out.flush()，把这一批回复合并为一次写出；
+     *       dec的最大字符串长度会被限制为sb的容量，超出的长度前缀直接按协议错误处理
+     */
+    bool feed(sockbuffer& sb, decoder& dec, writer& out) {
+        if (dec.max_bulk_len() > sb.capacity()) dec.set_max_bulk_len(sb.capacity());
+        status st;
+        while ((st = dec.parse(sb.data(), sb.pending())) == status::complete) {
+            if (dec.is_command()) {
+                dispatch(dec.args(), out);
+            } else if (dec.values()[0].t != type::inline_command) {
+                out.error("ERR Protocol error: expected an array of bulk strings");
+            }
+            sb.consume(dec.consumed());
+        }
+        sb.drop_read();
+        if (st == status::error) {
+            out.error("ERR Protocol error");
+            return false;
+        }
+        if (sb.freespace() == 0) {
+            // 缓冲区已满时readsock()读不到新数据，这条命令永远无法完整，继续等待只会让反应堆空转
+            out.error("ERR Protocol error: command exceeds the connection buffer");
+            return false;
+        }
+        return true;
+    }
+};
+
+}  // namespace resp
+}  // namespace fnet
@@ -0,0 +1,540 @@
+#pragma once
+#include <endian.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "conntable.h"
+#include "reactor.h"
+
+namespace fnet {
+namespace rpc {
+
+/**
+ * 帧格式（小端）：
+ *   uint32 len     消息体长度
+ *   uint8  type    frame_type
+ *   uint8  flags   保留，为0
+ *   uint16 method  方法号
+ *   uint64 id      请求编号，应答帧原样带回
+ *   char   body[len]
+ */
+static constexpr size_t header_size = 16;
+
+enum class frame_type : uint8_t {
+    request = 1,
+    response = 2,
+    error = 3     // 消息体为错误描述
+};
+
+/**
+ * @brief 调用的结果
+ */
+enum class status {
+    ok,
+    error,         // 对端返回错误（未知方法、处理函数抛出异常等），消息体为错误描述
+    timeout,       // 超过期限未收到应答，之后到达的应答被丢弃
+    disconnected   // 连接在收到应答之前被remove()
+};
+
+/**
+ * @brief 服务端收到的一次调用，可以拷贝保存，稍后再应答
+ */
+struct call {
+    int fd = -1;
+    uint32_t gen = 0;     // 连接的代数，连接关闭后应答被忽略
+    uint16_t method = 0;
+    uint64_t id = 0;
+};
+
+namespace details {
+
+inline void encode_header(char* p, frame_type t, uint16_t method, uint64_t id, uint32_t len) {
+    uint32_t l = htole32(len);
+    uint16_t m = htole16(method);
+    uint64_t i = htole64(id);
+    memcpy(p, &l, 4);
+    p[4] = static_cast<char>(t);
+    p[5] = 0;
+    memcpy(p + 6, &m, 2);
+    memcpy(p + 8, &i, 8);
+}
+
+struct frame_header {
+    uint32_t len;
+    frame_type type;
+    uint16_t method;
+    uint64_t id;
+};
+
+inline frame_header decode_header(const char* p) {
+    frame_header h;
+    uint32_t l;
+    uint16_t m;
+    uint64_t i;
+    memcpy(&l, p, 4);
+    memcpy(&m, p + 6, 2);
+    memcpy(&i, p + 8, 8);
+    h.len = le32toh(l);
+    h.type = static_cast<frame_type>(p[4]);
+    h.method = le16toh(m);
+    h.id = le64toh(i);
+    return h;
+}
+
+/**
+ * @brief 未完成的调用表：以请求编号为键的开放寻址表（线性探测，删除时后移）
+ * 编号是顺序分配的，直接取低位会使未完成的调用连成一整簇，删除时需扫描整簇，因此先做乘法散列
+ */
+template <typename Entry>
+class call_table {
+    std::vector<Entry> slots;   // id为0表示空槽
+    size_t mask = 0;
+    int shift = 64;
+    size_t count = 0;
+
+    size_t home(uint64_t id) const noexcept {
+        return static_cast<size_t>((id * 0x9E3779B97F4A7C15ull) >> shift);
+    }
+
+public:
+    explicit call_table(size_t cap = 64) {
+        size_t n = 16;
+        while (n < cap) n <<= 1;
+        slots.resize(n);
+        mask = n - 1;
+        shift = 64 - __builtin_ctzll(n);
+    }
+
+    size_t size() const noexcept {
+        return count;
+    }
+
+    Entry* find(uint64_t id) noexcept {
+        if (id == 0) return nullptr;
+        for (size_t i = home(id);; i = (i + 1) & mask) {
+            if (slots[i].id == id) return &slots[i];
+            if (slots[i].id == 0) return nullptr;
+        }
+    }
+
+    void insert(Entry&& e) {
+        if ((count + 1) * 2 > slots.size()) grow();
+        size_t i = home(e.id);
+        while (slots[i].id != 0) i = (i + 1) & mask;
+        slots[i] = std::move(e);
+        ++count;
+    }
+
+    /**
+     * @brief 取出并删除
+     * @return 是否存在
+     */
+    bool take(uint64_t id, Entry& out) {
+        Entry* e = find(id);
+        if (!e) return false;
+        out = std::move(*e);
+        erase_slot(static_cast<size_t>(e - slots.data()));
+        return true;
+    }
+
+    /**
+     * @brief 取出满足条件的所有项
+     */
+    template <typename Pred>
+    std::vector<Entry> take_if(Pred&& pred) {
+        std::vector<Entry> out;
+        for (size_t i = 0; i < slots.size();) {
+            if (slots[i].id != 0 && pred(slots[i])) {
+                out.push_back(std::move(slots[i]));
+                erase_slot(i);  // 后移的项可能落在i上，需重新检查
+            } else {
+                ++i;
+            }
+        }
+        return out;
+    }
+
+private:
+    void erase_slot(size_t i) {
+        // 把后续簇中可以前移的项移到空位上，保持探测链连续
+        size_t j = i;
+        while (true) {
+            j = (j + 1) & mask;
+            if (slots[j].id == 0) break;
+            size_t h = home(slots[j].id);
+            if (((j - h) & mask) >= ((j - i) & mask)) {
+                slots[i] = std::move(slots[j]);
+                i = j;
+            }
+        }
+        slots[i] = Entry();
+        --count;
+    }
+
+    void grow() {
+        std::vector<Entry> old(slots.size() * 2);
+        old.swap(slots);
+        mask = slots.size() - 1;
+        --shift;
+        count = 0;
+        for (auto& e : old) {
+            if (e.id != 0) insert(std::move(e));
+        }
+    }
+};
+
+}  // namespace details
+
+/**
+ * @brief 单个反应堆上的多路复用RPC：每个连接上可以有任意多个未完成的调用，应答按编号匹配，不要求按序返回
+ * 同一个端点既可以发起调用（客户端），也可以注册方法处理对端的调用（服务端）；
+ * 帧通过reactor::send()写出，同一轮事件循环中一个连接上的所有请求与应答合并为一次sendmsg；
+ * 调用的期限由一个按最早期限设置的反应堆定时器统一处理
+ * @note 只能在所属反应堆的线程中使用。连接需已通过add_socket()加入反应堆并attach()，
+ *       在可读回调中调用on_readable()（返回false时应remove()并关闭连接），在断开回调中调用remove()
+ */
+class endpoint {
+public:
+    using reply_cb_t = std::function<void(status, std::string_view)>;
+    using handler_t = std::function<void(const call&, std::string_view)>;
+
+    struct options {
+        size_t max_frame = 16 * 1024 * 1024;   // 消息体的最大长度，超过时视为协议错误
+        int timeout_ms = 5000;                 // 默认的调用期限，0表示不限
+        size_t read_chunk = 64 * 1024;         // 每次recv的最小缓冲空间
+        size_t read_budget = 1024 * 1024;      // 每次on_readable()最多读取的字节数，用尽时推迟到本轮其他fd之后
+    };
+
+    struct statistics {
+        uint64_t calls = 0;          // 发起的调用
+        uint64_t replies = 0;        // 收到的应答（含错误应答）
+        uint64_t timeouts = 0;
+        uint64_t late_replies = 0;   // 超时或连接移除后到达、被丢弃的应答
+        uint64_t requests = 0;       // 处理的对端调用
+        uint64_t protocol_errors = 0;
+    };
+
+private:
+    struct pending {
+        uint64_t id = 0;
+        uint64_t deadline = 0;
+        int fd = -1;
+        uint32_t gen = 0;
+        reply_cb_t cb;
+    };
+
+    struct deadline_entry {
+        uint64_t deadline;
+        uint64_t id;
+        bool operator>(const deadline_entry& o) const noexcept {
+            return deadline > o.deadline;
+        }
+    };
+
+    // 每个连接的输入缓冲，[rd, wr)为未处理的数据
+    struct conn {
+        std::unique_ptr<char[]> buf;
+        size_t cap = 0;
+        size_t rd = 0;
+        size_t wr = 0;
+        size_t inflight = 0;   // 本端在该连接上未完成的调用
+        budget_lease lease;    // 输入缓冲在反应堆内存预算中的记账
+    };
+
+    reactor& rec;
+    options opt;
+    conntable<conn> conns;
+    details::call_table<pending> calls;
+    std::vector<deadline_entry> deadlines;   // 最小堆，已完成的调用延迟删除
+    std::unordered_map<uint16_t, handler_t> handlers;
+    uint64_t next_id = 0;
+    uint64_t timer_id = 0;
+    uint64_t armed_deadline = 0;
+    statistics st;
+
+public:
+    explicit endpoint(reactor& rec) : endpoint(rec, options()) {}
+    endpoint(reactor& rec, options opt)
+        : rec(rec)
+        , opt(opt) {}
+    endpoint(const endpoint&) = delete;
+    ~endpoint() {
+        if (timer_id) rec.cancel_timer(timer_id);
+    }
+
+    /**
+     * @brief 注册方法，处理函数中可以立即应答，也可以保存call稍后应答
+     * @param method 方法号
+     * @param h 处理函数，类型: void(const call&, std::string_view body)，body只在调用期间有效；
+     *          抛出异常时以异常描述作为错误应答
+     */
+    void on(uint16_t method, handler_t h) {
+        handlers[method] = std::move(h);
+    }
+
+    /**
+     * @brief 管理一个连接
+     * @note 在add_socket()之后调用，输入缓冲计入反应堆挂载的内存预算（见reactor::set_mem_budget()）
+     */
+    void attach(int fd) {
+        conn& c = conns.emplace(fd);
+        c.lease = budget_lease(rec.mem_budget_of(), fd, c.cap);
+    }
+
+    /**
+     * @brief 移除连接：丢弃未处理的输入，本端在该连接上未完成的调用以status::disconnected结束
+     * @note 不关闭fd；连接断开时调用
+     */
+    void remove(int fd) {
+        conn* c = conns.find(fd);
+        if (!c) return;
+        uint32_t gen = conns.handle_of(fd).gen;
+        bool has_calls = c->inflight > 0;
+        conns.erase(fd);
+        if (!has_calls) return;
+        auto failed = calls.take_if([&](const pending& p) { return p.fd == fd && p.gen == gen; });
+        for (auto& p : failed) p.cb(status::disconnected, {});
+    }
+
+    /**
+     * @brief 发起调用
+     * @param fd 已attach()的连接
+     * @param method 方法号
+     * @param body 消息体，会被拷贝
+     * @param cb 应答回调，类型: void(status, std::string_view body)，body只在回调期间有效
+     * @param timeout_ms 期限（毫秒），-1表示使用options::timeout_ms，0表示不限
+     * @return 请求编号
+     * @note 连接未attach()或消息体超过max_frame时抛出异常
+     */
+    uint64_t invoke(int fd, uint16_t method, std::string_view body, reply_cb_t cb, int timeout_ms = -1) {
+        conn* c = conns.find(fd);
+        if (!c) throw std::runtime_error("rpc: connection is not attached");
+        if (body.size() > opt.max_frame) throw std::runtime_error("rpc: message too large");
+        uint64_t id = ++next_id;
+        if (timeout_ms < 0) timeout_ms = opt.timeout_ms;
+        uint64_t deadline = timeout_ms ? rec.loop_now() + static_cast<uint64_t>(timeout_ms) * 1000000 : 0;
+        calls.insert({id, deadline, fd, conns.handle_of(fd).gen, std::move(cb)});
+        ++c->inflight;
+        ++st.calls;
+        write_frame(fd, frame_type::request, method, id, body);
+        if (deadline) add_deadline(deadline, id);
+        return id;
+    }
+
+    /**
+     * @brief 放弃一个未完成的调用，不再调用其回调
+     * @return 调用是否仍未完成
+     */
+    bool cancel(uint64_t id) {
+        pending p;
+        if (!calls.take(id, p)) return false;
+        release(p);
+        return true;
+    }
+
+    /**
+     * @brief 应答一次调用
+     * @return 连接是否仍然存在
+     * @note 消息体超过max_frame时改为发送错误应答，对端回调收到status::error而不是被截断的结果
+     */
+    bool reply(const call& c, std::string_view body) {
+        return respond(c, frame_type::response, body);
+    }
+
+    /**
+     * @brief 以错误应答一次调用，对端回调收到status::error
+     * @note 错误描述超过max_frame时被截断
+     */
+    bool fail(const call& c, std::string_view message) {
+        return respond(c, frame_type::error, message);
+    }
+
+    /**
+     * @brief 读取并处理连接上到达的帧，每读一次先处理完整的帧再继续读
+     * @return false -> 对端关闭、读出错或协议错误，调用者应remove()并关闭连接
+     * @note 读满options::read_budget时调用reactor::defer_readable()，剩余的数据在本轮其他fd之后处理
+     */
+    bool on_readable(int fd) {
+        conn* c = conns.find(fd);
+        if (!c) return false;
+        auto h = conns.handle_of(fd);
+        size_t left = opt.read_budget;
+        while (true) {
+            reserve(*c, opt.read_chunk);
+            size_t room = std::min(c->cap - c->wr, left);
+            ssize_t n = recv(fd, c->buf.get() + c->wr, room, MSG_DONTWAIT);
+            int err = errno;
+            if (n < 0 && err == EINTR) continue;
+            if (n > 0) c->wr += static_cast<size_t>(n);
+            if (!parse(h)) return false;
+            c = conns.find(h);
+            if (n == 0) return false;
+            if (n < 0) return err == EAGAIN || err == EWOULDBLOCK;
+            if (static_cast<size_t>(n) < room) return true;  // 已读空
+            left -= static_cast<size_t>(n);
+            if (!left) {
+                rec.defer_readable(fd);
+                return true;
+            }
+        }
+    }
+
+    /**
+     * @brief 本端未完成的调用数
+     */
+    size_t inflight() const noexcept {
+        return calls.size();
+    }
+
+    const statistics& stats() const noexcept {
+        return st;
+    }
+
+private:
+    void write_frame(int fd, frame_type t, uint16_t method, uint64_t id, std::string_view body) {
+        char head[header_size];
+        details::encode_header(head, t, method, id, static_cast<uint32_t>(body.size()));
+        rec.send(fd, head, sizeof(head));
+        rec.send(fd, body.data(), body.size());
+    }
+
+    bool respond(const call& c, frame_type t, std::string_view body) {
+        if (!conns.find(conntable<conn>::handle{c.fd, c.gen})) return false;
+        std::string err;
+        if (t == frame_type::response && body.size() > opt.max_frame) {
+            err = "rpc: reply too large (" + std::to_string(body.size()) + " bytes)";
+            t = frame_type::error;
+            body = err;
+        }
+        if (body.size() > opt.max_frame) body = body.substr(0, opt.max_frame);
+        write_frame(c.fd, t, c.method, c.id, body);
+        return true;
+    }
+
+    void dispatch(const call& c, std::string_view body) {
+        ++st.requests;
+        auto it = handlers.find(c.method);
+        if (it == handlers.end()) {
+            fail(c, "unknown method " + std::to_string(c.method));
+            return;
+        }
+        try {
+            it->second(c, body);
+        } catch (const std::exception& e) {
+            fail(c, e.what());
+        }
+    }
+
+    void complete(uint64_t id, status s, std::string_view body) {
+        pending p;
+        if (!calls.take(id, p)) {
+            ++st.late_replies;
+            return;
+        }
+        release(p);
+        if (s != status::timeout) ++st.replies;
+        p.cb(s, body);
+    }
+
+    void release(const pending& p) {
+        if (conn* c = conns.find(conntable<conn>::handle{p.fd, p.gen})) --c->inflight;
+    }
+
+    // 处理缓冲区中完整的帧，不完整的帧预留出剩余的空间；协议错误或回调中移除了连接时返回false
+    bool parse(conntable<conn>::handle h) {
+        conn* c;
+        while ((c = conns.find(h))) {
+            size_t avail = c->wr - c->rd;
+            if (avail < header_size) return true;
+            auto fh = details::decode_header(c->buf.get() + c->rd);
+            if (fh.len > opt.max_frame || fh.type < frame_type::request || fh.type > frame_type::error) {
+                ++st.protocol_errors;
+                return false;
+            }
+            if (avail < header_size + fh.len) {
+                reserve(*c, header_size + fh.len - avail);
+                return true;
+            }
+            std::string_view body(c->buf.get() + c->rd + header_size, fh.len);
+            c->rd += header_size + fh.len;
+            if (fh.type == frame_type::request) dispatch({h.fd, h.gen, fh.method, fh.id}, body);
+            else complete(fh.id, fh.type == frame_type::response ? status::ok : status::error, body);
+        }
+        return false;
+    }
+
+    // 保证[wr, cap)至少有room字节（不足时先把未处理的数据移到前端，仍不足再扩容）
+    void reserve(conn& c, size_t room) {
+        if (c.rd == c.wr) c.rd = c.wr = 0;
+        if (c.cap - c.wr >= room) return;
+        size_t used = c.wr - c.rd;
+        if (c.cap >= used + room) {
+            memmove(c.buf.get(), c.buf.get() + c.rd, used);
+        } else {
+            size_t cap = std::max<size_t>(c.cap * 2, 4096);
+            while (cap < used + room) cap *= 2;
+            std::unique_ptr<char[]> buf(new char[cap]);
+            if (used) memcpy(buf.get(), c.buf.get() + c.rd, used);
+            c.buf = std::move(buf);
+            c.cap = cap;
+            c.lease.resize(cap);
+        }
+        c.rd = 0;
+        c.wr = used;
+    }
+
+    void add_deadline(uint64_t deadline, uint64_t id) {
+        // 已完成的调用积压过多时重建堆
+        if (deadlines.size() > 2 * calls.size() + 1024) {
+            deadlines.erase(std::remove_if(deadlines.begin(), deadlines.end(),
+                                           [&](const deadline_entry& d) { return !calls.find(d.id); }),
+                            deadlines.end());
+            std::make_heap(deadlines.begin(), deadlines.end(), std::greater<deadline_entry>());
+        }
+        deadlines.push_back({deadline, id});
+        std::push_heap(deadlines.begin(), deadlines.end(), std::greater<deadline_entry>());
+        arm(deadline);
+    }
+
+    // 定时器只按最早的期限设置一个，期限更早时才重新设置
+    void arm(uint64_t deadline) {
+        if (timer_id && armed_deadline <= deadline) return;
+        if (timer_id) rec.cancel_timer(timer_id);
+        armed_deadline = deadline;
+        timer_id = rec.run_at(deadline, [this] {
+            timer_id = 0;
+            expire();
+        });
+    }
+
+    void expire() {
+        uint64_t now = rec.loop_now();
+        while (!deadlines.empty()) {
+            auto top = deadlines.front();
+            pending* p = calls.find(top.id);
+            if (p && top.deadline > now) {
+                arm(top.deadline);
+                return;
+            }
+            std::pop_heap(deadlines.begin(), deadlines.end(), std::greater<deadline_entry>());
+            deadlines.pop_back();
+            if (p) {
+                ++st.timeouts;
+                complete(top.id, status::timeout, {});
+            }
+        }
+    }
+};
+
+}  // namespace rpc
+}  // namespace fnet
@@ -0,0 +1,379 @@
+#pragma once
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace fnet {
+
+/**
+ * @brief 同一主机上进程间的共享内存消息环（memfd + mmap），单消费者，单生产者或多生产者
+ * @note 消息以[seq, len]头部加数据的记录连续存放，记录按16字节对齐，放不下时以填充记录跳到环的开头；
+ *       消费者处理完一条记录后把其中每个16字节对齐处清零，空闲区域中不会出现已发布的记录头；
+ *       两个eventfd作为门铃：数据门铃由生产者在消费者空闲时敲响，消费者正在处理时不敲（门铃抑制）；
+ *       空间门铃由消费者在有生产者等待空间时敲响。三个fd可通过UNIX域套接字传给另一个进程（send_fds()/receive_fds()）
+ *       同一对象只能由一个线程使用，多个生产者线程各自通过share()得到自己的对象
+ */
+class shm_ring {
+    static const uint32_t magic = 0x666e7372;  // "fnsr"
+    static const uint32_t pad_len = UINT32_MAX;
+    static const size_t record_hdr = 16;
+
+    struct header {
+        uint32_t magic;
+        uint32_t multi_producer;
+        uint64_t capacity;
+        alignas(64) std::atomic<uint64_t> head;      // 生产者预留到的位置
+        alignas(64) std::atomic<uint64_t> tail;      // 消费者读到的位置
+        alignas(64) std::atomic<uint32_t> consumer_idle;  // 消费者已停止处理，需要敲数据门铃
+        alignas(64) std::atomic<uint32_t> space_waiters;  // 有生产者在等待空间，需要敲空间门铃
+    };
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared atomics must be lock free");
+
+    struct record {
+        std::atomic<uint64_t> seq;  // 发布后为位置+1
+        uint32_t len;
+        uint32_t reserved;
+    };
+
+    int mem_fd = -1;
+    int data_fd = -1;    // 数据门铃
+    int space_fd = -1;   // 空间门铃
+    header* hdr = nullptr;
+    char* ring = nullptr;
+    size_t map_size = 0;
+    uint64_t mask = 0;
+    uint64_t read_pos = 0;     // 消费者本地的读位置，批量发布到tail
+    uint64_t doorbells = 0;
+    uint64_t suppressed = 0;
+
+public:
+    /**
+     * @brief 创建一个新的环
+     * @param capacity 数据区大小，向上取整为2的幂，至少4096
+     * @param multi_producer 是否允许多个生产者（以CAS预留空间）
+     */
+    explicit shm_ring(size_t capacity, bool multi_producer = false) {
+        uint64_t cap = 4096;
+        while (cap < capacity) cap <<= 1;
+        mem_fd = memfd_create("fastnet-shmring", MFD_CLOEXEC);
+        if (mem_fd == -1 || ftruncate(mem_fd, static_cast<off_t>(header_size() + cap)) == -1) abort_on_error();
+        data_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        space_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (data_fd == -1 || space_fd == -1) abort_on_error();
+        map(header_size() + cap);
+        hdr->magic = magic;
+        hdr->multi_producer = multi_producer;
+        hdr->capacity = cap;
+        hdr->consumer_idle.store(1, std::memory_order_relaxed);
+        mask = cap - 1;
+    }
+
+    /**
+     * @brief 映射另一个进程创建的环，接管三个fd
+     */
+    shm_ring(int memfd, int data_doorbell, int space_doorbell)
+        : mem_fd(memfd), data_fd(data_doorbell), space_fd(space_doorbell) {
+        struct stat st;
+        if (fstat(mem_fd, &st) == -1) abort_on_error();
+        map(static_cast<size_t>(st.st_size));
+        if (hdr->magic != magic || header_size() + hdr->capacity != map_size) {
+            std::cerr<<"[FastNet-Error]: "<<"not a shm_ring"<<'\n';
+            std::abort();
+        }
+        mask = hdr->capacity - 1;
+        read_pos = hdr->tail.load(std::memory_order_acquire);
+    }
+
+    shm_ring(const shm_ring&) = delete;
+    shm_ring& operator=(const shm_ring&) = delete;
+    shm_ring(shm_ring&& other) noexcept {
+        *this = std::move(other);
+    }
+    shm_ring& operator=(shm_ring&& other) noexcept {
+        if (this != &other) {
+            release();
+            mem_fd = other.mem_fd;
+            data_fd = other.data_fd;
+            space_fd = other.space_fd;
+            hdr = other.hdr;
+            ring = other.ring;
+            map_size = other.map_size;
+            mask = other.mask;
+            read_pos = other.read_pos;
+            doorbells = other.doorbells;
+            suppressed = other.suppressed;
+            other.mem_fd = other.data_fd = other.space_fd = -1;
+            other.hdr = nullptr;
+            other.ring = nullptr;
+            other.map_size = 0;
+        }
+        return *this;
+    }
+    ~shm_ring() {
+        release();
+    }
+
+    /**
+     * @brief 在本进程中再映射一份，供另一个线程使用（如多生产者）
+     */
+    shm_ring share() const {
+        int fds[3] = {dup(mem_fd), dup(data_fd), dup(space_fd)};
+        if (fds[0] == -1 || fds[1] == -1 || fds[2] == -1) throw std::runtime_error(strerror(errno));
+        return shm_ring(fds[0], fds[1], fds[2]);
+    }
+
+    /**
+     * @brief 通过UNIX域套接字把环传给另一个进程
+     * @note 失败时抛出异常
+     */
+    void send_fds(int unix_sock) const {
+        int fds[3] = {mem_fd, data_fd, space_fd};
+        char byte = 'r';
+        struct iovec iov = {&byte, 1};
+        alignas(struct cmsghdr) char ctrl[CMSG_SPACE(sizeof(fds))];
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = ctrl;
+        msg.msg_controllen = sizeof(ctrl);
+        struct cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+        cm->cmsg_level = SOL_SOCKET;
+        cm->cmsg_type = SCM_RIGHTS;
+        cm->cmsg_len = CMSG_LEN(sizeof(fds));
+        memcpy(CMSG_DATA(cm), fds, sizeof(fds));
+        if (sendmsg(unix_sock, &msg, MSG_NOSIGNAL) != 1) throw std::runtime_error(strerror(errno));
+    }
+
+    /**
+     * @brief 从UNIX域套接字接收send_fds()发出的环
+     * @note 失败时抛出异常
+     */
+    static shm_ring receive_fds(int unix_sock) {
+        int fds[3];
+        char byte;
+        struct iovec iov = {&byte, 1};
+        alignas(struct cmsghdr) char ctrl[CMSG_SPACE(sizeof(fds))];
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = ctrl;
+        msg.msg_controllen = sizeof(ctrl);
+        if (recvmsg(unix_sock, &msg, MSG_CMSG_CLOEXEC) != 1) throw std::runtime_error(strerror(errno));
+        struct cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+        if (!cm || cm->cmsg_type != SCM_RIGHTS || cm->cmsg_len != CMSG_LEN(sizeof(fds))) {
+            throw std::runtime_error("shm_ring: missing descriptors");
+        }
+        memcpy(fds, CMSG_DATA(cm), sizeof(fds));
+        return shm_ring(fds[0], fds[1], fds[2]);
+    }
+
+    /**
+     * @brief 发送一条消息（生产者）
+     * @param data 数据，拷贝到环中
+     * @param len 长度，不超过max_message()
+     * @return false -> 空间不足，之后消费者腾出空间时敲响空间门铃（space_doorbell()可读）
+     */
+    bool try_send(const void* data, size_t len) {
+        if (len > max_message()) throw std::runtime_error("shm_ring: message too large");
+        uint64_t need = record_size(len);
+        uint64_t cap = mask + 1;
+        uint64_t pos = hdr->head.load(std::memory_order_relaxed);
+        uint64_t start, end;
+        while (true) {
+            uint64_t off = pos & mask;
+            start = off + need > cap ? pos + (cap - off) : pos;
+            end = start + need;
+            if (end - hdr->tail.load(std::memory_order_acquire) > cap && !wait_space(end)) return false;
+            if (!hdr->multi_producer) {
+                hdr->head.store(end, std::memory_order_relaxed);
+                break;
+            }
+            if (hdr->head.compare_exchange_weak(pos, end, std::memory_order_relaxed)) break;
+        }
+        if (start != pos) publish(pos, pad_len);
+        memcpy(ring + (start & mask) + record_hdr, data, len);
+        publish(start, static_cast<uint32_t>(len));
+        // 与消费者在poll()中的检查配对：要么消费者看到这条消息，要么这里看到消费者空闲
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (hdr->consumer_idle.load(std::memory_order_relaxed) && hdr->consumer_idle.exchange(0)) {
+            ring_doorbell(data_fd);
+            ++doorbells;
+        } else {
+            ++suppressed;
+        }
+        return true;
+    }
+
+    /**
+     * @brief 处理已发布的消息（消费者），处理完毕后标记为空闲
+     * @param cb 回调，类型: void(const char* data, size_t len)，data只在回调期间有效
+     * @param budget 本次最多处理的消息数
+     * @return 处理的消息数；达到budget时不标记空闲，调用者应稍后再次调用（见idle()）
+     */
+    template <typename F>
+    size_t poll(F&& cb, size_t budget = SIZE_MAX) {
+        size_t n = 0;
+        while (true) {
+            n += drain(cb, budget - n);
+            if (n == budget) return n;
+            hdr->consumer_idle.store(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!ready()) return n;
+            // 标记空闲前有消息发布，生产者可能没有敲门铃，继续处理
+            if (!hdr->consumer_idle.exchange(0)) {
+                // 生产者已经敲响门铃，留给下一次事件处理即可
+                return n;
+            }
+        }
+    }
+
+    /**
+     * @brief 消费者是否已标记空闲（poll()未因budget提前返回）
+     */
+    bool idle() const noexcept {
+        return hdr->consumer_idle.load(std::memory_order_relaxed) != 0;
+    }
+
+    /**
+     * @brief 清空门铃的计数，在门铃fd可读时调用
+     */
+    static void clear_doorbell(int fd) noexcept {
+        uint64_t val;
+        while (read(fd, &val, sizeof(val)) > 0) {}
+    }
+
+    static void ring_doorbell(int fd) noexcept {
+        uint64_t one = 1;
+        (void)!write(fd, &one, sizeof(one));
+    }
+
+    // 数据门铃，消费者监听其可读事件
+    int data_doorbell() const noexcept {
+        return data_fd;
+    }
+
+    // 空间门铃，等待空间的生产者监听其可读事件
+    int space_doorbell() const noexcept {
+        return space_fd;
+    }
+
+    int memfd() const noexcept {
+        return mem_fd;
+    }
+
+    size_t capacity() const noexcept {
+        return mask + 1;
+    }
+
+    size_t max_message() const noexcept {
+        return (mask + 1) / 2 - record_hdr;
+    }
+
+    // 本对象发送时敲门铃与被抑制的次数
+    uint64_t doorbells_rung() const noexcept {
+        return doorbells;
+    }
+    uint64_t doorbells_suppressed() const noexcept {
+        return suppressed;
+    }
+
+private:
+    static size_t header_size() noexcept {
+        return (sizeof(header) + 4095) & ~size_t(4095);
+    }
+
+    static uint64_t record_size(size_t len) noexcept {
+        return (record_hdr + len + 15) & ~uint64_t(15);
+    }
+
+    [[noreturn]] static void abort_on_error() {
+        std::cerr<<"[FastNet-Error]: "<<strerror(errno)<<'\n';
+        std::abort();
+    }
+
+    void map(size_t size) {
+        void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, mem_fd, 0);
+        if (p == MAP_FAILED) abort_on_error();
+        map_size = size;
+        hdr = static_cast<header*>(p);
+        ring = static_cast<char*>(p) + header_size();
+    }
+
+    void release() noexcept {
+        if (hdr) munmap(hdr, map_size);
+        if (mem_fd != -1) close(mem_fd);
+        if (data_fd != -1) close(data_fd);
+        if (space_fd != -1) close(space_fd);
+        hdr = nullptr;
+        mem_fd = data_fd = space_fd = -1;
+    }
+
+    record* at(uint64_t pos) const noexcept {
+        return reinterpret_cast<record*>(ring + (pos & mask));
+    }
+
+    void publish(uint64_t pos, uint32_t len) noexcept {
+        record* r = at(pos);
+        r->len = len;
+        r->seq.store(pos + 1, std::memory_order_release);
+    }
+
+    bool ready() const noexcept {
+        return at(read_pos)->seq.load(std::memory_order_acquire) == read_pos + 1;
+    }
+
+    // 登记等待空间后再检查一次，与消费者在drain()中的检查配对
+    bool wait_space(uint64_t end) {
+        hdr->space_waiters.store(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return end - hdr->tail.load(std::memory_order_acquire) <= mask + 1;
+    }
+
+    template <typename F>
+    size_t drain(F& cb, size_t budget) {
+        size_t n = 0;
+        uint64_t published = read_pos;
+        uint64_t cap = mask + 1;
+        while (n < budget && ready()) {
+            record* r = at(read_pos);
+            if (r->len == pad_len) {
+                r->seq.store(0, std::memory_order_relaxed);
+                read_pos += cap - (read_pos & mask);
+                continue;
+            }
+            cb(reinterpret_cast<const char*>(r) + record_hdr, static_cast<size_t>(r->len));
+            uint64_t size = record_size(r->len);
+            // 之后的记录头可能落在任何16字节对齐处，清零后旧数据不会被误认为已发布的记录
+            for (uint64_t o = 0; o < size; o += 16) at(read_pos + o)->seq.store(0, std::memory_order_relaxed);
+            read_pos += size;
+            ++n;
+            // 每处理四分之一个环发布一次读位置，让生产者尽早继续
+            if (read_pos - published >= cap / 4) {
+                publish_tail();
+                published = read_pos;
+            }
+        }
+        if (read_pos != published) publish_tail();
+        return n;
+    }
+
+    void publish_tail() noexcept {
+        hdr->tail.store(read_pos, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (hdr->space_waiters.load(std::memory_order_relaxed) && hdr->space_waiters.exchange(0)) {
+            ring_doorbell(space_fd);
+        }
+    }
+};
+
+}  // namespace fnet
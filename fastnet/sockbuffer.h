@@ -3,6 +3,8 @@
 #include <cstring>
 #include <string_view>
 #include <memory>
+#include "membudget.h"
+#include "metrics.h"
 
 
 namespace fnet {
@@ -14,6 +16,10 @@ class sockbuffer {
     char* p_wd = nullptr;
     char* p_end = nullptr;
     int fd = 0;
+    size_t budget = static_cast<size_t>(-1);
+    bool more = false;
+    reactor_metrics* stats = nullptr;
+    budget_lease lease;
 public:
     sockbuffer() = default;
     sockbuffer(int fd, size_t buf_sz)
@@ -31,12 +37,19 @@ public:
     /**
      * @brief 从socket缓冲中读取内容到内存中
      * @return 返回读取的字节数
-     * @note 此调用会快速填充未写的缓冲区
+     * @note 此调用会快速填充未写的缓冲区，单次读取的字节数不超过读预算
      */
     size_t readsock() {
         size_t count = 0;
+        more = false;
         while (1) {
-            int b = recv(fd, p_wd, p_end-p_wd, MSG_DONTWAIT);
+            size_t room = p_end - p_wd;
+            if (room > budget - count) room = budget - count;
+            if (!room) {
+                more = true;  // 预算用尽或缓冲区已满，socket中可能还有数据
+                break;
+            }
+            int b = recv(fd, p_wd, room, MSG_DONTWAIT);
             if (b <= 0) {
                 break;
             } else {
@@ -44,6 +57,46 @@ public:
                 count += b;
             }
         }
+        if (stats) {
+            stats->bytes_read.add(count);
+            stats->sockbuffer_fill.record((p_wd - buf.get()) * 100 / buf_sz);
+        }
+        return count;
+    }
+
+    /**
+     * @brief 设置每次readsock()最多读取的字节数，用于在边缘触发模式下限制单个连接占用事件循环的时间
+     * @param bytes 字节数，默认不限制
+     * @note 预算用尽时应调用reactor::defer_readable()，让反应堆在处理完其他fd后再回到该连接
+     */
+    void set_read_budget(size_t bytes) {
+        budget = bytes;
+    }
+
+    /**
+     * @brief 上一次readsock()是否因读预算用尽或缓冲区已满而提前结束
+     * @return true -> socket中可能仍有未读数据
+     */
+    bool has_more() const {
+        return more;
+    }
+
+    /**
+     * @brief 绑定反应堆的指标，之后的readsock()会统计读入字节数与填充率
+     * @param m 指标结构，可通过reactor::metrics()获取，传入nullptr则解除绑定
+     */
+    void bind_metrics(reactor_metrics* m) {
+        stats = m;
+    }
+
+    /**
+     * @brief 把缓冲区的容量记入反应堆的内存预算，replace()后按新容量记账，析构时归还
+     * @param b 预算，可通过reactor::mem_budget_of()获取，传入nullptr则解除绑定
+     * @note 在add_socket()之后绑定（添加连接会清空fd之前的记账）；migrate()在源反应堆线程中归还并解除原来的绑定，
+     *       应在attach中绑定新反应堆的预算；预算的生命周期须长于sockbuffer
+     */
+    void bind_budget(mem_budget* b) {
+        lease = budget_lease(b, fd, buf_sz);
     }
 
     /**
@@ -88,6 +141,23 @@ public:
         return p_wd - p_rd;
     }
 
+    /**
+     * @brief 获取待处理内容的起始地址，内容连续存放，长度为pending()
+     * @note 不消耗内容；调用drop_read()或reflush()后地址失效
+     */
+    char* data() {
+        return p_rd;
+    }
+
+    /**
+     * @brief 消耗掉待处理内容的前n个字节
+     * @param n 字节数，超出pending()时按pending()处理
+     */
+    void consume(size_t n) {
+        size_t l = p_wd - p_rd;
+        p_rd += (n > l) ? l : n;
+    }
+
     /**
      * @brief 获取空闲可读空间
      * @return size_t 字节数
@@ -96,6 +166,14 @@ public:
         return p_end - p_wd;
     }
 
+    /**
+     * @brief 获取缓冲区的总容量
+     * @return size_t 字节数
+     */
+    size_t capacity() const {
+        return buf_sz;
+    }
+
     /**
      * @brief 清空内部缓冲区（单纯改变指针指向O(1)）
      * @note 未读的f内容会被丢弃
@@ -114,6 +192,7 @@ public:
     auto replace(std::unique_ptr<char[]> new_buf, size_t new_buf_sz) -> std::unique_ptr<char[]> {
         buf.swap(new_buf);
         buf_sz = new_buf_sz;
+        lease.resize(buf_sz);
         p_end = buf.get() + buf_sz;
         reflush();
         return new_buf;
@@ -128,6 +207,7 @@ public:
         auto old = buf.release();
         buf.reset(new char[new_buf_sz]);
         buf_sz = new_buf_sz;
+        lease.resize(buf_sz);
         p_end = buf.get() + buf_sz;
         reflush();
         return std::unique_ptr<char[]>(old);
@@ -139,7 +219,7 @@ public:
      * @note 未被读的内容会被拷贝到缓冲区的前端，并保持未读的状态
      */
     void drop_read() {
-        strncpy(buf.get(), p_rd, p_wd-p_rd);
+        memmove(buf.get(), p_rd, p_wd - p_rd);
         p_wd = buf.get() + (p_wd - p_rd);
         p_rd = buf.get();
     }
@@ -0,0 +1,117 @@
+#pragma once
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <cerrno>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+namespace fnet {
+
+/**
+ * @brief 声明式的socket选项配置，挂在接收器上，对每个接收到的连接自动设置
+ * 未赋值的选项保持系统默认值；TCP_*选项只适用于tcp/tcp6接收器
+ * @note 设置失败时抛出异常，异常信息包含选项名；acceptor::do_accept()中则关闭该连接并返回-1，
+ *       反应堆的接收循环中关闭该连接并计入sockopt_failures
+ */
+struct sockopts {
+    // ---- 每个连接 ----
+    std::optional<bool> nodelay;        // TCP_NODELAY，关闭Nagle算法
+    std::optional<int>  rcvbuf;         // SO_RCVBUF，字节（内核会加倍）；同时设置在监听socket上，以便握手时确定窗口缩放
+    std::optional<int>  sndbuf;         // SO_SNDBUF，字节
+    std::optional<bool> quickack;       // TCP_QUICKACK，立即确认（内核可能在之后自动清除）
+    std::optional<int>  notsent_lowat;  // TCP_NOTSENT_LOWAT，未发送数据低于该值时才报告可写
+    std::optional<int>  busy_poll;      // SO_BUSY_POLL，微秒，读取时忙等网卡队列（超过系统设置时需CAP_NET_ADMIN）
+    std::optional<bool> keepalive;      // SO_KEEPALIVE
+    std::optional<int>  keepidle;       // TCP_KEEPIDLE，秒，空闲多久后开始探测
+    std::optional<int>  keepintvl;      // TCP_KEEPINTVL，秒，探测间隔
+    std::optional<int>  keepcnt;        // TCP_KEEPCNT，探测失败多少次后断开
+    // ---- 只作用于监听socket ----
+    std::optional<bool> reuse_port;     // SO_REUSEPORT，需在绑定之前设置
+    std::optional<int>  defer_accept;   // TCP_DEFER_ACCEPT，秒，收到数据后才唤醒accept
+    std::optional<int>  fastopen;       // TCP_FASTOPEN，TFO队列长度
+
+    /**
+     * @brief 偏向延迟：关闭Nagle、立即确认、限制未发送数据量、开启保活
+     */
+    static sockopts low_latency() {
+        sockopts o;
+        o.nodelay = true;
+        o.quickack = true;
+        o.notsent_lowat = 16384;
+        o.keepalive = true;
+        return o;
+    }
+
+    /**
+     * @brief 偏向吞吐：大的收发缓冲，保留Nagle算法，收到数据后才接收连接
+     */
+    static sockopts throughput() {
+        sockopts o;
+        o.rcvbuf = 4 << 20;
+        o.sndbuf = 4 << 20;
+        o.defer_accept = 1;
+        o.keepalive = true;
+        return o;
+    }
+
+    /**
+     * @brief 设置监听socket上的选项（在接收器绑定之前调用）
+     * @param fd 监听socket
+     */
+    void apply_listener(int fd) const {
+        set(fd, SOL_SOCKET, SO_REUSEPORT, reuse_port, "SO_REUSEPORT");
+        set(fd, SOL_SOCKET, SO_RCVBUF, rcvbuf, "SO_RCVBUF");
+        set(fd, IPPROTO_TCP, TCP_DEFER_ACCEPT, defer_accept, "TCP_DEFER_ACCEPT");
+        set(fd, IPPROTO_TCP, TCP_FASTOPEN, fastopen, "TCP_FASTOPEN");
+    }
+
+    /**
+     * @brief 设置已接收的连接上的选项
+     * @param fd 连接
+     */
+    void apply(int fd) const {
+        if (const char* what = apply_conn(fd)) throw std::runtime_error(std::string(what) + ": " + strerror(errno));
+    }
+
+    /**
+     * @brief 同apply()，但不抛出异常，供接收循环使用
+     * @param fd 连接
+     * @return 失败时返回false，errno为setsockopt的错误码，后续选项不再设置
+     */
+    bool try_apply(int fd) const noexcept {
+        return !apply_conn(fd);
+    }
+
+private:
+    // 依次设置连接上的选项，返回第一个失败的选项名，全部成功时返回nullptr
+    const char* apply_conn(int fd) const noexcept {
+        if (!put(fd, IPPROTO_TCP, TCP_NODELAY, nodelay)) return "TCP_NODELAY";
+        if (!put(fd, SOL_SOCKET, SO_RCVBUF, rcvbuf)) return "SO_RCVBUF";
+        if (!put(fd, SOL_SOCKET, SO_SNDBUF, sndbuf)) return "SO_SNDBUF";
+        if (!put(fd, IPPROTO_TCP, TCP_QUICKACK, quickack)) return "TCP_QUICKACK";
+        if (!put(fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT, notsent_lowat)) return "TCP_NOTSENT_LOWAT";
+        if (!put(fd, SOL_SOCKET, SO_BUSY_POLL, busy_poll)) return "SO_BUSY_POLL";
+        if (!put(fd, SOL_SOCKET, SO_KEEPALIVE, keepalive)) return "SO_KEEPALIVE";
+        if (!put(fd, IPPROTO_TCP, TCP_KEEPIDLE, keepidle)) return "TCP_KEEPIDLE";
+        if (!put(fd, IPPROTO_TCP, TCP_KEEPINTVL, keepintvl)) return "TCP_KEEPINTVL";
+        if (!put(fd, IPPROTO_TCP, TCP_KEEPCNT, keepcnt)) return "TCP_KEEPCNT";
+        return nullptr;
+    }
+
+    template <typename T>
+    static bool put(int fd, int level, int name, const std::optional<T>& v) noexcept {
+        if (!v) return true;
+        int option = static_cast<int>(*v);
+        return -1 != setsockopt(fd, level, name, (void*)&option, sizeof(option));
+    }
+
+    template <typename T>
+    static void set(int fd, int level, int name, const std::optional<T>& v, const char* what) {
+        if (!put(fd, level, name, v)) throw std::runtime_error(std::string(what) + ": " + strerror(errno));
+    }
+};
+
+}  // namespace fnet
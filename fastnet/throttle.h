@@ -0,0 +1,166 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "conntable.h"
+#include "ratelimit.h"
+#include "reactor.h"
+
+namespace fnet {
+
+/**
+ * @brief 按连接与来源地址限制请求速率
+ * 每个连接与每个来源地址各有一个惰性补充的令牌桶；令牌不足时暂停读取该连接，
+ * 所有被暂停的连接按恢复时间放在一个堆中，只占用反应堆的一个定时器
+ * @note 只能在反应堆线程中使用；连接关闭前须调用remove()
+ */
+class throttle {
+public:
+    struct options {
+        double conn_rate = 0;     // 每个连接每秒的请求数，0表示不限制
+        double conn_burst = 32;
+        double ip_rate = 0;       // 每个来源地址每秒的请求数，0表示不限制
+        double ip_burst = 128;
+    };
+
+private:
+    struct conn {
+        token_bucket bucket;
+        uint64_t ip = 0;
+        bool paused = false;
+    };
+    using handle_t = conntable<conn>::handle;
+
+    struct wakeup {
+        uint64_t at;
+        handle_t h;
+        double cost;
+        bool operator>(const wakeup& o) const noexcept {
+            return at > o.at;
+        }
+    };
+
+    reactor& rec;
+    options opt;
+    conntable<conn> conns;
+    ip_table ips;
+    std::vector<wakeup> wakeups;  // 最小堆
+    uint64_t armed_id = 0;        // 反应堆定时器，0表示未设置
+    uint64_t armed_at = UINT64_MAX;
+
+public:
+    throttle(reactor& rec, options opt)
+        : rec(rec)
+        , opt(opt) {}
+    throttle(const throttle&) = delete;
+
+    /**
+     * @brief 开始限制一个连接
+     * @param fd 已添加到反应堆的套接字
+     * @param ip 来源地址的键，见ip_key()
+     */
+    void add(int fd, uint64_t ip) {
+        auto& e = ips.insert(ip);
+        if (e.conns++ == 0) e.bucket = token_bucket(opt.ip_rate, opt.ip_burst);
+        conns.emplace(fd, conn{token_bucket(opt.conn_rate, opt.conn_burst), ip, false});
+    }
+
+    /**
+     * @brief 停止限制（连接关闭前调用），不改变fd在反应堆中的状态
+     */
+    void remove(int fd) {
+        auto* c = conns.find(fd);
+        if (!c) return;
+        auto* e = ips.find(c->ip);
+        if (e && --e->conns == 0) ips.erase(c->ip);
+        conns.erase(fd);
+    }
+
+    /**
+     * @brief 处理一个请求前调用，从连接与来源地址的令牌桶中各取出cost个令牌
+     * @param cost 不超过burst
+     * @return false -> 令牌不足，连接已被暂停读取，调用者应停止处理并保留未处理的数据；
+     *         令牌补充后恢复读取并通过reactor::defer_readable()再次调用可读回调
+     */
+    bool consume(int fd, double cost = 1) {
+        auto* c = conns.find(fd);
+        if (!c) return true;
+        if (c->paused) return false;
+        uint64_t now = rec.loop_now();
+        auto* ip = opt.ip_rate > 0 ? &ips.find(c->ip)->bucket : nullptr;
+        if (opt.conn_rate <= 0 || c->bucket.ready_at(cost, now) <= now) {
+            if (!ip || ip->try_take(cost, now)) {
+                if (opt.conn_rate > 0) c->bucket.try_take(cost, now);
+                return true;
+            }
+        }
+        c->paused = true;
+        rec.pause_reading(fd);
+        schedule({ready_at(*c, cost, now), conns.handle_of(fd), cost});
+        return false;
+    }
+
+    /**
+     * @brief 连接是否被暂停
+     */
+    bool paused(int fd) const noexcept {
+        auto* c = conns.find(fd);
+        return c && c->paused;
+    }
+
+    size_t size() const noexcept {
+        return conns.size();
+    }
+
+private:
+    uint64_t ready_at(conn& c, double cost, uint64_t now) {
+        uint64_t at = now;
+        if (opt.conn_rate > 0) at = std::max(at, c.bucket.ready_at(cost, now));
+        if (opt.ip_rate > 0) at = std::max(at, ips.find(c.ip)->bucket.ready_at(cost, now));
+        return at;
+    }
+
+    void schedule(wakeup w) {
+        wakeups.push_back(w);
+        std::push_heap(wakeups.begin(), wakeups.end(), std::greater<wakeup>());
+        arm();
+    }
+
+    // 让反应堆定时器对准堆顶
+    void arm() {
+        if (wakeups.empty() || wakeups.front().at >= armed_at) return;
+        if (armed_id) rec.cancel_timer(armed_id);
+        armed_at = wakeups.front().at;
+        armed_id = rec.run_at(armed_at, [this] {
+            armed_id = 0;
+            armed_at = UINT64_MAX;
+            on_timer();
+        });
+    }
+
+    void on_timer() {
+        uint64_t now = rec.loop_now();
+        while (!wakeups.empty() && wakeups.front().at <= now) {
+            wakeup w = wakeups.front();
+            std::pop_heap(wakeups.begin(), wakeups.end(), std::greater<wakeup>());
+            wakeups.pop_back();
+            conn* c = conns.find(w.h);
+            if (!c) continue;  // 连接已被移除
+            // 同一地址的其他连接可能先取走了令牌
+            uint64_t at = ready_at(*c, w.cost, now);
+            if (at > now) {
+                w.at = at;
+                wakeups.push_back(w);
+                std::push_heap(wakeups.begin(), wakeups.end(), std::greater<wakeup>());
+                continue;
+            }
+            c->paused = false;
+            rec.resume_reading(w.h.fd);
+            // 用户缓冲中可能还有未处理的请求，不能只依赖新的可读事件
+            rec.defer_readable(w.h.fd);
+        }
+        arm();
+    }
+};
+
+}  // namespace fnet
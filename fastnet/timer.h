@@ -1,10 +1,12 @@
 #pragma once
 #include <chrono>
 #include <cstdint>
+#include <iostream>
 #include <set>
 #include <mutex>
 #include <thread>
 #include <condition_variable>
+#include "metrics.h"
 
 namespace fnet {
 namespace details {
@@ -84,6 +86,12 @@ public:
     bool is_timeout(clock_t::time_point now) const {
         return std::chrono::time_point_cast<duration_t>(now) > timeout_stamp;
     }
+    /**
+     * @brief 获取超时时间点
+     */
+    timestamp_t deadline() const {
+        return timeout_stamp;
+    }
     bool operator < (const timer<ratio_t>& other) const {
         return this->timeout_stamp < other.timeout_stamp;
     }
@@ -105,6 +113,7 @@ private:
     std::thread thrd;
     std::condition_variable thread_cv;
     container_t timers = {};
+    histogram* lag_hist = nullptr;
 public:
     explicit timer_master() = default;
     timer_master(const timer_master&) = delete;
@@ -145,18 +154,31 @@ public:
         std::lock_guard<std::mutex> lock(lok);
         return timers.size();
     }
+    /**
+     * @brief 设置记录定时器延迟的直方图（单位：纳秒），如reactor_metrics::timer_lag_ns
+     * @param h 直方图，传入nullptr则不记录
+     * @note 直方图只允许单线程写入，启用异步清理后由工作线程写入；reactor_metrics::timer_lag_ns同时记录反应堆
+     *       自己的定时器，只有在反应堆线程中清理时才能共用，否则应传入另一个直方图
+     */
+    void set_lag_histogram(histogram* h) {
+        std::lock_guard<std::mutex> lock(lok);
+        lag_hist = h;
+    }
     /**
      * @brief 清除超时定时器
      * @param exec 是否执行回调
      */
     void clean_timeout_timers() {
-        timer<ratio_t> temp(0);  // 瞬间过期
         std::lock_guard<std::mutex> lock(lok);
-        auto lb = timers.lower_bound(temp);
-        for (auto it = timers.begin(); it != lb; ++it) {
-            (*it)();
-        }
-        timers.erase(timers.begin(), lb);
+        expire(timer<ratio_t>::clock_t::now());
+    }
+    /**
+     * @brief 以调用者给出的当前时间清除超时定时器，如reactor::loop_time_point()
+     * @param now 当前时间
+     */
+    void clean_timeout_timers(typename timer<ratio_t>::clock_t::time_point now) {
+        std::lock_guard<std::mutex> lock(lok);
+        expire(now);
     }
     /**
      * @brief 启动自动清除超时定时器功能
@@ -179,13 +201,23 @@ private:
             if (closed) return;
             thread_cv.wait_for(locker, std::chrono::milliseconds(tval));
             // 清除并自动执行回调
-            timer<ratio_t> temp(0);  // 瞬间过期
-            auto lb = timers.lower_bound(temp);
-            for (auto it = timers.begin(); it != lb; ++it) {
-                (*it)();
+            expire(timer<ratio_t>::clock_t::now());
+        }
+    }
+    // 执行并清除超时定时器，调用者需持有锁
+    void expire(typename timer<ratio_t>::clock_t::time_point now) {
+        // 按到期时间有序，逐个比较到第一个未到期的定时器为止
+        auto stamp = std::chrono::time_point_cast<typename timer<ratio_t>::duration_t>(now);
+        auto lb = timers.begin();
+        while (lb != timers.end() && lb->deadline() < stamp) ++lb;
+        for (auto it = timers.begin(); it != lb; ++it) {
+            if (lag_hist) {
+                auto lag = now - it->deadline();
+                lag_hist->record(std::chrono::duration_cast<std::chrono::nanoseconds>(lag).count());
             }
-            timers.erase(timers.begin(), lb);
+            (*it)();
         }
+        timers.erase(timers.begin(), lb);
     }
 };
 
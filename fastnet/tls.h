@@ -0,0 +1,475 @@
+#pragma once
+#include <openssl/bio.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/opensslv.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#include <sys/sendfile.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include "conntable.h"
+#include "reactor.h"
+
+/**
+ * TLS依赖OpenSSL 3.0以上（EVP_EC_gen()、SSL_OP_ENABLE_KTLS），不包含在fastnet.h中：
+ * 使用时包含本文件并链接libssl与libcrypto（CMake中为find_package(OpenSSL 3.0)与OpenSSL::SSL）
+ * 内核TLS（kTLS）还需要OpenSSL编译时未定义OPENSSL_NO_KTLS与加载了tls模块的内核，缺少任一条件时回退到用户态加解密
+ */
+#if OPENSSL_VERSION_NUMBER < 0x30000000L
+#error "fastnet/tls.h requires OpenSSL 3.0 or later"
+#endif
+
+namespace fnet {
+namespace tls {
+
+namespace details {
+
+inline std::string last_error(const char* what) {
+    char buf[256];
+    unsigned long e = ERR_get_error();
+    ERR_clear_error();
+    if (!e) return std::string("tls: ") + what;
+    ERR_error_string_n(e, buf, sizeof(buf));
+    return std::string("tls: ") + what + ": " + buf;
+}
+
+struct ctx_deleter {
+    void operator()(SSL_CTX* c) const noexcept {
+        SSL_CTX_free(c);
+    }
+};
+
+struct ssl_deleter {
+    void operator()(SSL* s) const noexcept {
+        SSL_free(s);
+    }
+};
+
+}  // namespace details
+
+/**
+ * @brief 证书、私钥与校验设置（SSL_CTX），可被多个反应堆上的端点共享
+ * @note 加载失败时抛出异常
+ */
+class context {
+    std::shared_ptr<SSL_CTX> ctx;
+
+    explicit context(const SSL_METHOD* method) {
+        SSL_CTX* c = SSL_CTX_new(method);
+        if (!c) throw std::runtime_error(details::last_error("SSL_CTX_new"));
+        ctx.reset(c, details::ctx_deleter());
+        SSL_CTX_set_min_proto_version(c, TLS1_2_VERSION);
+    }
+
+public:
+    /**
+     * @brief 服务端，从PEM文件加载证书链与私钥
+     */
+    static context server(const std::string& cert_file, const std::string& key_file) {
+        context c(TLS_server_method());
+        if (SSL_CTX_use_certificate_chain_file(c.native(), cert_file.c_str()) != 1 ||
+            SSL_CTX_use_PrivateKey_file(c.native(), key_file.c_str(), SSL_FILETYPE_PEM) != 1 ||
+            SSL_CTX_check_private_key(c.native()) != 1) {
+            throw std::runtime_error(details::last_error("load certificate"));
+        }
+        return c;
+    }
+
+    /**
+     * @brief 服务端，使用临时生成的自签名证书（P-256），用于测试与基准
+     * @param common_name 证书的CN
+     */
+    static context self_signed(const std::string& common_name = "localhost") {
+        context c(TLS_server_method());
+        std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)> key(EVP_EC_gen("P-256"), EVP_PKEY_free);
+        std::unique_ptr<X509, decltype(&X509_free)> cert(X509_new(), X509_free);
+        if (!key || !cert) throw std::runtime_error(details::last_error("generate key"));
+        X509_set_version(cert.get(), 2);
+        ASN1_INTEGER_set(X509_get_serialNumber(cert.get()), 1);
+        X509_gmtime_adj(X509_getm_notBefore(cert.get()), 0);
+        X509_gmtime_adj(X509_getm_notAfter(cert.get()), 365L * 24 * 3600);
+        X509_set_pubkey(cert.get(), key.get());
+        X509_NAME* name = X509_get_subject_name(cert.get());
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                                   reinterpret_cast<const unsigned char*>(common_name.c_str()), -1, -1, 0);
+        X509_set_issuer_name(cert.get(), name);
+        if (!X509_sign(cert.get(), key.get(), EVP_sha256()) ||
+            SSL_CTX_use_certificate(c.native(), cert.get()) != 1 ||
+            SSL_CTX_use_PrivateKey(c.native(), key.get()) != 1) {
+            throw std::runtime_error(details::last_error("self-signed certificate"));
+        }
+        return c;
+    }
+
+    /**
+     * @brief 客户端
+     * @param ca_file 用于校验服务端证书的CA（PEM），为空时使用系统默认的CA路径
+     * @param verify 是否校验服务端证书；关闭时任何证书都被接受，只应在测试中使用
+     */
+    static context client(const std::string& ca_file = "", bool verify = true) {
+        context c(TLS_client_method());
+        if (!verify) return c;
+        SSL_CTX_set_verify(c.native(), SSL_VERIFY_PEER, nullptr);
+        int ok = ca_file.empty() ? SSL_CTX_set_default_verify_paths(c.native())
+                                 : SSL_CTX_load_verify_locations(c.native(), ca_file.c_str(), nullptr);
+        if (ok != 1) throw std::runtime_error(details::last_error("load CA"));
+        return c;
+    }
+
+    SSL_CTX* native() const noexcept {
+        return ctx.get();
+    }
+};
+
+/**
+ * @brief 单个反应堆上的TLS连接：握手由可读/可写事件驱动，在用户态通过OpenSSL完成，
+ *        之后尽量把连接切换为内核TLS（TCP_ULP "tls"）：
+ *          - 发送方向启用kTLS时，send()把明文直接交给reactor::send()，与其他写入一同合并写出，由内核加密；
+ *            send_file()以sendfile零拷贝发送
+ *          - 未启用时在用户态加密到内存中，再把密文交给reactor::send()
+ *          - 接收方向无论是否启用kTLS都经SSL_read()读取（启用时OpenSSL只从内核读取明文，不再解密）
+ * @note 只能在所属反应堆的线程中使用。连接需已通过add_socket()以event::readable加入反应堆，再accept()或connect()；
+ *       在可读回调中调用on_readable()、可写回调中调用on_writable()（返回false时应remove()并关闭连接），
+ *       在断开回调中调用remove()。启用kTLS后不能再直接读取fd（内核会以EIO拒绝非应用数据的记录）；
+ *       TLS状态不随reactor::migrate()迁移
+ */
+class endpoint {
+public:
+    using ready_cb_t = std::function<void(int)>;
+    using data_cb_t = std::function<void(int, std::string_view)>;
+
+    struct options {
+        bool ktls = true;                  // 握手完成后尝试切换为内核TLS
+        size_t read_chunk = 64 * 1024;     // 每次SSL_read()的缓冲大小
+    };
+
+    struct statistics {
+        uint64_t handshakes = 0;       // 完成的握手
+        uint64_t failures = 0;         // 握手或读取中的TLS错误
+        uint64_t ktls_tx = 0;          // 发送方向启用了kTLS的连接
+        uint64_t ktls_rx = 0;          // 接收方向启用了kTLS的连接
+        uint64_t bytes_in = 0;         // 解密后的明文字节数
+        uint64_t bytes_out = 0;        // 发送的明文字节数
+        uint64_t sendfile_bytes = 0;   // 以sendfile零拷贝发送的字节数
+    };
+
+private:
+    struct conn {
+        std::unique_ptr<SSL, details::ssl_deleter> ssl;
+        pattern_t pat = pattern::lt;
+        bool ready = false;        // 握手完成
+        bool want_write = false;   // OpenSSL写socket时遇到EAGAIN，临时监听可写事件
+        bool ktls_tx = false;
+        bool ktls_rx = false;
+        BIO* out = nullptr;        // 未启用发送方向kTLS时的密文缓冲（由ssl持有）
+        std::string early;         // 握手完成前send()的明文
+    };
+
+    reactor& rec;
+    context ctx;
+    options opt;
+    conntable<conn> conns;
+    std::unique_ptr<char[]> rbuf;
+    ready_cb_t ready_cb = [](int) {};
+    data_cb_t data_cb = [](int, std::string_view) {};
+    statistics st;
+
+public:
+    endpoint(reactor& rec, context ctx) : endpoint(rec, std::move(ctx), options()) {}
+    endpoint(reactor& rec, context ctx, options opt)
+        : rec(rec)
+        , ctx(std::move(ctx))
+        , opt(opt)
+        , rbuf(new char[opt.read_chunk]) {}
+    endpoint(const endpoint&) = delete;
+
+    /**
+     * @brief 握手完成的回调，类型: void(int fd)，之后的send()立即写出
+     */
+    void set_ready_cb(ready_cb_t cb) {
+        ready_cb = std::move(cb);
+    }
+
+    /**
+     * @brief 收到明文的回调，类型: void(int fd, std::string_view data)，data只在回调期间有效
+     */
+    void set_data_cb(data_cb_t cb) {
+        data_cb = std::move(cb);
+    }
+
+    /**
+     * @brief 以服务端身份管理一个连接，等待客户端发起握手
+     * @param fd 已以event::readable加入反应堆的连接
+     * @param pat 加入反应堆时的模式，握手中临时监听可写事件时沿用
+     */
+    void accept(int fd, pattern_t pat = pattern::lt) {
+        conn& c = attach(fd, pat);
+        SSL_set_accept_state(c.ssl.get());
+    }
+
+    /**
+     * @brief 以客户端身份管理一个连接并立即发起握手
+     * @param host 服务端名称，用于SNI与证书校验（context::client()开启校验时），为空时不设置
+     * @return false -> 握手已失败，应remove()并关闭连接
+     */
+    bool connect(int fd, std::string_view host = {}, pattern_t pat = pattern::lt) {
+        conn& c = attach(fd, pat);
+        SSL* s = c.ssl.get();
+        SSL_set_connect_state(s);
+        if (!host.empty()) {
+            std::string h(host);
+            SSL_set_tlsext_host_name(s, h.c_str());
+            if (SSL_CTX_get_verify_mode(ctx.native()) & SSL_VERIFY_PEER) SSL_set1_host(s, h.c_str());
+        }
+        return drive(fd, c);
+    }
+
+    /**
+     * @brief 移除连接，丢弃TLS状态
+     * @note 不关闭fd，也不发送close_notify（见shutdown()）
+     */
+    void remove(int fd) {
+        conns.erase(fd);
+    }
+
+    /**
+     * @brief 处理可读事件：推进握手，读出并解密数据交给数据回调
+     * @return false -> 对端关闭（close_notify或EOF）或TLS错误
+     */
+    bool on_readable(int fd) {
+        conn* c = conns.find(fd);
+        return c && drive(fd, *c);
+    }
+
+    /**
+     * @brief 处理可写事件：OpenSSL写socket曾遇到EAGAIN时继续
+     * @return 同on_readable()
+     */
+    bool on_writable(int fd) {
+        conn* c = conns.find(fd);
+        if (!c) return false;
+        if (!c->want_write) return true;
+        c->want_write = false;
+        rec.reset_event(fd, event::readable, c->pat);
+        return drive(fd, *c);
+    }
+
+    /**
+     * @brief 发送明文，握手完成前暂存
+     * @note 密文（或kTLS下的明文）经reactor::send()写出，写不完的部分由反应堆继续
+     */
+    void send(int fd, const void* data, size_t len) {
+        conn* c = conns.find(fd);
+        if (!c || !len) return;
+        if (!c->ready) {
+            c->early.append(static_cast<const char*>(data), len);
+            return;
+        }
+        write(fd, *c, data, len);
+    }
+
+    void send(int fd, std::string_view data) {
+        send(fd, data.data(), data.size());
+    }
+
+    /**
+     * @brief 发送文件的一段：发送方向启用kTLS且连接没有未写出的数据时以sendfile零拷贝写出，
+     *        其余部分（及未启用kTLS时的全部）读入内存后经send()发送
+     * @param fd 握手已完成的连接
+     * @param file_fd 打开的文件
+     * @param offset 文件中的起始位置
+     * @param len 长度
+     * @note 全部内容都会进入发送队列；大文件应分段调用，根据reactor::pending_output()控制节奏
+     */
+    void send_file(int fd, int file_fd, off_t offset, size_t len) {
+        conn* c = conns.find(fd);
+        if (!c || !c->ready) throw std::runtime_error("tls: connection is not ready");
+        if (c->ktls_tx && rec.pending_output(fd) == 0) {
+            while (len) {
+                ssize_t n = ::sendfile(fd, file_fd, &offset, len);
+                if (n <= 0) break;
+                len -= n;
+                st.sendfile_bytes += n;
+                st.bytes_out += n;
+            }
+        }
+        std::string buf;  // 可能在数据回调中调用，不能使用rbuf
+        while (len) {
+            buf.resize(std::min(len, opt.read_chunk));
+            ssize_t n = pread(file_fd, &buf[0], buf.size(), offset);
+            if (n <= 0) throw std::runtime_error(std::string("tls: pread: ") + strerror(n < 0 ? errno : EIO));
+            write(fd, *c, buf.data(), n);
+            offset += n;
+            len -= n;
+        }
+    }
+
+    /**
+     * @brief 发送close_notify，之后不能再send()
+     * @note 发送方向启用kTLS时close_notify由OpenSSL直接写入socket，等reactor::send()队列写完后
+     *       （reactor::when_drained()）再发送；在此之前remove()的连接不再发送
+     */
+    void shutdown(int fd) {
+        conn* c = conns.find(fd);
+        if (!c || !c->ready) return;
+        if (c->ktls_tx && rec.pending_output(fd)) {
+            auto h = conns.handle_of(fd);
+            rec.when_drained(fd, [this, h](int fd) {
+                if (conns.find(h)) shutdown(fd);
+            });
+            return;
+        }
+        SSL_shutdown(c->ssl.get());
+        flush_out(fd, *c);
+    }
+
+    /**
+     * @brief 握手是否已完成
+     */
+    bool ready(int fd) const noexcept {
+        auto* c = conns.find(fd);
+        return c && c->ready;
+    }
+
+    /**
+     * @brief 发送方向是否由内核加密
+     */
+    bool ktls_send(int fd) const noexcept {
+        auto* c = conns.find(fd);
+        return c && c->ktls_tx;
+    }
+
+    /**
+     * @brief 接收方向是否由内核解密
+     */
+    bool ktls_recv(int fd) const noexcept {
+        auto* c = conns.find(fd);
+        return c && c->ktls_rx;
+    }
+
+    /**
+     * @brief 协商的TLS版本，如"TLSv1.3"
+     */
+    const char* version(int fd) const noexcept {
+        auto* c = conns.find(fd);
+        return c ? SSL_get_version(c->ssl.get()) : "";
+    }
+
+    const statistics& stats() const noexcept {
+        return st;
+    }
+
+private:
+    conn& attach(int fd, pattern_t pat) {
+        SSL* s = SSL_new(ctx.native());
+        if (!s) throw std::runtime_error(details::last_error("SSL_new"));
+        conns.erase(fd);  // 未remove()就被复用的fd，使之前连接的句柄失效
+        conn& c = conns.emplace(fd);
+        c.ssl.reset(s);
+        c.pat = pat;
+        if (SSL_set_fd(s, fd) != 1) throw std::runtime_error(details::last_error("SSL_set_fd"));
+        if (opt.ktls) SSL_set_options(s, SSL_OP_ENABLE_KTLS);
+        return c;
+    }
+
+    // 推进握手，之后读出所有可读的数据
+    bool drive(int fd, conn& c) {
+        SSL* s = c.ssl.get();
+        if (!c.ready) {
+            int r = SSL_do_handshake(s);
+            if (r != 1) return retry(fd, c, r);
+            on_handshake(fd, c);
+        }
+        while (true) {
+            int n = SSL_read(s, rbuf.get(), static_cast<int>(opt.read_chunk));
+            if (n <= 0) {
+                bool ok = retry(fd, c, n);
+                if (c.out) flush_out(fd, c);  // 读取中产生的控制消息（如KeyUpdate的应答）
+                return ok;
+            }
+            st.bytes_in += n;
+            data_cb(fd, std::string_view(rbuf.get(), n));
+            if (!conns.find(fd)) return false;  // 回调中移除了连接
+        }
+    }
+
+    // SSL操作未完成：等待可读或可写时返回true，连接关闭或出错时返回false
+    bool retry(int fd, conn& c, int r) {
+        switch (SSL_get_error(c.ssl.get(), r)) {
+        case SSL_ERROR_WANT_READ:
+            return true;
+        case SSL_ERROR_WANT_WRITE:
+            if (!c.want_write) {
+                c.want_write = true;
+                rec.reset_event(fd, event::readable | event::writable, c.pat);
+            }
+            return true;
+        case SSL_ERROR_ZERO_RETURN:
+            return false;
+        case SSL_ERROR_SYSCALL:
+            ERR_clear_error();
+            return false;
+        default:
+            ++st.failures;
+            ERR_clear_error();
+            return false;
+        }
+    }
+
+    void on_handshake(int fd, conn& c) {
+        SSL* s = c.ssl.get();
+        c.ready = true;
+        ++st.handshakes;
+        c.ktls_tx = BIO_get_ktls_send(SSL_get_wbio(s));
+        c.ktls_rx = BIO_get_ktls_recv(SSL_get_rbio(s));
+        if (c.ktls_tx) ++st.ktls_tx;
+        if (c.ktls_rx) ++st.ktls_rx;
+        if (!c.ktls_tx) {
+            // 之后的密文写入内存，由reactor::send()合并写出
+            c.out = BIO_new(BIO_s_mem());
+            SSL_set0_wbio(s, c.out);
+        }
+        if (!c.early.empty()) {
+            std::string early;
+            early.swap(c.early);
+            write(fd, c, early.data(), early.size());
+        }
+        ready_cb(fd);
+    }
+
+    void write(int fd, conn& c, const void* data, size_t len) {
+        st.bytes_out += len;
+        if (c.ktls_tx) {
+            rec.send(fd, data, len);
+            return;
+        }
+        // 内存BIO总能写完
+        if (SSL_write(c.ssl.get(), data, static_cast<int>(len)) <= 0) {
+            ++st.failures;
+            ERR_clear_error();
+            return;
+        }
+        flush_out(fd, c);
+    }
+
+    void flush_out(int fd, conn& c) {
+        if (!c.out) return;
+        char* p = nullptr;
+        long n = BIO_get_mem_data(c.out, &p);
+        if (n <= 0) return;
+        rec.send(fd, p, static_cast<size_t>(n));
+        (void)BIO_reset(c.out);
+    }
+};
+
+}  // namespace tls
+}  // namespace fnet
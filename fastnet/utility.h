@@ -36,9 +36,41 @@ struct utility {
         }
     }
 
+    /**
+     * @brief 允许多个socket绑定同一端口，内核在它们之间分配新连接
+     * @note 失败时抛出异常
+     */
+    static void set_reuse_port(int fd) {
+        int option = 1;
+        if (-1 == setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, (void*)&option, sizeof(option))) {
+            throw std::runtime_error(strerror(errno));
+        }
+    }
+
+    /**
+     * @brief 设置SO_INCOMING_CPU：对SO_REUSEPORT的一组监听socket，内核优先把新连接交给与处理该连接的CPU相同的socket
+     * @note 失败时抛出异常
+     */
+    static void set_incoming_cpu(int fd, int cpu) {
+        if (-1 == setsockopt(fd, SOL_SOCKET, SO_INCOMING_CPU, (void*)&cpu, sizeof(cpu))) {
+            throw std::runtime_error(strerror(errno));
+        }
+    }
+
+    /**
+     * @brief 获取处理该连接数据包的CPU（网卡队列中断所在的CPU）
+     * @return CPU编号，未知时返回-1
+     */
+    static int incoming_cpu(int fd) {
+        int cpu = -1;
+        socklen_t len = sizeof(cpu);
+        if (-1 == getsockopt(fd, SOL_SOCKET, SO_INCOMING_CPU, (void*)&cpu, &len)) return -1;
+        return cpu;
+    }
+
     // 禁止Nagle算法
     static void set_tcp_nondelay(int sock) {
-        int option;
+        int option = 1;
         if (-1 == setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (void*)(&option), sizeof(option))) {
             throw std::runtime_error(strerror(errno));
         }
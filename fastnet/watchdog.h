@@ -0,0 +1,191 @@
+#pragma once
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "metrics.h"
+
+/**
+ * 慢回调检测与事件循环追踪
+ * 仅在定义了 FNET_ENABLE_WATCHDOG 时编译进反应堆，未定义时反应堆中不存在任何相关代码
+ */
+
+namespace fnet {
+
+/**
+ * @brief 覆盖式的无锁环形记录器（单写者），写者从不阻塞，读者获取最近的N条记录
+ * @tparam T 记录类型，需可平凡拷贝
+ * @tparam N 容量，需为2的幂
+ */
+template <typename T, size_t N>
+class trace_ring {
+    static_assert((N & (N - 1)) == 0, "capacity must be a power of 2");
+    static_assert(std::is_trivially_copyable<T>::value, "record must be trivially copyable");
+
+    struct slot {
+        std::atomic<uint64_t> seq = {0};  // 奇数表示正在写入
+        T data;
+    };
+    std::atomic<uint64_t> head = {0};
+    std::unique_ptr<slot[]> slots;
+
+public:
+    trace_ring()
+        : slots(new slot[N]) {}
+    trace_ring(const trace_ring&) = delete;
+
+    void push(const T& rec) noexcept {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        slot& s = slots[h & (N - 1)];
+        uint64_t seq = s.seq.load(std::memory_order_relaxed);
+        s.seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(&s.data, &rec, sizeof(T));
+        s.seq.store(seq + 2, std::memory_order_release);
+        head.store(h + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief 读出最近的记录（由旧到新），正在被覆盖的记录会被跳过
+     * @param out 输出
+     */
+    void collect(std::vector<T>& out) const {
+        uint64_t h = head.load(std::memory_order_acquire);
+        uint64_t begin = h > N ? h - N : 0;
+        for (uint64_t i = begin; i < h; ++i) {
+            const slot& s = slots[i & (N - 1)];
+            uint64_t seq1 = s.seq.load(std::memory_order_acquire);
+            if (seq1 & 1) continue;
+            T copy;
+            std::memcpy(&copy, &s.data, sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (s.seq.load(std::memory_order_relaxed) != seq1) continue;
+            out.push_back(copy);
+        }
+    }
+
+    // 写入过的记录总数（包括已被覆盖的）
+    uint64_t total() const noexcept {
+        return head.load(std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @brief 反应堆看门狗，记录超过阈值的回调，并保存最近若干轮事件循环的时间线
+ * @note 通过reactor::set_watchdog()挂载，记录只由反应堆线程写入，可在任意线程读取或导出
+ */
+class watchdog {
+public:
+    // 慢回调记录
+    struct stall {
+        uint64_t begin_ns;
+        uint64_t dur_ns;
+        int fd;
+        cb_kind kind;
+    };
+    // 一轮事件循环
+    struct iteration {
+        uint64_t wait_begin_ns;   // 开始epoll_wait
+        uint64_t begin_ns;        // epoll_wait返回
+        uint64_t end_ns;          // 本轮事件处理完毕
+        int events;
+    };
+
+private:
+    std::atomic<uint64_t> threshold;
+    std::atomic<long> tid = {0};
+    trace_ring<stall, 1024> stalls_ring;
+    trace_ring<iteration, 4096> loops_ring;
+
+public:
+    /**
+     * @brief 构造看门狗
+     * @param threshold_ns 慢回调阈值，单位: ns
+     */
+    explicit watchdog(uint64_t threshold_ns)
+        : threshold(threshold_ns) {}
+    watchdog(const watchdog&) = delete;
+
+    void set_threshold(uint64_t threshold_ns) noexcept {
+        threshold.store(threshold_ns, std::memory_order_relaxed);
+    }
+
+    // 由反应堆在每次回调结束后调用
+    void on_callback(int fd, cb_kind kind, uint64_t begin_ns, uint64_t end_ns) noexcept {
+        uint64_t dur = end_ns - begin_ns;
+        if (dur >= threshold.load(std::memory_order_relaxed)) {
+            stalls_ring.push(stall{begin_ns, dur, fd, kind});
+        }
+    }
+
+    // 由反应堆在每轮事件处理结束后调用
+    void on_iteration(uint64_t wait_begin_ns, uint64_t begin_ns, uint64_t end_ns, int events) noexcept {
+        if (!tid.load(std::memory_order_relaxed)) {
+            tid.store(syscall(SYS_gettid), std::memory_order_relaxed);
+        }
+        loops_ring.push(iteration{wait_begin_ns, begin_ns, end_ns, events});
+    }
+
+    /**
+     * @brief 获取最近的慢回调记录
+     */
+    std::vector<stall> stalls() const {
+        std::vector<stall> res;
+        stalls_ring.collect(res);
+        return res;
+    }
+
+    /**
+     * @brief 获取最近的事件循环记录
+     */
+    std::vector<iteration> iterations() const {
+        std::vector<iteration> res;
+        loops_ring.collect(res);
+        return res;
+    }
+
+    /**
+     * @brief 慢回调总数（包括已被覆盖的记录）
+     */
+    uint64_t num_stalls() const noexcept {
+        return stalls_ring.total();
+    }
+
+    /**
+     * @brief 导出Chrome Trace（Perfetto可直接打开）格式的JSON时间线
+     * @param os 输出流
+     */
+    void dump_chrome_trace(std::ostream& os) const {
+        long t = tid.load(std::memory_order_relaxed);
+        auto us = [](uint64_t ns) { return std::to_string(ns / 1000) + "." + std::to_string(ns % 1000 / 100); };
+        bool first = true;
+        auto begin_event = [&]() -> std::ostream& {
+            os << (first ? "\n" : ",\n");
+            first = false;
+            return os;
+        };
+        os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        for (auto& it : iterations()) {
+            begin_event() << "{\"name\":\"epoll_wait\",\"cat\":\"loop\",\"ph\":\"X\",\"pid\":" << getpid()
+                          << ",\"tid\":" << t << ",\"ts\":" << us(it.wait_begin_ns)
+                          << ",\"dur\":" << us(it.begin_ns - it.wait_begin_ns) << "}";
+            begin_event() << "{\"name\":\"dispatch\",\"cat\":\"loop\",\"ph\":\"X\",\"pid\":" << getpid()
+                          << ",\"tid\":" << t << ",\"ts\":" << us(it.begin_ns) << ",\"dur\":"
+                          << us(it.end_ns - it.begin_ns) << ",\"args\":{\"events\":" << it.events << "}}";
+        }
+        for (auto& s : stalls()) {
+            begin_event() << "{\"name\":\"" << details::cb_kind_name(s.kind) << "\",\"cat\":\"stall\",\"ph\":\"X\""
+                          << ",\"pid\":" << getpid() << ",\"tid\":" << t << ",\"ts\":" << us(s.begin_ns)
+                          << ",\"dur\":" << us(s.dur_ns) << ",\"args\":{\"fd\":" << s.fd << "}}";
+        }
+        os << "\n]}\n";
+    }
+};
+
+}  // namespace fnet
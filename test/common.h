@@ -0,0 +1,38 @@
+#pragma once
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cassert>
+#include <string>
+
+// 测试程序共用的工具：非阻塞的socketpair与读空连接
+
+/**
+ * @brief 读出非阻塞fd中已到达的全部数据，读到EAGAIN或对端关闭为止
+ */
+inline std::string drain(int fd) {
+    std::string s;
+    char buf[65536];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) s.append(buf, n);
+    return s;
+}
+
+/**
+ * @brief 一对非阻塞的UNIX域流socket：local加入反应堆，测试代码在peer上读写
+ */
+struct pair_fd {
+    int local, peer;
+    pair_fd() {
+        int sv[2];
+        assert(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv) == 0);
+        local = sv[0];
+        peer = sv[1];
+    }
+    ~pair_fd() {
+        close(local);
+        close(peer);
+    }
+    std::string drain() {
+        return ::drain(peer);
+    }
+};
@@ -10,8 +10,7 @@ int main() {
     acp.do_listen();
 
     rec.add_acceptor(std::move(acp), [&rec](int new_fd){
-        std::cout<<"Accepted:"<<new_fd<<" ip:"<<
-        fnet::utility::to_str(rec.remote().sin_addr)<<" port:"<<rec.remote().sin_port<<'\n';
+        std::cout<<"Accepted:"<<new_fd<<" from:"<<rec.remote().to_string()<<'\n';
         fnet::utility::set_nonblocking(new_fd);
         rec.add_socket(new_fd, fnet::event::readable, fnet::pattern::et);
     });
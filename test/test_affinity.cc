@@ -0,0 +1,65 @@
+#include <fastnet/fastnet.h>
+#include <cassert>
+#include <iostream>
+#include <thread>
+
+void test_pin() {
+    int last = fnet::affinity::num_cpus() - 1;
+    std::thread t([&] {
+        fnet::affinity::pin_thread(last);
+        assert(fnet::affinity::current_cpu() == last);
+    });
+    t.join();
+    assert(fnet::affinity::node_of(last) >= 0);
+}
+
+void test_node_array() {
+    fnet::node_array<int> a(1000, fnet::affinity::node_of(0));
+    for (size_t i = 0; i < a.size(); ++i) assert(a[i] == 0);
+    a[999] = 7;
+    fnet::node_array<int> b(std::move(a));
+    assert(b[999] == 7 && a.get() == nullptr);
+}
+
+// 反应堆在activate()开始时绑定CPU，回调都在该CPU上执行
+void test_reactor_cpu() {
+    fnet::reactor rec;
+    int cpu = fnet::affinity::num_cpus() - 1;
+    rec.set_cpu(cpu, true);
+    assert(rec.cpu() == cpu);
+
+    fnet::acceptor<fnet::protocol::tcp> acp;
+    fnet::utility::set_reuse_port(acp.get_fd());
+    acp.do_bind("127.0.0.1", 0);
+    acp.do_listen();
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    getsockname(acp.get_fd(), (struct sockaddr*)&addr, &len);
+    int listener = acp.get_fd();
+    rec.add_acceptor(std::move(acp), [&](int fd) {
+        assert(fnet::affinity::current_cpu() == cpu);
+        assert(fnet::utility::incoming_cpu(fd) >= -1);
+        close(fd);
+        rec.destroy();
+    });
+    int steered = -1;
+    socklen_t olen = sizeof(steered);
+    getsockopt(listener, SOL_SOCKET, SO_INCOMING_CPU, &steered, &olen);
+    assert(steered == cpu);
+
+    std::thread client([&] {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        assert(connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+        close(fd);
+    });
+    std::thread loop([&] { rec.activate(); });
+    loop.join();
+    client.join();
+}
+
+int main() {
+    test_pin();
+    test_node_array();
+    test_reactor_cpu();
+    std::cout << "ok\n";
+}
@@ -0,0 +1,92 @@
+#include <fastnet/cbtrie.h>
+#include <cassert>
+#include <iostream>
+#include <string>
+
+// 插入与查找，未找到时返回0而不是终止进程
+void test_search() {
+    fnet::cbtrie trie;
+    std::string hit;
+    trie.insert("get", [&](char*, size_t) { hit = "get"; });
+    trie.insert("getset", [&](char*, size_t) { hit = "getset"; });
+    trie.insert("set", [&](char*, size_t) { hit = "set"; });
+    trie.insert("ZADD", [&](char*, size_t) { hit = "ZADD"; });
+    trie.insert("x-1\r\n", 5, [&](char*, size_t) { hit = "x-1"; });
+    trie.freeze();
+
+    int p = trie.search("getset", 6);
+    assert(p);
+    trie[p](nullptr, 0);
+    assert(hit == "getset");
+    trie.get(trie.search("get", 3))(nullptr, 0);
+    assert(hit == "get");
+    trie.get(trie.search("x-1\r\n", 5))(nullptr, 0);
+    assert(hit == "x-1");
+    assert(trie.search("ZADD", 4));
+
+    assert(!trie.search("ge", 2));       // 前缀
+    assert(!trie.search("gets", 4));
+    assert(!trie.search("zadd", 4));     // 区分大小写
+    assert(!trie.search("\xff\x00!", 3)); // 任意字节
+    assert(!trie.search("", 0));
+    assert(trie.size() == 5);
+}
+
+// 忽略大小写
+void test_case_insensitive() {
+    fnet::cbtrie trie(true);
+    trie.insert("Ping", [](char*, size_t) {});
+    trie.freeze();
+    assert(trie.search("PING", 4));
+    assert(trie.search("ping", 4) == trie.search("pInG", 4));
+    assert(!trie.search("pong", 4));
+}
+
+// 查找不修改trie：冻结前后结果一致，冻结后继续插入需要再次freeze()
+void test_insert_after_freeze() {
+    fnet::cbtrie trie;
+    const fnet::cbtrie& view = trie;
+    trie.insert("a", [](char*, size_t) {});
+    assert(!view.frozen() && view.search("a", 1));
+    int a = view.search("a", 1);
+    trie.freeze();
+    assert(view.frozen() && view.search("a", 1) == a);
+    assert(!view.search("ab", 2));
+    trie.insert("ab", [](char*, size_t) {});
+    assert(!view.frozen());
+    assert(view.search("ab", 2));
+    assert(view.search("a", 1) == a && !view.search("b", 1));
+    trie.freeze();
+    assert(view.search("a", 1) == a && view.search("ab", 2) && view.search("a", 1) != view.search("ab", 2));
+    // 重复插入只替换回调
+    trie.insert("a", [](char*, size_t) {});
+    assert(trie.size() == 2);
+}
+
+// 大量随机key
+void test_many() {
+    fnet::cbtrie trie;
+    std::vector<std::string> keys;
+    unsigned seed = 7;
+    for (int i = 0; i < 2000; ++i) {
+        std::string k;
+        int len = 1 + (seed = seed * 1103515245 + 12345) % 16;
+        for (int j = 0; j < len; ++j) k += static_cast<char>((seed = seed * 1103515245 + 12345) >> 16);
+        keys.push_back(k);
+        trie.insert(k.data(), k.size(), [](char*, size_t) {});
+    }
+    std::vector<int> before;
+    for (auto& k : keys) before.push_back(trie.search(k.data(), k.size()));
+    trie.freeze();
+    for (size_t i = 0; i < keys.size(); ++i) {
+        assert(before[i] && trie.search(keys[i].data(), keys[i].size()) == before[i]);
+    }
+    std::cout << "keys: " << trie.size() << '\n';
+}
+
+int main() {
+    test_search();
+    test_case_insensitive();
+    test_insert_after_freeze();
+    test_many();
+}
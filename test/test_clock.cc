@@ -0,0 +1,84 @@
+#include <fastnet/fastnet.h>
+#include <cassert>
+#include <iostream>
+#include <thread>
+
+uint64_t diff(uint64_t a, uint64_t b) {
+    return a > b ? a - b : b - a;
+}
+
+// 各时钟源与CLOCK_MONOTONIC使用同一时间基准；TSC不可用时退回steady
+void test_sources() {
+    for (auto s : {fnet::clock_source::steady, fnet::clock_source::coarse, fnet::clock_source::tsc}) {
+        uint64_t a = fnet::loop_clock::read(s);
+        uint64_t b = fnet::loop_clock::read(s);
+        assert(b >= a);
+        assert(diff(a, fnet::details::now_ns()) < 20000000);
+    }
+    fnet::loop_clock c(fnet::clock_source::tsc);
+    if (!fnet::loop_clock::tsc_available()) {
+        assert(c.source() == fnet::clock_source::steady);
+    } else {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        assert(diff(c.update(), fnet::details::now_ns()) < 1000000);
+    }
+    std::cout << "tsc available: " << fnet::loop_clock::tsc_available() << "\n";
+}
+
+// 缓存值只在update()时改变
+void test_cached() {
+    fnet::loop_clock c(fnet::clock_source::coarse);
+    uint64_t t = c.now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    assert(c.now() == t);
+    assert(c.update() > t + 10000000);
+    auto tp = c.time_point();
+    assert(static_cast<uint64_t>(std::chrono::nanoseconds(tp.time_since_epoch()).count()) == c.now());
+}
+
+// 回调中的loop_now()不变；定时器在各时钟源下按时到期
+void test_reactor() {
+    for (auto s : {fnet::clock_source::steady, fnet::clock_source::coarse, fnet::clock_source::tsc}) {
+        fnet::reactor rec;
+        rec.set_clock_source(s);
+        uint64_t begin = fnet::details::now_ns(), fired = 0;
+        rec.post([&] {
+            uint64_t t = rec.loop_now();
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            assert(rec.loop_now() == t);
+            rec.run_after(30, [&] {
+                fired = fnet::details::now_ns();
+                rec.destroy();
+            });
+        });
+        rec.activate();
+        // coarse源的采样最多落后一个节拍
+        assert(fired - begin >= 20000000 && fired - begin < 500000000);
+    }
+}
+
+// 以缓存时间检查timer与timer_master
+void test_timer_api() {
+    fnet::reactor rec;
+    fnet::timer_master<std::milli> master;
+    fnet::timer<std::milli> t(10, rec.loop_time_point());
+    master.attach(t);
+    master.attach(fnet::timer<std::milli>(1000, rec.loop_time_point()));
+    auto stale = rec.loop_time_point();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    assert(!t.is_timeout(stale));
+    master.clean_timeout_timers(stale);
+    assert(master.num_timers() == 2);
+    auto now = rec.loop_time_point();
+    assert(t.is_timeout(now));
+    master.clean_timeout_timers(now);
+    assert(master.num_timers() == 1);
+}
+
+int main() {
+    test_sources();
+    test_cached();
+    test_reactor();
+    test_timer_api();
+    std::cout << "ok\n";
+}
@@ -0,0 +1,50 @@
+#include <fastnet/cmdtable.h>
+#include <cassert>
+#include <iostream>
+#include <string>
+
+static constexpr auto cmds = fnet::make_cmdtable("get", "set", "del", "incrby", "getrange", "hincrbyfloat", "ping");
+
+// 编译期即可查找
+static_assert(cmds.size() == 7, "size");
+static_assert(cmds.index_of("get") == 0, "get");
+static_assert(cmds.index_of("hincrbyfloat") == 5, "hincrbyfloat");
+static_assert(cmds.index_of("pong") == -1, "pong");
+static_assert(cmds.index_of("ge") == -1, "prefix");
+static_assert(cmds.name(3) == "incrby", "name");
+
+void test_find() {
+    std::string buf = "getrange";
+    assert(cmds.find(buf.data(), buf.size()) == 4);
+    assert(cmds.find(buf.data(), 3) == 0);  // 不要求'\0'结尾
+    assert(cmds.find("GET", 3) == -1);
+    assert(cmds.find("hincrbyfloaT", 12) == -1);
+    assert(cmds.find("hincrbyfloat!", 13) == -1);  // 超过最长命令
+    assert(cmds.find("", 0) == -1);
+    for (size_t i = 0; i < cmds.size(); ++i) {
+        auto n = cmds.name(i);
+        assert(cmds.find(n.data(), n.size()) == static_cast<int>(i));
+    }
+}
+
+void test_dispatch() {
+    int sets = 0, others = 0;
+    auto handler = [&](auto cmd, int& arg) {
+        if constexpr (static_cast<int>(cmd) == cmds.index_of("set")) {
+            sets += arg;
+        } else {
+            others++;
+        }
+    };
+    int arg = 2;
+    assert(cmds.dispatch("set", 3, handler, arg));
+    assert(cmds.dispatch("ping", 4, handler, arg));
+    assert(!cmds.dispatch("quit", 4, handler, arg));
+    assert(sets == 2 && others == 1);
+}
+
+int main() {
+    test_find();
+    test_dispatch();
+    std::cout << "slots: " << cmds.slots << " buckets: " << cmds.buckets << '\n';
+}
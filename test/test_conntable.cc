@@ -0,0 +1,68 @@
+#include <fastnet/conntable.h>
+#include <fastnet/reactor.h>
+#include <cassert>
+#include <iostream>
+#include <set>
+#include <string>
+
+// 插入、查找、删除与稠密的存活列表
+void test_basic() {
+    fnet::conntable<std::string> t;
+    assert(t.empty() && !t.find(3) && !t.find(-1) && !t.erase(3));
+    t.emplace(3, "a");
+    t.emplace(5000, "b");  // 跨块
+    t[7] = "c";
+    assert(t.size() == 3);
+    assert(*t.find(3) == "a" && *t.find(5000) == "b" && t[7] == "c");
+    assert(!t.find(4) && !t.contains(4999));
+    t.emplace(3, "a2");  // 替换
+    assert(t.size() == 3 && *t.find(3) == "a2");
+
+    std::string* b = t.find(5000);
+    for (int fd = 8; fd < 3000; ++fd) t.emplace(fd, std::to_string(fd));
+    assert(b == t.find(5000));  // 插入不会移动已有元素
+
+    assert(t.erase(3));
+    assert(!t.find(3) && !t.erase(3));
+    std::set<int> seen;
+    t.for_each([&](int fd, std::string& v) {
+        assert(v.size());
+        seen.insert(fd);
+    });
+    assert(seen.size() == t.size() && !seen.count(3) && seen.count(5000));
+    assert(std::set<int>(t.fds().begin(), t.fds().end()) == seen);
+    t.clear();
+    assert(t.empty() && !t.find(5000));
+}
+
+// fd被关闭后复用，旧的弱引用失效
+void test_generation() {
+    fnet::conntable<int> t;
+    t.emplace(10, 1);
+    auto h = t.handle_of(10);
+    assert(t.find(h) && *t.find(h) == 1);
+    t.erase(10);
+    assert(!t.find(h));
+    t.emplace(10, 2);  // 复用
+    assert(!t.find(h));
+    auto h2 = t.handle_of(10);
+    assert(t.find(h2) && *t.find(h2) == 2);
+    assert(!t.find(fnet::conntable<int>::handle{11, 0}));
+}
+
+// 反应堆的内部fd表：投递任务（eventfd）依然可用
+void test_reactor_specific() {
+    fnet::reactor rec;
+    int n = 0;
+    rec.post([&] { ++n; });
+    rec.post([&] { rec.destroy(); });
+    rec.activate();
+    assert(n == 1);
+}
+
+int main() {
+    test_basic();
+    test_generation();
+    test_reactor_specific();
+    std::cout << "ok\n";
+}
@@ -0,0 +1,118 @@
+#include <fastnet/fastnet.h>
+#include <fastnet/sockbuffer.h>
+#include <sys/socket.h>
+#include <cassert>
+#include <iostream>
+#include <string>
+#include "common.h"
+
+// 边缘触发 + 读预算：每次只读4KB，推迟到后续轮次把数据读完，期间其他连接照常处理
+void test_budget_drain() {
+    fnet::reactor rec;
+    auto* m = rec.enable_metrics();
+    pair_fd heavy, light;
+    rec.add_socket(heavy.local, fnet::event::readable, fnet::pattern::et);
+    rec.add_socket(light.local, fnet::event::readable, fnet::pattern::et);
+    fnet::sockbuffer sb(heavy.local, 64 << 10);
+    sb.set_read_budget(4096);
+    const size_t total = 60 << 10;
+    std::string sent;
+    for (size_t i = 0; i < total; ++i) sent.push_back(static_cast<char>('a' + i % 26));
+    assert(write(heavy.peer, sent.data(), total) == static_cast<ssize_t>(total));
+    assert(write(light.peer, "x", 1) == 1);
+    std::string got;
+    int calls = 0, light_at = -1;
+    rec.set_readable_cb([&](int fd) {
+        if (fd == light.local) {
+            char c;
+            while (read(fd, &c, 1) > 0) {}
+            light_at = calls;
+            return;
+        }
+        ++calls;
+        assert(sb.readsock() <= 4096);
+        got.append(sb.data(), sb.pending());
+        sb.consume(sb.pending());
+        sb.reflush();
+        if (sb.has_more()) rec.defer_readable(fd);
+        if (got.size() == total) rec.destroy();
+    });
+    rec.activate();
+    assert(got == sent);
+    // 边缘触发只通知一次，其余全部由推迟处理读完
+    assert(calls >= static_cast<int>(total / 4096) && m->deferred_reads.load() >= total / 4096 - 1);
+    // 轻量连接在同一轮中先于重连接的剩余数据得到处理
+    assert(light_at >= 0 && light_at <= 1);
+}
+
+// 同一轮中重复推迟只生效一次
+void test_duplicate() {
+    fnet::reactor rec;
+    auto* m = rec.enable_metrics();
+    pair_fd a;
+    rec.add_socket(a.local, fnet::event::readable, fnet::pattern::et);
+    int calls = 0;
+    rec.set_readable_cb([&](int fd) {
+        if (++calls == 1) {
+            rec.defer_readable(fd);
+            rec.defer_readable(fd);
+        } else {
+            char c;
+            while (read(fd, &c, 1) > 0) {}
+        }
+    });
+    rec.run_after(50, [&] { rec.destroy(); });
+    assert(write(a.peer, "x", 1) == 1);
+    rec.activate();
+    assert(calls == 2 && m->deferred_reads.load() == 1);
+}
+
+// 关闭后取消推迟，不再回调；fd被复用时新连接也不会继承之前的推迟
+void test_cancel_after_close() {
+    fnet::reactor rec;
+    int sv[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv) == 0);
+    rec.add_socket(sv[0], fnet::event::readable, fnet::pattern::et);
+    int calls = 0;
+    rec.set_readable_cb([&](int fd) {
+        ++calls;
+        rec.defer_readable(fd);
+        close(sv[0]);
+        close(sv[1]);
+        rec.cancel_deferred(fd);
+    });
+    rec.run_after(50, [&] { rec.destroy(); });
+    assert(write(sv[1], "x", 1) == 1);
+    rec.activate();
+    assert(calls == 1);
+
+    fnet::reactor rec2;
+    assert(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv) == 0);
+    rec2.add_socket(sv[0], fnet::event::readable, fnet::pattern::et);
+    int old_fd = sv[0], reused = -1;
+    calls = 0;
+    rec2.set_readable_cb([&](int fd) {
+        ++calls;
+        if (fd != old_fd || reused >= 0) return;
+        // 推迟后关闭但未取消，同一轮中又接受了复用该fd的新连接
+        rec2.defer_readable(fd);
+        close(sv[0]);
+        close(sv[1]);
+        assert(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv) == 0);
+        reused = sv[0];
+        rec2.add_socket(sv[0], fnet::event::readable, fnet::pattern::et);
+    });
+    rec2.run_after(50, [&] { rec2.destroy(); });
+    assert(write(sv[1], "x", 1) == 1);
+    rec2.activate();
+    assert(reused == old_fd && calls == 1);
+    close(sv[0]);
+    close(sv[1]);
+}
+
+int main() {
+    test_budget_drain();
+    test_duplicate();
+    test_cancel_after_close();
+    std::cout << "ok\n";
+}
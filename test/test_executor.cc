@@ -0,0 +1,61 @@
+#include <fastnet/executor.h>
+#include <cassert>
+#include <iostream>
+#include <thread>
+
+// 单线程下deque的后进先出与窃取的先进先出
+void test_ws_deque() {
+    fnet::ws_deque<int*> dq(2);  // 小容量以触发扩容
+    int vals[10];
+    for (auto& v : vals) dq.push(&v);
+    assert(dq.size() == 10);
+    assert(dq.steal() == &vals[0]);
+    assert(dq.pop() == &vals[9]);
+    assert(dq.size() == 8);
+    while (dq.pop()) {}
+    assert(dq.steal() == nullptr && dq.pop() == nullptr);
+}
+
+// 外部提交与工作线程内嵌套提交的任务都会被执行
+void test_executor() {
+    std::cout << "---------------------------\n";
+    std::atomic<int> count = {0};
+    {
+        fnet::executor pool(4);
+        for (int i = 0; i < 1000; ++i) {
+            pool.submit([&] {
+                for (int j = 0; j < 10; ++j) pool.submit([&] { count++; });
+                count++;
+            });
+        }
+        while (count.load() < 11000) std::this_thread::yield();
+        auto s = pool.stats();
+        std::cout << "submitted: " << s.submitted << " executed: " << s.executed << " steals: " << s.steals << '\n';
+        assert(s.submitted == 11000);
+    }
+    assert(count.load() == 11000);
+    std::cout << "---------------------------\n";
+}
+
+// 计算结果回到反应堆线程
+void test_result_delivery() {
+    fnet::reactor rec;
+    fnet::executor pool(2);
+    auto reactor_tid = std::this_thread::get_id();
+    int done = 0;
+    for (int i = 0; i < 100; ++i) {
+        pool.submit(rec, [i] { return i * i; }, [&, i](int res) {
+            assert(std::this_thread::get_id() == reactor_tid);
+            assert(res == i * i);
+            if (++done == 100) rec.destroy();
+        });
+    }
+    rec.activate();
+    assert(done == 100);
+}
+
+int main() {
+    test_ws_deque();
+    test_executor();
+    test_result_delivery();
+}
@@ -0,0 +1,214 @@
+#include <fastnet/http.h>
+#include <fastnet/sockbuffer.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cassert>
+#include <iostream>
+#include <string>
+
+using fnet::http::status;
+
+// 完整的请求一次解析
+void test_simple() {
+    std::string s = "GET /metrics?x=1 HTTP/1.1\r\nHost: a\r\nX-Empty:\r\nAccept:  */* \r\n\r\n";
+    fnet::http::parser p;
+    fnet::http::request req;
+    assert(p.parse(s.data(), s.size(), req) == status::complete);
+    assert(p.consumed() == s.size());
+    assert(req.method == "GET");
+    assert(req.target == "/metrics?x=1");
+    assert(req.minor_version == 1);
+    assert(req.num_headers == 3);
+    assert(req.get("host") == "a");
+    assert(req.get("ACCEPT") == "*/*");
+    assert(req.get("x-empty").empty());
+    assert(req.body.empty());
+    assert(req.keep_alive);
+}
+
+// 逐字节到达，且两次调用之间缓冲区被移动
+void test_byte_by_byte() {
+    std::string s = "POST /a HTTP/1.0\r\nConnection: keep-alive\r\nContent-Length: 5\r\n\r\nhello";
+    fnet::http::parser p;
+    fnet::http::request req;
+    std::string buf;
+    for (size_t i = 0; i < s.size(); ++i) {
+        buf.push_back(s[i]);
+        std::string moved = buf;  // 新的地址
+        auto r = p.parse(moved.data(), moved.size(), req);
+        if (i + 1 < s.size()) {
+            assert(r == status::incomplete);
+        } else {
+            assert(r == status::complete);
+            assert(req.method == "POST");
+            assert(req.get("content-length") == "5");
+            assert(req.body == "hello");
+            assert(req.keep_alive);
+            assert(req.minor_version == 0);
+            buf = moved;
+        }
+    }
+}
+
+// 消息体在后续调用中到达，且每次调用传入新的request，如每次可读回调各声明一个
+void test_split_body() {
+    std::string s = "POST /up HTTP/1.1\r\nConnection: close\r\nContent-Length: 5\r\n\r\nhello";
+    size_t split = s.size() - 5;
+    fnet::http::parser p;
+    {
+        fnet::http::request req;
+        assert(p.parse(s.data(), split, req) == status::incomplete);
+    }
+    std::string moved = s;  // 新的地址
+    fnet::http::request req;
+    assert(p.parse(moved.data(), moved.size(), req) == status::complete);
+    assert(req.method == "POST");
+    assert(req.target == "/up");
+    assert(req.num_headers == 2);
+    assert(req.get("content-length") == "5");
+    assert(!req.keep_alive);
+    assert(req.body == "hello");
+    assert(req.method.data() == moved.data());
+}
+
+// 一次到达多个流水线请求
+void test_pipelined() {
+    std::string s = "GET /1 HTTP/1.1\r\n\r\nGET /2 HTTP/1.1\r\nConnection: close\r\n\r\nGET /3 HTTP/1.0\r\n\r\nGET /4";
+    fnet::http::parser p;
+    fnet::http::request req;
+    const char* targets[] = {"/1", "/2", "/3"};
+    bool alive[] = {true, false, false};
+    size_t off = 0;
+    for (int i = 0; i < 3; ++i) {
+        assert(p.parse(s.data() + off, s.size() - off, req) == status::complete);
+        assert(req.target == targets[i]);
+        assert(req.keep_alive == alive[i]);
+        off += p.consumed();
+    }
+    assert(p.parse(s.data() + off, s.size() - off, req) == status::incomplete);
+}
+
+// 分块编码被原地拼接
+void test_chunked() {
+    static const char raw[] = "POST /c HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+                              "5\r\nhello\r\n1;ext=1\r\n \r\nc\r\nchunked\0body\r\n0\r\nX-Trailer: t\r\n\r\nGET";
+    std::string s(raw, sizeof(raw) - 1);
+    fnet::http::parser p;
+    fnet::http::request req;
+    std::string buf;
+    for (size_t i = 0; i < s.size(); ++i) {
+        buf.push_back(s[i]);
+        auto r = p.parse(buf.data(), buf.size(), req);
+        if (r == status::complete) break;
+        assert(r == status::incomplete);
+    }
+    assert(req.chunked);
+    assert(req.body == std::string_view("hello chunked\0body", 18));
+    assert(p.consumed() == s.size() - 3);
+}
+
+// 非法请求
+void test_errors() {
+    auto parse = [](std::string s, size_t max_head = 8192, size_t max_body = 1 << 20) {
+        fnet::http::parser p(max_head, max_body);
+        fnet::http::request req;
+        auto r = p.parse(s.data(), s.size(), req);
+        return r == status::error ? p.error_code() : 0;
+    };
+    assert(parse("GET / HTTP/2.0\r\n\r\n") == 400);
+    assert(parse("GET /\r\n\r\n") == 400);
+    assert(parse("GET / HTTP/1.1\r\nBad Name: x\r\n\r\n") == 400);
+    assert(parse("GET / HTTP/1.1\r\nA: b\r\n folded\r\n\r\n") == 400);
+    assert(parse("POST / HTTP/1.1\r\nContent-Length: 1x\r\n\r\n") == 400);
+    assert(parse("POST / HTTP/1.1\r\nContent-Length: 1\r\nTransfer-Encoding: chunked\r\n\r\n") == 400);
+    assert(parse("POST / HTTP/1.1\r\nTransfer-Encoding: gzip\r\n\r\n") == 501);
+    assert(parse("POST / HTTP/1.1\r\nContent-Length: 100\r\n\r\n", 8192, 10) == 413);
+    assert(parse("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n") == 400);
+    assert(parse("GET / HTTP/1.1\r\nA: " + std::string(100, 'a'), 64) == 431);
+    std::string many = "GET / HTTP/1.1\r\n";
+    for (int i = 0; i < 40; ++i) many += "H: v\r\n";
+    assert(parse(many + "\r\n") == 431);
+}
+
+// 在sockbuffer上解析流水线请求，并由responder以writev一次写回
+void test_sockbuffer_roundtrip() {
+    int sv[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+    std::string reqs = "GET /a HTTP/1.1\r\n\r\nGET /b HTTP/1.1\r\n\r\nGET /c HTTP/1.1\r\nConnection: close\r\n\r\n";
+    // 第一次只到达一部分
+    assert(write(sv[1], reqs.data(), 25) == 25);
+    fnet::sockbuffer sb(sv[0], 4096);
+    fnet::http::parser p;
+    fnet::http::request req;
+    fnet::http::responder out;
+    static const char page[] = "static page";
+    int handled = 0;
+    bool close_after = false;
+    for (int round = 0; round < 2; ++round) {
+        sb.readsock();
+        while (p.parse(sb.data(), sb.pending(), req) == status::complete) {
+            if (req.target == "/b") {
+                out.add_static(200, page, "text/html", req.keep_alive);
+            } else {
+                out.add(404, std::string(req.target), "text/plain", req.keep_alive, {{"X-Seq", "1"}});
+            }
+            close_after = !req.keep_alive;
+            sb.consume(p.consumed());
+            ++handled;
+        }
+        sb.drop_read();
+        if (round == 0) {
+            assert(handled == 1);
+            assert(write(sv[1], reqs.data() + 25, reqs.size() - 25) == static_cast<ssize_t>(reqs.size() - 25));
+        }
+    }
+    assert(handled == 3);
+    assert(close_after);
+    size_t expect = out.pending();
+    assert(out.flush(sv[0]) == static_cast<ssize_t>(expect));
+    assert(out.empty());
+    char buf[1024];
+    auto n = read(sv[1], buf, sizeof(buf));
+    std::string resp(buf, n);
+    assert(resp ==
+           "HTTP/1.1 404 Not Found\r\nContent-Length: 2\r\nContent-Type: text/plain\r\nX-Seq: 1\r\n\r\n/a"
+           "HTTP/1.1 200 OK\r\nContent-Length: 11\r\nContent-Type: text/html\r\n\r\nstatic page"
+           "HTTP/1.1 404 Not Found\r\nContent-Length: 2\r\nContent-Type: text/plain\r\n"
+           "Connection: close\r\nX-Seq: 1\r\n\r\n/c");
+    close(sv[0]);
+    close(sv[1]);
+}
+
+// 发送缓冲写满时保留未写出的部分
+void test_partial_flush() {
+    int sv[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv) == 0);
+    int small = 4096;
+    setsockopt(sv[0], SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+    std::string body(64 * 1024, 'x');
+    fnet::http::responder out;
+    for (int i = 0; i < 8; ++i) out.add_static(200, body);
+    size_t total = out.pending();
+    size_t received = 0;
+    char buf[65536];
+    while (!out.empty()) {
+        assert(out.flush(sv[0]) >= 0);
+        ssize_t n;
+        while ((n = read(sv[1], buf, sizeof(buf))) > 0) received += n;
+    }
+    assert(received == total);
+    std::cout << "flushed " << total << " bytes\n";
+    close(sv[0]);
+    close(sv[1]);
+}
+
+int main() {
+    test_simple();
+    test_byte_by_byte();
+    test_split_body();
+    test_pipelined();
+    test_chunked();
+    test_errors();
+    test_sockbuffer_roundtrip();
+    test_partial_flush();
+}
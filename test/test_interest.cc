@@ -0,0 +1,78 @@
+#include <fastnet/fastnet.h>
+#include <sys/socket.h>
+#include <cassert>
+#include <iostream>
+#include "common.h"
+
+// 循环之外立即提交，掩码不变时跳过
+void test_redundant() {
+    fnet::reactor rec;
+    auto* m = rec.enable_metrics();
+    pair_fd a;
+    rec.add_socket(a.local, fnet::event::readable, fnet::pattern::lt);
+    uint64_t base = m->epoll_ctls.load();
+    rec.reset_event(a.local, fnet::event::readable, fnet::pattern::lt);
+    assert(m->epoll_ctls.load() == base && m->epoll_ctls_saved.load() == 1);
+    rec.reset_event(a.local, fnet::event::readable | fnet::event::writable, fnet::pattern::lt);
+    assert(m->epoll_ctls.load() == base + 1);
+}
+
+// oneshot：每次事件之后重新注册一次；回调中对可写事件的打开与关闭合并，不产生系统调用
+void test_oneshot() {
+    fnet::reactor rec;
+    auto* m = rec.enable_metrics();
+    pair_fd a;
+    rec.add_socket(a.local, fnet::event::readable, fnet::pattern::lt_oneshot);
+    int events = 0;
+    uint64_t base = 0;
+    rec.set_readable_cb([&](int fd) {
+        char buf[64];
+        while (read(fd, buf, sizeof(buf)) > 0) {}
+        rec.reset_event(fd, fnet::event::readable | fnet::event::writable, fnet::pattern::lt_oneshot);
+        rec.reset_event(fd, fnet::event::readable, fnet::pattern::lt_oneshot);
+        rec.reset_event(fd, fnet::event::readable, fnet::pattern::lt_oneshot);
+        if (++events == 10) {
+            rec.destroy();
+        } else {
+            rec.post([&] { assert(write(a.peer, "x", 1) == 1); });
+        }
+    });
+    base = m->epoll_ctls.load();
+    assert(write(a.peer, "x", 1) == 1);
+    rec.activate();
+    assert(events == 10);
+    // 前9次事件各重新注册一次，最后一次在destroy()之后不再提交
+    assert(m->epoll_ctls.load() - base == 9);
+    assert(m->epoll_ctls_saved.load() >= 18);
+}
+
+// 提交之前fd被关闭，不影响事件循环
+void test_closed_before_commit() {
+    fnet::reactor rec;
+    pair_fd a;
+    int sv[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv) == 0);
+    rec.add_socket(a.local, fnet::event::readable, fnet::pattern::lt);
+    rec.add_socket(sv[0], fnet::event::readable, fnet::pattern::lt);
+    int rounds = 0;
+    rec.set_readable_cb([&](int fd) {
+        char buf[64];
+        while (read(fd, buf, sizeof(buf)) > 0) {}
+        rec.reset_event(sv[0], fnet::event::readable | fnet::event::writable, fnet::pattern::lt);
+        close(sv[0]);
+        close(sv[1]);
+    });
+    rec.set_timeout(1, [&] {
+        if (++rounds == 3) rec.destroy();
+    });
+    assert(write(a.peer, "x", 1) == 1);
+    rec.activate();
+    assert(rounds == 3);
+}
+
+int main() {
+    test_redundant();
+    test_oneshot();
+    test_closed_before_commit();
+    std::cout << "ok\n";
+}
@@ -0,0 +1,140 @@
+#include <fastnet/fastnet.h>
+#include <cassert>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+const char* path = "/tmp/fnet_test_logger.log";
+
+std::string slurp(const char* p) {
+    std::ifstream in(p);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+size_t count(const std::string& s, const std::string& what) {
+    size_t n = 0;
+    for (size_t pos = s.find(what); pos != std::string::npos; pos = s.find(what, pos + 1)) ++n;
+    return n;
+}
+
+// 参数按类型格式化，多余的参数以空格追加
+void test_format() {
+    auto& log = fnet::logger::instance();
+    unlink(path);
+    log.open_file(path);
+    std::string s = "str";
+    const char* null = nullptr;
+    FNET_LOG_INFO("int={} neg={} real={} bool={} char={} cstr={} string={} null={}", 42, -7L, 1.5, true, 'x',
+                  "lit", s, null);
+    FNET_LOG_WARN("no placeholder", 1, "two");
+    FNET_LOG_ERROR("size={}", static_cast<size_t>(1) << 40);
+    log.flush();
+    auto out = slurp(path);
+    assert(out.find("int=42 neg=-7 real=1.5 bool=true char=x cstr=lit string=str null=(null)\n") != std::string::npos);
+    assert(out.find("INFO  test_logger.cc:") != std::string::npos);
+    assert(out.find("WARN  test_logger.cc:") != std::string::npos);
+    assert(out.find("no placeholder 1 two") != std::string::npos);
+    assert(out.find("size=1099511627776\n") != std::string::npos);
+    log.open_fd(2);
+}
+
+// 低于编译期级别的参数不求值，低于运行时级别的不写出
+void test_levels() {
+    auto& log = fnet::logger::instance();
+    unlink(path);
+    log.open_file(path);
+    int evaluated = 0;
+    FNET_LOG_TRACE("trace {}", ++evaluated);
+    FNET_LOG_DEBUG("debug {}", ++evaluated);
+    assert(evaluated == 0);
+    log.set_level(fnet::log_level::warn);
+    FNET_LOG_INFO("hidden {}", ++evaluated);
+    FNET_LOG_WARN("shown {}", 1);
+    log.set_level(fnet::log_level::info);
+    log.flush();
+    auto out = slurp(path);
+    assert(evaluated == 0);
+    assert(out.find("hidden") == std::string::npos);
+    assert(out.find("shown 1") != std::string::npos);
+    log.open_fd(2);
+}
+
+// 多个线程各自的记录都写出，且每个线程内保持顺序
+void test_threads() {
+    auto& log = fnet::logger::instance();
+    unlink(path);
+    log.open_file(path);
+    const int nthreads = 4, per = 1000;
+    std::vector<std::thread> ths;
+    for (int t = 0; t < nthreads; ++t) {
+        ths.emplace_back([t] {
+            for (int i = 0; i < per; ++i) FNET_LOG_INFO("thread {} seq {}", t, i);
+        });
+    }
+    for (auto& th : ths) th.join();
+    log.flush();
+    auto out = slurp(path);
+    std::vector<int> next(nthreads, 0);
+    std::istringstream in(out);
+    std::string line;
+    while (std::getline(in, line)) {
+        int t, i;
+        auto pos = line.find("thread ");
+        assert(pos != std::string::npos);
+        assert(sscanf(line.c_str() + pos, "thread %d seq %d", &t, &i) == 2);
+        assert(next[t] == i);
+        ++next[t];
+    }
+    for (int n : next) assert(n == per);
+    log.open_fd(2);
+}
+
+// 环写满时丢弃而不阻塞，写出与丢弃之和等于调用次数
+void test_drops() {
+    auto& log = fnet::logger::instance();
+    unlink(path);
+    log.open_file(path);
+    log.set_ring_size(4096);
+    uint64_t w0 = log.written(), d0 = log.dropped();
+    const int total = 10000;
+    std::thread th([] {
+        for (int i = 0; i < total; ++i) FNET_LOG_INFO("burst {} {}", i, "padding padding padding");
+    });
+    th.join();
+    log.flush();
+    log.set_ring_size(1 << 18);
+    uint64_t w = log.written() - w0, d = log.dropped() - d0;
+    assert(d > 0);
+    assert(w + d == total);
+    auto out = slurp(path);
+    assert(count(out, "burst ") == w);
+    assert(out.find("logger: dropped") != std::string::npos);
+    log.open_fd(2);
+}
+
+// mmap日志文件关闭时截断到实际长度
+void test_journal() {
+    auto& log = fnet::logger::instance();
+    log.open_journal(path, 4096);
+    for (int i = 0; i < 500; ++i) FNET_LOG_INFO("journal {}", i);
+    log.flush();
+    log.open_fd(2);
+    auto out = slurp(path);
+    assert(count(out, "journal ") == 500);
+    assert(out.back() == '\n');
+    assert(out.find('\0') == std::string::npos);
+    unlink(path);
+}
+
+int main() {
+    test_format();
+    test_levels();
+    test_threads();
+    test_drops();
+    test_journal();
+    std::cout << "ok\n";
+}
@@ -0,0 +1,220 @@
+#include <fastnet/fastnet.h>
+#include <fastnet/sockbuffer.h>
+#include <sys/socket.h>
+#include <cassert>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "common.h"
+
+// send()未写出的数据计入预算，写出或丢弃后归还
+void test_output_accounting() {
+    fnet::mem_budget budget;
+    fnet::reactor rec;
+    rec.set_mem_budget(&budget);
+    pair_fd p;
+    rec.add_socket(p.local, fnet::event::readable, fnet::pattern::lt);
+    rec.send(p.local, std::string(4 << 20, 'x'));
+    size_t pending = rec.pending_output(p.local);
+    assert(pending > 0);
+    assert(budget.usage(p.local) == pending && budget.used() == pending);
+    rec.discard_output(p.local);
+    assert(budget.usage(p.local) == 0 && budget.used() == 0);
+}
+
+// sockbuffer按容量记账：replace()后按新容量，移动后不重复，析构时归还
+void test_sockbuffer_lease() {
+    fnet::mem_budget budget;
+    {
+        fnet::sockbuffer sb(7, 4096);
+        sb.bind_budget(&budget);
+        assert(budget.usage(7) == 4096);
+        sb.replace(16384);
+        assert(budget.usage(7) == 16384);
+        fnet::sockbuffer moved(std::move(sb));
+        assert(budget.used() == 16384);
+        fnet::sockbuffer other(8, 1024);
+        other.bind_budget(&budget);
+        other = std::move(moved);
+        assert(budget.usage(8) == 0 && budget.usage(7) == 16384);
+    }
+    assert(budget.used() == 0);
+    // 连接被断开后（forget）析构不会重复归还
+    {
+        fnet::sockbuffer sb(9, 2048);
+        sb.bind_budget(&budget);
+        budget.forget(9);
+        assert(budget.used() == 0);
+    }
+    assert(budget.used() == 0);
+    // 共享上限的实例看到同一个总量，析构时归还自己的部分
+    {
+        auto sib = budget.sibling();
+        sib.charge(3, 100);
+        budget.charge(4, 50);
+        assert(budget.used() == 150 && sib.used() == 150 && sib.local_used() == 100);
+    }
+    assert(budget.used() == 50);
+}
+
+// 单个连接的待写数据超过conn_limit时暂停读取，对端读走后恢复
+void test_conn_limit() {
+    fnet::mem_budget::options opt;
+    opt.conn_limit = 1 << 20;
+    fnet::mem_budget budget(opt);
+    fnet::reactor rec;
+    auto* m = rec.enable_metrics();
+    rec.set_mem_budget(&budget);
+    pair_fd p;
+    rec.add_socket(p.local, fnet::event::readable, fnet::pattern::lt);
+    int reads = 0, reads_at_pause = -1;
+    rec.set_readable_cb([&](int fd) {
+        drain(fd);
+        ++reads;
+        rec.send(fd, std::string(256 << 10, 'r'));
+        if (reads_at_pause >= 0 && reads > reads_at_pause) rec.destroy();
+    });
+    // 对端持续写入请求但不读取应答
+    int writes = 0;
+    std::function<void()> writer = [&] {
+        assert(write(p.peer, "x", 1) == 1);
+        if (++writes < 20) rec.run_after(1, writer);
+    };
+    rec.run_after(0, writer);
+    std::function<void()> reader = [&] {
+        drain(p.peer);
+        rec.run_after(1, reader);
+    };
+    rec.run_after(40, [&] {
+        assert(budget.paused(p.local) && rec.reading_paused(p.local) == false);
+        assert(reads < 20);
+        assert(rec.pending_output(p.local) > opt.conn_limit);
+        assert(budget.usage(p.local) == rec.pending_output(p.local));
+        assert(m->mem_pauses.load() == 1);
+        reads_at_pause = reads;
+        reader();
+    });
+    rec.run_after(2000, [&] { rec.destroy(); });
+    rec.activate();
+    assert(reads > reads_at_pause);
+    assert(budget.stats().pauses >= 1 && budget.stats().resumes >= 1);
+}
+
+// 总量超过global_limit时按占用从多到少断开，直到回落到global_limit * resume_ratio
+void test_global_shed() {
+    fnet::mem_budget::options opt;
+    opt.global_limit = 1 << 20;
+    opt.conn_limit = 8 << 20;
+    fnet::mem_budget budget(opt);
+    fnet::reactor rec;
+    auto* m = rec.enable_metrics();
+    rec.set_mem_budget(&budget);
+    pair_fd a, b, c;
+    std::vector<fnet::sockbuffer> bufs;
+    size_t sizes[] = {200000, 600000, 300000};
+    pair_fd* pairs[] = {&a, &b, &c};
+    for (int i = 0; i < 3; ++i) {
+        rec.add_socket(pairs[i]->local, fnet::event::readable, fnet::pattern::lt);
+        bufs.emplace_back(pairs[i]->local, sizes[i]);
+        bufs.back().bind_budget(&budget);
+    }
+    std::vector<int> shed;
+    rec.set_disconnect_cb([&](int fd) {
+        shed.push_back(fd);
+        if (fd == b.local) bufs[1] = fnet::sockbuffer();
+    });
+    rec.run_after(5, [&] { rec.destroy(); });
+    rec.activate();
+    assert((shed == std::vector<int>{b.local}));
+    assert(budget.used() == 500000 && budget.stats().sheds == 1);
+    assert(budget.stats().peak == 1100000);
+    // 断开后总量已低于暂停线，其余连接不暂停
+    assert(!budget.paused(a.local) && !budget.paused(c.local));
+    assert(m->mem_sheds.load() == 1 && m->mem_used.load() == 500000);
+    auto text = fnet::to_prometheus(m->snap());
+    assert(text.find("fastnet_mem_used_bytes{} 500000") != std::string::npos);
+    assert(text.find("fastnet_mem_sheds_total{} 1") != std::string::npos);
+}
+
+// 大量只写不读的连接：占用在一轮的增量之内受限于global_limit
+void test_slow_reader_flood() {
+    fnet::mem_budget::options opt;
+    opt.global_limit = 4 << 20;
+    opt.conn_limit = 1 << 20;
+    fnet::mem_budget budget(opt);
+    fnet::reactor rec;
+    rec.set_mem_budget(&budget);
+    const int n = 16;
+    const size_t reply = 128 << 10;
+    std::vector<pair_fd> pairs(n);
+    for (auto& p : pairs) rec.add_socket(p.local, fnet::event::readable, fnet::pattern::lt);
+    rec.set_readable_cb([&](int fd) {
+        drain(fd);
+        rec.send(fd, std::string(reply, 'r'));
+    });
+    int shed = 0;
+    rec.set_disconnect_cb([&](int) { ++shed; });
+    int rounds = 0;
+    std::function<void()> flood = [&] {
+        for (auto& p : pairs) (void)!write(p.peer, "x", 1);
+        if (++rounds < 100) rec.run_after(1, flood);
+    };
+    rec.run_after(0, flood);
+    rec.run_after(300, [&] { rec.destroy(); });
+    rec.activate();
+    assert(budget.stats().pauses > 0);
+    assert(budget.stats().peak <= opt.global_limit + n * reply);
+    assert(budget.used() <= opt.global_limit);
+    assert(static_cast<uint64_t>(shed) == budget.stats().sheds);
+}
+
+// 迁移连接：源反应堆的预算在迁出时归还全部记账并取消暂停，sockbuffer的绑定随之失效，
+// 目标反应堆在attach中重新绑定时不再访问源预算（此时源预算已析构），只记入目标预算
+void test_migrate() {
+    fnet::mem_budget::options opt;
+    opt.conn_limit = 64 << 10;
+    auto src = std::make_unique<fnet::mem_budget>(opt);
+    fnet::mem_budget dst(opt);
+    fnet::reactor a, b;
+    a.set_mem_budget(src.get());
+    b.set_mem_budget(&dst);
+    pair_fd p;
+    a.add_socket(p.local, fnet::event::readable, fnet::pattern::lt);
+    auto sb = std::make_shared<fnet::sockbuffer>(p.local, 4096);
+    sb->bind_budget(src.get());
+    a.set_migration_cb([&](int) { return std::shared_ptr<void>(std::move(sb)); }, nullptr);
+    size_t pending = 0, adopted_usage = 0;
+    std::shared_ptr<fnet::sockbuffer> moved;
+    b.set_migration_cb(nullptr, [&](int fd, std::shared_ptr<void> ctx) {
+        moved = std::static_pointer_cast<fnet::sockbuffer>(ctx);
+        assert(dst.usage(fd) == b.pending_output(fd));  // 接管时记入未写出的数据
+        moved->bind_budget(b.mem_budget_of());
+        pending = b.pending_output(fd);
+        adopted_usage = dst.usage(fd);
+        b.destroy();
+    });
+    a.run_after(0, [&] { a.send(p.local, std::string(1 << 20, 'x')); });
+    a.run_after(10, [&] {
+        assert(src->paused(p.local) && src->local_used() > opt.conn_limit);
+        assert(a.migrate(p.local, b));
+        assert(!src->paused(p.local) && src->local_used() == 0 && src->used() == 0);
+        a.destroy();
+    });
+    a.activate();
+    src.reset();
+    b.activate();
+    assert(pending > opt.conn_limit && adopted_usage == pending + 4096);
+    moved.reset();
+    assert(dst.usage(p.local) == pending);
+}
+
+int main() {
+    test_output_accounting();
+    test_sockbuffer_lease();
+    test_conn_limit();
+    test_global_shed();
+    test_slow_reader_flood();
+    test_migrate();
+    std::cout << "ok\n";
+}
@@ -0,0 +1,128 @@
+#include <fastnet/fastnet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <thread>
+
+// 桶的上下界包含样本，相对误差不超过1/sub_buckets
+void test_buckets() {
+    using h = fnet::histogram;
+    for (uint64_t v = 0; v < static_cast<uint64_t>(h::sub_buckets); ++v) {
+        assert(h::index_of(v) == static_cast<int>(v) && h::upper_bound(h::index_of(v)) == v);
+    }
+    for (uint64_t v : {8ull, 9ull, 15ull, 16ull, 17ull, 1000ull, 123456789ull, ~0ull}) {
+        int i = h::index_of(v);
+        assert(i < h::num_buckets);
+        assert(h::lower_bound(i) <= v && v <= h::upper_bound(i));
+        assert((h::upper_bound(i) - h::lower_bound(i)) <= h::lower_bound(i) / h::sub_buckets);
+    }
+    assert(h::index_of(15) < h::index_of(16));
+}
+
+void test_percentile() {
+    fnet::histogram hist;
+    assert(hist.snap().percentile(0.5) == 0);
+    for (uint64_t v = 1; v <= 1000; ++v) hist.record(v);
+    auto s = hist.snap();
+    assert(s.count == 1000 && s.sum == 500500);
+    assert(s.mean() == 500.5);
+    uint64_t p50 = s.percentile(0.5), p99 = s.percentile(0.99), p100 = s.percentile(1.0);
+    assert(p50 >= 500 && p50 <= 500 + 500 / fnet::histogram::sub_buckets);
+    assert(p99 >= 990 && p99 <= 990 + 990 / fnet::histogram::sub_buckets);
+    assert(p100 >= 1000);
+    fnet::histogram other;
+    other.record(5000);
+    s.merge(other.snap());
+    assert(s.count == 1001 && s.percentile(1.0) >= 5000);
+}
+
+void test_prometheus() {
+    fnet::reactor_metrics m;
+    m.events.add(3);
+    m.loop_time_ns.record(100);
+    m.loop_time_ns.record(100);
+    m.loop_time_ns.record(5000);
+    auto text = fnet::to_prometheus(m.snap(), "reactor=\"0\"");
+    assert(text.find("# TYPE fastnet_events_total counter\nfastnet_events_total{reactor=\"0\"} 3\n") !=
+           std::string::npos);
+    assert(text.find("# TYPE fastnet_loop_time_ns histogram\n") != std::string::npos);
+    // 桶为累计值，边界固定为2^k-1，空桶同样输出
+    assert(text.find("fastnet_loop_time_ns_bucket{reactor=\"0\",le=\"0\"} 0\n") != std::string::npos);
+    assert(text.find("fastnet_loop_time_ns_bucket{reactor=\"0\",le=\"63\"} 0\n") != std::string::npos);
+    assert(text.find("fastnet_loop_time_ns_bucket{reactor=\"0\",le=\"127\"} 2\n") != std::string::npos);
+    assert(text.find("fastnet_loop_time_ns_bucket{reactor=\"0\",le=\"4095\"} 2\n") != std::string::npos);
+    assert(text.find("fastnet_loop_time_ns_bucket{reactor=\"0\",le=\"8191\"} 3\n") != std::string::npos);
+    assert(text.find("fastnet_loop_time_ns_bucket{reactor=\"0\",le=\"1099511627775\"} 3\n") != std::string::npos);
+    // 没有样本的直方图输出同一组桶
+    fnet::reactor_metrics empty;
+    auto lines = [](const std::string& t, const std::string& name) {
+        size_t n = 0;
+        for (size_t p = 0; (p = t.find(name + "_bucket{", p)) != std::string::npos; ++p) ++n;
+        return n;
+    };
+    auto blank = fnet::to_prometheus(empty.snap(), "reactor=\"0\"");
+    assert(lines(text, "fastnet_loop_time_ns") == lines(blank, "fastnet_loop_time_ns"));
+    assert(lines(blank, "fastnet_loop_time_ns") == fnet::details::prom_max_pow2 + 2);
+    assert(text.find("fastnet_loop_time_ns_bucket{reactor=\"0\",le=\"+Inf\"} 3\n") != std::string::npos);
+    assert(text.find("fastnet_loop_time_ns_sum{reactor=\"0\"} 5200\n") != std::string::npos);
+    assert(text.find("fastnet_callback_latency_ns_count{reactor=\"0\",kind=\"timer\"} 0\n") != std::string::npos);
+}
+
+// 反应堆自己的定时器记录执行延迟
+void test_timer_lag() {
+    fnet::reactor rec;
+    auto* m = rec.enable_metrics();
+    rec.run_after(1, [&] { rec.destroy(); });
+    rec.activate();
+    auto s = m->snap();
+    assert(s.timer_lag_ns.count == 1);
+}
+
+// 应答远大于socket缓冲时分多次写完，Content-Length与收到的正文一致
+void test_endpoint() {
+    fnet::acceptor<fnet::protocol::tcp> acp;
+    acp.do_bind("127.0.0.1", 0);
+    acp.do_listen();
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    getsockname(acp.get_fd(), (struct sockaddr*)&addr, &len);
+    fnet::reactor rec;
+    std::string labels = "big=\"" + std::string(64 << 10, 'x') + "\"";
+    rec.add_metrics_endpoint(std::move(acp), labels);
+    std::thread t([&] { rec.activate(); });
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    int rcvbuf = 4096;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    assert(connect(fd, (struct sockaddr*)&addr, len) == 0);
+    const char req[] = "GET /metrics HTTP/1.0\r\n\r\n";
+    assert(write(fd, req, sizeof(req) - 1) == sizeof(req) - 1);
+    usleep(50000);  // 让服务端先写满socket缓冲
+    std::string resp;
+    char buf[65536];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) resp.append(buf, n);
+    close(fd);
+    rec.post([&] { rec.destroy(); });
+    t.join();
+
+    auto head_end = resp.find("\r\n\r\n");
+    assert(resp.compare(0, 15, "HTTP/1.0 200 OK") == 0 && head_end != std::string::npos);
+    auto cl = resp.find("Content-Length: ");
+    size_t body_len = std::stoul(resp.substr(cl + 16));
+    assert(body_len > (1 << 20));
+    assert(resp.size() - head_end - 4 == body_len);
+    assert(resp.find("fastnet_accepts_total{" + labels + "} 0\n") != std::string::npos);
+    assert(resp.find("fastnet_scrapes_total{" + labels + "} 1\n") != std::string::npos);
+}
+
+int main() {
+    test_buckets();
+    test_percentile();
+    test_prometheus();
+    test_timer_lag();
+    test_endpoint();
+    std::cout << "ok\n";
+}
@@ -0,0 +1,202 @@
+#include <fastnet/fastnet.h>
+#include <sys/socket.h>
+#include <cassert>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#include "common.h"
+
+// 未写出的数据、暂停状态、连接定时器与用户上下文随连接迁移
+void test_migrate() {
+    fnet::reactor a, b;
+    auto* m = a.enable_metrics();
+    pair_fd p, q;
+    a.add_socket(p.local, fnet::event::readable, fnet::pattern::lt);
+    a.add_socket(q.local, fnet::event::readable, fnet::pattern::lt);
+
+    std::map<int, std::string> a_state, b_state;
+    a_state[p.local] = "ctx-p";
+    a_state[q.local] = "ctx-q";
+    a.set_migration_cb([&](int fd) {
+        auto ctx = std::make_shared<std::string>(a_state[fd]);
+        a_state.erase(fd);
+        return ctx;
+    }, nullptr);
+    std::thread::id b_thread;
+    bool q_paused = false;
+    b.set_migration_cb(nullptr, [&](int fd, std::shared_ptr<void> ctx) {
+        b_state[fd] = *std::static_pointer_cast<std::string>(ctx);
+        if (fd == q.local) q_paused = b.reading_paused(fd);
+    });
+    std::string got;
+    b.set_readable_cb([&](int fd) { got += drain(fd); });
+    std::thread::id timer_thread;
+    std::thread tb([&] {
+        b_thread = std::this_thread::get_id();
+        b.activate();
+    });
+
+    a.post([&] {
+        a.send(p.local, "queued", 6);
+        a.run_after(p.local, 30, [&](int fd) {
+            timer_thread = std::this_thread::get_id();
+            assert(fd == p.local);
+            b.destroy();
+        });
+        a.pause_reading(q.local);
+        assert(a.migrate(p.local, b));
+        assert(a.migrate(q.local, b));
+        assert(!a.migrate(p.local, b));     // 已不在本反应堆中
+        assert(!a.migrate(12345, b));
+        assert(write(p.peer, "ping", 4) == 4);
+        a.destroy();
+    });
+    a.activate();
+    tb.join();
+    assert(drain(p.peer) == "queued");
+    assert(got == "ping");
+    assert(a_state.empty() && b_state[p.local] == "ctx-p" && b_state[q.local] == "ctx-q");
+    assert(q_paused);
+    assert(timer_thread == b_thread);
+    assert(m->migrations.load() == 2);
+}
+
+// shed()按回调次数挑选最活跃的连接
+void test_shed() {
+    fnet::reactor a, b;
+    a.enable_load_tracking();
+    pair_fd p[4];
+    for (auto& x : p) a.add_socket(x.local, fnet::event::readable, fnet::pattern::lt);
+    a.set_readable_cb([](int fd) { drain(fd); });
+    int ticks = 0;
+    std::function<void()> tick = [&] {
+        assert(write(p[0].peer, "x", 1) == 1);
+        if (ticks % 2 == 0) assert(write(p[1].peer, "x", 1) == 1);
+        if (ticks == 0) {
+            assert(write(p[2].peer, "x", 1) == 1);
+            assert(write(p[3].peer, "x", 1) == 1);
+        }
+        if (++ticks < 60) {
+            a.run_after(1, tick);
+            return;
+        }
+        a.run_after(5, [&] {
+            assert(a.shed(b, 0.5, 10) == 1);
+            assert(a.shed(b, 0.5, 10) == 0);  // 重新开始统计
+            a.destroy();
+        });
+    };
+    std::vector<int> adopted;
+    b.set_migration_cb(nullptr, [&](int fd, std::shared_ptr<void>) { adopted.push_back(fd); });
+    a.run_after(1, tick);
+    a.activate();
+    assert(a.busy_ns() > 0);
+    b.post([&] { b.destroy(); });
+    b.activate();
+    assert(adopted.size() == 1 && adopted[0] == p[0].local);
+}
+
+// 一个反应堆处理所有连接且持续繁忙时，balancer把一部分连接迁移到空闲的反应堆
+void test_balancer() {
+    fnet::reactor a, b;
+    fnet::balancer::options opt;
+    opt.high = 0.5;
+    opt.min_gap = 0.3;
+    fnet::balancer bal({&a, &b}, opt);
+    const int n = 8;
+    pair_fd p[n];
+    std::atomic<int> served_by_b = {0};
+    auto serve = [](int fd) {
+        drain(fd);
+        uint64_t until = fnet::details::now_ns() + 200000;  // 每次处理200us
+        while (fnet::details::now_ns() < until) {}
+        (void)!write(fd, "r", 1);
+    };
+    a.set_readable_cb(serve);
+    b.set_readable_cb([&](int fd) {
+        serve(fd);
+        ++served_by_b;
+    });
+    for (auto& x : p) a.add_socket(x.local, fnet::event::readable, fnet::pattern::lt);
+    std::atomic<bool> stop = {false};
+    std::thread client([&] {
+        while (!stop) {
+            for (auto& x : p) {
+                drain(x.peer);
+                (void)!write(x.peer, "q", 1);
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    });
+    std::thread ta([&] { a.activate(); });
+    std::thread tb([&] { b.activate(); });
+    for (int i = 0; i < 20 && bal.migrations() == 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        bal.balance();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    stop = true;
+    client.join();
+    a.post([&] { a.destroy(); });
+    b.post([&] { b.destroy(); });
+    ta.join();
+    tb.join();
+    assert(bal.migrations() > 0 && bal.migrations() < n);
+    assert(served_by_b > 0);
+}
+
+// 处理一批事件的过程中迁出的fd，本批中剩余的事件不再回调源反应堆，由目标反应堆接管后处理
+//   prioritized: 投递的任务（high级别）先于同一批中的连接事件执行，在任务中迁移，如balancer调用shed()
+//   否则在先被处理的连接的回调中迁出另一个连接
+void check_migrate_in_batch(bool prioritized) {
+    fnet::reactor a, b;
+    if (prioritized) a.set_priority_budget(fnet::priority::normal, 1000000);
+    pair_fd p, q;
+    a.add_socket(p.local, fnet::event::readable, fnet::pattern::lt);
+    a.add_socket(q.local, fnet::event::readable, fnet::pattern::lt);
+    std::vector<int> a_seen;
+    int moved = -1;
+    a.set_readable_cb([&](int fd) {
+        a_seen.push_back(fd);
+        drain(fd);
+        if (moved < 0) {
+            moved = fd == p.local ? q.local : p.local;
+            assert(a.migrate(moved, b));
+        }
+    });
+    std::string b_got;
+    b.set_readable_cb([&](int fd) {
+        b_got += drain(fd);
+        b.destroy();
+    });
+    b.run_after(2000, [&] { b.destroy(); });
+    assert(write(p.peer, "p", 1) == 1);
+    assert(write(q.peer, "q", 1) == 1);
+    if (prioritized) {
+        a.post([&] {
+            moved = q.local;
+            assert(a.migrate(q.local, b));
+        });
+    }
+    a.run_after(50, [&] { a.destroy(); });
+    std::thread tb([&] { b.activate(); });
+    a.activate();
+    tb.join();
+    assert(a_seen.size() == 1 && a_seen[0] != moved);
+    assert(b_got == (moved == p.local ? "p" : "q"));
+}
+
+void test_migrate_in_batch() {
+    check_migrate_in_batch(false);
+    check_migrate_in_batch(true);
+}
+
+int main() {
+    test_migrate();
+    test_migrate_in_batch();
+    test_shed();
+    test_balancer();
+    std::cout << "ok\n";
+}
@@ -0,0 +1,195 @@
+#include <fastnet/fastnet.h>
+#include <sys/socket.h>
+#include <cassert>
+#include <iostream>
+#include <string>
+#include "common.h"
+
+// 一次应答的三次写入在本轮结束时一次写出
+void test_coalesce() {
+    fnet::reactor rec;
+    auto* m = rec.enable_metrics();
+    pair_fd a, b;
+    rec.add_socket(a.local, fnet::event::readable, fnet::pattern::lt);
+    rec.add_socket(b.local, fnet::event::readable, fnet::pattern::lt);
+    int replies = 0;
+    rec.set_readable_cb([&](int fd) {
+        char buf[64];
+        while (read(fd, buf, sizeof(buf)) > 0) {}
+        rec.send(fd, "head|", 5);
+        rec.send(fd, std::string("body|"));
+        rec.send(fd, std::string(10000, 'x'));  // 较长的字符串移入队列
+        rec.send(fd, "tail", 4);
+        assert(rec.pending_output(fd) == 10014);
+        if (++replies == 2) rec.destroy();
+    });
+    assert(write(a.peer, "?", 1) == 1 && write(b.peer, "?", 1) == 1);
+    rec.activate();
+    std::string expect = "head|body|" + std::string(10000, 'x') + "tail";
+    assert(a.drain() == expect && b.drain() == expect);
+    assert(m->sends.load() == 8);
+    assert(m->send_syscalls.load() == 2);
+}
+
+// 写不完的数据由反应堆监听可写事件继续写出，用户的可写回调不受影响
+void test_backpressure() {
+    fnet::reactor rec;
+    pair_fd a;
+    int small = 4096;
+    setsockopt(a.local, SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+    rec.add_socket(a.local, fnet::event::readable, fnet::pattern::lt);
+    int writable_calls = 0;
+    rec.set_writable_cb([&](int) { ++writable_calls; });
+    std::string expect;
+    rec.post([&] {
+        for (int i = 0; i < 64; ++i) {
+            std::string chunk(3000, static_cast<char>('a' + i % 26));
+            expect += chunk;
+            rec.send(a.local, chunk);
+        }
+    });
+    std::string got;
+    rec.set_timeout(1, [&] {
+        got += a.drain();
+        if (got.size() == expect.size()) rec.destroy();
+    });
+    rec.activate();
+    assert(got == expect);
+    assert(rec.pending_output(a.local) == 0);
+    assert(writable_calls == 0);
+}
+
+// oneshot：事件交给回调后，写不完的数据只注册可写事件，reset_event()之前不会再次收到可读事件
+void test_oneshot_partial() {
+    fnet::reactor rec;
+    pair_fd a;
+    int small = 4096;
+    setsockopt(a.local, SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+    rec.add_socket(a.local, fnet::event::readable, fnet::pattern::lt_oneshot);
+    std::string expect(200000, 'z');
+    int reads = 0;
+    bool rearmed = false;
+    rec.set_readable_cb([&](int fd) {
+        char buf[64];
+        while (read(fd, buf, sizeof(buf)) > 0) {}
+        if (++reads == 1) {
+            rec.send(fd, std::string(expect));
+            assert(write(a.peer, "y", 1) == 1);  // 回调仍持有连接时到达的新数据
+        } else {
+            assert(rearmed);
+            rec.destroy();
+        }
+    });
+    std::string got;
+    int rounds = 0;
+    rec.set_timeout(1, [&] {
+        got += a.drain();
+        // 模拟其他线程处理完毕后重新注册
+        if (got.size() == expect.size() && !rearmed) {
+            assert(reads == 1);
+            rearmed = true;
+            rec.reset_event(a.local, fnet::event::readable, fnet::pattern::lt_oneshot);
+        }
+        if (++rounds == 5000) rec.destroy();
+    });
+    assert(write(a.peer, "x", 1) == 1);
+    rec.activate();
+    assert(got == expect);
+    assert(reads == 2);
+}
+
+// 全部写出后执行一次when_drained()的任务；队列为空时立即执行，丢弃数据时任务随之丢弃
+void test_drained() {
+    fnet::reactor rec;
+    pair_fd a;
+    int small = 4096;
+    setsockopt(a.local, SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+    rec.add_socket(a.local, fnet::event::readable, fnet::pattern::lt);
+    int now = 0;
+    rec.when_drained(a.local, [&](int) { ++now; });
+    assert(now == 1);
+
+    std::string expect(200000, 'd');
+    std::string got;
+    size_t got_at_drain = 0;
+    int drained = 0;
+    rec.post([&] {
+        rec.send(a.local, "stale", 5);
+        rec.when_drained(a.local, [&](int) { ++now; });
+        rec.discard_output(a.local);
+        rec.send(a.local, std::string(expect));
+        rec.when_drained(a.local, [&](int fd) {
+            assert(fd == a.local && rec.pending_output(fd) == 0);
+            got_at_drain = got.size();
+            ++drained;
+        });
+    });
+    rec.set_timeout(1, [&] {
+        got += a.drain();
+        if (got.size() == expect.size()) rec.destroy();
+    });
+    rec.activate();
+    assert(got == expect && now == 1);
+    assert(drained == 1 && got_at_drain < expect.size());
+}
+
+// 立即写出模式；循环之外的send()也立即写出
+void test_immediate() {
+    fnet::reactor rec;
+    pair_fd a;
+    rec.add_socket(a.local, fnet::event::readable, fnet::pattern::lt);
+    rec.set_write_mode(a.local, fnet::write_mode::immediate);
+    rec.post([&] {
+        rec.send(a.local, "now", 3);
+        assert(a.drain() == "now");
+        rec.destroy();
+    });
+    rec.activate();
+
+    fnet::reactor idle;
+    pair_fd b;
+    idle.add_socket(b.local, fnet::event::readable, fnet::pattern::lt);
+    idle.send(b.local, "direct", 6);
+    assert(b.drain() == "direct");
+}
+
+// 丢弃未写出的数据；fd被重新添加时不会收到之前连接的数据
+void test_discard() {
+    fnet::reactor rec;
+    pair_fd a;
+    rec.add_socket(a.local, fnet::event::readable, fnet::pattern::lt);
+    int sv[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv) == 0);
+    rec.add_socket(sv[0], fnet::event::readable, fnet::pattern::lt);
+    int reused[2] = {-1, -1};
+    rec.post([&] {
+        rec.send(a.local, "stale", 5);
+        rec.discard_output(a.local);
+        rec.send(a.local, "x", 1);
+        // 关闭后同一轮中fd被复用
+        rec.send(sv[0], "old", 3);
+        close(sv[0]);
+        close(sv[1]);
+        assert(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, reused) == 0);
+        assert(reused[0] == sv[0] || reused[1] == sv[0]);
+        rec.add_socket(sv[0], fnet::event::readable, fnet::pattern::lt);
+        rec.destroy();
+    });
+    rec.activate();
+    assert(a.drain() == "x");
+    char buf[8];
+    int other = reused[0] == sv[0] ? reused[1] : reused[0];
+    assert(read(other, buf, sizeof(buf)) == -1 && errno == EAGAIN);
+    close(reused[0]);
+    close(reused[1]);
+}
+
+int main() {
+    test_coalesce();
+    test_backpressure();
+    test_oneshot_partial();
+    test_drained();
+    test_immediate();
+    test_discard();
+    std::cout << "ok\n";
+}
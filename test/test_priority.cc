@@ -0,0 +1,105 @@
+#include <fastnet/fastnet.h>
+#include <sys/socket.h>
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "common.h"
+
+void busy_for(int us) {
+    uint64_t end = fnet::details::now_ns() + static_cast<uint64_t>(us) * 1000;
+    while (fnet::details::now_ns() < end) {}
+}
+
+// 同一批事件按级别处理，投递任务（内部fd）最先
+void test_order() {
+    fnet::reactor rec;
+    pair_fd low, normal, high;
+    for (auto* p : {&low, &normal, &high}) rec.add_socket(p->local, fnet::event::readable, fnet::pattern::lt);
+    rec.set_priority(low.local, fnet::priority::low);
+    rec.set_priority(high.local, fnet::priority::high);
+    assert(rec.priority_of(normal.local) == fnet::priority::normal);
+    std::vector<std::string> order;
+    rec.set_readable_cb([&](int fd) {
+        drain(fd);
+        order.push_back(fd == low.local ? "low" : fd == normal.local ? "normal" : "high");
+        if (order.size() == 4) rec.destroy();
+    });
+    // 按低到高的顺序就绪
+    rec.post([&] { order.push_back("post"); });
+    for (auto* p : {&low, &normal, &high}) assert(write(p->peer, "x", 1) == 1);
+    rec.activate();
+    assert((order == std::vector<std::string>{"post", "high", "normal", "low"}));
+    assert(rec.priority_of(low.local) == fnet::priority::low);
+}
+
+// 低级别用完时间预算后剩余的事件留到之后的轮次，高级别的事件不受影响
+void check_budget(fnet::pattern_t pat) {
+    fnet::reactor rec;
+    auto* m = rec.enable_metrics();
+    rec.set_priority_budget(fnet::priority::low, 1000);
+    const int n = 4;
+    std::vector<pair_fd> bulk(n);
+    pair_fd ctrl;
+    for (auto& p : bulk) {
+        rec.add_socket(p.local, fnet::event::readable, pat);
+        rec.set_priority(p.local, fnet::priority::low);
+    }
+    rec.add_socket(ctrl.local, fnet::event::readable, pat);
+    rec.set_priority(ctrl.local, fnet::priority::high);
+    std::vector<uint64_t> bulk_iters;
+    uint64_t ctrl_iter = 0;
+    rec.set_readable_cb([&](int fd) {
+        drain(fd);
+        uint64_t iter = m->loop_iterations.load();
+        if (fd == ctrl.local) {
+            ctrl_iter = iter;
+            return;
+        }
+        bulk_iters.push_back(iter);
+        busy_for(2000);
+        if (bulk_iters.size() == n) rec.destroy();
+    });
+    for (auto& p : bulk) assert(write(p.peer, "x", 1) == 1);
+    assert(write(ctrl.peer, "x", 1) == 1);
+    rec.run_after(1000, [&] { rec.destroy(); });
+    rec.activate();
+    assert(bulk_iters.size() == n);
+    for (int i = 1; i < n; ++i) assert(bulk_iters[i] > bulk_iters[i - 1]);
+    assert(ctrl_iter == bulk_iters[0]);
+    assert(m->budget_deferred.load() >= n - 1);
+}
+
+void test_budget() {
+    check_budget(fnet::pattern::lt);
+    check_budget(fnet::pattern::et);  // 边缘触发的事件不会再次报告，由反应堆保存
+}
+
+// cancel_deferred()丢弃留到下一轮的事件（如在定时器中关闭了连接）
+void test_cancel_carried() {
+    fnet::reactor rec;
+    rec.set_priority_budget(fnet::priority::normal, 100);
+    pair_fd a, b;
+    rec.add_socket(a.local, fnet::event::readable, fnet::pattern::et);
+    rec.add_socket(b.local, fnet::event::readable, fnet::pattern::et);
+    std::vector<int> seen;
+    rec.set_readable_cb([&](int fd) {
+        drain(fd);
+        seen.push_back(fd);
+        busy_for(500);
+        int other = fd == a.local ? b.local : a.local;
+        rec.run_after(0, [&rec, other] { rec.cancel_deferred(other); });
+    });
+    assert(write(a.peer, "x", 1) == 1 && write(b.peer, "x", 1) == 1);
+    rec.run_after(30, [&] { rec.destroy(); });
+    rec.activate();
+    assert(seen.size() == 1);
+}
+
+int main() {
+    test_order();
+    test_budget();
+    test_cancel_carried();
+    std::cout << "ok\n";
+}
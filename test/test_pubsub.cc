@@ -0,0 +1,165 @@
+#include <fastnet/pubsub.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <thread>
+#include "common.h"
+
+// 消息只分配一次，由所有队列共享
+void test_payload() {
+    auto p = fnet::payload::make("hello");
+    assert(p.size() == 5 && std::string(p.data(), p.size()) == "hello");
+    {
+        auto q = p;
+        fnet::payload r;
+        r = q;
+        assert(p.use_count() == 3 && r.data() == p.data());
+    }
+    assert(p.use_count() == 1);
+}
+
+// 按主题发布，跳过发布者，所有订阅者收到同样的内容
+void test_publish() {
+    fnet::reactor rec;
+    fnet::pubsub hub(rec);
+    pair_fd a, b, c;
+    for (auto* p : {&a, &b, &c}) rec.add_socket(p->local, fnet::event::readable, fnet::pattern::lt);
+    hub.subscribe("news", a.local);
+    hub.subscribe("news", b.local);
+    hub.subscribe("news", b.local);  // 重复订阅被忽略
+    hub.subscribe("news", c.local);
+    hub.subscribe("other", c.local);
+    assert(hub.subscribers("news") == 3);
+    assert(hub.publish("news", "x1", 2, a.local) == 2);
+    assert(hub.publish("news", "x2", 2) == 3);
+    assert(hub.publish("other", "y", 1) == 1);
+    assert(hub.publish("none", "z", 1) == 0);
+    hub.flush();
+    assert(a.drain() == "x2");
+    assert(b.drain() == "x1x2");
+    assert(c.drain() == "x1x2y");
+
+    // 移除a、退订b后，被移动到空位上的c的下标随之更新
+    hub.remove(a.local);
+    hub.unsubscribe("news", b.local);
+    assert(hub.subscribers("news") == 1);
+    hub.publish("news", "m", 1);
+    hub.unsubscribe("news", c.local);
+    assert(hub.subscribers("news") == 0 && hub.subscribers("other") == 1);
+    // 发布后自动安排的写出在反应堆中执行
+    rec.post([&] { rec.destroy(); });
+    rec.activate();
+    assert(a.drain().empty() && b.drain().empty());
+    assert(c.drain() == "m");
+    assert(hub.stats().published == 4);
+}
+
+// 三种溢出策略
+void test_overflow() {
+    fnet::reactor rec;
+    fnet::pubsub::options opt;
+    opt.max_messages = 2;
+    pair_fd a;
+    rec.add_socket(a.local, fnet::event::readable, fnet::pattern::lt);
+
+    opt.policy = fnet::overflow::drop_newest;
+    fnet::pubsub newest(rec, opt);
+    newest.subscribe("t", a.local);
+    for (char c = '1'; c <= '5'; ++c) newest.publish("t", &c, 1);
+    newest.flush();
+    assert(a.drain() == "12");
+    assert(newest.stats().dropped == 3);
+    newest.remove(a.local);
+
+    opt.policy = fnet::overflow::drop_oldest;
+    fnet::pubsub oldest(rec, opt);
+    oldest.subscribe("t", a.local);
+    for (char c = '1'; c <= '5'; ++c) oldest.publish("t", &c, 1);
+    oldest.flush();
+    assert(a.drain() == "45");
+    oldest.remove(a.local);
+
+    opt.policy = fnet::overflow::disconnect;
+    fnet::pubsub strict(rec, opt);
+    int evicted = -1;
+    strict.set_overflow_cb([&](int fd) { evicted = fd; });
+    strict.subscribe("t", a.local);
+    for (char c = '1'; c <= '3'; ++c) strict.publish("t", &c, 1);
+    assert(evicted == a.local);
+    assert(strict.subscribers("t") == 0 && strict.stats().disconnected == 1);
+
+    // 默认经反应堆的断开回调处理，fd由断开回调决定何时关闭
+    fnet::pubsub plain(rec, opt);
+    int reported = -1;
+    rec.set_disconnect_cb([&](int fd) {
+        plain.remove(fd);
+        reported = fd;
+    });
+    plain.subscribe("t", a.local);
+    for (char c = '1'; c <= '3'; ++c) plain.publish("t", &c, 1);
+    assert(reported == a.local && plain.subscribers("t") == 0);
+    assert(fcntl(a.local, F_GETFD) != -1);
+}
+
+// 慢消费者：发送缓冲写满后监听可写事件，按顺序继续写出
+void test_slow_consumer() {
+    fnet::reactor rec;
+    fnet::pubsub hub(rec);
+    pair_fd a;
+    int small = 4096;
+    setsockopt(a.local, SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+    rec.add_socket(a.local, fnet::event::readable, fnet::pattern::lt);
+    rec.set_writable_cb([&](int fd) { hub.on_writable(fd); });
+    hub.subscribe("t", a.local);
+    std::string expect;
+    for (int i = 0; i < 64; ++i) {
+        std::string msg(4000, static_cast<char>('a' + i % 26));
+        expect += msg;
+        hub.publish("t", msg.data(), msg.size());
+    }
+    hub.flush();
+    assert(hub.queued_bytes(a.local) > 0);
+    std::string got;
+    rec.set_timeout(1, [&] {
+        got += a.drain();
+        if (got.size() == expect.size()) rec.destroy();
+    });
+    rec.activate();
+    assert(got == expect);
+    assert(hub.queued_bytes(a.local) == 0);
+}
+
+// 分片：每个反应堆各自写给本地的订阅者，消息只创建一次
+void test_group() {
+    fnet::reactor r0, r1;
+    fnet::pubsub_group group({&r0, &r1});
+    pair_fd a, b;
+    r0.add_socket(a.local, fnet::event::readable, fnet::pattern::lt);
+    r1.add_socket(b.local, fnet::event::readable, fnet::pattern::lt);
+    group.shard(0).subscribe("t", a.local);
+    group.shard(1).subscribe("t", b.local);
+    std::thread t0([&] { r0.activate(); });
+    std::thread t1([&] { r1.activate(); });
+    auto msg = fnet::payload::make("shared");
+    group.publish("t", msg);
+    group.publish("t", "!", 1, a.local, 0);
+    // 分片中的发布会再投递一次写出，在其之后停止
+    r0.post([&] { r0.post([&] { r0.destroy(); }); });
+    r1.post([&] { r1.post([&] { r1.destroy(); }); });
+    t0.join();
+    t1.join();
+    assert(a.drain() == "shared");
+    assert(b.drain() == "shared!");
+    assert(msg.use_count() == 1);
+}
+
+int main() {
+    test_payload();
+    test_publish();
+    test_overflow();
+    test_slow_consumer();
+    test_group();
+    std::cout << "ok\n";
+}
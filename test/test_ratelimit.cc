@@ -0,0 +1,191 @@
+#include <fastnet/throttle.h>
+#include <sys/socket.h>
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// 令牌按时间惰性补充，不超过桶容量
+void test_bucket() {
+    fnet::token_bucket b(1000, 4);  // 每毫秒一个令牌
+    uint64_t t = 1000000000;
+    for (int i = 0; i < 4; ++i) assert(b.try_take(1, t));
+    assert(!b.try_take(1, t));
+    assert(b.ready_at(1, t) == t + 1000000);
+    assert(b.ready_at(2, t + 500000) == t + 2000000);
+    assert(b.try_take(1, t + 1000000));
+    assert(b.available(t + 1000000000) == 4);
+    assert(b.ready_at(5, t) == UINT64_MAX);
+}
+
+// 开放寻址：大量插入与删除后其余的键仍可找到
+void test_ip_table() {
+    fnet::ip_table tab;
+    for (uint64_t k = 1; k <= 1000; ++k) tab.insert(k).conns = static_cast<uint32_t>(k);
+    assert(tab.size() == 1000);
+    for (uint64_t k = 1; k <= 1000; k += 2) tab.erase(k);
+    assert(tab.size() == 500);
+    for (uint64_t k = 1; k <= 1000; ++k) {
+        auto* e = tab.find(k);
+        if (k % 2) assert(e == nullptr);
+        else assert(e && e->conns == k);
+    }
+    tab.erase(12345);
+    assert(tab.size() == 500);
+}
+
+// 每个来源地址的连接数上限与接收速率
+void test_admission() {
+    fnet::admission::options opt;
+    opt.max_conns_per_ip = 2;
+    opt.accept_rate = 1000;
+    opt.accept_burst = 2;
+    fnet::admission adm(opt);
+    assert(adm.admit(10, 7) && adm.admit(11, 7));
+    assert(!adm.admit(12, 7));
+    assert(adm.admit(12, 8));
+    assert(adm.connections(7) == 2 && adm.rejected() == 1);
+    adm.release(10);
+    adm.release(10);  // 重复释放无效
+    assert(adm.connections(7) == 1);
+    assert(adm.admit(10, 7));
+
+    uint64_t t = 1000000000;
+    assert(adm.next_accept(t) == t);
+    adm.on_accept(t);
+    adm.on_accept(t);
+    assert(adm.next_accept(t) == t + 1000000);
+}
+
+// 反应堆内的定时器：按到期时间执行，可取消，不触发超时回调
+void test_timers() {
+    fnet::reactor rec;
+    std::string order;
+    int timeouts = 0;
+    rec.set_timeout(1000, [&] { ++timeouts; });
+    rec.run_after(3, [&] { order += 'c'; rec.destroy(); });
+    rec.run_after(1, [&] { order += 'a'; });
+    auto id = rec.run_after(2, [&] { order += 'x'; });
+    rec.run_after(2, [&] { order += 'b'; });
+    assert(rec.cancel_timer(id) && !rec.cancel_timer(id));
+    uint64_t begin = fnet::details::now_ns();
+    rec.activate();
+    assert(order == "abc");
+    assert(fnet::details::now_ns() - begin >= 3000000);
+    assert(timeouts == 0);
+}
+
+// 暂停读取后不再触发可读事件，恢复后已到达的数据再次触发
+void test_pause() {
+    fnet::reactor rec;
+    int sv[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv) == 0);
+    rec.add_socket(sv[0], fnet::event::readable, fnet::pattern::et);
+    int reads = 0;
+    rec.set_readable_cb([&](int) { ++reads; });
+    rec.pause_reading(sv[0]);
+    rec.reset_event(sv[0], fnet::event::readable, fnet::pattern::et);  // 暂停期间仍不监听可读
+    assert(rec.reading_paused(sv[0]));
+    assert(write(sv[1], "hi", 2) == 2);
+    rec.run_after(5, [&] {
+        assert(reads == 0);
+        rec.resume_reading(sv[0]);
+        rec.run_after(5, [&] { rec.destroy(); });
+    });
+    rec.activate();
+    assert(reads == 1);
+    close(sv[0]);
+    close(sv[1]);
+}
+
+// 每个字节算作一个请求：令牌耗尽时暂停，补充后通过推迟的可读回调处理缓冲中剩余的请求
+void test_throttle() {
+    fnet::reactor rec;
+    auto* m = rec.enable_metrics();
+    fnet::throttle::options opt;
+    opt.conn_rate = 1000;
+    opt.conn_burst = 4;
+    opt.ip_rate = 2000;
+    opt.ip_burst = 4;
+    fnet::throttle thr(rec, opt);
+    int a[2], b[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, a) == 0);
+    assert(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, b) == 0);
+    rec.add_socket(a[0], fnet::event::readable, fnet::pattern::lt);
+    rec.add_socket(b[0], fnet::event::readable, fnet::pattern::lt);
+    thr.add(a[0], 1);
+    thr.add(b[0], 1);  // 与a同一来源地址，共享地址的令牌桶
+
+    const int total = 20;
+    std::string pending[2];
+    int done = 0;
+    rec.set_readable_cb([&](int fd) {
+        auto& buf = pending[fd == a[0] ? 0 : 1];
+        char tmp[64];
+        ssize_t n;
+        while ((n = read(fd, tmp, sizeof(tmp))) > 0) buf.append(tmp, n);
+        size_t i = 0;
+        while (i < buf.size() && thr.consume(fd)) ++i;
+        buf.erase(0, i);
+        done += static_cast<int>(i);
+        if (done == 2 * total) rec.destroy();
+    });
+    std::string req(total, 'r');
+    assert(write(a[1], req.data(), req.size()) == total);
+    assert(write(b[1], req.data(), req.size()) == total);
+    uint64_t begin = fnet::details::now_ns();
+    rec.activate();
+    double ms = (fnet::details::now_ns() - begin) / 1e6;
+    // 共40个请求，地址桶初始4个令牌，其余以每秒2000个补充
+    assert(ms >= 17);
+    assert(m->paused_reads.load() > 0);
+    assert(!thr.paused(a[0]) || !thr.paused(b[0]));
+    thr.remove(a[0]);
+    thr.remove(b[0]);
+    assert(thr.size() == 0 && thr.consume(a[0]));
+    for (int fd : {a[0], a[1], b[0], b[1]}) close(fd);
+}
+
+// 同一地址超出连接数上限的连接在接收后立即关闭
+void test_admission_acceptor() {
+    fnet::reactor rec;
+    auto* m = rec.enable_metrics();
+    fnet::acceptor<fnet::protocol::tcp> acp;
+    acp.do_bind("127.0.0.1", 0);
+    acp.do_listen();
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    getsockname(acp.get_fd(), (struct sockaddr*)&addr, &len);
+
+    fnet::admission::options opt;
+    opt.max_conns_per_ip = 2;
+    fnet::admission adm(opt);
+    std::vector<int> accepted;
+    rec.add_acceptor(std::move(acp), [&](int fd) { accepted.push_back(fd); }, adm);
+    std::vector<int> clients;
+    for (int i = 0; i < 4; ++i) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        assert(connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+        clients.push_back(fd);
+    }
+    rec.run_after(20, [&] { rec.destroy(); });
+    rec.activate();
+    assert(accepted.size() == 2);
+    assert(adm.rejected() == 2 && m->rejected_accepts.load() == 2);
+    for (int fd : accepted) {
+        adm.release(fd);
+        close(fd);
+    }
+    for (int fd : clients) close(fd);
+}
+
+int main() {
+    test_bucket();
+    test_ip_table();
+    test_admission();
+    test_timers();
+    test_pause();
+    test_throttle();
+    test_admission_acceptor();
+    std::cout << "ok\n";
+}
@@ -0,0 +1,189 @@
+#include <fastnet/resp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cassert>
+#include <iostream>
+#include <map>
+#include <string>
+
+using fnet::resp::status;
+using fnet::resp::type;
+
+// 批量字符串组成的数组被解析为命令参数
+void test_command() {
+    std::string s = "*3\r\n$3\r\nSET\r\n$3\r\nkey\r\n$5\r\nva\r\nl\r\n";
+    fnet::resp::decoder dec;
+    assert(dec.parse(s.data(), s.size()) == status::complete);
+    assert(dec.consumed() == s.size());
+    assert(dec.is_command());
+    auto& args = dec.args();
+    assert(args.size() == 3);
+    assert(args[0] == "SET" && args[1] == "key" && args[2] == "va\r\nl");
+    assert(args[2].data() > s.data() && args[2].data() < s.data() + s.size());  // 不拷贝
+}
+
+// 逐字节到达，且两次调用之间缓冲区被移动
+void test_partial() {
+    std::string s = "*2\r\n$4\r\nECHO\r\n$11\r\nhello world\r\n";
+    fnet::resp::decoder dec;
+    std::string buf;
+    for (size_t i = 0; i < s.size(); ++i) {
+        buf.push_back(s[i]);
+        std::string moved = buf;
+        auto r = dec.parse(moved.data(), moved.size());
+        if (i + 1 < s.size()) {
+            assert(r == status::incomplete);
+        } else {
+            assert(r == status::complete);
+            assert(dec.args().size() == 2);
+            assert(dec.args()[0] == "ECHO");
+            assert(dec.args()[1] == "hello world");
+            buf = moved;
+        }
+    }
+}
+
+// RESP3的各种类型
+void test_resp3() {
+    std::string s = "%2\r\n+first\r\n*3\r\n:-42\r\n#t\r\n_\r\n$6\r\nsecond\r\n"
+                    "|1\r\n+ttl\r\n:10\r\n,3.25\r\n";
+    fnet::resp::decoder dec;
+    assert(dec.parse(s.data(), s.size()) == status::complete);
+    auto& v = dec.values();
+    assert(v.size() == 11);
+    assert(v[0].t == type::map && v[0].num == 2);
+    assert(v[1].t == type::simple_string && v[1].str == "first");
+    assert(v[2].t == type::array && v[2].num == 3);
+    assert(v[3].t == type::integer && v[3].num == -42);
+    assert(v[4].t == type::boolean && v[4].num == 1);
+    assert(v[5].t == type::null);
+    assert(v[6].t == type::bulk_string && v[6].str == "second");
+    assert(v[7].t == type::attribute);  // 属性不计入map的元素
+    assert(v[10].t == type::real && v[10].str == "3.25");
+    assert(!dec.is_command());
+    assert(dec.consumed() == s.size());
+
+    std::string nulls = "*-1\r\n$-1\r\n";
+    assert(dec.parse(nulls.data(), nulls.size()) == status::complete);
+    assert(dec.values()[0].is_null && dec.consumed() == 5);
+    assert(dec.parse(nulls.data() + 5, 5) == status::complete);
+    assert(dec.values()[0].t == type::bulk_string && dec.values()[0].is_null);
+}
+
+// 内联命令与协议错误
+void test_inline_and_errors() {
+    fnet::resp::decoder dec;
+    std::string s = "  PING  hello\r\n";
+    assert(dec.parse(s.data(), s.size()) == status::complete);
+    assert(dec.args().size() == 2 && dec.args()[0] == "PING" && dec.args()[1] == "hello");
+
+    auto parse = [](std::string s) {
+        fnet::resp::decoder dec(16, 4);
+        return dec.parse(s.data(), s.size());
+    };
+    assert(parse("*1\r\n$x\r\n") == status::error);
+    assert(parse("*1\r\n$3\r\nabcd\r\n") == status::error);
+    assert(parse("$17\r\n") == status::error);    // 超过max_bulk
+    assert(parse("*5\r\n") == status::error);     // 超过max_elements
+    assert(parse("*1\r\n?\r\n") == status::error);
+    assert(parse("#x\r\n") == status::error);
+    assert(parse("*2\r\n$1\r\na\r\n") == status::incomplete);
+}
+
+// 编码
+void test_writer() {
+    fnet::resp::writer w;
+    w.simple("OK").error("ERR x").integer(-7).bulk("a\r\nb").null().array(2).boolean(true).map(1);
+    int sv[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+    assert(w.flush(sv[0]) > 0 && w.empty());
+    w.set_protocol(3);
+    w.null().boolean(false).map(1).real(0.5).set(0);
+    assert(w.flush(sv[0]) > 0);
+    char buf[256];
+    std::string got(buf, read(sv[1], buf, sizeof(buf)));
+    assert(got == "+OK\r\n-ERR x\r\n:-7\r\n$4\r\na\r\nb\r\n$-1\r\n*2\r\n:1\r\n*2\r\n"
+                  "_\r\n#f\r\n%1\r\n,0.5\r\n~0\r\n");
+    close(sv[0]);
+    close(sv[1]);
+}
+
+// 一次读入的多条流水线命令经cbtrie分发，回复合并为一次写出
+void test_pipeline_dispatch() {
+    int sv[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+    std::map<std::string, std::string, std::less<>> db;
+    fnet::resp::dispatcher cmds;
+    cmds.on("set", [&](auto& args, auto& out) {
+        db[std::string(args[1])] = std::string(args[2]);
+        out.simple("OK");
+    });
+    cmds.on("get", [&](auto& args, auto& out) {
+        auto it = db.find(args[1]);
+        if (it == db.end()) out.null();
+        else out.bulk(it->second);
+    });
+    std::string in = "*3\r\n$3\r\nset\r\n$1\r\nk\r\n$1\r\nv\r\n*2\r\n$3\r\nGET\r\n$1\r\nk\r\n"
+                     "*2\r\n$3\r\nGeT\r\n$1\r\nz\r\n*1\r\n$4\r\nnope\r\n*2\r\n$3\r\nget";
+    assert(write(sv[1], in.data(), in.size()) == static_cast<ssize_t>(in.size()));
+    fnet::sockbuffer sb(sv[0], 4096);
+    fnet::resp::decoder dec;
+    fnet::resp::writer out;
+    sb.readsock();
+    assert(cmds.feed(sb, dec, out));
+    assert(sb.pending() == 11);  // 不完整的最后一条命令留在缓冲中
+    assert(out.flush(sv[0]) > 0);
+    assert(write(sv[1], "\r\n$1\r\nk\r\n", 9) == 9);
+    sb.readsock();
+    assert(cmds.feed(sb, dec, out));
+    assert(out.flush(sv[0]) > 0);
+    char buf[256];
+    std::string got(buf, read(sv[1], buf, sizeof(buf)));
+    assert(got == "+OK\r\n$1\r\nv\r\n$-1\r\n-ERR unknown command 'nope'\r\n$1\r\nv\r\n");
+    close(sv[0]);
+    close(sv[1]);
+}
+
+// 超过连接缓冲区的值无法完整到达，feed()应报告错误而不是一直等待
+void test_oversized() {
+    int sv[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+    fnet::resp::dispatcher cmds;
+    cmds.on("set", [](auto&, auto& out) { out.simple("OK"); });
+    fnet::sockbuffer sb(sv[0], 64);
+    fnet::resp::writer out;
+
+    // 长度前缀超过缓冲区容量，读到前缀时即失败
+    fnet::resp::decoder dec;
+    std::string in = "*3\r\n$3\r\nset\r\n$1\r\nk\r\n$100\r\n";
+    assert(write(sv[1], in.data(), in.size()) == static_cast<ssize_t>(in.size()));
+    sb.readsock();
+    assert(!cmds.feed(sb, dec, out));
+    assert(dec.max_bulk_len() == 64);
+
+    // 每个字符串都不超过容量，但整条命令填满了缓冲区
+    sb.reflush();
+    fnet::resp::decoder dec2;
+    in = "*3\r\n$3\r\nset\r\n$1\r\nk\r\n$40\r\n" + std::string(40, 'v') + "\r\n";
+    assert(write(sv[1], in.data(), in.size()) == static_cast<ssize_t>(in.size()));
+    sb.readsock();
+    assert(sb.freespace() == 0);
+    assert(!cmds.feed(sb, dec2, out));
+    assert(out.flush(sv[0]) > 0);
+    char buf[256];
+    std::string got(buf, read(sv[1], buf, sizeof(buf)));
+    assert(got == "-ERR Protocol error\r\n-ERR Protocol error: command exceeds the connection buffer\r\n");
+    close(sv[0]);
+    close(sv[1]);
+}
+
+int main() {
+    test_command();
+    test_partial();
+    test_resp3();
+    test_inline_and_errors();
+    test_writer();
+    test_pipeline_dispatch();
+    test_oversized();
+    std::cout << "ok\n";
+}
@@ -0,0 +1,221 @@
+#include <fastnet/fastnet.h>
+#include <sys/socket.h>
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "common.h"
+
+using fnet::rpc::status;
+
+// 同一个反应堆上的一对端点：client在local上发起调用，server在peer上处理
+struct rpc_pair {
+    fnet::reactor rec;
+    pair_fd p;
+    fnet::rpc::endpoint client;
+    fnet::rpc::endpoint server;
+
+    explicit rpc_pair(fnet::rpc::endpoint::options opt = fnet::rpc::endpoint::options())
+        : client(rec, opt)
+        , server(rec, opt) {
+        rec.add_socket(p.local, fnet::event::readable, fnet::pattern::lt);
+        rec.add_socket(p.peer, fnet::event::readable, fnet::pattern::lt);
+        client.attach(p.local);
+        server.attach(p.peer);
+        rec.set_readable_cb([this](int fd) {
+            auto& ep = fd == p.local ? client : server;
+            if (!ep.on_readable(fd)) {
+                ep.remove(fd);
+                rec.destroy();
+            }
+        });
+    }
+};
+
+// 多个未完成的调用，服务端倒序应答，按编号匹配
+void test_out_of_order() {
+    rpc_pair l;
+    std::vector<fnet::rpc::call> held;
+    l.server.on(1, [&](const fnet::rpc::call& c, std::string_view) {
+        held.push_back(c);
+        if (held.size() < 3) return;
+        for (auto it = held.rbegin(); it != held.rend(); ++it) {
+            l.server.reply(*it, "reply-" + std::to_string(it->id));
+        }
+    });
+    std::vector<uint64_t> order;
+    int done = 0;
+    for (int i = 0; i < 3; ++i) {
+        uint64_t id = l.client.invoke(l.p.local, 1, "req", [&, i](status s, std::string_view body) {
+            assert(s == status::ok);
+            order.push_back(i);
+            assert(body == "reply-" + std::to_string(i + 1));
+            if (++done == 3) l.rec.destroy();
+        });
+        assert(id == static_cast<uint64_t>(i + 1));
+    }
+    assert(l.client.inflight() == 3);
+    l.rec.activate();
+    assert((order == std::vector<uint64_t>{2, 1, 0}));
+    assert(l.client.inflight() == 0);
+    assert(l.client.stats().replies == 3 && l.server.stats().requests == 3);
+}
+
+// 未知方法与处理函数抛出的异常以错误应答
+void test_errors() {
+    rpc_pair l;
+    l.server.on(2, [](const fnet::rpc::call&, std::string_view) { throw std::runtime_error("boom"); });
+    int done = 0;
+    l.client.invoke(l.p.local, 9, "", [&](status s, std::string_view body) {
+        assert(s == status::error && body == "unknown method 9");
+        ++done;
+    });
+    l.client.invoke(l.p.local, 2, "", [&](status s, std::string_view body) {
+        assert(s == status::error && body == "boom");
+        if (++done == 2) l.rec.destroy();
+    });
+    l.rec.activate();
+    assert(done == 2);
+}
+
+// 超过期限以timeout结束，之后到达的应答被丢弃；cancel()的调用不再回调
+void test_timeout() {
+    rpc_pair l;
+    std::vector<fnet::rpc::call> held;
+    l.server.on(1, [&](const fnet::rpc::call& c, std::string_view) { held.push_back(c); });
+    int timeouts = 0;
+    uint64_t begin = fnet::details::now_ns();
+    l.client.invoke(l.p.local, 1, "a", [&](status s, std::string_view) {
+        assert(s == status::timeout);
+        ++timeouts;
+    }, 20);
+    l.client.invoke(l.p.local, 1, "b", [&](status s, std::string_view) {
+        assert(s == status::timeout);
+        ++timeouts;
+        for (auto& c : held) l.server.reply(c, "late");
+    }, 40);
+    uint64_t cancelled = l.client.invoke(l.p.local, 1, "c", [](status, std::string_view) { assert(false); }, 10);
+    assert(l.client.cancel(cancelled) && !l.client.cancel(cancelled));
+    l.rec.run_after(80, [&] { l.rec.destroy(); });
+    l.rec.activate();
+    assert(timeouts == 2);
+    assert(fnet::details::now_ns() - begin >= 40000000);
+    assert(l.client.stats().timeouts == 2);
+    assert(l.client.stats().late_replies == 3);
+    assert(l.client.inflight() == 0);
+}
+
+// 移除连接时未完成的调用以disconnected结束
+void test_disconnect() {
+    rpc_pair l;
+    l.server.on(1, [](const fnet::rpc::call&, std::string_view) {});
+    int failed = 0;
+    for (int i = 0; i < 4; ++i) {
+        l.client.invoke(l.p.local, 1, "x", [&](status s, std::string_view) {
+            assert(s == status::disconnected);
+            ++failed;
+        });
+    }
+    l.rec.run_after(10, [&] {
+        l.client.remove(l.p.local);
+        l.rec.destroy();
+    });
+    l.rec.activate();
+    assert(failed == 4 && l.client.inflight() == 0);
+    fnet::rpc::call stale{l.p.local, 0, 1, 1};
+    assert(!l.client.reply(stale, "x"));
+}
+
+// 大量并发调用使调用表扩容，大消息跨多次读取
+void test_many_and_large() {
+    rpc_pair l;
+    l.server.on(1, [&](const fnet::rpc::call& c, std::string_view body) { l.server.reply(c, body); });
+    const int n = 5000;
+    int done = 0;
+    std::string big(3 << 20, 'z');
+    for (int i = 0; i < n; ++i) {
+        std::string body = i == n / 2 ? big : std::to_string(i);
+        l.client.invoke(l.p.local, 1, body, [&, body](status s, std::string_view reply) {
+            assert(s == status::ok && reply == body);
+            if (++done == n) l.rec.destroy();
+        });
+    }
+    assert(l.client.inflight() == n);
+    l.rec.activate();
+    assert(done == n);
+}
+
+// 超过max_frame的帧视为协议错误
+void test_frame_limit() {
+    fnet::rpc::endpoint::options opt;
+    opt.max_frame = 1024;
+    rpc_pair l(opt);
+    bool threw = false;
+    try {
+        l.client.invoke(l.p.local, 1, std::string(2048, 'x'), [](status, std::string_view) {});
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    char head[fnet::rpc::header_size];
+    fnet::rpc::details::encode_header(head, fnet::rpc::frame_type::request, 1, 1, 4096);
+    assert(write(l.p.local, head, sizeof(head)) == sizeof(head));
+    l.rec.activate();
+    assert(l.server.stats().protocol_errors == 1);
+}
+
+// 超过max_frame的应答改为错误应答，过长的错误描述被截断
+void test_reply_limit() {
+    fnet::rpc::endpoint::options opt;
+    opt.max_frame = 64;
+    rpc_pair l(opt);
+    l.server.on(1, [&](const fnet::rpc::call& c, std::string_view) { l.server.reply(c, std::string(100, 'r')); });
+    l.server.on(2, [&](const fnet::rpc::call& c, std::string_view) { l.server.fail(c, std::string(100, 'e')); });
+    int done = 0;
+    l.client.invoke(l.p.local, 1, "big", [&](status s, std::string_view body) {
+        assert(s == status::error && body == "rpc: reply too large (100 bytes)");
+        if (++done == 2) l.rec.destroy();
+    });
+    l.client.invoke(l.p.local, 2, "err", [&](status s, std::string_view body) {
+        assert(s == status::error && body == std::string(64, 'e'));
+        if (++done == 2) l.rec.destroy();
+    });
+    l.rec.activate();
+    assert(done == 2 && l.client.stats().protocol_errors == 0);
+}
+
+// 每次on_readable()最多读取read_budget字节，其余的推迟到本轮其他fd之后
+void test_read_budget() {
+    fnet::rpc::endpoint::options opt;
+    opt.read_chunk = 4096;
+    opt.read_budget = 8192;
+    rpc_pair l(opt);
+    auto* m = l.rec.enable_metrics();
+    int requests = 0;
+    l.server.on(1, [&](const fnet::rpc::call&, std::string_view body) {
+        assert(body.size() == 1000);
+        if (++requests == 40) l.rec.destroy();
+    });
+    std::string body(1000, 'b');
+    for (int i = 0; i < 40; ++i) {
+        char head[fnet::rpc::header_size];
+        fnet::rpc::details::encode_header(head, fnet::rpc::frame_type::request, 1, i + 1, body.size());
+        assert(write(l.p.local, head, sizeof(head)) == sizeof(head));
+        assert(write(l.p.local, body.data(), body.size()) == static_cast<ssize_t>(body.size()));
+    }
+    l.rec.activate();
+    assert(requests == 40);
+    assert(m->deferred_reads.load() >= 40 * 1016 / 8192);
+}
+
+int main() {
+    test_out_of_order();
+    test_errors();
+    test_timeout();
+    test_disconnect();
+    test_many_and_large();
+    test_frame_limit();
+    test_reply_limit();
+    test_read_budget();
+    std::cout << "ok\n";
+}
@@ -0,0 +1,147 @@
+#include <fastnet/fastnet.h>
+#include <sys/wait.h>
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 不同长度的消息跨越环的末尾，按发送顺序收到
+void test_wrap() {
+    fnet::shm_ring ring(4096);
+    auto reader = ring.share();
+    std::vector<std::string> got;
+    auto collect = [&](const char* p, size_t n) { got.emplace_back(p, n); };
+    for (int round = 0; round < 50; ++round) {
+        std::vector<std::string> sent;
+        for (int i = 0; i < 7; ++i) {
+            sent.push_back(std::string((round * 7 + i) % 300, static_cast<char>('a' + i)));
+            assert(ring.try_send(sent.back().data(), sent.back().size()));
+        }
+        got.clear();
+        assert(reader.poll(collect) == 7);
+        assert(got == sent);
+    }
+    assert(reader.idle());
+}
+
+// 环满时返回false；消费者腾出空间后空间门铃可读
+void test_full() {
+    fnet::shm_ring ring(4096);
+    std::string msg(1000, 'x');
+    int sent = 0;
+    while (ring.try_send(msg.data(), msg.size())) ++sent;
+    assert(sent == 4096 / 1024);
+    uint64_t val;
+    assert(read(ring.space_doorbell(), &val, sizeof(val)) == -1);
+    int got = 0;
+    ring.poll([&](const char*, size_t n) { got += n == msg.size(); });
+    assert(got == sent);
+    assert(read(ring.space_doorbell(), &val, sizeof(val)) == sizeof(val));
+    assert(ring.try_send(msg.data(), msg.size()));
+    bool thrown = false;
+    try {
+        ring.try_send(msg.data(), ring.max_message() + 1);
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    assert(thrown);
+}
+
+// 消费者未处理之前只敲一次门铃；budget用完时不标记空闲
+void test_doorbell() {
+    fnet::shm_ring ring(1 << 16);
+    for (int i = 0; i < 100; ++i) assert(ring.try_send(&i, sizeof(i)));
+    assert(ring.doorbells_rung() == 1 && ring.doorbells_suppressed() == 99);
+    int next = 0;
+    auto check = [&](const char* p, size_t n) {
+        int v;
+        assert(n == sizeof(v));
+        memcpy(&v, p, n);
+        assert(v == next++);
+    };
+    assert(ring.poll(check, 60) == 60);
+    assert(!ring.idle());
+    assert(ring.try_send(&next, sizeof(next)) && ring.doorbells_rung() == 1);  // 仍在处理中，不敲门铃
+    ring.poll([&](const char*, size_t) { ++next; });
+    assert(next == 101 && ring.idle());
+    int v = 0;
+    assert(ring.try_send(&v, sizeof(v)) && ring.doorbells_rung() == 2);
+}
+
+// 多个生产者线程，每个生产者的消息保持顺序
+void test_mpsc() {
+    const int producers = 4, per = 20000;
+    fnet::shm_ring ring(1 << 14, true);
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p] {
+            auto mine = ring.share();
+            for (int i = 0; i < per;) {
+                int msg[2] = {p, i};
+                if (mine.try_send(msg, sizeof(msg))) ++i;
+                else std::this_thread::yield();
+            }
+        });
+    }
+    std::vector<int> next(producers, 0);
+    int total = 0;
+    while (total < producers * per) {
+        total += ring.poll([&](const char* d, size_t n) {
+            int msg[2];
+            assert(n == sizeof(msg));
+            memcpy(msg, d, n);
+            assert(msg[1] == next[msg[0]]++);
+        });
+    }
+    for (auto& t : threads) t.join();
+    for (int n : next) assert(n == per);
+}
+
+// 通过UNIX域套接字传给子进程，子进程作为生产者，反应堆作为消费者
+void test_cross_process() {
+    int sv[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+    const int count = 50000;
+    fnet::shm_ring ring(1 << 16);
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(sv[0]);
+        auto child = fnet::shm_ring::receive_fds(sv[1]);
+        fnet::reactor rec;
+        int i = 0;
+        auto produce = [&] {
+            for (; i < count; ++i) {
+                std::string msg = std::to_string(i);
+                if (!child.try_send(msg.data(), msg.size())) return;
+            }
+            rec.destroy();
+        };
+        rec.add_shm_writer(&child, produce);
+        rec.post(produce);
+        rec.activate();
+        _exit(i == count ? 0 : 1);
+    }
+    close(sv[1]);
+    ring.send_fds(sv[0]);
+    fnet::reactor rec;
+    int expect = 0;
+    rec.add_shm_reader(&ring, [&](const char* d, size_t n) {
+        assert(std::string(d, n) == std::to_string(expect));
+        if (++expect == count) rec.destroy();
+    }, 64);
+    rec.activate();
+    int status;
+    assert(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    assert(expect == count);
+    close(sv[0]);
+}
+
+int main() {
+    test_wrap();
+    test_full();
+    test_doorbell();
+    test_mpsc();
+    test_cross_process();
+    std::cout << "ok\n";
+}
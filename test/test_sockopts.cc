@@ -0,0 +1,187 @@
+#include <fastnet/fastnet.h>
+#include <cassert>
+#include <iostream>
+#include <thread>
+
+int get_int(int fd, int level, int name) {
+    int v = -1;
+    socklen_t len = sizeof(v);
+    assert(getsockopt(fd, level, name, &v, &len) == 0);
+    return v;
+}
+
+// 原来的实现传入未初始化的值
+void test_nondelay() {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    fnet::utility::set_tcp_nondelay(fd);
+    assert(get_int(fd, IPPROTO_TCP, TCP_NODELAY) == 1);
+    close(fd);
+}
+
+// 挂在接收器上的配置：监听socket上的选项立即设置，每个接收的连接在回调之前设置
+void test_profile() {
+    fnet::sockopts opt;
+    opt.nodelay = true;
+    opt.rcvbuf = 256 << 10;
+    opt.sndbuf = 128 << 10;
+    opt.quickack = true;
+    opt.notsent_lowat = 8192;
+    opt.keepalive = true;
+    opt.keepidle = 30;
+    opt.keepintvl = 5;
+    opt.keepcnt = 3;
+    opt.reuse_port = true;
+    opt.defer_accept = 1;
+    opt.fastopen = 16;
+
+    fnet::acceptor<fnet::protocol::tcp> acp;
+    acp.set_options(opt);
+    acp.do_bind("127.0.0.1", 0);
+    acp.do_listen();
+    int lfd = acp.get_fd();
+    assert(get_int(lfd, SOL_SOCKET, SO_REUSEPORT) == 1);
+    assert(get_int(lfd, IPPROTO_TCP, TCP_DEFER_ACCEPT) > 0);
+    assert(get_int(lfd, IPPROTO_TCP, TCP_FASTOPEN) == 16);
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    getsockname(lfd, (struct sockaddr*)&addr, &len);
+
+    fnet::reactor rec;
+    int checked = 0;
+    rec.add_acceptor(std::move(acp), [&](int fd) {
+        assert(get_int(fd, IPPROTO_TCP, TCP_NODELAY) == 1);
+        assert(get_int(fd, SOL_SOCKET, SO_RCVBUF) >= 256 << 10);  // 内核加倍
+        assert(get_int(fd, SOL_SOCKET, SO_SNDBUF) >= 128 << 10);
+        assert(get_int(fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT) == 8192);
+        assert(get_int(fd, SOL_SOCKET, SO_KEEPALIVE) == 1);
+        assert(get_int(fd, IPPROTO_TCP, TCP_KEEPIDLE) == 30);
+        assert(get_int(fd, IPPROTO_TCP, TCP_KEEPINTVL) == 5);
+        assert(get_int(fd, IPPROTO_TCP, TCP_KEEPCNT) == 3);
+        ++checked;
+        close(fd);
+        rec.destroy();
+    });
+    std::thread client([&] {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        assert(connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+        // 开启了TCP_DEFER_ACCEPT，发送数据后服务端才会接收
+        assert(write(fd, "x", 1) == 1);
+        char c;
+        (void)read(fd, &c, 1);
+        close(fd);
+    });
+    rec.activate();
+    client.join();
+    assert(checked == 1);
+}
+
+// TCP_QUICKACK在收到数据后可能被内核清除，接收后立即读取；SO_BUSY_POLL超过系统设置时需要CAP_NET_ADMIN
+void test_quickack_busy_poll() {
+    int probe = socket(AF_INET, SOCK_STREAM, 0);
+    int us = 50;
+    bool busy_poll = setsockopt(probe, SOL_SOCKET, SO_BUSY_POLL, &us, sizeof(us)) == 0;
+    assert(busy_poll || errno == EPERM);
+    close(probe);
+
+    fnet::sockopts opt;
+    opt.quickack = true;
+    if (busy_poll) opt.busy_poll = us;
+    fnet::acceptor<fnet::protocol::tcp> acp;
+    acp.set_options(opt);
+    acp.do_bind("127.0.0.1", 0);
+    acp.do_listen();
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    getsockname(acp.get_fd(), (struct sockaddr*)&addr, &len);
+    int client = socket(AF_INET, SOCK_STREAM, 0);
+    assert(connect(client, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+    int fd = acp.do_accept();
+    assert(fd >= 0);
+    assert(get_int(fd, IPPROTO_TCP, TCP_QUICKACK) == 1);
+    if (busy_poll) assert(get_int(fd, SOL_SOCKET, SO_BUSY_POLL) == us);
+    close(fd);
+    close(client);
+}
+
+// 未赋值的选项不改变，错误的用法抛出异常
+void test_errors() {
+    fnet::acceptor<fnet::protocol::uds> acp;
+    fnet::sockopts none;
+    acp.set_options(none);
+    fnet::sockopts tcp_only;
+    tcp_only.fastopen = 8;
+    bool thrown = false;
+    try {
+        acp.set_options(tcp_only);
+    } catch (const std::runtime_error& e) {
+        thrown = std::string(e.what()).find("TCP_FASTOPEN") != std::string::npos;
+    }
+    assert(thrown);
+    auto lat = fnet::sockopts::low_latency();
+    assert(lat.nodelay && *lat.nodelay && !lat.rcvbuf);
+}
+
+// do_accept()中设置选项失败：关闭该连接并返回-1
+void test_do_accept_failure() {
+    const char* path = "@fastnet_test_do_accept";
+    fnet::acceptor<fnet::protocol::uds> acp;
+    fnet::sockopts opt;
+    opt.nodelay = true;
+    acp.set_options(opt);
+    acp.do_bind(path);
+    acp.do_listen();
+    struct sockaddr_un addr;
+    auto len = fnet::details::make_unix_addr(path, addr);
+    int client = socket(AF_UNIX, SOCK_STREAM, 0);
+    assert(connect(client, (struct sockaddr*)&addr, len) == 0);
+    assert(acp.do_accept() == -1);
+    assert(errno == EOPNOTSUPP);
+    char c;
+    assert(read(client, &c, 1) == 0);  // 服务端已关闭
+    close(client);
+}
+
+// 接收循环中设置选项失败（UNIX域socket不支持TCP_NODELAY）：关闭该连接并计数，循环继续
+void test_accept_failure() {
+    const char* path = "@fastnet_test_sockopts";
+    fnet::acceptor<fnet::protocol::uds> acp;
+    fnet::sockopts opt;
+    opt.nodelay = true;
+    acp.set_options(opt);
+    acp.do_bind(path);
+    acp.do_listen();
+    struct sockaddr_un addr;
+    auto len = fnet::details::make_unix_addr(path, addr);
+
+    fnet::reactor rec;
+    auto* m = rec.enable_metrics();
+    int connected = 0;
+    rec.add_acceptor(std::move(acp), [&](int fd) {
+        ++connected;
+        close(fd);
+    });
+    int clients[2];
+    for (int& fd : clients) {
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        assert(connect(fd, (struct sockaddr*)&addr, len) == 0);
+    }
+    rec.run_after(50, [&] { rec.destroy(); });
+    rec.activate();
+    assert(connected == 0);
+    assert(m->accepts.load() == 2 && m->sockopt_failures.load() == 2);
+    for (int fd : clients) {
+        char c;
+        assert(read(fd, &c, 1) == 0);  // 服务端已关闭
+        close(fd);
+    }
+}
+
+int main() {
+    test_nondelay();
+    test_profile();
+    test_quickack_busy_poll();
+    test_errors();
+    test_do_accept_failure();
+    test_accept_failure();
+    std::cout << "ok\n";
+}
@@ -0,0 +1,220 @@
+#include <fastnet/fastnet.h>
+#include <fastnet/tls.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <cassert>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "common.h"
+
+// 回环TCP上的一对连接，kTLS只支持TCP
+struct tcp_pair {
+    int local, peer;
+    tcp_pair() {
+        int lfd = socket(AF_INET, SOCK_STREAM, 0);
+        struct sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        assert(bind(lfd, (struct sockaddr*)&addr, len) == 0 && listen(lfd, 1) == 0);
+        assert(getsockname(lfd, (struct sockaddr*)&addr, &len) == 0);
+        local = socket(AF_INET, SOCK_STREAM, 0);
+        assert(connect(local, (struct sockaddr*)&addr, len) == 0);
+        peer = accept(lfd, nullptr, nullptr);
+        close(lfd);
+        fnet::utility::set_nonblocking(local);
+        fnet::utility::set_nonblocking(peer);
+    }
+    ~tcp_pair() {
+        close(local);
+        close(peer);
+    }
+};
+
+// OpenSSL编译时启用了kTLS，且内核允许在TCP连接上设置TCP_ULP "tls"（tls模块已加载或可以自动加载）
+bool ktls_available() {
+#ifdef OPENSSL_NO_KTLS
+    return false;
+#else
+    tcp_pair p;
+    return setsockopt(p.local, SOL_TCP, TCP_ULP, "tls", sizeof("tls")) == 0;
+#endif
+}
+
+// 同一个反应堆上的一对端点：client在local上发起握手，server在peer上接受
+template <typename Pair>
+struct tls_link {
+    fnet::reactor rec;
+    Pair p;
+    fnet::tls::endpoint server;
+    fnet::tls::endpoint client;
+
+    explicit tls_link(fnet::tls::context cli_ctx = fnet::tls::context::client("", false),
+                      fnet::tls::endpoint::options opt = fnet::tls::endpoint::options())
+        : server(rec, fnet::tls::context::self_signed(), opt)
+        , client(rec, std::move(cli_ctx), opt) {
+        rec.add_socket(p.local, fnet::event::readable, fnet::pattern::lt);
+        rec.add_socket(p.peer, fnet::event::readable, fnet::pattern::lt);
+        server.accept(p.peer);
+        rec.set_readable_cb([this](int fd) {
+            auto& ep = fd == p.local ? client : server;
+            if (!ep.on_readable(fd)) {
+                ep.remove(fd);
+                rec.destroy();
+            }
+        });
+        rec.set_writable_cb([this](int fd) {
+            auto& ep = fd == p.local ? client : server;
+            if (!ep.on_writable(fd)) rec.destroy();
+        });
+    }
+};
+
+// 握手前的写入暂存到握手完成；服务端回显
+void test_echo() {
+    tls_link<pair_fd> l;
+    l.server.set_data_cb([&](int fd, std::string_view data) { l.server.send(fd, data); });
+    std::string got;
+    int ready = 0;
+    l.client.set_ready_cb([&](int) { ++ready; });
+    l.client.set_data_cb([&](int, std::string_view data) {
+        got.append(data.data(), data.size());
+        if (got == "hello, world") l.rec.destroy();
+    });
+    assert(l.client.connect(l.p.local, "localhost"));
+    assert(!l.client.ready(l.p.local));
+    l.client.send(l.p.local, "hello, ");
+    l.client.send(l.p.local, "world");
+    l.rec.activate();
+    assert(got == "hello, world" && ready == 1);
+    assert(l.client.ready(l.p.local) && l.server.ready(l.p.peer));
+    assert(std::string(l.client.version(l.p.local)) == "TLSv1.3");
+    assert(l.client.stats().handshakes == 1 && l.server.stats().handshakes == 1);
+    assert(l.server.stats().bytes_in == 12 && l.client.stats().bytes_out == 12);
+    // UNIX域套接字不支持kTLS，总是回退到用户态
+    assert(!l.client.ktls_send(l.p.local) && l.client.stats().ktls_tx == 0);
+}
+
+// 回环TCP上大量数据双向传输，无论是否启用了kTLS内容都一致；
+// 内核支持kTLS时发送方向由内核加密（明文经reactor::send()写出），否则两端都回退到用户态
+void check_bulk(bool ktls) {
+    fnet::tls::endpoint::options opt;
+    opt.ktls = ktls;
+    tls_link<tcp_pair> l(fnet::tls::context::client("", false), opt);
+    const size_t total = 8 << 20;
+    std::string pattern;
+    for (int i = 0; i < 997; ++i) pattern.push_back(static_cast<char>('a' + i % 26));
+    size_t server_got = 0, client_got = 0;
+    bool mismatch = false;
+    l.server.set_data_cb([&](int fd, std::string_view data) {
+        for (size_t i = 0; i < data.size(); ++i) mismatch |= data[i] != pattern[(server_got + i) % pattern.size()];
+        server_got += data.size();
+        l.server.send(fd, data);
+    });
+    l.client.set_data_cb([&](int, std::string_view data) {
+        for (size_t i = 0; i < data.size(); ++i) mismatch |= data[i] != pattern[(client_got + i) % pattern.size()];
+        client_got += data.size();
+        if (client_got == total) l.rec.destroy();
+    });
+    assert(l.client.connect(l.p.local));
+    for (size_t off = 0; off < total; off += pattern.size()) {
+        l.client.send(l.p.local, pattern.data(), std::min(pattern.size(), total - off));
+    }
+    l.rec.run_after(20000, [&] { l.rec.destroy(); });
+    l.rec.activate();
+    assert(!mismatch && server_got == total && client_got == total);
+    if (ktls && ktls_available()) {
+        assert(l.client.ktls_send(l.p.local) && l.server.ktls_send(l.p.peer));
+        assert(l.client.stats().ktls_tx == 1 && l.server.stats().ktls_tx == 1);
+    } else {
+        assert(!l.client.ktls_send(l.p.local) && !l.server.ktls_send(l.p.peer));
+        assert(!l.client.ktls_recv(l.p.local) && !l.server.ktls_recv(l.p.peer));
+        assert(l.client.stats().ktls_tx == 0 && l.server.stats().ktls_tx == 0);
+        assert(l.client.stats().ktls_rx == 0 && l.server.stats().ktls_rx == 0);
+    }
+    assert(l.client.stats().bytes_out == total && l.server.stats().bytes_in == total);
+}
+
+void test_bulk() {
+    check_bulk(true);
+    check_bulk(false);
+}
+
+// 文件内容经send_file()发送（启用kTLS时零拷贝，否则读入内存加密）；
+// 握手后的会话票据写出之后再发送，使kTLS下的sendfile路径总能执行
+void test_send_file() {
+    tls_link<tcp_pair> l;
+    char path[] = "/tmp/fnet_tls_XXXXXX";
+    int file = mkstemp(path);
+    assert(file >= 0);
+    unlink(path);
+    std::string content;
+    for (int i = 0; i < 300000; ++i) content.push_back(static_cast<char>(i * 7));
+    assert(write(file, content.data(), content.size()) == static_cast<ssize_t>(content.size()));
+    std::string got;
+    std::function<void(int)> start = [&](int fd) {
+        if (l.rec.pending_output(fd)) {
+            l.rec.run_after(fd, 1, start);
+            return;
+        }
+        l.server.send_file(fd, file, 1000, content.size() - 1000);
+    };
+    l.server.set_ready_cb(start);
+    l.client.set_data_cb([&](int, std::string_view data) {
+        got.append(data.data(), data.size());
+        if (got.size() == content.size() - 1000) l.rec.destroy();
+    });
+    assert(l.client.connect(l.p.local));
+    l.rec.activate();
+    close(file);
+    assert(got == content.substr(1000));
+    if (ktls_available()) {
+        assert(l.server.ktls_send(l.p.peer) && l.server.stats().sendfile_bytes > 0);
+    } else {
+        assert(!l.server.ktls_send(l.p.peer) && l.server.stats().sendfile_bytes == 0);
+    }
+    assert(l.server.stats().bytes_out == content.size() - 1000);
+}
+
+// 校验失败（自签名证书不受信任）时握手失败
+void test_verify_failure() {
+    tls_link<pair_fd> l(fnet::tls::context::client());
+    bool ready = false;
+    l.client.set_ready_cb([&](int) { ready = true; });
+    assert(l.client.connect(l.p.local, "localhost"));
+    l.rec.run_after(2000, [&] { l.rec.destroy(); });
+    l.rec.activate();
+    assert(!ready && l.client.stats().failures == 1 && l.client.stats().handshakes == 0);
+}
+
+// shutdown()发送close_notify，对端的on_readable()返回false
+void test_shutdown() {
+    tls_link<pair_fd> l;
+    l.client.set_ready_cb([&](int fd) { l.client.shutdown(fd); });
+    int closed_fd = -1;
+    l.rec.set_readable_cb([&](int fd) {
+        auto& ep = fd == l.p.local ? l.client : l.server;
+        if (!ep.on_readable(fd)) {
+            closed_fd = fd;
+            l.rec.destroy();
+        }
+    });
+    assert(l.client.connect(l.p.local));
+    l.rec.run_after(2000, [&] { l.rec.destroy(); });
+    l.rec.activate();
+    assert(closed_fd == l.p.peer && l.server.stats().failures == 0);
+}
+
+int main() {
+    if (!ktls_available()) std::cout << "kTLS unavailable, skipping the kernel path and checking the fallback\n";
+    test_echo();
+    test_bulk();
+    test_send_file();
+    test_verify_failure();
+    test_shutdown();
+    std::cout << "ok\n";
+}
@@ -0,0 +1,116 @@
+#include <fastnet/fastnet.h>
+#include <sys/un.h>
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// 连接到UNIX域地址，'@'开头为抽象命名空间
+int connect_unix(const char* path, int type) {
+    struct sockaddr_un addr;
+    auto len = fnet::details::make_unix_addr(path, addr);
+    int fd = socket(AF_UNIX, type, 0);
+    assert(fd != -1 && connect(fd, (struct sockaddr*)&addr, len) == 0);
+    return fd;
+}
+
+// 在反应堆中接收一个连接，返回已接收的fd与对端地址
+template <typename Protocol, typename Connect>
+std::pair<int, std::string> accept_one(fnet::acceptor<Protocol>&& acp, Connect&& connect_fn, int& client) {
+    fnet::reactor rec;
+    int accepted = -1;
+    std::string peer;
+    rec.add_acceptor(std::move(acp), [&](int fd) {
+        accepted = fd;
+        peer = rec.remote().to_string();
+        rec.destroy();
+    });
+    client = connect_fn();
+    rec.activate();
+    return {accepted, peer};
+}
+
+void test_tcp6() {
+    fnet::acceptor<fnet::protocol::tcp6> acp;
+    fnet::utility::set_reuse_address(acp.get_fd());
+    acp.do_bind("::1", 0);
+    acp.do_listen();
+    struct sockaddr_in6 addr;
+    socklen_t len = sizeof(addr);
+    getsockname(acp.get_fd(), (struct sockaddr*)&addr, &len);
+    int client = -1;
+    auto res = accept_one(std::move(acp), [&] {
+        int fd = socket(AF_INET6, SOCK_STREAM, 0);
+        assert(connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+        return fd;
+    }, client);
+    assert(res.first > 0);
+    assert(res.second.compare(0, 6, "[::1]:") == 0);
+    close(res.first);
+    close(client);
+}
+
+void test_uds() {
+    const char* path = "/tmp/fastnet_test_transport.sock";
+    fnet::acceptor<fnet::protocol::uds> acp;
+    acp.do_bind(path);
+    acp.do_listen();
+    int client = -1;
+    auto res = accept_one(std::move(acp), [&] { return connect_unix(path, SOCK_STREAM); }, client);
+    assert(res.first > 0 && res.second == "unix:");
+    assert(write(client, "ping", 4) == 4);
+    char buf[8];
+    assert(read(res.first, buf, sizeof(buf)) == 4);
+    close(res.first);
+    close(client);
+    unlink(path);
+}
+
+// 抽象命名空间 + SOCK_SEQPACKET：不创建文件，每次读取一条完整的消息
+void test_abstract_seqpacket() {
+    fnet::acceptor<fnet::protocol::uds_seqpacket> acp;
+    acp.do_bind("@fastnet_test_transport");
+    acp.do_listen();
+    int client = -1;
+    auto res = accept_one(std::move(acp), [&] { return connect_unix("@fastnet_test_transport", SOCK_SEQPACKET); },
+                          client);
+    assert(res.first > 0);
+    assert(write(client, "abc", 3) == 3);
+    assert(write(client, "de", 2) == 2);
+    char buf[16];
+    assert(read(res.first, buf, sizeof(buf)) == 3);
+    assert(read(res.first, buf, sizeof(buf)) == 2);
+    close(res.first);
+    close(client);
+}
+
+// 对端地址的文本形式与限速用的键
+void test_peer_address() {
+    fnet::peer_address a;
+    auto* in = reinterpret_cast<sockaddr_in*>(a.data());
+    in->sin_family = AF_INET;
+    in->sin_port = htons(80);
+    inet_pton(AF_INET, "10.0.0.1", &in->sin_addr);
+    assert(a.is_v4() && a.port() == 80 && a.to_string() == "10.0.0.1:80");
+
+    fnet::peer_address m;
+    auto* in6 = reinterpret_cast<sockaddr_in6*>(m.data());
+    in6->sin6_family = AF_INET6;
+    inet_pton(AF_INET6, "::ffff:10.0.0.1", &in6->sin6_addr);
+    assert(fnet::ip_key(m) == fnet::ip_key(a));  // IPv4映射地址与IPv4同键
+
+    fnet::peer_address b, c;
+    for (auto* p : {&b, &c}) reinterpret_cast<sockaddr_in6*>(p->data())->sin6_family = AF_INET6;
+    inet_pton(AF_INET6, "2001:db8::1", &reinterpret_cast<sockaddr_in6*>(b.data())->sin6_addr);
+    inet_pton(AF_INET6, "2001:db8::2", &reinterpret_cast<sockaddr_in6*>(c.data())->sin6_addr);
+    assert(fnet::ip_key(b) == fnet::ip_key(c));  // 同一/64前缀
+    assert(fnet::ip_key(b) != fnet::ip_key(a) && fnet::ip_key(b) != 0);
+}
+
+int main() {
+    test_tcp6();
+    test_uds();
+    test_abstract_seqpacket();
+    test_peer_address();
+    std::cout << "ok\n";
+}
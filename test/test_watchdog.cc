@@ -0,0 +1,63 @@
+#include <fastnet/fastnet.h>
+#include <sys/socket.h>
+#include <cassert>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+// 编译时需定义 FNET_ENABLE_WATCHDOG
+// 测试看门狗能否记录慢回调，并导出时间线
+void test_watchdog() {
+    std::cout << "---------------------------\n";
+    fnet::reactor rec;
+    fnet::watchdog dog(5 * 1000 * 1000);  // 5ms
+    rec.set_watchdog(&dog);
+
+    int sv[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+    fnet::utility::set_nonblocking(sv[0]);
+    rec.add_socket(sv[0], fnet::event::readable, fnet::pattern::lt);
+
+    int count = 0;
+    rec.set_readable_cb([&](int fd) {
+        char c;
+        assert(read(fd, &c, 1) == 1);
+        if (c == 's') std::this_thread::sleep_for(std::chrono::milliseconds(20));  // 慢回调
+        if (++count == 3) rec.destroy();
+    });
+    assert(write(sv[1], "f", 1) == 1);
+    assert(write(sv[1], "s", 1) == 1);
+    assert(write(sv[1], "f", 1) == 1);
+    rec.activate();
+
+    auto stalls = dog.stalls();
+    assert(stalls.size() == 1);
+    assert(stalls[0].fd == sv[0]);
+    assert(stalls[0].kind == fnet::cb_kind::readable);
+    assert(stalls[0].dur_ns >= 20 * 1000 * 1000);
+    std::cout << "stall: fd=" << stalls[0].fd << " dur=" << stalls[0].dur_ns / 1000 << "us\n";
+    assert(!dog.iterations().empty());
+
+    std::ofstream ofs("watchdog_trace.json");
+    dog.dump_chrome_trace(ofs);
+    std::cout << "trace written to watchdog_trace.json\n";
+    close(sv[0]);
+    close(sv[1]);
+    std::cout << "---------------------------\n";
+}
+
+// 覆盖式环形记录器只保留最近的N条
+void test_trace_ring() {
+    fnet::trace_ring<int, 8> ring;
+    for (int i = 0; i < 20; ++i) ring.push(i);
+    std::vector<int> out;
+    ring.collect(out);
+    assert(out.size() == 8);
+    assert(out.front() == 12 && out.back() == 19);
+    assert(ring.total() == 20);
+}
+
+int main() {
+    test_trace_ring();
+    test_watchdog();
+}